@@ -16,7 +16,9 @@
 #pragma once
 
 #include "types.h"
+#include <algorithm>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <map>
 #include <memory>
@@ -60,6 +62,28 @@ public:
     virtual Result<std::vector<FileInfo>> list_files_in_directory(const std::string& parent_uid, const std::string& tenant = "") = 0;
     virtual Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string& parent_uid, const std::string& tenant = "") = 0;
     virtual Result<std::vector<FileInfo>> list_all_files(const std::string& tenant = "") = 0;
+    // One page of a directory listing in (name, uid) order: at most `limit`
+    // non-deleted entries strictly after (after_name, after_uid); empty cursor
+    // values start at the beginning. Keyset paging, so a page deep into a huge
+    // directory costs the same as the first one. Non-pure so existing mocks
+    // need no change; this default pages the full listing.
+    virtual Result<std::vector<FileInfo>> list_files_in_directory_page(const std::string& parent_uid,
+                                                                       const std::string& after_name,
+                                                                       const std::string& after_uid,
+                                                                       size_t limit,
+                                                                       const std::string& tenant = "") {
+        auto all = list_files_in_directory(parent_uid, tenant);
+        if (!all.success) return all;
+        std::vector<FileInfo> page;
+        for (auto& info : all.value) {
+            if (std::tie(info.name, info.uid) > std::tie(after_name, after_uid)) page.push_back(std::move(info));
+        }
+        std::sort(page.begin(), page.end(), [](const FileInfo& a, const FileInfo& b) {
+            return std::tie(a.name, a.uid) < std::tie(b.name, b.uid);
+        });
+        if (page.size() > limit) page.resize(limit);
+        return Result<std::vector<FileInfo>>::ok(std::move(page));
+    }
     virtual Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string& name, const std::string& parent_uid, const std::string& tenant = "") = 0;
     virtual Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string& name, const std::string& parent_uid, const std::string& tenant = "") = 0;
     virtual Result<int64_t> get_file_size(const std::string& file_uid, const std::string& tenant = "") = 0;
@@ -75,6 +99,24 @@ public:
     virtual Result<int64_t> insert_version(const std::string& file_uid, const std::string& version_timestamp,
                                             int64_t size, const std::string& storage_path,
                                             const std::string& revised_by = "", const std::string& tenant = "") = 0;
+    // Record a newly stored version as the file's current content: the
+    // version row plus files.size (and, where a backend tracks them, current
+    // version and mtime) in one atomic step. Returns the version id. The
+    // default composes the individual calls, so it is neither atomic nor a
+    // single round trip; the concrete Database overrides it with one
+    // statement. Non-pure so existing mocks need no change.
+    virtual Result<int64_t> commit_new_version(const std::string& file_uid, const std::string& version_timestamp,
+                                               int64_t size, const std::string& storage_path,
+                                               const std::string& revised_by = "", const std::string& tenant = "") {
+        auto current = update_file_current_version(file_uid, version_timestamp, tenant);
+        if (!current.success) return Result<int64_t>::err("Failed to update current version: " + current.error);
+        auto version = insert_version(file_uid, version_timestamp, size, storage_path, revised_by, tenant);
+        if (!version.success) return Result<int64_t>::err("Failed to record version: " + version.error);
+        auto sized = update_file_size(file_uid, size, tenant);
+        if (!sized.success) return Result<int64_t>::err("Failed to update file size: " + sized.error);
+        update_file_modified(file_uid, tenant);
+        return version;
+    }
     virtual Result<std::optional<std::string>> get_version_storage_path(const std::string& file_uid, const std::string& version_timestamp, const std::string& tenant = "") = 0;
     virtual Result<std::vector<std::string>> list_versions(const std::string& file_uid, const std::string& tenant = "") = 0;
     // Remove a single version row for a file. Non-pure so existing mocks need
@@ -163,6 +205,25 @@ public:
                                     int effect = 0) = 0;
     virtual Result<std::vector<AclEntry>> get_acls_for_resource(const std::string& resource_uid,
                                                                  const std::string& tenant = "") = 0;
+    // One link of a resource's parent chain, as returned by get_ancestor_chain
+    struct AncestorEntry {
+        std::string uid;
+        std::string parent_uid;
+        bool deleted = false;
+        bool parent_exists = false;  // a row with uid == parent_uid exists
+        std::vector<AclEntry> acls;
+    };
+
+    // The resource itself followed by its ancestors, nearest first, each with
+    // its ACL rows, read in one query from the materialized files.ancestors
+    // path. Empty if the resource has no row; nullopt if its path is not
+    // materialized, in which case callers walk parent_uid instead. The path is
+    // not trusted blindly: callers should check that the links agree with
+    // parent_uid. Non-pure so existing mocks need no change.
+    virtual Result<std::optional<std::vector<AncestorEntry>>> get_ancestor_chain(const std::string& /*resource_uid*/,
+                                                                                 const std::string& /*tenant*/ = "") {
+        return Result<std::optional<std::vector<AncestorEntry>>>::ok(std::nullopt);
+    }
     virtual Result<std::vector<AclEntry>> get_user_acls(const std::string& resource_uid,
                                                         const std::string& principal,
                                                         int type,
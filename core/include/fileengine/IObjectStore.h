@@ -16,6 +16,7 @@
 #pragma once
 
 #include "types.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <memory>
@@ -59,6 +60,31 @@ public:
     virtual Result<void> delete_file(const std::string& storage_path, const std::string& tenant = "") = 0;
     virtual Result<bool> file_exists(const std::string& storage_path, const std::string& tenant = "") = 0;
 
+    // Positioned access to a stored object, so a byte range of a cold file can
+    // be served without downloading all of it. read_file_range() returns up to
+    // `length` bytes starting at `offset`; fewer only at end of object. The
+    // defaults read the whole object; S3Storage issues ranged GETs.
+    virtual Result<uint64_t> get_file_size(const std::string& storage_path, const std::string& tenant = "") {
+        auto result = read_file(storage_path, tenant);
+        if (!result.success) {
+            return Result<uint64_t>::err(result.error);
+        }
+        return Result<uint64_t>::ok(result.value.size());
+    }
+    virtual Result<std::vector<uint8_t>> read_file_range(const std::string& storage_path, uint64_t offset,
+                                                         size_t length, const std::string& tenant = "") {
+        auto result = read_file(storage_path, tenant);
+        if (!result.success) {
+            return result;
+        }
+        if (offset >= result.value.size()) {
+            return Result<std::vector<uint8_t>>::ok({});
+        }
+        size_t n = std::min<uint64_t>(length, result.value.size() - offset);
+        return Result<std::vector<uint8_t>>::ok(
+            std::vector<uint8_t>(result.value.begin() + offset, result.value.begin() + offset + n));
+    }
+
     // Get storage path for a virtual file
     virtual std::string get_storage_path(const std::string& virtual_path, const std::string& version_timestamp, const std::string& tenant = "") const = 0;
 
@@ -17,6 +17,8 @@
 
 #include "types.h"
 #include "IObjectStore.h"  // Include IObjectStore for type definition
+#include <cstdio>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <functional>
@@ -59,6 +61,99 @@ public:
     // Object store access for caching functionality
     virtual void set_object_store(IObjectStore* object_store) = 0;
     virtual IObjectStore* get_object_store() const = 0;
+
+    // Stream the stored bytes of `storage_path` to `on_chunk` in order, in
+    // chunks of the backend's choosing; returning false from `on_chunk` stops
+    // the read early (not an error). The default reads the whole file.
+    virtual Result<void> read_file_chunks(const std::string& storage_path,
+                                          const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                          const std::string& tenant = "") {
+        auto result = read_file(storage_path, tenant);
+        if (!result.success) {
+            return Result<void>::err(result.error);
+        }
+        if (!result.value.empty()) on_chunk(result.value.data(), result.value.size());
+        return Result<void>::ok();
+    }
+
+    // Positioned access to the stored (not decoded) bytes of `storage_path`.
+    // read_file_range() returns up to `length` bytes starting at `offset`;
+    // fewer only at end of file. The defaults read the whole file.
+    virtual Result<uint64_t> get_file_size(const std::string& storage_path, const std::string& tenant = "") {
+        auto result = read_file(storage_path, tenant);
+        if (!result.success) {
+            return Result<uint64_t>::err(result.error);
+        }
+        return Result<uint64_t>::ok(result.value.size());
+    }
+    virtual Result<std::vector<uint8_t>> read_file_range(const std::string& storage_path, uint64_t offset,
+                                                         size_t length, const std::string& tenant = "") {
+        auto result = read_file(storage_path, tenant);
+        if (!result.success) {
+            return result;
+        }
+        if (offset >= result.value.size()) {
+            return Result<std::vector<uint8_t>>::ok({});
+        }
+        size_t n = std::min<uint64_t>(length, result.value.size() - offset);
+        return Result<std::vector<uint8_t>>::ok(
+            std::vector<uint8_t>(result.value.begin() + offset, result.value.begin() + offset + n));
+    }
+
+    // Store a copy of the blob at `src_storage_path` as version
+    // `version_timestamp` of `uid`; returns the new storage path. Backends
+    // override this to copy without moving the bytes through user space. The
+    // default reads the blob and stores it again.
+    virtual Result<std::string> copy_file(const std::string& src_storage_path, const std::string& uid,
+                                          const std::string& version_timestamp, const std::string& tenant = "") {
+        auto result = read_file(src_storage_path, tenant);
+        if (!result.success) {
+            return Result<std::string>::err(result.error);
+        }
+        return store_file(uid, version_timestamp, result.value, tenant);
+    }
+
+    // Staged writes for callers that produce a blob incrementally (put_stream):
+    // write the payload to make_staging_path(), then publish_staged_file()
+    // moves it to `storage_path` with the backend's durability guarantees. A
+    // failed or abandoned staging file is the caller's to remove.
+    virtual std::string make_staging_path(const std::string& storage_path) {
+        return storage_path + ".part";
+    }
+    virtual Result<void> publish_staged_file(const std::string& staged_path, const std::string& storage_path) {
+        if (std::rename(staged_path.c_str(), storage_path.c_str()) != 0) {
+            return Result<void>::err("Failed to move " + staged_path + " to " + storage_path);
+        }
+        return Result<void>::ok();
+    }
+
+    // Content-addressed deduplication (optional; backends without it keep the
+    // defaults below). When enabled, versions whose stored bytes share a
+    // `content_key` share one blob on disk; the returned/recorded version path
+    // still resolves to the payload, so readers are unaffected.
+    virtual bool is_deduplication_enabled() const { return false; }
+    // store_file() with a caller-supplied content key (e.g. an HMAC of the
+    // plaintext, since encrypted bytes never repeat). If a blob with that key
+    // already exists it is reused and `data` is not written.
+    virtual Result<std::string> store_file_deduplicated(const std::string& uid, const std::string& version_timestamp,
+                                                        const std::vector<uint8_t>& data, const std::string& content_key,
+                                                        const std::string& tenant = "") {
+        (void)content_key;
+        return store_file(uid, version_timestamp, data, tenant);
+    }
+    // Fold an already-written version file (e.g. from put_stream) into the
+    // blob store under `content_key`, replacing it with the shared copy if one
+    // exists.
+    virtual Result<void> deduplicate_file(const std::string& storage_path, const std::string& content_key,
+                                          const std::string& tenant = "") {
+        (void)storage_path; (void)content_key; (void)tenant;
+        return Result<void>::ok();
+    }
+    // Unlink blobs no version references any more; returns how many were removed.
+    virtual Result<size_t> collect_unreferenced_blobs(const std::string& tenant = "") {
+        (void)tenant;
+        return Result<size_t>::ok(0);
+    }
 };
 
 } // namespace fileengine
\ No newline at end of file
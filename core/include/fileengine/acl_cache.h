@@ -0,0 +1,137 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "acl_manager.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fileengine {
+
+// Counters since construction
+struct AclCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;  // invalidate() calls
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t max_entries = 0;
+};
+
+// A permission decision as cached: the principal's bits on the resource
+// itself, and whether every ancestor grants it READ
+struct CachedPermissions {
+    int permissions = 0;
+    bool reachable = false;
+};
+
+// Process-wide cache of AclManager lookups, shared by every request
+// (FILEENGINE_ACL_CACHE_ENTRIES). Unlike CacheScope, which lives for one
+// handler on one thread, entries outlive the request that filled them.
+//
+// Two kinds of entry share one bounded LRU: a resource's ACL rules, keyed by
+// (tenant, resource), and a computed decision, keyed by (tenant, resource,
+// principal set), where the principal set is the user, effective roles and
+// claims the decision was made for.
+//
+// Every entry is stamped with its tenant's generation, read before the
+// database was queried, and is only served while that generation is
+// current. invalidate() bumps the generation after any change that can alter
+// a decision (a grant or revoke, role membership, deleting, restoring or
+// moving part of the tree), so an entry filled before the change, or while
+// it was in flight, can never grant access afterwards. Tenants hash onto a
+// fixed set of generation counters; two tenants sharing one only cost each
+// other some hits. Changes made by other server processes are bounded by
+// the optional TTL.
+class AclCache {
+public:
+    static constexpr size_t kDefaultMaxEntries = 100000;
+
+    // ttl of zero keeps entries until they are invalidated or evicted
+    explicit AclCache(size_t max_entries = kDefaultMaxEntries,
+                      std::chrono::milliseconds ttl = std::chrono::milliseconds(0),
+                      size_t shard_count = 16);
+
+    // Read before querying the database; pass it to the put_*() call
+    uint64_t generation(const std::string& tenant) const;
+
+    std::optional<std::vector<ACLRule>> get_rules(const std::string& tenant, const std::string& resource_uid);
+    void put_rules(const std::string& tenant, const std::string& resource_uid,
+                   const std::vector<ACLRule>& rules, uint64_t generation);
+
+    std::optional<CachedPermissions> get_permissions(const std::string& tenant, const std::string& resource_uid,
+                                                     const std::string& principal_key);
+    void put_permissions(const std::string& tenant, const std::string& resource_uid,
+                         const std::string& principal_key, CachedPermissions permissions,
+                         uint64_t generation);
+
+    // Retire every entry of `tenant`
+    void invalidate(const std::string& tenant);
+
+    // Key for the principal a decision was made for. `roles` must be the
+    // effective roles; order does not matter.
+    static std::string principal_key(const std::string& user, std::vector<std::string> roles,
+                                     const std::map<std::string, std::string>& claims);
+
+    AclCacheStats get_stats() const;
+
+private:
+    static constexpr size_t kGenerations = 64;
+
+    struct Entry {
+        std::vector<ACLRule> rules;
+        CachedPermissions permissions;
+        uint64_t generation;
+        std::chrono::steady_clock::time_point expires;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> map;
+        std::list<std::string> lru;  // front = most recently used
+        size_t max_entries = 0;
+    };
+
+    // Returns the entry for `key` if it is current; caller holds the shard lock
+    Entry* find_locked(Shard& shard, const std::string& key, const std::string& tenant);
+    Entry* insert_locked(Shard& shard, const std::string& key, uint64_t generation);
+    Shard& shard_for(const std::string& key);
+    std::atomic<uint64_t>& generation_for(const std::string& tenant);
+    const std::atomic<uint64_t>& generation_for(const std::string& tenant) const;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::array<std::atomic<uint64_t>, kGenerations> generations_{};
+    const std::chrono::milliseconds ttl_;
+    size_t max_entries_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace fileengine
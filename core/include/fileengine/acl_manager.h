@@ -16,10 +16,12 @@
 #pragma once
 
 #include "types.h"
+#include "IDatabase.h"
 #include <string>
 #include <vector>
 #include <memory>
 #include <map>
+#include <optional>
 
 namespace fileengine {
 
@@ -111,7 +113,10 @@ struct ACLRule {
     AclEffect effect = AclEffect::ALLOW;
 };
 
-class IDatabase;
+class MetadataCache;
+class AclCache;
+class RoleCache;
+struct CachedPermissions;
 
 // Reserved role names. A user whose effective roles (request_roles ∪ DB-stored
 // roles) contain either of these bypasses all ACL checks for the resource. There
@@ -150,6 +155,27 @@ public:
     void set_default_world_readable(bool enabled) { default_world_readable_ = enabled; }
     bool default_world_readable() const { return default_world_readable_; }
 
+    // FileInfo cache for the ancestor walks (has_deleted_ancestor,
+    // ancestors_readable). nullptr (the default) queries db_ directly. Must be
+    // the FileSystem's instance, which invalidates it on every mutation.
+    void set_metadata_cache(std::shared_ptr<MetadataCache> cache) { metadata_cache_ = std::move(cache); }
+
+    // Cross-request cache of ACL rules and permission decisions. nullptr (the
+    // default) leaves only the request-scoped CacheScope. Grants and revokes
+    // through this AclManager invalidate it; other changes that alter who can
+    // reach what must call invalidate_cached_permissions().
+    void set_acl_cache(std::shared_ptr<AclCache> cache) { acl_cache_ = std::move(cache); }
+
+    // Retire every cached decision for `tenant`. Call after a role membership
+    // change, or after deleting, restoring or moving part of the tree.
+    void invalidate_cached_permissions(const std::string& tenant);
+
+    // Cross-request cache of each user's database-stored roles. nullptr (the
+    // default) queries db_ on every check outside a CacheScope. Role changes
+    // must go through a RoleManager holding the same instance.
+    void set_role_cache(std::shared_ptr<RoleCache> cache) { role_cache_ = std::move(cache); }
+    std::shared_ptr<RoleCache> role_cache() const { return role_cache_; }
+
     // Read-by-default. When enabled (the default), every principal holds a
     // baseline READ on every resource, so an entity with no specific ACL is
     // readable by any user. The baseline is cleared by any matching DENY READ
@@ -181,7 +207,7 @@ public:
     // Request-scoped ACL lookup cache. Within the lifetime of a CacheScope,
     // repeat get_acls_for_resource lookups for the same (resource, tenant)
     // tuple on the same thread are served from memory instead of re-hitting
-    // Postgres. Any grant/revoke through this AclManager invalidates the
+    // Postgres, and a user's stored roles are resolved once. Any grant/revoke through this AclManager invalidates the
     // affected entry, so the cache is consistent for the lifetime of one
     // gRPC handler. See plan §6.3.
     class CacheScope {
@@ -273,9 +299,16 @@ public:
 
 private:
     std::shared_ptr<IDatabase> db_;
+    std::shared_ptr<MetadataCache> metadata_cache_;  // optional
+    std::shared_ptr<AclCache> acl_cache_;            // optional
+    std::shared_ptr<RoleCache> role_cache_;          // optional
     bool default_world_readable_ = false;
     bool default_read_ = true;
     
+    // get_file_by_uid(_include_deleted) through metadata_cache_, if set
+    Result<std::optional<FileInfo>> lookup_file(const std::string& uid, const std::string& tenant,
+                                                bool include_deleted);
+
     // Internal helper to get user permissions from the database
     Result<std::vector<ACLRule>> get_user_acls(const std::string& resource_uid, 
                                                const std::string& user, 
@@ -294,12 +327,30 @@ private:
     // unreachable, naturally respecting parent-container permissions. A
     // resource with no file record or an empty parent is treated as
     // root-level, hence reachable. `roles` are already-resolved effective
-    // roles. Fails closed if an ancestor's ACLs cannot be resolved.
+    // roles. Fails closed if an ancestor's ACLs cannot be resolved; a lookup
+    // failure also sets `*failed`, if given, so the answer is not cached.
     bool ancestors_readable(const std::string& resource_uid,
                             const std::string& user,
                             const std::vector<std::string>& roles,
                             const std::map<std::string, std::string>& claims,
-                            const std::string& tenant);
+                            const std::string& tenant,
+                            bool* failed = nullptr);
+
+    // The resource's row and its ancestors' rows with their ACLs, from one
+    // IDatabase::get_ancestor_chain query. nullopt when the path is not
+    // materialized, the query failed, or the links disagree with parent_uid;
+    // callers then walk the chain one level at a time. Seeds both ACL caches.
+    std::optional<std::vector<IDatabase::AncestorEntry>> load_ancestor_chain(const std::string& resource_uid,
+                                                                             const std::string& tenant);
+
+    // The principal's bits on the resource and whether its ancestors are
+    // readable, served from and filled into acl_cache_ (which must be set).
+    // `roles` are effective roles.
+    Result<CachedPermissions> decide(const std::string& resource_uid,
+                                     const std::string& user,
+                                     const std::vector<std::string>& roles,
+                                     const std::map<std::string, std::string>& claims,
+                                     const std::string& tenant);
 
     // Union request-supplied roles with DB-stored roles for the user (deduped).
     // Request roles support federated IdP setups; DB roles support local
@@ -308,6 +359,10 @@ private:
                                                      const std::vector<std::string>& request_roles,
                                                      const std::string& tenant);
 
+    // The user's DB-stored roles, via the CacheScope memo and role_cache_.
+    // Empty if the lookup fails.
+    std::vector<std::string> stored_roles(const std::string& user, const std::string& tenant);
+
     // CacheScope hooks. Implementation uses a thread-local optional map so a
     // single AclManager instance can serve multiple concurrent requests, each
     // with its own private cache.
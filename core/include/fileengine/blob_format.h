@@ -0,0 +1,156 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+#include "codec.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fileengine {
+
+// ---------------------------------------------------------------------------
+// Framed blob container (format version 1). A stored blob is cut into frames
+// of `frame_size` plaintext bytes, each compressed and AES-256-GCM sealed on
+// its own, followed by an index of the frames:
+//
+//   header   "FEFR" | version u8 | flags u8 | reserved u16 | frame_size u32 |
+//            reserved u32 | file_id[16]                                (32 B)
+//   frame*   stored_len u32 | plain_len u32 | crc32 u32 | codec u8 |
+//            last u8 | reserved u16                                    (16 B)
+//            payload[stored_len]   ([IV || ciphertext || tag] if encrypted)
+//   index    per frame: record_offset u64 | stored_len u32 | plain_len u32
+//   trailer  index_offset u64 | plain_size u64 | frame_count u32 | "FEFI"
+//
+// All integers are little-endian. The GCM AAD of frame N binds the file id,
+// N, plain_len, codec and the last-frame flag (the id is random per blob when
+// encrypted, zero otherwise), so frames cannot be swapped,
+// reordered, moved between blobs or truncated away without failing
+// authentication. Unencrypted frames are covered by the CRC only.
+//
+// `codec` is a CodecId (codec.h: 0 none, 1 zlib, 2 zstd, 3 lz4). Each frame
+// records its own, so raw frames mix freely with compressed ones and a
+// tenant can switch codecs without rewriting existing blobs.
+//
+// Frames are self-delimiting, so a blob can be decoded front to back while
+// it streams in (each frame is verified before its plaintext is released),
+// and the trailing index lets FramedBlobReader decode only the frames that
+// cover a byte range.
+//
+// Blobs written before this format (one zlib stream in one GCM envelope,
+// see CompressStream/EncryptStream) have no header and are still decoded;
+// frame_size 0 keeps writing them. As with the legacy helpers, empty input
+// encodes to an empty blob.
+
+static constexpr size_t kDefaultBlobFrameSize = 256 * 1024;
+
+// Plaintext -> stored bytes, streaming (same update/finish contract as
+// CompressStream). `key` empty means no encryption; `codec` nullptr means no
+// compression, and `compress` true selects zlib at its default level. The
+// codec is skipped for content that starts with a compressed-format
+// signature and for frames whose sampled entropy says they will not shrink
+// (see codec.h). Throws on failure.
+//
+// With a `pool` of more than one thread, frames are compressed and sealed on
+// the pool while the caller keeps feeding input; sealed frames are appended
+// in order, so the output is byte-for-byte what a serial encode produces for
+// the same blob id. update() then returns whatever frames have completed
+// (possibly none) and blocks only when about two frames per worker are
+// queued; finish() waits for the rest. The legacy format is always serial.
+class BlobEncoder {
+public:
+    BlobEncoder(bool compress, const std::string& key, size_t frame_size = kDefaultBlobFrameSize,
+                std::shared_ptr<WorkerPool> pool = nullptr);
+    BlobEncoder(std::shared_ptr<const Codec> codec, const std::string& key,
+                size_t frame_size = kDefaultBlobFrameSize, std::shared_ptr<WorkerPool> pool = nullptr);
+    ~BlobEncoder();
+    BlobEncoder(const BlobEncoder&) = delete;
+    BlobEncoder& operator=(const BlobEncoder&) = delete;
+    void update(const uint8_t* data, size_t n, std::vector<uint8_t>& out);
+    void finish(std::vector<uint8_t>& out);
+
+    static std::vector<uint8_t> encode(const std::vector<uint8_t>& data, bool compress, const std::string& key,
+                                       size_t frame_size = kDefaultBlobFrameSize,
+                                       std::shared_ptr<WorkerPool> pool = nullptr);
+    static std::vector<uint8_t> encode(const std::vector<uint8_t>& data, std::shared_ptr<const Codec> codec,
+                                       const std::string& key, size_t frame_size = kDefaultBlobFrameSize,
+                                       std::shared_ptr<WorkerPool> pool = nullptr);
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Stored bytes -> plaintext, streaming. Detects the format from the file
+// header: a blob is framed only if the magic, version, frame size and
+// encryption flag all check out, so a legacy blob that merely starts with
+// the magic (an IV or compressed stream can) is decoded as legacy.
+// `compress` and `key` describe how legacy blobs were written (framed blobs
+// carry that in their header); `legacy` skips detection for a blob already
+// known not to be framed. With a key, a header claiming an unencrypted blob
+// is not trusted: the bytes must then authenticate as legacy ciphertext.
+// Throws on corruption or failed authentication; framed blobs fail before
+// the bad frame's bytes are output. decode() also falls back to the legacy
+// decode when a framed decode fails, e.g. on the index or trailer.
+class BlobDecoder {
+public:
+    BlobDecoder(bool compress, const std::string& key, bool legacy = false);
+    ~BlobDecoder();
+    BlobDecoder(const BlobDecoder&) = delete;
+    BlobDecoder& operator=(const BlobDecoder&) = delete;
+    void update(const uint8_t* data, size_t n, std::vector<uint8_t>& out);
+    void finish(std::vector<uint8_t>& out);
+
+    static std::vector<uint8_t> decode(const std::vector<uint8_t>& stored, bool compress, const std::string& key);
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Random access to a framed blob through a positional read callback.
+class FramedBlobReader {
+public:
+    // Returns `len` bytes at `offset` of the stored blob, or an error; a short
+    // result is reported as a truncated blob.
+    using ReadAt = std::function<Result<std::vector<uint8_t>>(uint64_t offset, size_t len)>;
+
+    // True if `head` (the first bytes of a blob) starts with the framed magic.
+    // Legacy bytes can too: treat it as a hint and fall back to the legacy
+    // decode when open() rejects the blob.
+    static bool is_framed(const uint8_t* head, size_t n);
+
+    // Parse header, trailer and index of a `blob_size`-byte framed blob.
+    static Result<std::shared_ptr<FramedBlobReader>> open(uint64_t blob_size, ReadAt read_at,
+                                                          const std::string& key);
+    ~FramedBlobReader();
+
+    uint64_t size() const;          // plaintext size
+    size_t frame_count() const;
+
+    // Plaintext bytes [offset, offset + len), clamped to size(); reads and
+    // verifies only the frames overlapping the range.
+    Result<std::vector<uint8_t>> read(uint64_t offset, size_t len);
+
+private:
+    FramedBlobReader();
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace fileengine
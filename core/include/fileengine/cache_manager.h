@@ -18,27 +18,92 @@
 #include "types.h"
 #include "IStorage.h"
 #include "IObjectStore.h"
+#include "frequency_sketch.h"
 #include <string>
 #include <unordered_map>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <chrono>
+#include <atomic>
+#include <vector>
 
 namespace fileengine {
 
 struct CachedFile {
     std::string path;
-    std::vector<uint8_t> data;
+    SharedBlob data;  // never null; shared with readers of a cache hit
     std::chrono::steady_clock::time_point last_accessed;
     size_t size;
     std::string tenant;
 };
 
+// Counters since construction, for tuning the budget under real load
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;   // entries dropped to make room (not invalidations)
+    uint64_t insertions = 0;
+    uint64_t rejections = 0;  // new entries refused by TinyLFU admission
+    size_t entries = 0;
+    size_t size_bytes = 0;
+    size_t max_bytes = 0;
+};
+
+// In-memory LRU cache of file content with a fixed byte budget
+// (FILEENGINE_MAX_CACHE_SIZE_MB).
+//
+// FileSystem uses it as a read-through cache of decoded (plaintext) content
+// keyed by (tenant, uid, version): lookup() runs before local disk and the
+// object store are touched, and a miss is filled by insert() once the content
+// has been read and decoded. A version's content never changes, so entries
+// only leave by eviction or when a version is rewritten or purged
+// (invalidate()). The path-keyed get_file()/add_file() interface is older
+// and caches whatever bytes it is given.
+//
+// Keys are spread over independent shards by hash, each with its own lock,
+// LRU lists and an equal slice of the budget, so concurrent readers of
+// different files rarely contend. Eviction is per shard.
+//
+// Under the default TinyLfu policy (W-TinyLFU) each shard keeps a small
+// recency window (1% of its bytes) in front of the main LRU, plus a
+// FrequencySketch of recent accesses. An entry leaving the window only
+// enters the main region if it has been accessed more often than every
+// entry it would displace; otherwise it is dropped. A one-pass scan (an
+// object-store sync, a recursive copy, a crawler) therefore churns through
+// the window without flushing the hot set, and one large file cannot push
+// out many small popular ones. The Lru policy is plain LRU.
+enum class CachePolicy { Lru, TinyLfu };
+
 class CacheManager {
 public:
-    CacheManager(IStorage* storage, IObjectStore* object_store, double threshold = 0.80); // Default 80% threshold
+    static constexpr size_t kDefaultMaxCacheSize = 1024ull * 1024 * 1024;
+    // Default shard count is capped so each shard keeps at least this much
+    // of the budget (small caches get fewer shards, down to one)
+    static constexpr size_t kMinShardBytes = 32ull * 1024 * 1024;
+
+    // shard_count 0 picks a power of two from the core count and budget
+    CacheManager(IStorage* storage, IObjectStore* object_store, double threshold = 0.80, // Default 80% threshold
+                 size_t max_cache_size_bytes = kDefaultMaxCacheSize, size_t shard_count = 0,
+                 CachePolicy policy = CachePolicy::TinyLfu);
     ~CacheManager();
+
+    // "lru" | "tinylfu" (FILEENGINE_CACHE_POLICY); unknown -> TinyLfu
+    static CachePolicy parse_policy(const std::string& policy);
+
+    // Decoded content of `version` of `uid`, or nullptr (counted as a miss).
+    // A hit shares the cached buffer rather than copying it; it stays valid
+    // after the entry is evicted. Hit or miss, the access counts towards the
+    // key's admission frequency.
+    SharedBlob lookup(const std::string& tenant, const std::string& uid, const std::string& version);
+    // Cache decoded content, evicting entries as needed (subject to admission
+    // under TinyLfu). Entries over 1/8 of the budget, or half of a shard's
+    // slice of it, are never cached.
+    void insert(const std::string& tenant, const std::string& uid, const std::string& version,
+                SharedBlob data);
+    void invalidate(const std::string& tenant, const std::string& uid, const std::string& version);
+
+    CacheStats get_stats() const;
     
     // Get a file from cache or load from storage
     Result<std::vector<uint8_t>> get_file(const std::string& storage_path, const std::string& tenant = "");
@@ -56,6 +121,12 @@ public:
     double get_cache_usage_percentage() const;
     size_t get_cache_size_bytes() const;
     size_t get_max_cache_size_bytes() const;
+
+    // Change the byte budget, evicting down to it if needed
+    void set_max_cache_size_bytes(size_t max_cache_size_bytes);
+
+    size_t shard_count() const { return shards_.size(); }
+    CachePolicy policy() const { return policy_; }
     
     // Set the cache threshold (0.0 to 1.0)
     void set_cache_threshold(double threshold);
@@ -72,29 +143,72 @@ public:
     void update_access_time(const std::string& storage_path);
     
 private:
+    using LruList = std::list<std::string>;
+
     struct CacheEntry {
-        std::list<std::string>::iterator lru_iter;  // Iterator to LRU list position
+        LruList::iterator lru_iter;  // position in the window or main list
         CachedFile file;
+        bool in_window = false;
+    };
+    using EntryMap = std::unordered_map<std::string, CacheEntry>;
+
+    // One lock domain; every member is guarded by `mutex`
+    struct Shard {
+        mutable std::mutex mutex;
+        EntryMap map;
+        LruList lru;                 // main region; front = most recently used
+        LruList window;              // TinyLfu admission window; front = newest
+        size_t size_bytes = 0;       // window + main
+        size_t window_bytes = 0;
+        size_t max_bytes = 0;        // this shard's slice of the budget
+        size_t window_max_bytes = 0;
+        std::unique_ptr<FrequencySketch> sketch;  // TinyLfu only
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t insertions = 0;
+        uint64_t rejections = 0;
     };
     
     IStorage* storage_;
     IObjectStore* object_store_;
-    std::unordered_map<std::string, CacheEntry> cache_map_;
-    std::list<std::string> lru_list_;  // For LRU eviction
-    mutable std::mutex cache_mutex_;
-    
-    size_t current_cache_size_;
-    size_t max_cache_size_bytes_;  // Max cache size in bytes (calculated based on threshold and system storage)
-    double threshold_;  // Threshold for cache size as percentage of total storage
-    
-    // Calculate the maximum cache size based on system storage and threshold
-    void calculate_max_cache_size();
-    
-    // Remove least recently used items until cache is below threshold
-    void evict_lru_items();
-    
-    // Helper to get system's available storage space
-    size_t get_available_system_storage() const;
+    const CachePolicy policy_;
+    std::vector<std::unique_ptr<Shard>> shards_;  // size is a power of two
+    std::atomic<size_t> max_cache_size_bytes_;    // Byte budget across all shards
+    std::atomic<double> threshold_;  // Fraction of the budget cleanup_cache() evicts down to
+
+    Shard& shard_for(const std::string& key) const;
+
+    // Key of a decoded version (never a valid storage path)
+    static std::string version_key(const std::string& tenant, const std::string& uid, const std::string& version);
+
+    // Set the shard's budget and window size. Caller holds shard.mutex.
+    static void resize_locked(Shard& shard, size_t max_bytes);
+
+    // Record an access for admission decisions. Caller holds shard.mutex.
+    static void record_access_locked(Shard& shard, const std::string& key);
+
+    // Insert or replace `key`: straight into the main LRU under Lru,
+    // through the window and admission under TinyLfu. False if it is larger
+    // than the shard's budget. Caller holds shard.mutex.
+    static bool insert_locked(Shard& shard, const std::string& key, SharedBlob data,
+                              const std::string& tenant);
+
+    // Move the window's oldest entries into the main region, or drop them if
+    // they lose admission, until the window is within its size. Caller holds
+    // shard.mutex.
+    static void drain_window_locked(Shard& shard);
+
+    // Move `it` to the front of its list. Caller holds shard.mutex.
+    static void touch_locked(Shard& shard, EntryMap::iterator it);
+
+    // Remove `it` from its list and the map. Caller holds shard.mutex.
+    static void erase_locked(Shard& shard, EntryMap::iterator it);
+
+    // Evict entries until the shard holds at most `limit` bytes: least
+    // recently used of the main region first, then the window. Caller holds
+    // shard.mutex.
+    static void evict_to_locked(Shard& shard, size_t limit);
 };
 
 } // namespace fileengine
\ No newline at end of file
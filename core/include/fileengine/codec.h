@@ -0,0 +1,74 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fileengine {
+
+// Compression codec of one blob frame, as recorded in the frame's codec byte
+// (see blob_format.h). Values are part of the stored format.
+enum class CodecId : uint8_t { None = 0, Zlib = 1, Zstd = 2, Lz4 = 3 };
+
+// Block compressor for blob frames. zlib is always built in; zstd and lz4
+// only when the build found them (FILEENGINE_ENABLE_ZSTD / _LZ4), and a frame
+// written with a codec this build lacks fails to decode with an error naming
+// it. Instances are immutable and safe to share across threads (frames are
+// encoded on a worker pool).
+class Codec {
+public:
+    virtual ~Codec() = default;
+
+    virtual CodecId id() const = 0;
+    virtual int level() const = 0;
+
+    // Compress `n` bytes into `out`. Returns false when the result would not
+    // be smaller than the input; the frame is then stored raw.
+    virtual bool compress(const uint8_t* in, size_t n, std::vector<uint8_t>& out) const = 0;
+    // Decompress into exactly `plain_len` bytes at `out`; false if the input
+    // is corrupt or does not expand to exactly that length.
+    virtual bool decompress(const uint8_t* in, size_t n, uint8_t* out, size_t plain_len) const = 0;
+
+    // Codec `id` at `level` (0 = the codec's default); nullptr for None or a
+    // codec not built in.
+    static std::shared_ptr<const Codec> make(CodecId id, int level = 0);
+    // Parse "name[:level]": "zlib", "zlib:9", "zstd:3", "lz4", "lz4:9", or
+    // "none" (value nullptr). Fails for unknown names and codecs not built in.
+    static Result<std::shared_ptr<const Codec>> from_spec(const std::string& spec);
+    // Shared default-level instance for decoding; nullptr if not built in.
+    static const Codec* decoder(CodecId id);
+
+    static bool available(CodecId id);
+    static const char* name(CodecId id);
+};
+
+// Cheap check for content that will not compress: a signature of a
+// compressed format (JPEG, PNG, GIF, WebP, MP4/MOV, Matroska, MP3, Ogg, ZIP
+// and its derivatives, gzip, bzip2, xz, zstd, 7z, RAR) at the start of
+// `data`.
+bool has_compressed_signature(const uint8_t* data, size_t n);
+
+// Estimates byte entropy and byte-pair repetition from a few small windows
+// spread over `data` (at most 4 KiB sampled) and reports near-random content
+// — already compressed or encrypted — that a codec would only spend CPU on.
+bool looks_incompressible(const uint8_t* data, size_t n);
+
+} // namespace fileengine
@@ -28,12 +28,38 @@ struct Config {
     std::string db_name = "fileengine";
     std::string db_user = "fileengine_user";
     std::string db_password = "fileengine_password";
+    // Prepare hot statements once per pooled connection; turn off behind a
+    // transaction-mode pooler (PgBouncer) that does not keep sessions.
+    bool db_prepared_statements = true;
     
     // Storage configuration
     std::string storage_base_path = "/tmp/fileengine_storage";
     bool encrypt_data = false;
     bool compress_data = false;
     std::string encryption_key;  // Added for encryption support
+    // Content-addressed blob layout: identical payloads (re-uploads, copies,
+    // re-saves) share one blob on disk, reference-counted by hard links.
+    bool storage_deduplicate = false;
+    // Durability of local blob writes: "group" (batched syncfs), "fsync"
+    // (per write) or "none" (page cache only; fastest, unsafe on crash).
+    std::string storage_sync_mode = "group";
+    // Local read path: "posix" (blocking reads) or "uring" (io_uring, when
+    // built with FILEENGINE_ENABLE_IO_URING and allowed by the kernel).
+    std::string storage_io_backend = "posix";
+    // Plaintext bytes per frame of the seekable blob format used when
+    // compression or encryption is on; 0 writes the legacy single-stream format.
+    int storage_frame_kb = 256;
+    // Threads compressing/encrypting frames of large writes in parallel
+    // (shared by all requests); 0 = one per CPU, 1 = on the request thread.
+    int storage_encode_threads = 0;
+    // Frame compression codec when compression is on: "zlib", "zstd" or
+    // "lz4", optionally with ":level" (e.g. "zstd:3").
+    std::string storage_codec = "zlib";
+    // Stored blobs smaller than this many KiB are appended to shared segment
+    // files under <base>/.packs instead of one file each; 0 disables packing.
+    int storage_pack_kb = 0;
+    // Seconds between background compactions of the pack segments.
+    int storage_pack_compact_seconds = 600;
     
     // S3/MinIO configuration
     std::string s3_endpoint = "http://localhost:9000";
@@ -46,6 +72,14 @@ struct Config {
     // Cache configuration
     double cache_threshold = 0.8;  // 80% threshold
     size_t max_cache_size_mb = 1024;  // 1GB max cache
+    std::string cache_policy = "tinylfu";  // "tinylfu" (scan-resistant admission) or "lru"
+    size_t metadata_cache_entries = 100000;  // FileInfo rows cached in memory; 0 = off
+    int metadata_cache_ttl_ms = 5000;        // bound on staleness from other servers; 0 = none
+    int negative_cache_ttl_ms = 1000;        // how long a uid with no row is remembered; 0 = off
+    size_t acl_cache_entries = 100000;       // ACL rule sets + permission decisions; 0 = off
+    int acl_cache_ttl_ms = 5000;             // bound on staleness from other servers; 0 = none
+    size_t role_cache_entries = 100000;      // users whose stored roles are cached; 0 = off
+    int role_cache_ttl_ms = 5000;            // bound on staleness from other servers; 0 = none
     
     // Tenant configuration
     bool multi_tenant_enabled = true;
@@ -22,20 +22,42 @@
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <unordered_map>
 #include <libpq-fe.h>
 
 namespace fileengine {
 
 class DatabaseConnection {
 public:
-    explicit DatabaseConnection(const std::string& conninfo);
+    explicit DatabaseConnection(const std::string& conninfo, bool prepare_statements = true);
     ~DatabaseConnection();
 
     PGconn* get_connection() { return conn_; }
     bool is_valid() const { return conn_ && PQstatus(conn_) == CONNECTION_OK; }
 
+    // Run `sql` with text parameters, like PQexecParams. With statement
+    // preparation on, the first run of each distinct SQL text on this
+    // connection PQprepare()s it and later runs PQexecPrepared() the stored
+    // statement, so Postgres skips the parse and plan. Callers build the SQL
+    // with the tenant schema in it, so the text is the (schema, statement)
+    // key. The caller owns the returned PGresult, as with PQexecParams.
+    PGresult* exec_cached(const std::string& sql, int n_params, const char* const* param_values);
+
+    // Statements currently prepared on this connection.
+    size_t prepared_count() const { return prepared_.size(); }
+
 private:
+    // Upper bound on statements kept per connection (a few hot statements
+    // times the tenants this connection has served); reaching it starts over.
+    static constexpr size_t kMaxPreparedStatements = 512;
+
+    // Drop every prepared statement; with `deallocate`, on the server too.
+    void forget_prepared(bool deallocate);
+
     PGconn* conn_;
+    bool prepare_statements_;
+    std::unordered_map<std::string, std::string> prepared_;  // SQL text -> statement name
+    uint64_t next_statement_id_ = 0;
 };
 
 class ConnectionPool {
@@ -50,12 +72,19 @@ public:
     bool initialize();
     void shutdown();
 
+    // Whether connections opened from now on prepare their hot statements
+    // (DatabaseConnection::exec_cached). Set before initialize(). Turn it
+    // off behind a transaction-mode pooler such as PgBouncer, where
+    // statements prepared on one session are not visible to the next.
+    void set_prepare_statements(bool enabled) { prepare_statements_ = enabled; }
+
     // Connection information access
     std::string get_connection_info() const { return connection_info_; }
 
 private:
     std::string connection_info_;
     int pool_size_;
+    bool prepare_statements_ = true;
 
     std::queue<std::shared_ptr<DatabaseConnection>> available_connections_;
     std::mutex pool_mutex_;
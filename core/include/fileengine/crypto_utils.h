@@ -98,6 +98,23 @@ private:
     std::unique_ptr<Impl> impl_;
 };
 
+// SHA-256 content digest, streaming. With a non-empty `key` it is HMAC-SHA256
+// keyed by that string instead, so a digest names content without revealing the
+// plain hash of it (used for content-addressed blob names under encryption).
+// finish() returns the lowercase hex digest and may be called once.
+class ContentHasher {
+public:
+    explicit ContentHasher(const std::string& key = "");
+    ~ContentHasher();
+    ContentHasher(const ContentHasher&) = delete;
+    ContentHasher& operator=(const ContentHasher&) = delete;
+    void update(const uint8_t* data, size_t n);
+    std::string finish();
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
 class CryptoUtils {
 public:
     // Compression functions
@@ -107,7 +124,19 @@ public:
     // Encryption functions
     static std::vector<uint8_t> encrypt_data(const std::vector<uint8_t>& data, const std::string& key);
     static std::vector<uint8_t> decrypt_data(const std::vector<uint8_t>& encrypted_data, const std::string& key);
+
+    // 32-byte AES-256 key from a 64-char hex string or base64; throws otherwise
+    static std::vector<uint8_t> parse_aes256_key(const std::string& key);
+
+    // 32-byte subkey (raw bytes) for `label`, derived from the AES-256 key
+    // `key` with HKDF-SHA256, so one configured key can serve several
+    // purposes without reusing the key material itself. Throws like
+    // parse_aes256_key.
+    static std::string derive_key(const std::string& key, const std::string& label);
     
+    // One-shot ContentHasher: hex SHA-256 of `data` (HMAC-SHA256 when keyed)
+    static std::string content_digest(const std::vector<uint8_t>& data, const std::string& key = "");
+
     // Utility function to convert hex string to bytes
     static std::vector<uint8_t> hex_string_to_bytes(const std::string& hex);
     
@@ -40,6 +40,10 @@ public:
     ~Database();
 
     // Connection management
+    // Prepare hot statements once per pooled connection instead of parsing
+    // and planning them on every call (on by default). Call before connect();
+    // also applies to a secondary configured later.
+    void set_prepared_statements(bool enabled);
     bool connect() override;
     void disconnect() override;
     bool is_connected() const override;
@@ -77,6 +81,11 @@ public:
     Result<std::vector<FileInfo>> list_files_in_directory(const std::string& parent_uid, const std::string& tenant) override;
     Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string& parent_uid, const std::string& tenant) override;
     Result<std::vector<FileInfo>> list_all_files(const std::string& tenant) override;
+    Result<std::vector<FileInfo>> list_files_in_directory_page(const std::string& parent_uid,
+                                                               const std::string& after_name,
+                                                               const std::string& after_uid,
+                                                               size_t limit,
+                                                               const std::string& tenant) override;
     Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string& name, const std::string& parent_uid, const std::string& tenant) override;
     Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string& name, const std::string& parent_uid, const std::string& tenant) override;
     Result<int64_t> get_file_size(const std::string& file_uid, const std::string& tenant) override;
@@ -92,6 +101,9 @@ public:
     Result<int64_t> insert_version(const std::string& file_uid, const std::string& version_timestamp,
                                     int64_t size, const std::string& storage_path,
                                     const std::string& revised_by, const std::string& tenant) override;
+    Result<int64_t> commit_new_version(const std::string& file_uid, const std::string& version_timestamp,
+                                       int64_t size, const std::string& storage_path,
+                                       const std::string& revised_by, const std::string& tenant) override;
     Result<std::optional<std::string>> get_version_storage_path(const std::string& file_uid, const std::string& version_timestamp, const std::string& tenant) override;
     Result<std::vector<std::string>> list_versions(const std::string& file_uid, const std::string& tenant) override;
     Result<bool> delete_version(const std::string& file_uid, const std::string& version_timestamp, const std::string& tenant = "") override;
@@ -120,6 +132,13 @@ public:
     Result<void> cleanup_tenant_data(const std::string& tenant) override;
     Result<std::vector<std::string>> list_tenants() override;
 
+    // Recompute the stored folder rollup (newest version beneath each folder)
+    // bottom-up, one tree level per statement. With only_missing, only folders whose rollup was never
+    // computed (rows predating the column) are filled in; otherwise every
+    // folder is recomputed, repairing any drift. Returns the number of folders
+    // written. Used by fileengine_rollup_backfill.
+    Result<int64_t> rebuild_folder_rollups(const std::string& tenant, bool only_missing = true);
+
     // ACL operations
     Result<void> add_acl(const std::string& resource_uid, const std::string& principal,
                          int type, int permissions,
@@ -133,6 +152,8 @@ public:
                             int effect = 0) override;
     Result<std::vector<AclEntry>> get_acls_for_resource(const std::string& resource_uid,
                                                         const std::string& tenant = "") override;
+    Result<std::optional<std::vector<AncestorEntry>>> get_ancestor_chain(const std::string& resource_uid,
+                                                                         const std::string& tenant = "") override;
     Result<std::vector<AclEntry>> get_user_acls(const std::string& resource_uid,
                                                 const std::string& principal,
                                                 int type,
@@ -179,6 +200,7 @@ private:
     std::string secondary_conn_info_;
     std::atomic<bool> using_secondary_{false};
     int pool_size_{10};                  // reused when building the secondary pool
+    bool prepared_statements_{true};     // likewise
 
     // Acquire a connection for the given operation kind: writes -> primary; reads
     // -> the replica while failed over, else the primary.
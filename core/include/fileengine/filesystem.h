@@ -21,9 +21,12 @@
 #include "IObjectStore.h"
 #include "acl_manager.h"
 #include "cache_manager.h"
+#include "metadata_cache.h"
 #include "tenant_manager.h"
 #include "file_culler.h"
 #include "event_sink.h"
+#include "worker_pool.h"
+#include "single_flight.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -60,6 +63,25 @@ public:
                                                                      const std::string& user,
                                                                      const std::vector<std::string>& roles = {},
                                                                      const std::string& tenant = "");
+    // One page of listdir in (name, uid) order: at most `limit` entries after
+    // the cursor (after_name, after_uid), where empty values start at the
+    // beginning. Same permission and deleted-directory checks as listdir. The
+    // last entry is the cursor for the next page; a short page is the last.
+    virtual Result<std::vector<DirectoryEntry>> listdir_page(const std::string& dir_uid,
+                                                             const std::string& after_name,
+                                                             const std::string& after_uid,
+                                                             size_t limit,
+                                                             const std::string& user,
+                                                             const std::vector<std::string>& roles = {},
+                                                             const std::string& tenant = "");
+
+    // Opaque page token for the listdir_page cursor (name, uid) in `dir_uid`.
+    // decode_page_token returns false for a malformed token or one issued for
+    // a different directory.
+    static std::string encode_page_token(const std::string& dir_uid, const std::string& name,
+                                         const std::string& uid);
+    static bool decode_page_token(const std::string& token, const std::string& dir_uid,
+                                  std::string& name, std::string& uid);
 
     // File operations
     virtual Result<std::string> touch(const std::string& parent_uid, const std::string& name,
@@ -80,6 +102,13 @@ public:
                                              const std::string& user,
                                              const std::vector<std::string>& roles = {},
                                              const std::string& tenant = "");
+    // get() without the copy: the returned buffer is shared with the read
+    // cache (or becomes the cached entry), so a hit costs no memcpy. get()
+    // copies out of it for callers that need their own vector.
+    virtual Result<SharedBlob> get_shared(const std::string& file_uid,
+                                          const std::string& user,
+                                          const std::vector<std::string>& roles = {},
+                                          const std::string& tenant = "");
 
     // Streaming write: pulls plaintext chunks via `next_chunk` (fills the vector,
     // returns false at end-of-input) and writes them compress->encrypt->disk
@@ -100,6 +129,25 @@ public:
                                     const std::string& user,
                                     const std::vector<std::string>& roles = {},
                                     const std::string& tenant = "");
+    // Byte-range read of the current version: emits plaintext bytes
+    // [offset, offset + length) via `on_chunk` (length 0 = to end of file) and
+    // returns the file's full plaintext size. Only the stored bytes the range
+    // needs are read: a positioned read for plain blobs, the covering frames
+    // for framed (compressed/encrypted) blobs, and ranged object-store reads
+    // when the file is not on local disk (no whole-file restore). Legacy
+    // unframed blobs are decoded from the start up to the end of the range;
+    // encrypted ones are first authenticated in full, so nothing is emitted
+    // from a blob that fails its GCM check.
+    virtual Result<uint64_t> get_range_stream(const std::string& file_uid, uint64_t offset, uint64_t length,
+                                              const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                              const std::string& user,
+                                              const std::vector<std::string>& roles = {},
+                                              const std::string& tenant = "");
+    // get_range_stream() collected into one buffer.
+    virtual Result<std::vector<uint8_t>> get_range(const std::string& file_uid, uint64_t offset, uint64_t length,
+                                                   const std::string& user,
+                                                   const std::vector<std::string>& roles = {},
+                                                   const std::string& tenant = "");
 
     // Metadata operations
     virtual Result<FileInfo> stat(const std::string& file_uid, const std::string& user,
@@ -138,6 +186,12 @@ public:
                                                      const std::string& user,
                                                      const std::vector<std::string>& roles = {},
                                                      const std::string& tenant = "");
+    // get_version() sharing the cached buffer, as get_shared()
+    virtual Result<SharedBlob> get_version_shared(const std::string& file_uid,
+                                                  const std::string& version_timestamp,
+                                                  const std::string& user,
+                                                  const std::vector<std::string>& roles = {},
+                                                  const std::string& tenant = "");
 
     virtual Result<bool> restore_to_version(const std::string& file_uid,
                                            const std::string& version_timestamp,
@@ -232,6 +286,20 @@ public:
         acl_manager_ = acl_manager;
     }
 
+    // Setter for the read cache of decoded file content. When unset (nullptr),
+    // every read goes to storage — the default. Shared with the REST server,
+    // which reports its counters.
+    virtual void set_cache_manager(std::shared_ptr<CacheManager> cache_manager) {
+        cache_manager_ = std::move(cache_manager);
+    }
+
+    // Setter for the FileInfo cache in front of get_file_by_uid. When unset
+    // (nullptr), every lookup queries the database. Share the same instance
+    // with the AclManager so permission checks see this object's invalidations.
+    virtual void set_metadata_cache(std::shared_ptr<MetadataCache> metadata_cache) {
+        metadata_cache_ = std::move(metadata_cache);
+    }
+
     // Setter for FileCuller
     virtual void set_file_culler(std::unique_ptr<FileCuller> file_culler) {
         file_culler_ = std::move(file_culler);
@@ -266,9 +334,32 @@ public:
 private:
     std::shared_ptr<TenantManager> tenant_manager_;
     std::shared_ptr<AclManager> acl_manager_;
-    std::unique_ptr<CacheManager> cache_manager_;
+    std::shared_ptr<CacheManager> cache_manager_;  // optional; nullptr = no read cache
+    std::shared_ptr<MetadataCache> metadata_cache_;  // optional; nullptr = no FileInfo cache
     std::unique_ptr<FileCuller> file_culler_;
     std::shared_ptr<IEventSink> event_sink_;  // optional; nullptr = events disabled
+    std::shared_ptr<WorkerPool> encode_pool_;  // parallel frame encoding; nullptr = serial
+
+    // Concurrent cold reads of one (tenant, uid, version) share a single
+    // object-store fetch and local write, then a single decode
+    SingleFlight<SharedBlob> stored_fetches_;  // stored (encoded) bytes
+    SingleFlight<SharedBlob> cold_reads_;      // decoded content
+
+    // Copy a version's stored blob from the object store to local storage and
+    // return it, coalescing concurrent calls for the same version.
+    Result<SharedBlob> fetch_stored_blob(TenantContext& context, const std::string& file_uid,
+                                         const std::string& version, const std::string& tenant);
+
+    // get_file_by_uid(_include_deleted) through the metadata cache, if set
+    Result<std::optional<FileInfo>> lookup_file(TenantContext& context, const std::string& uid,
+                                                const std::string& tenant, bool include_deleted = false);
+    // Drop cached metadata for `uid` (and its ancestors) after its row
+    // changed; `parent_uid` as for MetadataCache::invalidate()
+    void invalidate_metadata(const std::string& tenant, const std::string& uid,
+                             const std::optional<std::string>& parent_uid = std::nullopt);
+    // Retire cached permission decisions after a delete, restore or move,
+    // which changes what the ancestor walk sees
+    void invalidate_permissions(const std::string& tenant);
 
     // Best-effort emission of a file-activity event after a successful mutation.
     // noexcept + fully guarded: never disturbs the calling operation. Enriches
@@ -287,6 +378,12 @@ private:
     
     // Helper to get tenant context for operations
     TenantContext* get_tenant_context(const std::string& tenant);
+
+    // listdir's access rules: READ on the directory, and (except for admins)
+    // the directory itself must not be soft-deleted
+    Result<void> check_listable(TenantContext& context, const std::string& dir_uid,
+                                const std::string& user, const std::vector<std::string>& roles,
+                                const std::string& tenant);
     
     // Helper to validate permissions
     Result<bool> validate_user_permissions(const std::string& resource_uid,
@@ -0,0 +1,56 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fileengine {
+
+// Approximate access counts for cache admission (TinyLFU). A count-min
+// sketch of four rows of small saturating counters (max 15): a key's estimate
+// is the minimum of its four counters, so it can overcount on collisions but
+// never undercounts. After `10 * width` increments every counter is halved,
+// so the estimate tracks recent popularity rather than all-time totals.
+// Not thread-safe; callers serialize access.
+class FrequencySketch {
+public:
+    // `expected_entries` sizes the table (rounded up to a power of two, at
+    // least 1024 counters per row)
+    explicit FrequencySketch(size_t expected_entries);
+
+    void increment(const std::string& key);
+    uint32_t estimate(const std::string& key) const;
+
+    size_t width() const { return width_; }
+
+private:
+    static constexpr int kDepth = 4;
+    static constexpr uint8_t kMaxCount = 15;
+
+    size_t width_;
+    std::vector<uint8_t> table_;  // kDepth rows of width_ counters
+    size_t additions_ = 0;
+    size_t sample_size_;
+
+    size_t index_of(uint64_t hash, int row) const;
+    void age();
+};
+
+} // namespace fileengine
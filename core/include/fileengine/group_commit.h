@@ -0,0 +1,72 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "types.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fileengine {
+
+// Group commit for local blob writes. Instead of one fsync round-trip per
+// PUT, concurrent writers call commit() after finishing their writes; the
+// first caller becomes the leader and issues a single syncfs(2) on the
+// storage filesystem, which makes every write completed before it started
+// durable. Callers that arrive while a sync is in flight join the next
+// batch, so under load N writers cost roughly one flush per batch rather
+// than N.
+class GroupCommit {
+public:
+    // `path` is any directory on the filesystem to flush (the storage base).
+    explicit GroupCommit(const std::string& path);
+
+    // The instance shared by every caller on the filesystem holding `path`.
+    // syncfs() flushes the whole filesystem, so writers of different
+    // tenants' storages (or the pack store) batch into the same syncs.
+    static std::shared_ptr<GroupCommit> for_filesystem(const std::string& path);
+    ~GroupCommit();
+    GroupCommit(const GroupCommit&) = delete;
+    GroupCommit& operator=(const GroupCommit&) = delete;
+
+    // Blocks until a filesystem sync that started after this call completes.
+    Result<void> commit();
+
+    // Number of syncfs() calls issued so far (batches, not callers).
+    uint64_t sync_count() const;
+
+private:
+    struct FailedBatch {
+        uint64_t first_ticket;
+        uint64_t last_ticket;
+        std::string error;
+    };
+
+    int fd_;
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t next_ticket_ = 0;      // last ticket handed out
+    uint64_t completed_ticket_ = 0; // every ticket <= this has been synced
+    bool syncing_ = false;
+    uint64_t sync_count_ = 0;
+    std::vector<FailedBatch> failed_batches_;  // recent failures, bounded
+};
+
+} // namespace fileengine
@@ -208,6 +208,10 @@ public:
                                    const fileengine_rpc::GetFileRequest* request,
                                    grpc::ServerWriter<fileengine_rpc::GetFileResponse>* writer) override;
 
+    grpc::Status StreamListDirectory(grpc::ServerContext* context,
+                                     const fileengine_rpc::ListDirectoryRequest* request,
+                                     grpc::ServerWriter<fileengine_rpc::ListDirectoryResponse>* writer) override;
+
     // Administrative operations
     grpc::Status GetStorageUsage(grpc::ServerContext* context,
                                 const fileengine_rpc::StorageUsageRequest* request,
@@ -0,0 +1,163 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fileengine {
+
+class IDatabase;
+
+// Counters since construction
+struct MetadataCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t negative_hits = 0;  // lookups answered "no such row" from memory
+    uint64_t invalidations = 0;  // invalidate() calls
+    uint64_t evictions = 0;      // entries dropped to stay within max_entries
+    size_t entries = 0;
+    size_t max_entries = 0;
+};
+
+// Process-wide, bounded cache of FileInfo rows in front of
+// IDatabase::get_file_by_uid / get_file_by_uid_include_deleted
+// (FILEENGINE_METADATA_CACHE_ENTRIES).
+//
+// One request resolves the same rows several times (permission check,
+// ancestor walk, the operation itself, audit and event enrichment), each a
+// Postgres round trip. Both lookups are served from one entry per
+// (tenant, uid): it is filled by the include_deleted query, and the plain
+// lookup hides it when the row is soft-deleted, exactly as the database does.
+//
+// Entries are dropped by invalidate(), which FileSystem calls at every
+// metadata mutation (the same points that emit file events). A row's
+// ancestors are dropped with it, since a folder reports the newest mtime
+// beneath it and a file its rendition count. Should that parent chain not
+// be fully cached, every entry of the tenant is marked stale instead. A fill
+// that raced an invalidate() of its tenant is discarded, so a stale row is
+// never cached. Both counters behind this are kept per tenant (hashed into
+// slots), so one tenant's writes do not flush or stall another's entries.
+//
+// A uid with no row at all is remembered for negative_ttl, so clients
+// probing for files that do not exist are answered without a query. The
+// uid may only appear later through this server creating, restoring or
+// moving it (which invalidates it) or through another writer such as a
+// second server or the object-store import; negative_ttl bounds the latter
+// and is kept short.
+//
+// Writes by other server processes are not seen; the optional TTL bounds
+// how long such a row can be served. Keys are spread over shards by hash,
+// each with its own lock and LRU list.
+class MetadataCache {
+public:
+    static constexpr size_t kDefaultMaxEntries = 100000;
+
+    // ttl of zero keeps entries until they are invalidated or evicted;
+    // negative_ttl of zero does not remember missing rows
+    explicit MetadataCache(size_t max_entries = kDefaultMaxEntries,
+                           std::chrono::milliseconds ttl = std::chrono::milliseconds(0),
+                           size_t shard_count = 16,
+                           std::chrono::milliseconds negative_ttl = std::chrono::milliseconds(0));
+
+    // Read-through equivalents of the IDatabase calls of the same name.
+    // Errors are not cached; missing rows are, for negative_ttl.
+    Result<std::optional<FileInfo>> get_file_by_uid(IDatabase& db, const std::string& uid,
+                                                    const std::string& tenant = "");
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(IDatabase& db, const std::string& uid,
+                                                                    const std::string& tenant = "");
+
+    // Drop `uid` and its cached ancestors after its row changed. `parent_uid`
+    // is the row's parent as the caller knows it (required for a row that
+    // was just created, so not cached yet); its chain is dropped as well.
+    void invalidate(const std::string& tenant, const std::string& uid,
+                    const std::optional<std::string>& parent_uid = std::nullopt);
+
+    // For callers that learn of a missing row from their own query (the
+    // ancestor-chain lookup): true if `uid` is remembered as having no row,
+    // and put_missing() to remember it. Read epoch(tenant) before the query.
+    bool known_missing(const std::string& tenant, const std::string& uid);
+    uint64_t epoch(const std::string& tenant) const;
+    void put_missing(const std::string& tenant, const std::string& uid, uint64_t epoch);
+
+    void clear();
+    MetadataCacheStats get_stats() const;
+
+private:
+    static constexpr size_t kTenantSlots = 64;
+
+    struct Entry {
+        FileInfo info;
+        bool missing;         // no such row; `info` is empty
+        uint64_t generation;  // stale once its tenant's generation moves past it
+        std::chrono::steady_clock::time_point expires;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> map;
+        std::list<std::string> lru;  // front = most recently used
+        size_t max_entries = 0;
+    };
+
+    Result<std::optional<FileInfo>> fetch(IDatabase& db, const std::string& uid,
+                                          const std::string& tenant, bool include_deleted);
+    // Sets `missing` if the key is remembered as having no row
+    std::optional<FileInfo> lookup(const std::string& tenant, const std::string& key, bool& missing);
+    // A nullopt `info` remembers a missing row
+    void insert(const std::string& tenant, const std::string& key, const std::optional<FileInfo>& info,
+                uint64_t epoch);
+    // Removes `key`; if it held a row, stores its parent in `parent_out`
+    bool erase(const std::string& key, std::string& parent_out);
+    // Erases `uid` and its ancestors up to the root; false if a link
+    // other than the root was not cached
+    bool erase_chain(const std::string& tenant, std::string uid);
+    Shard& shard_for(const std::string& key);
+
+    // Invalidation counters of the tenants hashed to one slot
+    struct TenantCounters {
+        std::atomic<uint64_t> epoch{0};       // bumped by every invalidate()
+        std::atomic<uint64_t> generation{0};  // bumped when a chain could not be dropped
+    };
+    TenantCounters& counters_for(const std::string& tenant);
+    const TenantCounters& counters_for(const std::string& tenant) const;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::array<TenantCounters, kTenantSlots> counters_{};
+    const std::chrono::milliseconds ttl_;
+    const std::chrono::milliseconds negative_ttl_;
+    size_t max_entries_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> negative_hits_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace fileengine
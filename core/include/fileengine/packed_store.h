@@ -0,0 +1,161 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "types.h"
+#include "storage.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fileengine {
+
+class GroupCommit;
+
+struct PackedStoreOptions {
+    size_t threshold = 0;                         // blobs smaller than this are packed; 0 = packing off
+    uint64_t segment_size = 64ull * 1024 * 1024;  // start a new segment once the active one reaches this
+    double compact_garbage_ratio = 0.5;           // compact a sealed segment once this share of it is dead
+    int compact_interval_seconds = 600;           // background compaction period; 0 = only via compact()
+};
+
+// Append-only store for small blobs. Instead of one inode per version, blobs
+// under the threshold are appended to large segment files and found through
+// an in-memory index keyed by their (base-relative) version path, so millions
+// of tiny files cost a handful of inodes and directory scans stay short.
+//
+// Segment layout (<dir>/<id:016x>.seg), a sequence of records:
+//   "FEPK" | flags u8 | 0 u8 | key_len u16 | data_len u32 | seq u64 | crc32 u32
+//   | key | data
+// flags bit 0 marks a record dead (deleted or superseded); it is set in place,
+// and for a superseded record only once its replacement has been flushed, so
+// a crash can never leave the flag durable without the copy. The index is
+// rebuilt on open by scanning the records. A record that is not intact (bad
+// magic, short, or failing its CRC) ends the newest segment like any torn
+// tail; segments before it were flushed when sealed, so there a corrupt
+// record is logged and skipped, and an unparseable tail is kept on disk and
+// never compacted. When
+// a key occurs more than once (a crash between writing a copy and retiring
+// the original, or a compaction cut short) the highest seq wins. The data CRC
+// is also checked on every read.
+//
+// Writes go to the one active segment and are flushed per the sync mode
+// before put() returns. A delete sets the record's dead flag and flushes it
+// before returning; on open a dead record also retires every older copy of
+// its key, whatever that copy's own flag says. compact() copies the
+// live records of mostly-dead sealed segments into the active one and
+// unlinks them, and runs periodically on a background thread.
+//
+// One instance serves a directory per process: every Storage over the same
+// base path shares it through open().
+class PackedStore {
+public:
+    struct Stats {
+        size_t segments = 0;
+        size_t blobs = 0;
+        uint64_t live_bytes = 0;  // record bytes still referenced by the index
+        uint64_t dead_bytes = 0;  // record bytes awaiting compaction
+    };
+
+    // Open (creating if needed) the store in `dir`, or return the instance
+    // already open for it; `options` and `sync_mode` apply on first open only.
+    static Result<std::shared_ptr<PackedStore>> open(const std::string& dir, const PackedStoreOptions& options,
+                                                      StorageSyncMode sync_mode);
+    ~PackedStore();
+    PackedStore(const PackedStore&) = delete;
+    PackedStore& operator=(const PackedStore&) = delete;
+
+    size_t threshold() const { return options_.threshold; }
+    // True when a blob of `size` bytes belongs in the store
+    bool accepts(size_t size) const { return size < options_.threshold; }
+
+    // Store `data` under `key`, replacing any previous blob for it.
+    Result<void> put(const std::string& key, const uint8_t* data, size_t size);
+    bool contains(const std::string& key) const;
+    Result<uint64_t> size(const std::string& key) const;
+    // Up to `length` bytes from `offset`; fewer only at the end of the blob.
+    Result<std::vector<uint8_t>> read(const std::string& key, uint64_t offset = 0,
+                                      size_t length = SIZE_MAX) const;
+    // False when the key was not stored here.
+    bool remove(const std::string& key);
+    // Remove every key starting with `prefix`; returns how many.
+    size_t remove_prefix(const std::string& prefix);
+    std::vector<std::string> list(const std::string& prefix = "") const;
+
+    // Rewrite sealed segments whose dead share reaches the garbage ratio
+    // (`force`: any dead bytes at all); returns how many segments were freed.
+    Result<size_t> compact(bool force = false);
+
+    Stats stats() const;
+
+private:
+    struct Segment;
+    struct Location {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset;     // record start
+        uint32_t key_len;
+        uint32_t data_len;
+        uint64_t seq;
+    };
+
+    PackedStore(const std::string& dir, const PackedStoreOptions& options, StorageSyncMode sync_mode);
+    Result<void> load();
+    Result<std::shared_ptr<Segment>> start_segment_locked();
+    // Append a record for `key` to the active segment (unflushed) and point
+    // the index at it. Returns the record it replaced, which the caller
+    // retires once the new one is flushed. Caller holds write_mutex_.
+    Result<std::optional<Location>> append_locked(const std::string& key, const uint8_t* data, size_t size);
+    // Count a record as dead; with `persist`, also set its dead flag on disk
+    // (unflushed; see flush_dead_flags).
+    void mark_dead_locked(const Location& loc, bool persist = true);
+    // Make every dead flag written so far durable.
+    Result<void> flush_dead_flags();
+    Result<void> flush(int fd);
+    Result<void> sync_dir();
+    void compactor_loop();
+
+    std::string dir_;
+    PackedStoreOptions options_;
+    StorageSyncMode sync_mode_;
+    std::shared_ptr<GroupCommit> group_commit_;  // set in Group mode; shared per filesystem
+
+    // Mutators (put/remove/compact) serialize on write_mutex_; readers only
+    // take index_mutex_ shared, and writers take it exclusively to publish.
+    mutable std::mutex write_mutex_;
+    mutable std::shared_mutex index_mutex_;
+    std::unordered_map<std::string, Location> index_;
+    std::map<uint64_t, std::shared_ptr<Segment>> segments_;
+    std::shared_ptr<Segment> active_;
+    uint64_t next_segment_id_ = 1;
+    uint64_t next_seq_ = 1;
+
+    std::mutex compactor_mutex_;
+    std::condition_variable compactor_cv_;
+    bool stopping_ = false;
+    std::thread compactor_;
+};
+
+} // namespace fileengine
@@ -32,6 +32,9 @@ namespace fileengine {
 
 class CacheManager;
 class FileCuller;
+class MetadataCache;
+class AclCache;
+class RoleCache;
 
 // Embedded HTTP monitoring listener for the fileengine server.
 //
@@ -59,6 +62,12 @@ public:
     // bound address. (Security review L2.)
     void set_allowed_ips(std::vector<std::string> ips);
 
+    // Optional FileInfo, ACL and role caches whose counters /v1/status reports.
+    // Call before start(); nullptr (the default) omits the section.
+    void set_metadata_cache(MetadataCache* metadata_cache) { metadata_cache_ = metadata_cache; }
+    void set_acl_cache(AclCache* acl_cache) { acl_cache_ = acl_cache; }
+    void set_role_cache(RoleCache* role_cache) { role_cache_ = role_cache; }
+
     // Start the listener on the given address/port. Returns false on bind
     // failure so the caller (server.cpp) can choose to fail the boot.
     // Non-blocking: the listener runs on a dedicated thread.
@@ -73,6 +82,9 @@ private:
 
     std::shared_ptr<IDatabase> db_;
     CacheManager* cache_manager_;
+    MetadataCache* metadata_cache_ = nullptr;
+    AclCache* acl_cache_ = nullptr;
+    RoleCache* role_cache_ = nullptr;
     FileCuller* file_culler_;
 
     std::unique_ptr<httplib::Server> http_;
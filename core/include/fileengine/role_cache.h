@@ -0,0 +1,104 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fileengine {
+
+// Counters since construction
+struct RoleCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t max_entries = 0;
+};
+
+// Process-wide cache of the roles stored in the database for each user, as
+// returned by IDatabase::get_roles_for_user (FILEENGINE_ROLE_CACHE_ENTRIES).
+// AclManager consults it before every role lookup; the request-supplied
+// roles it unions in are never cached here.
+//
+// RoleManager drops a user's entry after assigning or removing one of their
+// roles, and every entry of the tenant after deleting a role. A fill that
+// read the database before such a change is discarded (see epoch()), so a
+// removed role is never served once the change has returned. Changes made by
+// other server processes, or directly in the database, are bounded by the
+// TTL.
+class RoleCache {
+public:
+    static constexpr size_t kDefaultMaxEntries = 100000;
+
+    // ttl of zero keeps entries until they are invalidated or evicted
+    explicit RoleCache(size_t max_entries = kDefaultMaxEntries,
+                       std::chrono::milliseconds ttl = std::chrono::milliseconds(0),
+                       size_t shard_count = 16);
+
+    // Read before querying the database; pass it to put()
+    uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+    std::optional<std::vector<std::string>> get(const std::string& tenant, const std::string& user);
+    void put(const std::string& tenant, const std::string& user,
+             const std::vector<std::string>& roles, uint64_t epoch);
+
+    // Drop one user's roles
+    void invalidate(const std::string& tenant, const std::string& user);
+    // Drop every user of `tenant`, e.g. after a role was deleted
+    void invalidate_tenant(const std::string& tenant);
+
+    RoleCacheStats get_stats() const;
+
+private:
+    struct Entry {
+        std::vector<std::string> roles;
+        std::chrono::steady_clock::time_point expires;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> map;
+        std::list<std::string> lru;  // front = most recently used
+        size_t max_entries = 0;
+    };
+
+    Shard& shard_for(const std::string& key);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    const std::chrono::milliseconds ttl_;
+    size_t max_entries_;
+    // Bumped by every invalidation, before the entry is dropped
+    std::atomic<uint64_t> epoch_{0};
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace fileengine
@@ -23,10 +23,13 @@
 namespace fileengine {
 
 class IDatabase;
+class RoleCache;
 
 class RoleManager {
 public:
-    RoleManager(std::shared_ptr<IDatabase> db);
+    // role_cache, if set, must be the AclManager's (AclManager::role_cache());
+    // membership changes made here drop the affected entries from it.
+    RoleManager(std::shared_ptr<IDatabase> db, std::shared_ptr<RoleCache> role_cache = nullptr);
 
     // Assign a user to a role
     Result<void> assign_user_to_role(const std::string& user, const std::string& role, 
@@ -55,6 +58,7 @@ public:
 
 private:
     std::shared_ptr<IDatabase> db_;
+    std::shared_ptr<RoleCache> role_cache_;  // optional
 };
 
 } // namespace fileengine
\ No newline at end of file
@@ -70,6 +70,11 @@ public:
     Result<std::string> store_file_from_path(const std::string& virtual_path, const std::string& version_timestamp,
                                              const std::string& local_path, const std::string& tenant = "") override;
     Result<std::vector<uint8_t>> read_file(const std::string& storage_path, const std::string& tenant = "") override;
+    // Ranged GET / HEAD, so byte-range reads of cold files fetch only the
+    // bytes they need.
+    Result<std::vector<uint8_t>> read_file_range(const std::string& storage_path, uint64_t offset,
+                                                 size_t length, const std::string& tenant = "") override;
+    Result<uint64_t> get_file_size(const std::string& storage_path, const std::string& tenant = "") override;
     Result<void> delete_file(const std::string& storage_path, const std::string& tenant = "") override;
     Result<bool> file_exists(const std::string& storage_path, const std::string& tenant = "") override;
 
@@ -0,0 +1,99 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "types.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fileengine {
+
+// Duplicate-call suppression. Concurrent run() calls with the same key
+// execute `fn` once: the first caller (the leader) runs it, and callers that
+// arrive while it is in flight block and receive a copy of the leader's
+// result. The key is forgotten as soon as the call finishes, so a later
+// run() executes `fn` again; this coalesces concurrent work, it does not
+// cache results. Used to turn N simultaneous cold reads of one file version
+// into one object-store fetch.
+template <typename T>
+class SingleFlight {
+public:
+    Result<T> run(const std::string& key, const std::function<Result<T>()>& fn) {
+        std::shared_ptr<Call> call;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = calls_.find(key);
+            if (it != calls_.end()) {
+                call = it->second;
+            } else {
+                call = std::make_shared<Call>();
+                calls_.emplace(key, call);
+                leader = true;
+            }
+        }
+
+        if (!leader) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(call->mutex);
+            call->cv.wait(lock, [&] { return call->done; });
+            return call->result;
+        }
+
+        Result<T> result = Result<T>::err("single-flight call did not complete");
+        try {
+            result = fn();
+        } catch (const std::exception& e) {
+            result = Result<T>::err(e.what());
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            calls_.erase(key);
+        }
+        {
+            std::lock_guard<std::mutex> lock(call->mutex);
+            call->result = result;
+            call->done = true;
+        }
+        call->cv.notify_all();
+        return result;
+    }
+
+    // Callers that waited on another caller's run() instead of running `fn`
+    uint64_t coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+
+private:
+    struct Call {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        Result<T> result = Result<T>::err("");
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Call>> calls_;
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+} // namespace fileengine
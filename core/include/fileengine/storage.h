@@ -19,23 +19,63 @@
 #include "IStorage.h"
 #include <string>
 #include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 
 namespace fileengine {
 
 class IObjectStore;
+class GroupCommit;
+class PackedStore;
+struct PackedStoreOptions;
+
+// How a finished blob write is made durable before store_file returns.
+//   None  - rename into place only (page cache; a crash can lose recent writes)
+//   Fsync - fdatasync the file, rename, fsync the directory (per write)
+//   Group - same ordering, but the flushes are syncfs(2) group commits shared
+//           by all concurrent writers (see GroupCommit)
+enum class StorageSyncMode { None, Fsync, Group };
 
 class Storage : public IStorage {
 public:
-    Storage(const std::string& base_path, bool encrypt_data = false, bool compress_data = false);
+    // `deduplicate` selects the content-addressed layout: every version path is
+    // a hard link to a blob under <base>/<tenant>/.blobs named by its content
+    // key, and the blob's link count is its reference count.
+    Storage(const std::string& base_path, bool encrypt_data = false, bool compress_data = false,
+            bool deduplicate = false, StorageSyncMode sync_mode = StorageSyncMode::None);
+
+    // "none" | "fsync" | "group" (FILEENGINE_STORAGE_SYNC); anything else is
+    // logged as a warning and treated as Group, the safe default.
+    static StorageSyncMode parse_sync_mode(const std::string& mode);
     ~Storage();
 
+    // Keep blobs under `options.threshold` bytes in append-only segment files
+    // under <base>/.packs instead of one file each (see PackedStore). Version
+    // paths are unchanged and every method below resolves them in the packs
+    // first, so callers cannot tell the layouts apart. Larger blobs keep the
+    // file-per-version layout.
+    Result<void> enable_packing(const PackedStoreOptions& options);
+    PackedStore* packed_store() const { return packed_.get(); }
+
     // File storage operations (automatically compress and encrypt)
     Result<std::string> store_file(const std::string& uid, const std::string& version_timestamp,
                                    const std::vector<uint8_t>& data, const std::string& tenant = "") override;
     Result<std::vector<uint8_t>> read_file(const std::string& storage_path, const std::string& tenant = "") override;
+    Result<void> read_file_chunks(const std::string& storage_path,
+                                  const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                  const std::string& tenant = "") override;
+    Result<uint64_t> get_file_size(const std::string& storage_path, const std::string& tenant = "") override;
+    Result<std::vector<uint8_t>> read_file_range(const std::string& storage_path, uint64_t offset,
+                                                 size_t length, const std::string& tenant = "") override;
     Result<void> delete_file(const std::string& storage_path, const std::string& tenant = "") override;
+    // Shares the source's deduplicated blob when there is one, otherwise
+    // clones it with FICLONE (XFS, btrfs) or copy_file_range(2); plain
+    // read/write only where neither is supported.
+    Result<std::string> copy_file(const std::string& src_storage_path, const std::string& uid,
+                                  const std::string& version_timestamp, const std::string& tenant = "") override;
     Result<bool> file_exists(const std::string& storage_path, const std::string& tenant = "") override;
 
     // Get storage path for a file by UUID and timestamp
@@ -63,18 +103,114 @@ public:
     // Storage clearing operation
     Result<void> clear_storage(const std::string& tenant = "") override;
 
+    // Staged writes (put_stream)
+    std::string make_staging_path(const std::string& storage_path) override;
+    Result<void> publish_staged_file(const std::string& staged_path, const std::string& storage_path) override;
+
+    // Remove temp and staging files (".<name>.tmp<n>") that a crash or a
+    // killed upload left beside their targets, if not modified for `min_age`;
+    // younger ones may belong to a write still in progress. Run at startup.
+    // Returns how many were removed.
+    Result<size_t> sweep_temp_files(std::chrono::seconds min_age = kTempFileMaxAge);
+    static constexpr std::chrono::seconds kTempFileMaxAge{24 * 60 * 60};
+
+    // Content-addressed deduplication
+    bool is_deduplication_enabled() const override;
+    Result<std::string> store_file_deduplicated(const std::string& uid, const std::string& version_timestamp,
+                                                const std::vector<uint8_t>& data, const std::string& content_key,
+                                                const std::string& tenant = "") override;
+    Result<void> deduplicate_file(const std::string& storage_path, const std::string& content_key,
+                                  const std::string& tenant = "") override;
+    Result<size_t> collect_unreferenced_blobs(const std::string& tenant = "") override;
+
+    // Directory (directly under the base/tenant dir) holding deduplicated blobs
+    static constexpr const char* kBlobDirName = ".blobs";
+
+    // Directory (directly under the base dir) holding packed small blobs
+    static constexpr const char* kPackDirName = ".packs";
+
+    // Chunk size used by read_file_chunks
+    static constexpr size_t kReadChunkSize = 256 * 1024;
+
+protected:
+    // True when `storage_path` is held in the packed store
+    bool is_packed(const std::string& storage_path) const;
+
 private:
     std::string base_path_;
     bool encrypt_data_;
     bool compress_data_;
-    mutable std::mutex storage_mutex_;
+    bool deduplicate_;
+    StorageSyncMode sync_mode_;
+    std::shared_ptr<GroupCommit> group_commit_;  // set in Group mode; shared per filesystem
     IObjectStore* object_store_;
+    std::shared_ptr<PackedStore> packed_;  // set by enable_packing
+
+    // Writers share no lock: every version is written to a private temp file
+    // in its own directory and renamed into place, so concurrent PUTs (any
+    // tenant, any uid) proceed in parallel. Only blob-store link/unlink
+    // decisions for one content key must be serialized; those take a lock
+    // from a fixed stripe chosen by the key.
+    static constexpr size_t kBlobLockStripes = 64;
+    mutable std::array<std::mutex, kBlobLockStripes> blob_locks_;
+    std::atomic<uint64_t> temp_seq_{0};
 
     // Helper to create SHA256-based directory structure (desaturation)
     std::string get_sha256_desaturated_path(const std::string& uid) const;
     
     // Helper to ensure directory exists
     Result<void> ensure_directory_exists(const std::string& dir_path);
+
+    // Hidden (dot-prefixed, so never listed as a version) unique sibling of
+    // `full_path` for staging a write or link before the atomic rename.
+    std::string make_temp_path(const std::string& full_path);
+
+    // Write `data` to a temp file next to `full_path` and publish it; readers
+    // see either the previous file or the complete new one.
+    Result<void> write_file_atomic(const std::string& full_path, const std::vector<uint8_t>& data);
+
+    // Fill `dst_fd` with the contents of `src_fd` (`size` bytes), in the
+    // kernel where the filesystem allows it.
+    Result<void> clone_file_contents(int src_fd, int dst_fd, uint64_t size, const std::string& what);
+
+    // Rename a fully written temp file to `full_path`, flushing per sync_mode_
+    // so the data is durable before the name and the name before returning
+    // (in Group mode the file is fdatasync'd and the rename goes in one group
+    // commit).
+    // `fd` may be an open descriptor of `temp_path` (else it is opened if needed).
+    Result<void> publish_file(const std::string& temp_path, const std::string& full_path, int fd = -1);
+
+    // Key of `storage_path` in the packed store (path relative to the base),
+    // or "" when packing is off or the path is outside the base.
+    std::string pack_key(const std::string& storage_path) const;
+
+    // Pack `data` as `full_path` when it is under the threshold, replacing
+    // any file of its own; false when it belongs in a file instead.
+    Result<bool> store_packed(const std::string& full_path, const uint8_t* data, size_t size);
+
+    // Forget any packed copy of `full_path` once a file of its own took over
+    void drop_packed(const std::string& full_path);
+
+    // delete_file() for the file-per-version layout
+    Result<void> delete_local_file(const std::string& storage_path);
+
+    // Flush a rename/link in `dir_path` per sync_mode_
+    Result<void> sync_directory(const std::string& dir_path);
+
+    // <base>/[<tenant>/].blobs/<k0k1>/<k2k3>/<content_key>
+    std::string get_blob_path(const std::string& content_key, const std::string& tenant) const;
+
+    // Stripe lock guarding link/unlink decisions for one content key
+    std::mutex& blob_lock_for(const std::string& content_key) const;
+
+    // Atomically replace `full_path` with a hard link to `blob_path`
+    Result<void> replace_with_link(const std::string& blob_path, const std::string& full_path);
+
+    // Make `full_path` a link of the blob for `content_key`: adopt the file as
+    // the blob if none exists yet, otherwise swap it for a link to the existing
+    // blob. Caller holds blob_lock_for(content_key).
+    Result<void> link_into_blob_store_locked(const std::string& full_path, const std::string& content_key,
+                                             const std::string& tenant);
 };
 
 } // namespace fileengine
\ No newline at end of file
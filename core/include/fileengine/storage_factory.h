@@ -0,0 +1,36 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "storage.h"
+#include "packed_store.h"
+
+#include <memory>
+#include <string>
+
+namespace fileengine {
+
+// Build the local blob store for the configured I/O backend
+// (FILEENGINE_STORAGE_IO): "uring" returns a UringStorage when core was built
+// with io_uring support (FILEENGINE_ENABLE_IO_URING) and the kernel allows
+// it, otherwise - and for "posix" - the blocking Storage. A non-zero
+// `packing.threshold` turns on small-blob packing (FILEENGINE_STORAGE_PACK_KB).
+std::unique_ptr<Storage> make_local_storage(const std::string& base_path, bool encrypt_data, bool compress_data,
+                                            bool deduplicate, StorageSyncMode sync_mode,
+                                            const std::string& io_backend,
+                                            const PackedStoreOptions& packing = PackedStoreOptions());
+
+} // namespace fileengine
@@ -19,6 +19,7 @@
 #include "IDatabase.h"
 #include "IStorage.h"
 #include "IObjectStore.h"
+#include "codec.h"
 #include <map>
 #include <memory>
 #include <mutex>
@@ -42,6 +43,14 @@ struct TenantConfig {
     bool encrypt_data;
     bool compress_data;
     std::string encryption_key;  // Added for encryption support
+    bool storage_deduplicate = false;  // content-addressed blob layout (Storage)
+    std::string storage_sync_mode = "group";  // none | fsync | group (Storage)
+    std::string storage_io_backend = "posix";  // posix | uring (make_local_storage)
+    size_t storage_frame_size = 256 * 1024;   // blob frame size in bytes; 0 = legacy format
+    int storage_encode_threads = 0;  // frame encode pool size (FileSystem); 0 = per CPU, 1 = serial
+    std::string storage_codec = "zlib";  // frame codec when compress_data: "zlib|zstd|lz4[:level]"
+    size_t storage_pack_threshold = 0;   // pack stored blobs below this many bytes (Storage); 0 = off
+    int storage_pack_compact_seconds = 600;  // pack compaction period
 };
 
 struct TenantContext {
@@ -50,6 +59,9 @@ struct TenantContext {
     std::unique_ptr<IObjectStore> object_store;
     class StorageTracker* storage_tracker;  // Pointer to shared storage tracker
     TenantConfig config;  // Added to store tenant-specific configuration including encryption key
+    // Frame codec resolved from config.storage_codec (zlib if that is not
+    // usable); nullptr when compress_data is off.
+    std::shared_ptr<const Codec> codec;
 };
 
 class TenantManager {
@@ -19,9 +19,15 @@
 #include <vector>
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <utility>
 
 namespace fileengine {
 
+// Immutable, reference-counted file content. Cache hits and whole-file reads
+// share one buffer between the cache and every reader instead of copying it.
+using SharedBlob = std::shared_ptr<const std::vector<uint8_t>>;
+
 // File types
 enum class FileType {
     REGULAR_FILE,
@@ -76,6 +82,10 @@ struct Result {
         return Result<T>{true, val, ""};
     }
 
+    static Result<T> ok(T&& val) {
+        return Result<T>{true, std::move(val), ""};
+    }
+
     static Result<T> err(const std::string& error_msg) {
         return Result<T>{false, T{}, error_msg};
     }
@@ -0,0 +1,66 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "storage.h"
+#include <functional>
+#include <memory>
+
+namespace fileengine {
+
+struct UringStorageOptions {
+    unsigned queue_depth = 256;       // SQ entries; bounds I/Os in flight per ring
+    size_t buffer_count = 64;         // registered buffers shared by streamed reads
+    size_t buffer_size = 256 * 1024;  // bytes per buffer, also the read chunk size
+    size_t read_ahead = 4;            // chunks kept in flight per streamed read
+};
+
+// Storage whose reads go through io_uring instead of blocking ifstream calls.
+// read_file() splits a blob into chunk reads and submits them in one batch;
+// read_file_chunks() keeps `read_ahead` chunks in flight, so a GET overlaps
+// disk latency with the decrypt/decompress/send work of the previous chunk.
+// Those reads use pre-registered buffers (IORING_OP_READ_FIXED) when the
+// shared pool has one free and per-read heap buffers otherwise; a pool
+// buffer is never waited for, and is handed to the chunk callback in place
+// and returned right after it. Storages with the same options share one
+// ring and one pool, trimmed to fit RLIMIT_MEMLOCK. One reaper thread
+// drains completions and wakes the waiting caller.
+//
+// Layout, writes, deduplication and durability are inherited from Storage.
+// When the ring cannot be set up (old kernel, io_uring disabled by sysctl
+// or seccomp) every read falls back to the Storage implementation.
+class UringStorage : public Storage {
+public:
+    UringStorage(const std::string& base_path, bool encrypt_data, bool compress_data, bool deduplicate,
+                 StorageSyncMode sync_mode, const UringStorageOptions& options = UringStorageOptions());
+    ~UringStorage() override;
+
+    // False when io_uring is unavailable and reads use the blocking path
+    bool is_active() const { return ring_ != nullptr; }
+
+    Result<std::vector<uint8_t>> read_file(const std::string& storage_path, const std::string& tenant = "") override;
+    Result<void> read_file_chunks(const std::string& storage_path,
+                                  const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                  const std::string& tenant = "") override;
+
+private:
+    class Ring;
+
+    UringStorageOptions options_;
+    std::shared_ptr<Ring> ring_;
+};
+
+} // namespace fileengine
@@ -0,0 +1,184 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/acl_cache.h"
+#include <algorithm>
+#include <functional>
+
+namespace fileengine {
+
+namespace {
+std::string rules_key(const std::string& tenant, const std::string& resource_uid) {
+    return "r" + tenant + '\0' + resource_uid;
+}
+
+std::string permissions_key(const std::string& tenant, const std::string& resource_uid,
+                            const std::string& principal_key) {
+    return "p" + tenant + '\0' + resource_uid + '\0' + principal_key;
+}
+} // namespace
+
+AclCache::AclCache(size_t max_entries, std::chrono::milliseconds ttl, size_t shard_count)
+    : ttl_(ttl), max_entries_(max_entries) {
+    const size_t count = std::max<size_t>(1, std::min(shard_count, max_entries));
+    shards_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->max_entries = std::max<size_t>(1, max_entries / count);
+    }
+}
+
+AclCache::Shard& AclCache::shard_for(const std::string& key) {
+    size_t h = std::hash<std::string>{}(key);
+    h ^= h >> 32;
+    return *shards_[h % shards_.size()];
+}
+
+std::atomic<uint64_t>& AclCache::generation_for(const std::string& tenant) {
+    return generations_[std::hash<std::string>{}(tenant) % kGenerations];
+}
+
+const std::atomic<uint64_t>& AclCache::generation_for(const std::string& tenant) const {
+    return generations_[std::hash<std::string>{}(tenant) % kGenerations];
+}
+
+uint64_t AclCache::generation(const std::string& tenant) const {
+    return generation_for(tenant).load(std::memory_order_acquire);
+}
+
+void AclCache::invalidate(const std::string& tenant) {
+    generation_for(tenant).fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string AclCache::principal_key(const std::string& user, std::vector<std::string> roles,
+                                    const std::map<std::string, std::string>& claims) {
+    std::sort(roles.begin(), roles.end());
+    std::string key = user;
+    key += '\x1e';
+    for (const auto& role : roles) {
+        key += role;
+        key += '\x1f';
+    }
+    key += '\x1e';
+    for (const auto& [name, value] : claims) {
+        key += name;
+        key += '=';
+        key += value;
+        key += '\x1f';
+    }
+    return key;
+}
+
+AclCache::Entry* AclCache::find_locked(Shard& shard, const std::string& key, const std::string& tenant) {
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+        return nullptr;
+    }
+    Entry& entry = it->second;
+    if (entry.generation != generation(tenant) || std::chrono::steady_clock::now() >= entry.expires) {
+        shard.lru.erase(entry.lru_it);
+        shard.map.erase(it);
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_it);
+    return &entry;
+}
+
+AclCache::Entry* AclCache::insert_locked(Shard& shard, const std::string& key, uint64_t generation) {
+    const auto expires = ttl_.count() > 0 ? std::chrono::steady_clock::now() + ttl_
+                                          : std::chrono::steady_clock::time_point::max();
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+    } else {
+        while (shard.map.size() >= shard.max_entries && !shard.lru.empty()) {
+            shard.map.erase(shard.lru.back());
+            shard.lru.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.lru.push_front(key);
+        it = shard.map.emplace(key, Entry{}).first;
+        it->second.lru_it = shard.lru.begin();
+    }
+    it->second.generation = generation;
+    it->second.expires = expires;
+    return &it->second;
+}
+
+std::optional<std::vector<ACLRule>> AclCache::get_rules(const std::string& tenant, const std::string& resource_uid) {
+    const std::string key = rules_key(tenant, resource_uid);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (Entry* entry = find_locked(shard, key, tenant)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return entry->rules;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+void AclCache::put_rules(const std::string& tenant, const std::string& resource_uid,
+                         const std::vector<ACLRule>& rules, uint64_t generation) {
+    const std::string key = rules_key(tenant, resource_uid);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Filled from a read that may predate a change: would never be served
+    if (generation != this->generation(tenant)) {
+        return;
+    }
+    insert_locked(shard, key, generation)->rules = rules;
+}
+
+std::optional<CachedPermissions> AclCache::get_permissions(const std::string& tenant, const std::string& resource_uid,
+                                                          const std::string& principal_key) {
+    const std::string key = permissions_key(tenant, resource_uid, principal_key);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (Entry* entry = find_locked(shard, key, tenant)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return entry->permissions;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+void AclCache::put_permissions(const std::string& tenant, const std::string& resource_uid,
+                               const std::string& principal_key, CachedPermissions permissions,
+                               uint64_t generation) {
+    const std::string key = permissions_key(tenant, resource_uid, principal_key);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (generation != this->generation(tenant)) {
+        return;
+    }
+    insert_locked(shard, key, generation)->permissions = permissions;
+}
+
+AclCacheStats AclCache::get_stats() const {
+    AclCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.max_entries = max_entries_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->map.size();
+    }
+    return stats;
+}
+
+} // namespace fileengine
@@ -15,6 +15,9 @@
 
 #include "fileengine/acl_manager.h"
 #include "fileengine/IDatabase.h"
+#include "fileengine/acl_cache.h"
+#include "fileengine/metadata_cache.h"
+#include "fileengine/role_cache.h"
 #include <algorithm>
 #include <map>
 #include <optional>
@@ -32,11 +35,44 @@ namespace {
 // an optional so the cache only exists inside an explicit CacheScope and
 // outside scopes get_acls_for_resource hits the DB as before.
 thread_local std::optional<std::map<std::string, std::vector<ACLRule>>> tls_acl_cache;
+// Same lifetime: each user's DB-stored roles, keyed tenant::user, so one
+// request resolves them once however many checks it makes.
+thread_local std::optional<std::map<std::string, std::vector<std::string>>> tls_role_memo;
 }
 
 AclManager::AclManager(std::shared_ptr<IDatabase> db) : db_(db) {
 }
 
+namespace {
+std::vector<ACLRule> to_acl_rules(const std::string& resource_uid,
+                                  const std::vector<IDatabase::AclEntry>& entries) {
+    std::vector<ACLRule> acls;
+    acls.reserve(entries.size());
+    for (const auto& db_acl : entries) {
+        ACLRule rule;
+        rule.resource_uid = resource_uid;
+        rule.principal = db_acl.principal;
+        rule.type = static_cast<PrincipalType>(db_acl.type);
+        rule.permissions = db_acl.permissions;
+        rule.effect = static_cast<AclEffect>(db_acl.effect);
+        acls.push_back(rule);
+    }
+    return acls;
+}
+
+// A materialized path is only used if every link agrees with parent_uid and
+// the top link really is top-level. A path left stale by an older core (or
+// any other writer that did not maintain it) fails this and is walked instead.
+bool chain_is_consistent(const std::vector<IDatabase::AncestorEntry>& chain) {
+    for (size_t i = 0; i + 1 < chain.size(); ++i) {
+        if (chain[i].parent_uid != chain[i + 1].uid) {
+            return false;
+        }
+    }
+    return chain.empty() || chain.back().parent_uid.empty() || !chain.back().parent_exists;
+}
+} // namespace
+
 // Reentrance counter so nested CacheScope objects don't clobber each other.
 // The outermost scope owns the cache; nested ones are no-ops. This lets a
 // gRPC handler open a scope and the FileSystem methods it calls open scopes
@@ -48,6 +84,7 @@ thread_local int tls_cache_scope_depth = 0;
 void AclManager::enter_cache_scope() {
     if (tls_cache_scope_depth == 0) {
         tls_acl_cache.emplace();
+        tls_role_memo.emplace();
     }
     ++tls_cache_scope_depth;
 }
@@ -56,6 +93,7 @@ void AclManager::exit_cache_scope() {
     --tls_cache_scope_depth;
     if (tls_cache_scope_depth == 0) {
         tls_acl_cache.reset();
+        tls_role_memo.reset();
     }
 }
 
@@ -91,8 +129,10 @@ Result<void> AclManager::grant_permission(const std::string& resource_uid,
     auto result = db_->add_acl(resource_uid, principal, static_cast<int>(type), permissions,
                                tenant, performed_by, static_cast<int>(effect));
     // Invalidate any cached read of this resource's ACLs so subsequent checks
-    // in the same scope see the new grant.
+    // in the same scope see the new grant. The shared cache is retired for
+    // the whole tenant: the grant also decides reachability of descendants.
     invalidate_cache_entry(resource_uid, tenant);
+    invalidate_cached_permissions(tenant);
     return result;
 }
 
@@ -108,9 +148,16 @@ Result<void> AclManager::revoke_permission(const std::string& resource_uid,
     auto result = db_->remove_acl(resource_uid, principal, static_cast<int>(type), permissions,
                                   tenant, performed_by, static_cast<int>(effect));
     invalidate_cache_entry(resource_uid, tenant);
+    invalidate_cached_permissions(tenant);
     return result;
 }
 
+void AclManager::invalidate_cached_permissions(const std::string& tenant) {
+    if (acl_cache_) {
+        acl_cache_->invalidate(tenant);
+    }
+}
+
 Result<bool> AclManager::check_permission(const std::string& resource_uid,
                                           const std::string& user,
                                           const std::vector<std::string>& roles,
@@ -129,6 +176,15 @@ Result<bool> AclManager::check_permission(const std::string& resource_uid,
         return Result<bool>::ok(true);
     }
 
+    if (acl_cache_) {
+        auto decision = decide(resource_uid, user, effective_roles, claims, tenant);
+        if (!decision.success) {
+            return Result<bool>::err(decision.error);
+        }
+        return Result<bool>::ok((decision.value.permissions & required_permissions) == required_permissions &&
+                                decision.value.reachable);
+    }
+
     auto acls_result = get_acls_for_resource(resource_uid, tenant);
     if (!acls_result.success) {
         return Result<bool>::err(acls_result.error);
@@ -150,6 +206,34 @@ Result<bool> AclManager::check_permission(const std::string& resource_uid,
     return Result<bool>::ok(true);
 }
 
+Result<CachedPermissions> AclManager::decide(const std::string& resource_uid,
+                                             const std::string& user,
+                                             const std::vector<std::string>& roles,
+                                             const std::map<std::string, std::string>& claims,
+                                             const std::string& tenant) {
+    const std::string principal = AclCache::principal_key(user, roles, claims);
+    if (auto hit = acl_cache_->get_permissions(tenant, resource_uid, principal)) {
+        return Result<CachedPermissions>::ok(*hit);
+    }
+    const uint64_t generation = acl_cache_->generation(tenant);
+
+    auto acls_result = get_acls_for_resource(resource_uid, tenant);
+    if (!acls_result.success) {
+        return Result<CachedPermissions>::err(acls_result.error);
+    }
+
+    // Unlike the uncached checks, always walk the ancestors: the decision is
+    // reused for any required bits
+    CachedPermissions decision;
+    decision.permissions = calculate_effective_permissions(acls_result.value, user, roles, claims);
+    bool failed = false;
+    decision.reachable = ancestors_readable(resource_uid, user, roles, claims, tenant, &failed);
+    if (!failed) {
+        acl_cache_->put_permissions(tenant, resource_uid, principal, decision, generation);
+    }
+    return Result<CachedPermissions>::ok(decision);
+}
+
 bool AclManager::is_system_admin(const std::string& user,
                                  const std::vector<std::string>& request_roles,
                                  const std::string& tenant) {
@@ -183,24 +267,27 @@ Result<std::vector<ACLRule>> AclManager::get_acls_for_resource(const std::string
         return Result<std::vector<ACLRule>>::ok(cached);
     }
 
+    // Then the shared cache, which other requests may have filled
+    uint64_t generation = 0;
+    if (acl_cache_) {
+        if (auto shared = acl_cache_->get_rules(tenant, resource_uid)) {
+            put_cached_acls(cache_key, *shared);
+            return Result<std::vector<ACLRule>>::ok(std::move(*shared));
+        }
+        generation = acl_cache_->generation(tenant);
+    }
+
     auto acl_result = db_->get_acls_for_resource(resource_uid, tenant);
     if (!acl_result.success) {
         return Result<std::vector<ACLRule>>::err(acl_result.error);
     }
 
-    std::vector<ACLRule> acls;
-    for (const auto& db_acl : acl_result.value) {
-        ACLRule rule;
-        rule.resource_uid = resource_uid;
-        rule.principal = db_acl.principal;
-        rule.type = static_cast<PrincipalType>(db_acl.type);
-        rule.permissions = db_acl.permissions;
-        rule.effect = static_cast<AclEffect>(db_acl.effect);
-
-        acls.push_back(rule);
-    }
+    std::vector<ACLRule> acls = to_acl_rules(resource_uid, acl_result.value);
 
     put_cached_acls(cache_key, acls);
+    if (acl_cache_) {
+        acl_cache_->put_rules(tenant, resource_uid, acls, generation);
+    }
     return Result<std::vector<ACLRule>>::ok(acls);
 }
 
@@ -220,6 +307,14 @@ Result<int> AclManager::get_effective_permissions(const std::string& resource_ui
         return Result<int>::ok(kAllPermissions);
     }
 
+    if (acl_cache_) {
+        auto decision = decide(resource_uid, user, effective_roles, claims, tenant);
+        if (!decision.success) {
+            return Result<int>::err(decision.error);
+        }
+        return Result<int>::ok(decision.value.reachable ? decision.value.permissions : 0);
+    }
+
     auto acls_result = get_acls_for_resource(resource_uid, tenant);
     if (!acls_result.success) {
         return Result<int>::err(acls_result.error);
@@ -249,18 +344,48 @@ std::vector<std::string> AclManager::resolve_effective_roles(const std::string&
     // failure here is non-fatal — we degrade to request roles rather than
     // denying every permission check, but we don't silently swallow either:
     // the db_ method will have logged the underlying error already.
-    auto db_roles = db_->get_roles_for_user(user, tenant);
-    if (db_roles.success) {
-        for (const auto& r : db_roles.value) {
-            if (std::find(roles.begin(), roles.end(), r) == roles.end()) {
-                roles.push_back(r);
-            }
+    for (const auto& r : stored_roles(user, tenant)) {
+        if (std::find(roles.begin(), roles.end(), r) == roles.end()) {
+            roles.push_back(r);
         }
     }
 
     return roles;
 }
 
+std::vector<std::string> AclManager::stored_roles(const std::string& user, const std::string& tenant) {
+    // Request memo first (only inside a CacheScope), then the shared cache
+    const std::string memo_key = tenant + "::" + user;
+    if (tls_role_memo.has_value()) {
+        auto it = tls_role_memo->find(memo_key);
+        if (it != tls_role_memo->end()) {
+            return it->second;
+        }
+    }
+
+    std::optional<std::vector<std::string>> roles;
+    if (role_cache_) {
+        roles = role_cache_->get(tenant, user);
+    }
+    if (!roles) {
+        const uint64_t epoch = role_cache_ ? role_cache_->epoch() : 0;
+        auto db_roles = db_->get_roles_for_user(user, tenant);
+        if (!db_roles.success) {
+            // Not cached or memoised, so the next check retries
+            return {};
+        }
+        roles = std::move(db_roles.value);
+        if (role_cache_) {
+            role_cache_->put(tenant, user, *roles, epoch);
+        }
+    }
+
+    if (tls_role_memo.has_value()) {
+        (*tls_role_memo)[memo_key] = *roles;
+    }
+    return std::move(*roles);
+}
+
 Result<void> AclManager::apply_default_acls(const std::string& resource_uid,
                                            const std::string& creator,
                                            const std::string& tenant) {
@@ -448,8 +573,51 @@ int AclManager::calculate_effective_permissions(const std::vector<ACLRule>& rule
     return result;
 }
 
+Result<std::optional<FileInfo>> AclManager::lookup_file(const std::string& uid, const std::string& tenant,
+                                                       bool include_deleted) {
+    if (metadata_cache_) {
+        return include_deleted ? metadata_cache_->get_file_by_uid_include_deleted(*db_, uid, tenant)
+                               : metadata_cache_->get_file_by_uid(*db_, uid, tenant);
+    }
+    return include_deleted ? db_->get_file_by_uid_include_deleted(uid, tenant)
+                           : db_->get_file_by_uid(uid, tenant);
+}
+
+std::optional<std::vector<IDatabase::AncestorEntry>> AclManager::load_ancestor_chain(const std::string& resource_uid,
+                                                                                     const std::string& tenant) {
+    // A uid already known to have no row (a client probing for a file that
+    // isn't there) needs no query at all
+    if (metadata_cache_ && metadata_cache_->known_missing(tenant, resource_uid)) {
+        return std::vector<IDatabase::AncestorEntry>{};
+    }
+    const uint64_t generation = acl_cache_ ? acl_cache_->generation(tenant) : 0;
+    const uint64_t metadata_epoch = metadata_cache_ ? metadata_cache_->epoch(tenant) : 0;
+    auto chain = db_->get_ancestor_chain(resource_uid, tenant);
+    if (!chain.success || !chain.value || !chain_is_consistent(*chain.value)) {
+        return std::nullopt;
+    }
+    if (chain.value->empty() && metadata_cache_) {
+        metadata_cache_->put_missing(tenant, resource_uid, metadata_epoch);
+    }
+    // The query read every link's ACLs; keep them for the checks that follow
+    for (const auto& link : *chain.value) {
+        auto rules = to_acl_rules(link.uid, link.acls);
+        put_cached_acls(tenant + "::" + link.uid, rules);
+        if (acl_cache_) {
+            acl_cache_->put_rules(tenant, link.uid, rules, generation);
+        }
+    }
+    return std::move(*chain.value);
+}
+
 bool AclManager::has_deleted_ancestor(const std::string& resource_uid,
                                       const std::string& tenant) {
+    // One query when the path is materialized: chain[0] is the resource itself
+    if (auto chain = load_ancestor_chain(resource_uid, tenant)) {
+        return std::any_of(chain->begin() + (chain->empty() ? 0 : 1), chain->end(),
+                           [](const IDatabase::AncestorEntry& link) { return link.deleted; });
+    }
+
     // Walk the parent chain (STRICT ancestors only — never the node itself, whose
     // own `deleted` flag is enforced by the caller's get_file_by_uid). If any
     // ancestor is soft-deleted the resource is hidden. `include_deleted` is used
@@ -457,7 +625,7 @@ bool AclManager::has_deleted_ancestor(const std::string& resource_uid,
     std::set<std::string> visited;
     std::string current = resource_uid;
     while (true) {
-        auto file = db_->get_file_by_uid_include_deleted(current, tenant);
+        auto file = lookup_file(current, tenant, true);
         if (!file.success || !file.value.has_value()) {
             return false; // no record — root / bare resource — not hidden
         }
@@ -468,7 +636,7 @@ bool AclManager::has_deleted_ancestor(const std::string& resource_uid,
         if (!visited.insert(parent).second) {
             return false; // defensive cycle guard
         }
-        auto pinfo = db_->get_file_by_uid_include_deleted(parent, tenant);
+        auto pinfo = lookup_file(parent, tenant, true);
         if (pinfo.success && pinfo.value.has_value() && pinfo.value->deleted) {
             return true; // a strict ancestor is soft-deleted -> subtree hidden
         }
@@ -480,7 +648,35 @@ bool AclManager::ancestors_readable(const std::string& resource_uid,
                                     const std::string& user,
                                     const std::vector<std::string>& roles,
                                     const std::map<std::string, std::string>& claims,
-                                    const std::string& tenant) {
+                                    const std::string& tenant,
+                                    bool* failed) {
+    const int read_bit = static_cast<int>(Permission::READ);
+
+    // Materialized path: deleted flags and ACLs of the whole chain come from
+    // one query, so the cost does not grow with depth. Same rules as the walk
+    // below.
+    if (auto chain = load_ancestor_chain(resource_uid, tenant)) {
+        if (chain->empty()) {
+            return true;  // no file record
+        }
+        for (size_t i = 1; i < chain->size(); ++i) {
+            if ((*chain)[i].deleted) {
+                return false;
+            }
+        }
+        if ((*chain)[0].deleted) {
+            return true;  // the resource's own flag is the caller's to enforce
+        }
+        for (size_t i = 1; i < chain->size(); ++i) {
+            const auto& link = (*chain)[i];
+            int eff = calculate_effective_permissions(to_acl_rules(link.uid, link.acls), user, roles, claims);
+            if ((eff & read_bit) != read_bit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     // Reachability by deletion first: a resource under a soft-deleted folder is
     // hidden regardless of ACLs, so it never leaks through any permission-gated
     // surface (stat/get/read/listdir/check_permission -> search, dashboard).
@@ -493,15 +689,15 @@ bool AclManager::ancestors_readable(const std::string& resource_uid,
     // unreachable — this is what makes a DENY READ on a folder (e.g. to
     // everyone) hide its entire subtree. `roles` are already-resolved
     // effective roles, passed straight through.
-    const int read_bit = static_cast<int>(Permission::READ);
     std::set<std::string> visited;
     std::string current = resource_uid;
 
     while (true) {
-        auto file = db_->get_file_by_uid(current, tenant);
+        auto file = lookup_file(current, tenant, false);
         // No file record (bare resource / unit-test fixture) — nothing above it
         // to traverse; treat as root-level and therefore reachable.
         if (!file.success || !file.value.has_value()) {
+            if (failed && !file.success) *failed = true;
             return true;
         }
         const std::string parent = file.value->parent_uid;
@@ -513,6 +709,7 @@ bool AclManager::ancestors_readable(const std::string& resource_uid,
         }
         auto parent_acls = get_acls_for_resource(parent, tenant);
         if (!parent_acls.success) {
+            if (failed) *failed = true;
             return false; // fail closed if an ancestor's ACLs can't be resolved
         }
         int eff = calculate_effective_permissions(parent_acls.value, user, roles, claims);
@@ -0,0 +1,753 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/blob_format.h"
+#include "fileengine/crypto_utils.h"
+#include "fileengine/codec.h"
+#include <zlib.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <stdexcept>
+
+namespace fileengine {
+
+namespace {
+
+constexpr uint8_t kHeaderMagic[4] = {'F', 'E', 'F', 'R'};
+constexpr uint8_t kTrailerMagic[4] = {'F', 'E', 'F', 'I'};
+constexpr uint8_t kFormatVersion = 1;
+constexpr uint8_t kFlagEncrypted = 0x01;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kRecordHeaderSize = 16;
+constexpr size_t kIndexEntrySize = 16;
+constexpr size_t kTrailerSize = 24;
+constexpr size_t kFileIdSize = 16;
+constexpr size_t kIvSize = 12;
+constexpr size_t kTagSize = 16;
+// Upper bound on frame_size accepted from a header, so a corrupt length
+// cannot make the decoder allocate without limit.
+constexpr size_t kMaxFrameSize = 64 * 1024 * 1024;
+
+constexpr uint8_t kCodecNone = static_cast<uint8_t>(CodecId::None);
+constexpr uint8_t kCodecMax = static_cast<uint8_t>(CodecId::Lz4);
+
+void put_u16(std::vector<uint8_t>& out, uint16_t v) {
+    for (int i = 0; i < 2; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+void put_u64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+uint32_t get_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+uint64_t get_u64(const uint8_t* p) {
+    return static_cast<uint64_t>(get_u32(p)) | static_cast<uint64_t>(get_u32(p + 4)) << 32;
+}
+
+struct FileHeader {
+    bool encrypted = false;
+    uint32_t frame_size = 0;
+    uint8_t file_id[kFileIdSize] = {};
+};
+
+struct RecordHeader {
+    uint32_t stored_len = 0;
+    uint32_t plain_len = 0;
+    uint32_t crc = 0;
+    uint8_t codec = kCodecNone;
+    bool last = false;
+};
+
+FileHeader parse_file_header(const uint8_t* p) {
+    if (std::memcmp(p, kHeaderMagic, 4) != 0) {
+        throw std::runtime_error("Not a framed blob");
+    }
+    if (p[4] != kFormatVersion) {
+        throw std::runtime_error("Unsupported framed blob version " + std::to_string(p[4]));
+    }
+    FileHeader h;
+    h.encrypted = p[5] & kFlagEncrypted;
+    h.frame_size = get_u32(p + 8);
+    if (h.frame_size == 0 || h.frame_size > kMaxFrameSize) {
+        throw std::runtime_error("Invalid frame size in framed blob header");
+    }
+    std::memcpy(h.file_id, p + 16, kFileIdSize);
+    return h;
+}
+
+RecordHeader parse_record_header(const uint8_t* p, const FileHeader& file) {
+    RecordHeader r;
+    r.stored_len = get_u32(p);
+    r.plain_len = get_u32(p + 4);
+    r.crc = get_u32(p + 8);
+    r.codec = p[12];
+    r.last = p[13] != 0;
+    const size_t overhead = file.encrypted ? kIvSize + kTagSize : 0;
+    if (r.plain_len == 0 || r.plain_len > file.frame_size ||
+        r.stored_len < overhead || r.stored_len > compressBound(file.frame_size) + overhead ||
+        r.codec > kCodecMax) {
+        throw std::runtime_error("Corrupt frame header in framed blob");
+    }
+    return r;
+}
+
+// Additional authenticated data for frame `frame_no`: everything about the
+// frame that is not inside its ciphertext.
+std::vector<uint8_t> frame_aad(const FileHeader& file, uint64_t frame_no, uint32_t plain_len, uint8_t codec,
+                               bool last) {
+    std::vector<uint8_t> aad(file.file_id, file.file_id + kFileIdSize);
+    put_u64(aad, frame_no);
+    put_u32(aad, plain_len);
+    aad.push_back(codec);
+    aad.push_back(last ? 1 : 0);
+    return aad;
+}
+
+std::vector<uint8_t> gcm_seal(const std::vector<uint8_t>& key, const std::vector<uint8_t>& aad,
+                              const uint8_t* data, size_t n) {
+    std::vector<uint8_t> out(kIvSize + n + kTagSize);
+    if (RAND_bytes(out.data(), kIvSize) != 1) {
+        throw std::runtime_error("Failed to generate frame IV");
+    }
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int len = 0;
+    bool ok = ctx &&
+              EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, kIvSize, nullptr) == 1 &&
+              EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), out.data()) == 1 &&
+              EVP_EncryptUpdate(ctx, nullptr, &len, aad.data(), static_cast<int>(aad.size())) == 1 &&
+              EVP_EncryptUpdate(ctx, out.data() + kIvSize, &len, data, static_cast<int>(n)) == 1 &&
+              EVP_EncryptFinal_ex(ctx, out.data() + kIvSize + len, &len) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, kTagSize, out.data() + kIvSize + n) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    if (!ok) {
+        throw std::runtime_error("Frame encryption failed");
+    }
+    return out;
+}
+
+std::vector<uint8_t> gcm_open(const std::vector<uint8_t>& key, const std::vector<uint8_t>& aad,
+                              const uint8_t* sealed, size_t n) {
+    const size_t ct_len = n - kIvSize - kTagSize;
+    std::vector<uint8_t> out(ct_len);
+    std::vector<uint8_t> tag(sealed + kIvSize + ct_len, sealed + n);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int len = 0;
+    bool ok = ctx &&
+              EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, kIvSize, nullptr) == 1 &&
+              EVP_DecryptInit_ex(ctx, nullptr, nullptr, key.data(), sealed) == 1 &&
+              EVP_DecryptUpdate(ctx, nullptr, &len, aad.data(), static_cast<int>(aad.size())) == 1 &&
+              EVP_DecryptUpdate(ctx, out.data(), &len, sealed + kIvSize, static_cast<int>(ct_len)) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, kTagSize, tag.data()) == 1 &&
+              EVP_DecryptFinal_ex(ctx, out.data() + len, &len) > 0;
+    EVP_CIPHER_CTX_free(ctx);
+    if (!ok) {
+        throw std::runtime_error("Frame authentication failed");
+    }
+    return out;
+}
+
+// Verify and decode one frame payload to its plaintext.
+std::vector<uint8_t> decode_frame(const FileHeader& file, const std::vector<uint8_t>& key, uint64_t frame_no,
+                                  const RecordHeader& rec, const uint8_t* payload) {
+    if (static_cast<uint32_t>(crc32(0L, payload, rec.stored_len)) != rec.crc) {
+        throw std::runtime_error("Checksum mismatch in frame " + std::to_string(frame_no));
+    }
+
+    std::vector<uint8_t> opened;
+    const uint8_t* body = payload;
+    size_t body_len = rec.stored_len;
+    if (file.encrypted) {
+        opened = gcm_open(key, frame_aad(file, frame_no, rec.plain_len, rec.codec, rec.last), payload,
+                          rec.stored_len);
+        body = opened.data();
+        body_len = opened.size();
+    }
+
+    if (rec.codec == kCodecNone) {
+        if (body_len != rec.plain_len) {
+            throw std::runtime_error("Length mismatch in frame " + std::to_string(frame_no));
+        }
+        return opened.empty() ? std::vector<uint8_t>(body, body + body_len) : std::move(opened);
+    }
+
+    const Codec* codec = Codec::decoder(static_cast<CodecId>(rec.codec));
+    if (!codec) {
+        throw std::runtime_error(std::string("Frame ") + std::to_string(frame_no) + " is " +
+                                 Codec::name(static_cast<CodecId>(rec.codec)) +
+                                 "-compressed, which this build does not support");
+    }
+    std::vector<uint8_t> plain(rec.plain_len);
+    if (!codec->decompress(body, body_len, plain.data(), plain.size())) {
+        throw std::runtime_error("Decompression failed in frame " + std::to_string(frame_no));
+    }
+    return plain;
+}
+
+} // namespace
+
+// ------------------------------- BlobEncoder --------------------------------
+struct BlobEncoder::Impl {
+    // What sealing a frame needs; shared read-only with pool workers.
+    struct Params {
+        std::shared_ptr<const Codec> codec;  // nullptr: no compression
+        std::vector<uint8_t> key;        // empty: no encryption
+        FileHeader header;
+    };
+    struct SealedFrame {
+        std::vector<uint8_t> body;       // stored payload
+        uint32_t plain_len = 0;
+        uint8_t codec = kCodecNone;
+        bool last = false;
+    };
+
+    std::shared_ptr<Params> params;
+    size_t frame_size = 0;               // 0: legacy monolithic format
+    std::vector<uint8_t> pending;        // plaintext of the frame not yet emitted
+    uint64_t written = 0;                // stored bytes emitted so far
+    uint64_t plain_total = 0;
+    uint64_t frames_started = 0;
+    bool store_raw = false;              // content has a compressed-format signature
+    struct IndexEntry { uint64_t offset; uint32_t stored_len; uint32_t plain_len; };
+    std::vector<IndexEntry> index;
+
+    // Parallel encoding: frames sealed on the pool, appended in order.
+    std::shared_ptr<WorkerPool> pool;
+    size_t max_in_flight = 0;
+    std::deque<std::future<SealedFrame>> in_flight;
+
+    // Legacy format
+    std::unique_ptr<CompressStream> compressor;
+    std::unique_ptr<EncryptStream> encryptor;
+    std::vector<uint8_t> cbuf;
+
+    static SealedFrame seal_frame(const Params& params, uint64_t frame_no, std::vector<uint8_t> plain, bool last,
+                                  bool try_compress);
+    void emit_frame(bool last, std::vector<uint8_t>& out);
+    void append_frame(const SealedFrame& frame, std::vector<uint8_t>& out);
+    // Append finished frames from the front of in_flight; with `wait`, block
+    // until at most `keep` remain.
+    void drain(size_t keep, std::vector<uint8_t>& out);
+};
+
+BlobEncoder::BlobEncoder(bool compress, const std::string& key, size_t frame_size,
+                         std::shared_ptr<WorkerPool> pool)
+    : BlobEncoder(compress ? Codec::make(CodecId::Zlib) : nullptr, key, frame_size, std::move(pool)) {}
+
+BlobEncoder::BlobEncoder(std::shared_ptr<const Codec> codec, const std::string& key, size_t frame_size,
+                         std::shared_ptr<WorkerPool> pool)
+    : impl_(std::make_unique<Impl>()) {
+    impl_->params = std::make_shared<Impl::Params>();
+    impl_->params->codec = std::move(codec);
+    impl_->frame_size = std::min(frame_size, kMaxFrameSize);
+    if (impl_->frame_size == 0) {
+        // The legacy format is one zlib stream whatever the codec.
+        if (impl_->params->codec) impl_->compressor = std::make_unique<CompressStream>();
+        if (!key.empty()) impl_->encryptor = std::make_unique<EncryptStream>(key);
+        return;
+    }
+    Impl::Params& params = *impl_->params;
+    if (!key.empty()) params.key = CryptoUtils::parse_aes256_key(key);
+    params.header.encrypted = !params.key.empty();
+    params.header.frame_size = static_cast<uint32_t>(impl_->frame_size);
+    // Only encrypted blobs need a unique id (it is bound into every AAD);
+    // unencrypted ones keep it zero so equal content encodes to equal bytes
+    // and still deduplicates.
+    if (params.header.encrypted && RAND_bytes(params.header.file_id, kFileIdSize) != 1) {
+        throw std::runtime_error("Failed to generate blob id");
+    }
+    // A single worker would only add hand-off latency.
+    if (pool && pool->size() > 1) {
+        impl_->pool = std::move(pool);
+        // Enough queued frames to keep every worker busy, bounded so memory
+        // stays at a few frames per worker however fast the input arrives.
+        impl_->max_in_flight = 2 * impl_->pool->size();
+    }
+    impl_->pending.reserve(impl_->frame_size);
+}
+
+BlobEncoder::~BlobEncoder() {
+    // Wait out frames still being sealed so an abandoned upload (the caller
+    // threw) leaves no work behind on the shared pool.
+    if (impl_) {
+        for (auto& f : impl_->in_flight) f.wait();
+    }
+}
+
+BlobEncoder::Impl::SealedFrame BlobEncoder::Impl::seal_frame(const Params& params, uint64_t frame_no,
+                                                             std::vector<uint8_t> plain, bool last,
+                                                             bool try_compress) {
+    SealedFrame frame;
+    frame.plain_len = static_cast<uint32_t>(plain.size());
+    frame.last = last;
+
+    // Frames are stored raw when sampling says they are already compressed,
+    // or when the codec does not shrink them.
+    if (try_compress && !looks_incompressible(plain.data(), plain.size()) &&
+        params.codec->compress(plain.data(), plain.size(), frame.body)) {
+        frame.codec = static_cast<uint8_t>(params.codec->id());
+    }
+    if (frame.codec == kCodecNone) frame.body = std::move(plain);
+
+    if (params.header.encrypted) {
+        frame.body = gcm_seal(params.key, frame_aad(params.header, frame_no, frame.plain_len, frame.codec, last),
+                              frame.body.data(), frame.body.size());
+    }
+    return frame;
+}
+
+void BlobEncoder::Impl::emit_frame(bool last, std::vector<uint8_t>& out) {
+    const uint64_t frame_no = frames_started++;
+    std::vector<uint8_t> plain;
+    plain.swap(pending);
+    pending.reserve(frame_size);
+
+    // Media and archives announce themselves in their first bytes; skip the
+    // codec for the whole blob rather than sampling every frame.
+    if (frame_no == 0 && params->codec) store_raw = has_compressed_signature(plain.data(), plain.size());
+    const bool try_compress = params->codec && !store_raw;
+
+    if (!pool) {
+        append_frame(seal_frame(*params, frame_no, std::move(plain), last, try_compress), out);
+        return;
+    }
+    std::shared_ptr<const Params> p = params;
+    in_flight.push_back(pool->run([p, frame_no, last, try_compress, plain = std::move(plain)]() mutable {
+        return seal_frame(*p, frame_no, std::move(plain), last, try_compress);
+    }));
+    // Block only when the window is full; otherwise take what is ready.
+    drain(max_in_flight - 1, out);
+}
+
+void BlobEncoder::Impl::drain(size_t keep, std::vector<uint8_t>& out) {
+    while (!in_flight.empty()) {
+        auto& front = in_flight.front();
+        if (in_flight.size() <= keep &&
+            front.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            break;
+        }
+        SealedFrame frame = front.get();  // rethrows a worker's failure
+        in_flight.pop_front();
+        append_frame(frame, out);
+    }
+}
+
+void BlobEncoder::Impl::append_frame(const SealedFrame& frame, std::vector<uint8_t>& out) {
+    if (written == 0) {
+        const FileHeader& header = params->header;
+        out.insert(out.end(), kHeaderMagic, kHeaderMagic + 4);
+        out.push_back(kFormatVersion);
+        out.push_back(header.encrypted ? kFlagEncrypted : 0);
+        put_u16(out, 0);
+        put_u32(out, header.frame_size);
+        put_u32(out, 0);
+        out.insert(out.end(), header.file_id, header.file_id + kFileIdSize);
+        written = kHeaderSize;
+    }
+
+    put_u32(out, static_cast<uint32_t>(frame.body.size()));
+    put_u32(out, frame.plain_len);
+    put_u32(out, static_cast<uint32_t>(crc32(0L, frame.body.data(), static_cast<uInt>(frame.body.size()))));
+    out.push_back(frame.codec);
+    out.push_back(frame.last ? 1 : 0);
+    put_u16(out, 0);
+    out.insert(out.end(), frame.body.begin(), frame.body.end());
+
+    index.push_back({written, static_cast<uint32_t>(frame.body.size()), frame.plain_len});
+    written += kRecordHeaderSize + frame.body.size();
+}
+
+void BlobEncoder::update(const uint8_t* data, size_t n, std::vector<uint8_t>& out) {
+    out.clear();
+    if (impl_->frame_size == 0) {
+        const uint8_t* p = data;
+        if (impl_->compressor) {
+            impl_->compressor->update(data, n, impl_->cbuf);
+            p = impl_->cbuf.data();
+            n = impl_->cbuf.size();
+        }
+        if (impl_->encryptor) impl_->encryptor->update(p, n, out);
+        else out.assign(p, p + n);
+        return;
+    }
+
+    impl_->plain_total += n;
+    while (n > 0) {
+        // A full frame is only emitted once more data arrives: until then it
+        // may turn out to be the last one, which its AAD has to record.
+        if (impl_->pending.size() == impl_->frame_size) impl_->emit_frame(false, out);
+        size_t take = std::min(n, impl_->frame_size - impl_->pending.size());
+        impl_->pending.insert(impl_->pending.end(), data, data + take);
+        data += take;
+        n -= take;
+    }
+}
+
+void BlobEncoder::finish(std::vector<uint8_t>& out) {
+    out.clear();
+    if (impl_->frame_size == 0) {
+        if (impl_->compressor) {
+            impl_->compressor->finish(impl_->cbuf);
+            if (impl_->encryptor) impl_->encryptor->update(impl_->cbuf.data(), impl_->cbuf.size(), out);
+            else out = impl_->cbuf;
+        }
+        if (impl_->encryptor) {
+            std::vector<uint8_t> tail;
+            impl_->encryptor->finish(tail);
+            out.insert(out.end(), tail.begin(), tail.end());
+        }
+        return;
+    }
+
+    if (impl_->plain_total == 0) return;  // empty content -> empty blob
+    impl_->emit_frame(true, out);
+    impl_->drain(0, out);
+
+    const uint64_t index_offset = impl_->written;
+    for (const auto& e : impl_->index) {
+        put_u64(out, e.offset);
+        put_u32(out, e.stored_len);
+        put_u32(out, e.plain_len);
+    }
+    put_u64(out, index_offset);
+    put_u64(out, impl_->plain_total);
+    put_u32(out, static_cast<uint32_t>(impl_->index.size()));
+    out.insert(out.end(), kTrailerMagic, kTrailerMagic + 4);
+}
+
+std::vector<uint8_t> BlobEncoder::encode(const std::vector<uint8_t>& data, bool compress, const std::string& key,
+                                         size_t frame_size, std::shared_ptr<WorkerPool> pool) {
+    return encode(data, compress ? Codec::make(CodecId::Zlib) : nullptr, key, frame_size, std::move(pool));
+}
+
+std::vector<uint8_t> BlobEncoder::encode(const std::vector<uint8_t>& data, std::shared_ptr<const Codec> codec,
+                                         const std::string& key, size_t frame_size,
+                                         std::shared_ptr<WorkerPool> pool) {
+    BlobEncoder encoder(std::move(codec), key, frame_size, std::move(pool));
+    std::vector<uint8_t> out, tail;
+    encoder.update(data.data(), data.size(), out);
+    encoder.finish(tail);
+    out.insert(out.end(), tail.begin(), tail.end());
+    return out;
+}
+
+// ------------------------------- BlobDecoder --------------------------------
+struct BlobDecoder::Impl {
+    enum class State { Detect, Legacy, Framed, Done };
+    State state = State::Detect;
+    bool compress = false;
+    std::string key_string;
+    std::vector<uint8_t> key;
+
+    std::vector<uint8_t> buf;  // framed: undecoded stored bytes from `pos` on
+    size_t pos = 0;
+    bool have_header = false;
+    FileHeader header;
+    uint64_t frame_no = 0;
+
+    std::unique_ptr<DecryptStream> decryptor;
+    std::unique_ptr<DecompressStream> decompressor;
+    std::vector<uint8_t> dbuf;
+
+    void legacy_update(const uint8_t* p, size_t n, std::vector<uint8_t>& out);
+    void framed_drain(std::vector<uint8_t>& out);
+    // True if `buf` starts with a valid framed header for this key
+    bool framed_header_valid() const;
+};
+
+BlobDecoder::BlobDecoder(bool compress, const std::string& key, bool legacy) : impl_(std::make_unique<Impl>()) {
+    impl_->compress = compress;
+    impl_->key_string = key;
+    if (!key.empty()) impl_->key = CryptoUtils::parse_aes256_key(key);
+    if (legacy) impl_->state = Impl::State::Legacy;
+}
+
+bool BlobDecoder::Impl::framed_header_valid() const {
+    try {
+        FileHeader h = parse_file_header(buf.data());
+        return h.encrypted == !key.empty();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+BlobDecoder::~BlobDecoder() = default;
+
+void BlobDecoder::Impl::legacy_update(const uint8_t* p, size_t n, std::vector<uint8_t>& out) {
+    if (!decryptor && !key_string.empty()) decryptor = std::make_unique<DecryptStream>(key_string);
+    if (!decompressor && compress) decompressor = std::make_unique<DecompressStream>();
+    if (decryptor) {
+        decryptor->update(p, n, dbuf);
+        p = dbuf.data();
+        n = dbuf.size();
+    }
+    if (decompressor) decompressor->update(p, n, out);
+    else out.assign(p, p + n);
+}
+
+void BlobDecoder::Impl::framed_drain(std::vector<uint8_t>& out) {
+    if (!have_header) {
+        if (buf.size() - pos < kHeaderSize) return;
+        header = parse_file_header(buf.data() + pos);
+        if (!key.empty() && !header.encrypted) {
+            throw std::runtime_error("Framed blob is not encrypted but encryption is enabled");
+        }
+        if (key.empty() && header.encrypted) {
+            throw std::runtime_error("Framed blob is encrypted but no key is available");
+        }
+        have_header = true;
+        pos += kHeaderSize;
+    }
+
+    while (state == State::Framed && buf.size() - pos >= kRecordHeaderSize) {
+        RecordHeader rec = parse_record_header(buf.data() + pos, header);
+        if (buf.size() - pos < kRecordHeaderSize + rec.stored_len) break;
+        auto plain = decode_frame(header, key, frame_no++, rec, buf.data() + pos + kRecordHeaderSize);
+        out.insert(out.end(), plain.begin(), plain.end());
+        pos += kRecordHeaderSize + rec.stored_len;
+        if (rec.last) state = State::Done;  // the index and trailer follow
+    }
+
+    if (state == State::Done) {
+        buf.clear();
+        pos = 0;
+    } else if (pos > 0 && pos * 2 >= buf.size()) {
+        buf.erase(buf.begin(), buf.begin() + static_cast<std::ptrdiff_t>(pos));
+        pos = 0;
+    }
+}
+
+void BlobDecoder::update(const uint8_t* data, size_t n, std::vector<uint8_t>& out) {
+    out.clear();
+    switch (impl_->state) {
+    case Impl::State::Detect:
+        impl_->buf.insert(impl_->buf.end(), data, data + n);
+        if (impl_->buf.size() < kHeaderSize) return;
+        if (impl_->framed_header_valid()) {
+            impl_->state = Impl::State::Framed;
+            impl_->framed_drain(out);
+        } else {
+            impl_->state = Impl::State::Legacy;
+            std::vector<uint8_t> head;
+            head.swap(impl_->buf);
+            impl_->legacy_update(head.data(), head.size(), out);
+        }
+        return;
+    case Impl::State::Legacy:
+        impl_->legacy_update(data, n, out);
+        return;
+    case Impl::State::Framed:
+        impl_->buf.insert(impl_->buf.end(), data, data + n);
+        impl_->framed_drain(out);
+        return;
+    case Impl::State::Done:
+        return;
+    }
+}
+
+void BlobDecoder::finish(std::vector<uint8_t>& out) {
+    out.clear();
+    if (impl_->state == Impl::State::Detect) {
+        // Shorter than a header: only a (small or empty) legacy blob fits.
+        if (impl_->buf.empty()) return;
+        impl_->state = Impl::State::Legacy;
+        std::vector<uint8_t> head;
+        head.swap(impl_->buf);
+        impl_->legacy_update(head.data(), head.size(), out);
+    }
+    if (impl_->state == Impl::State::Framed) {
+        throw std::runtime_error("Framed blob is truncated");
+    }
+    if (impl_->state == Impl::State::Legacy) {
+        std::vector<uint8_t> tail;
+        if (impl_->decryptor) {
+            impl_->decryptor->finish(impl_->dbuf);  // verifies the GCM tag
+            if (impl_->decompressor) impl_->decompressor->update(impl_->dbuf.data(), impl_->dbuf.size(), tail);
+            else tail = impl_->dbuf;
+            out.insert(out.end(), tail.begin(), tail.end());
+        }
+        if (impl_->decompressor) {
+            impl_->decompressor->finish(tail);
+            out.insert(out.end(), tail.begin(), tail.end());
+        }
+    }
+}
+
+std::vector<uint8_t> BlobDecoder::decode(const std::vector<uint8_t>& stored, bool compress, const std::string& key) {
+    if (stored.empty()) return {};
+    // Legacy blobs keep the exact one-shot decode path they were written for.
+    auto legacy_decode = [&] {
+        std::vector<uint8_t> data = stored;
+        if (!key.empty()) data = CryptoUtils::decrypt_data(data, key);
+        if (compress) data = CryptoUtils::decompress_data(data);
+        return data;
+    };
+    if (!FramedBlobReader::is_framed(stored.data(), stored.size())) {
+        return legacy_decode();
+    }
+    std::string framed_error;
+    try {
+        BlobDecoder decoder(compress, key);
+        std::vector<uint8_t> out, tail;
+        decoder.update(stored.data(), stored.size(), out);
+        decoder.finish(tail);
+        out.insert(out.end(), tail.begin(), tail.end());
+        return out;
+    } catch (const std::exception& e) {
+        framed_error = e.what();
+    }
+    // The magic alone does not make a blob framed: a legacy blob may start
+    // with it. Report the framed error if the bytes are not legacy either.
+    try {
+        return legacy_decode();
+    } catch (const std::exception&) {
+        throw std::runtime_error(framed_error);
+    }
+}
+
+// ----------------------------- FramedBlobReader -----------------------------
+struct FramedBlobReader::Impl {
+    ReadAt read_at;
+    FileHeader header;
+    std::vector<uint8_t> key;
+    struct Frame { uint64_t offset; uint32_t stored_len; uint32_t plain_len; uint64_t plain_start; };
+    std::vector<Frame> frames;
+    uint64_t plain_size = 0;
+
+    // read_at() that treats a short read (truncated blob) as an error.
+    Result<std::vector<uint8_t>> read_exact(uint64_t offset, size_t len) const {
+        auto r = read_at(offset, len);
+        if (r.success && r.value.size() != len) {
+            return Result<std::vector<uint8_t>>::err("Truncated framed blob");
+        }
+        return r;
+    }
+};
+
+FramedBlobReader::FramedBlobReader() : impl_(std::make_unique<Impl>()) {}
+FramedBlobReader::~FramedBlobReader() = default;
+
+bool FramedBlobReader::is_framed(const uint8_t* head, size_t n) {
+    return n >= 4 && std::memcmp(head, kHeaderMagic, 4) == 0;
+}
+
+Result<std::shared_ptr<FramedBlobReader>> FramedBlobReader::open(uint64_t blob_size, ReadAt read_at,
+                                                                 const std::string& key) {
+    using R = Result<std::shared_ptr<FramedBlobReader>>;
+    if (blob_size < kHeaderSize + kTrailerSize) {
+        return R::err("Not a framed blob");
+    }
+    std::shared_ptr<FramedBlobReader> reader(new FramedBlobReader());
+    Impl& impl = *reader->impl_;
+    impl.read_at = std::move(read_at);
+
+    try {
+        auto head = impl.read_exact(0, kHeaderSize);
+        if (!head.success) return R::err(head.error);
+        impl.header = parse_file_header(head.value.data());
+        if (!key.empty()) impl.key = CryptoUtils::parse_aes256_key(key);
+        if (impl.header.encrypted != !impl.key.empty()) {
+            return R::err(impl.header.encrypted ? "Framed blob is encrypted but no key is available"
+                                                : "Framed blob is not encrypted but encryption is enabled");
+        }
+
+        auto trailer = impl.read_exact(blob_size - kTrailerSize, kTrailerSize);
+        if (!trailer.success) return R::err(trailer.error);
+        const uint8_t* t = trailer.value.data();
+        const uint64_t index_offset = get_u64(t);
+        impl.plain_size = get_u64(t + 8);
+        const uint32_t frame_count = get_u32(t + 16);
+        if (std::memcmp(t + 20, kTrailerMagic, 4) != 0 || frame_count == 0 ||
+            index_offset < kHeaderSize ||
+            index_offset + static_cast<uint64_t>(frame_count) * kIndexEntrySize + kTrailerSize != blob_size) {
+            return R::err("Corrupt framed blob trailer");
+        }
+
+        auto index = impl.read_exact(index_offset, static_cast<size_t>(frame_count) * kIndexEntrySize);
+        if (!index.success) return R::err(index.error);
+        uint64_t next_offset = kHeaderSize;
+        uint64_t plain_start = 0;
+        for (uint32_t i = 0; i < frame_count; ++i) {
+            const uint8_t* e = index.value.data() + static_cast<size_t>(i) * kIndexEntrySize;
+            Impl::Frame f{get_u64(e), get_u32(e + 8), get_u32(e + 12), plain_start};
+            if (f.offset != next_offset || f.plain_len == 0 || f.plain_len > impl.header.frame_size) {
+                return R::err("Corrupt framed blob index");
+            }
+            next_offset = f.offset + kRecordHeaderSize + f.stored_len;
+            plain_start += f.plain_len;
+            impl.frames.push_back(f);
+        }
+        if (next_offset != index_offset || plain_start != impl.plain_size) {
+            return R::err("Corrupt framed blob index");
+        }
+    } catch (const std::exception& e) {
+        return R::err(e.what());
+    }
+    return R::ok(reader);
+}
+
+uint64_t FramedBlobReader::size() const {
+    return impl_->plain_size;
+}
+
+size_t FramedBlobReader::frame_count() const {
+    return impl_->frames.size();
+}
+
+Result<std::vector<uint8_t>> FramedBlobReader::read(uint64_t offset, size_t len) {
+    using R = Result<std::vector<uint8_t>>;
+    std::vector<uint8_t> out;
+    if (offset >= impl_->plain_size || len == 0) return R::ok(out);
+    const uint64_t end = std::min<uint64_t>(impl_->plain_size, offset + len);
+    out.reserve(static_cast<size_t>(end - offset));
+
+    // First frame whose plaintext extends past `offset`.
+    auto it = std::upper_bound(impl_->frames.begin(), impl_->frames.end(), offset,
+                               [](uint64_t off, const Impl::Frame& f) { return off < f.plain_start; });
+    size_t i = static_cast<size_t>(std::distance(impl_->frames.begin(), it)) - 1;
+
+    try {
+        for (; i < impl_->frames.size() && impl_->frames[i].plain_start < end; ++i) {
+            const Impl::Frame& f = impl_->frames[i];
+            auto record = impl_->read_exact(f.offset, kRecordHeaderSize + f.stored_len);
+            if (!record.success) return R::err(record.error);
+            RecordHeader rec = parse_record_header(record.value.data(), impl_->header);
+            if (rec.stored_len != f.stored_len || rec.plain_len != f.plain_len ||
+                rec.last != (i + 1 == impl_->frames.size())) {
+                return R::err("Frame " + std::to_string(i) + " does not match the blob index");
+            }
+            auto plain = decode_frame(impl_->header, impl_->key, i, rec, record.value.data() + kRecordHeaderSize);
+            const uint64_t from = std::max(offset, f.plain_start) - f.plain_start;
+            const uint64_t to = std::min<uint64_t>(end, f.plain_start + f.plain_len) - f.plain_start;
+            out.insert(out.end(), plain.begin() + static_cast<std::ptrdiff_t>(from),
+                       plain.begin() + static_cast<std::ptrdiff_t>(to));
+        }
+    } catch (const std::exception& e) {
+        return R::err(e.what());
+    }
+    return R::ok(out);
+}
+
+} // namespace fileengine
@@ -15,49 +15,142 @@
 
 #include "fileengine/cache_manager.h"
 #include "fileengine/server_logger.h"
-#include <sys/statvfs.h>
 #include <algorithm>
+#include <functional>
 #include <mutex>
+#include <thread>
 
 namespace fileengine {
 
-CacheManager::CacheManager(IStorage* storage, IObjectStore* object_store, double threshold)
-    : storage_(storage), object_store_(object_store), current_cache_size_(0), 
-      max_cache_size_bytes_(0), threshold_(threshold) {
-    calculate_max_cache_size();
+namespace {
+size_t default_shard_count(size_t max_cache_size_bytes) {
+    size_t want = std::max<size_t>(1, std::thread::hardware_concurrency()) * 2;
+    want = std::min<size_t>(want, 64);
+    want = std::min(want, std::max<size_t>(1, max_cache_size_bytes / CacheManager::kMinShardBytes));
+    size_t count = 1;
+    while (count * 2 <= want) count *= 2;
+    return count;
 }
 
-CacheManager::~CacheManager() {
-    // Cleanup cache
-    std::lock_guard<std::mutex> lock(cache_mutex_);
-    cache_map_.clear();
-    lru_list_.clear();
+size_t round_down_pow2(size_t n) {
+    size_t count = 1;
+    while (count * 2 <= n) count *= 2;
+    return count;
 }
 
-Result<std::vector<uint8_t>> CacheManager::get_file(const std::string& storage_path, const std::string& tenant) {
-    SERVER_LOG_DEBUG("CacheManager::get_file", ServerLogger::getInstance().detailed_log_prefix() +
-              "Getting file from cache - storage_path: " + storage_path +
-              ", tenant: " + tenant +
-              " [CONCURRENCY CRITICAL: Cache access with potential race conditions]");
+// Sketch sizing: one counter per this many bytes of shard budget, which
+// covers a working set of mostly small files without growing unbounded
+constexpr size_t kSketchBytesPerEntry = 4 * 1024;
+constexpr size_t kMaxSketchEntries = 1 << 20;
+} // namespace
+
+CacheManager::CacheManager(IStorage* storage, IObjectStore* object_store, double threshold,
+                           size_t max_cache_size_bytes, size_t shard_count, CachePolicy policy)
+    : storage_(storage), object_store_(object_store), policy_(policy),
+      max_cache_size_bytes_(max_cache_size_bytes), threshold_(threshold) {
+    const size_t count = shard_count ? round_down_pow2(shard_count) : default_shard_count(max_cache_size_bytes);
+    shards_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        Shard& shard = *shards_.back();
+        resize_locked(shard, max_cache_size_bytes / count);
+        if (policy_ == CachePolicy::TinyLfu) {
+            shard.sketch = std::make_unique<FrequencySketch>(
+                std::min(kMaxSketchEntries, shard.max_bytes / kSketchBytesPerEntry));
+        }
+    }
+}
 
-    std::lock_guard<std::mutex> lock(cache_mutex_);
+CachePolicy CacheManager::parse_policy(const std::string& policy) {
+    if (policy == "lru") return CachePolicy::Lru;
+    return CachePolicy::TinyLfu;
+}
 
-    auto it = cache_map_.find(storage_path);
-    if (it != cache_map_.end()) {
-        SERVER_LOG_DEBUG("CacheManager::get_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "File found in cache: " + storage_path +
-                  ", updating LRU position [CONCURRENCY CRITICAL: LRU update within lock]");
-        // Update LRU position
-        lru_list_.erase(it->second.lru_iter);
-        lru_list_.push_front(storage_path);
-        it->second.lru_iter = lru_list_.begin();
+CacheManager::~CacheManager() = default;
 
-        // Update access time
-        it->second.file.last_accessed = std::chrono::steady_clock::now();
+CacheManager::Shard& CacheManager::shard_for(const std::string& key) const {
+    // Mix the high bits in: libstdc++ hashes some short strings with little
+    // entropy in the low bits
+    size_t h = std::hash<std::string>{}(key);
+    h ^= h >> 32;
+    return *shards_[h & (shards_.size() - 1)];
+}
 
-        SERVER_LOG_DEBUG("CacheManager::get_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Successfully retrieved file from cache: " + storage_path);
-        return Result<std::vector<uint8_t>>::ok(it->second.file.data);
+std::string CacheManager::version_key(const std::string& tenant, const std::string& uid,
+                                      const std::string& version) {
+    // NUL separators cannot appear in a storage path, so these keys never
+    // collide with the path-keyed entries of get_file()/add_file()
+    std::string key;
+    key.reserve(tenant.size() + uid.size() + version.size() + 2);
+    key.append(tenant).push_back('\0');
+    key.append(uid).push_back('\0');
+    key.append(version);
+    return key;
+}
+
+SharedBlob CacheManager::lookup(const std::string& tenant, const std::string& uid, const std::string& version) {
+    const std::string key = version_key(tenant, uid, version);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    record_access_locked(shard, key);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+        ++shard.misses;
+        return nullptr;
+    }
+    touch_locked(shard, it);
+    ++shard.hits;
+    return it->second.file.data;
+}
+
+void CacheManager::insert(const std::string& tenant, const std::string& uid, const std::string& version,
+                          SharedBlob data) {
+    if (!data || data->size() > max_cache_size_bytes_.load(std::memory_order_relaxed) / 8) {
+        return;
+    }
+    const std::string key = version_key(tenant, uid, version);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (data->size() > shard.max_bytes / 2) {
+        return;
+    }
+    insert_locked(shard, key, std::move(data), tenant);
+}
+
+void CacheManager::invalidate(const std::string& tenant, const std::string& uid, const std::string& version) {
+    remove_file(version_key(tenant, uid, version));
+}
+
+CacheStats CacheManager::get_stats() const {
+    CacheStats stats;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.hits += shard->hits;
+        stats.misses += shard->misses;
+        stats.evictions += shard->evictions;
+        stats.insertions += shard->insertions;
+        stats.rejections += shard->rejections;
+        stats.entries += shard->map.size();
+        stats.size_bytes += shard->size_bytes;
+    }
+    stats.max_bytes = max_cache_size_bytes_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+Result<std::vector<uint8_t>> CacheManager::get_file(const std::string& storage_path, const std::string& tenant) {
+    SERVER_LOG_DEBUG("CacheManager::get_file", ServerLogger::getInstance().detailed_log_prefix() +
+              "Getting file from cache - storage_path: " + storage_path +
+              ", tenant: " + tenant);
+
+    {
+        Shard& shard = shard_for(storage_path);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        record_access_locked(shard, storage_path);
+        auto it = shard.map.find(storage_path);
+        if (it != shard.map.end()) {
+            touch_locked(shard, it);
+            return Result<std::vector<uint8_t>>::ok(*it->second.file.data);
+        }
     }
 
     SERVER_LOG_DEBUG("CacheManager::get_file", ServerLogger::getInstance().detailed_log_prefix() +
@@ -137,180 +230,196 @@ Result<std::vector<uint8_t>> CacheManager::get_file(const std::string& storage_p
 }
 
 Result<void> CacheManager::add_file(const std::string& storage_path, const std::vector<uint8_t>& data, const std::string& tenant) {
-    size_t data_size = data.size();
-
     SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
               "Adding file to cache - storage_path: " + storage_path +
-              ", data_size: " + std::to_string(data_size) +
-              ", tenant: " + tenant +
-              " [CONCURRENCY CRITICAL: Cache operations with potential race conditions]");
+              ", data_size: " + std::to_string(data.size()) +
+              ", tenant: " + tenant);
 
-    // Use a unique_lock to allow for temporary unlocking during potentially long operations
-    std::unique_lock<std::mutex> lock(cache_mutex_);
-
-    SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-              "Acquired cache mutex, current cache size: " + std::to_string(current_cache_size_) +
-              ", max cache size: " + std::to_string(max_cache_size_bytes_) +
-              ", threshold: " + std::to_string(threshold_));
-
-    // Check if we still have space
-    if (current_cache_size_ + data_size <= max_cache_size_bytes_) {
-        SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Sufficient space available, adding file directly to cache: " + storage_path);
-        // Add new item
-        auto& entry = cache_map_[storage_path];
-        entry.file.path = storage_path;
-        entry.file.data = data;
-        entry.file.size = data_size;
-        entry.file.tenant = tenant;
-        entry.file.last_accessed = std::chrono::steady_clock::now();
-
-        lru_list_.push_front(storage_path);
-        entry.lru_iter = lru_list_.begin();
-
-        current_cache_size_ += data_size;
-
-        SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Successfully added file to cache: " + storage_path +
-                  ", new cache size: " + std::to_string(current_cache_size_));
-        return Result<void>::ok();
+    Shard& shard = shard_for(storage_path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!insert_locked(shard, storage_path, std::make_shared<const std::vector<uint8_t>>(data), tenant)) {
+        return Result<void>::err("Not enough space in cache even after eviction");
     }
+    return Result<void>::ok();
+}
 
-    SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-              "Insufficient space, need to evict items - required: " + std::to_string(data_size) +
-              ", available: " + std::to_string(max_cache_size_bytes_ - current_cache_size_) +
-              " [CONCURRENCY WARNING: About to release lock and perform eviction]");
+void CacheManager::resize_locked(Shard& shard, size_t max_bytes) {
+    shard.max_bytes = max_bytes;
+    shard.window_max_bytes = max_bytes / 100;
+}
 
-    // If not enough space, we need to evict some items
-    // First, temporarily release the lock to avoid holding it during potential long operations
-    lock.unlock();
+void CacheManager::record_access_locked(Shard& shard, const std::string& key) {
+    if (shard.sketch) shard.sketch->increment(key);
+}
 
-    // Evict items to make space - this is the critical section that needs to be atomic
-    {
-        SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Starting critical eviction section [CONCURRENCY CRITICAL: Eviction may conflict with other operations]");
-        std::lock_guard<std::mutex> eviction_lock(cache_mutex_);
-        // Check again in case another thread freed space
-        if (current_cache_size_ + data_size > max_cache_size_bytes_) {
-            SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                      "Performing cache eviction to make space for: " + storage_path +
-                      ", need to free: " + std::to_string((current_cache_size_ + data_size) - max_cache_size_bytes_) +
-                      " bytes");
-            // Evict enough items to make space
-            while (current_cache_size_ + data_size > max_cache_size_bytes_ && !lru_list_.empty()) {
-                // Remove least recently used item
-                std::string lru_path = lru_list_.back();
-                lru_list_.pop_back();
-
-                auto lru_it = cache_map_.find(lru_path);
-                if (lru_it != cache_map_.end()) {
-                    SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                              "Evicting LRU item: " + lru_path +
-                              ", size: " + std::to_string(lru_it->second.file.size) +
-                              " [CONCURRENCY CRITICAL: Removing item from cache_map]");
-                    current_cache_size_ -= lru_it->second.file.size;
-                    cache_map_.erase(lru_it);
-                    SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                              "Successfully evicted item: " + lru_path +
-                              ", new cache size: " + std::to_string(current_cache_size_));
+bool CacheManager::insert_locked(Shard& shard, const std::string& key, SharedBlob data,
+                                 const std::string& tenant) {
+    auto existing = shard.map.find(key);
+    if (existing != shard.map.end()) {
+        erase_locked(shard, existing);
+    }
+    const size_t size = data->size();
+    if (size > shard.max_bytes) {
+        return false;
+    }
+    if (!shard.sketch) {
+        evict_to_locked(shard, shard.max_bytes - size);
+    }
+
+    auto& entry = shard.map[key];
+    entry.file.path = key;
+    entry.file.data = std::move(data);
+    entry.file.size = size;
+    entry.file.tenant = tenant;
+    entry.file.last_accessed = std::chrono::steady_clock::now();
+    entry.in_window = shard.sketch != nullptr;
+    LruList& list = entry.in_window ? shard.window : shard.lru;
+    list.push_front(key);
+    entry.lru_iter = list.begin();
+
+    shard.size_bytes += size;
+    if (entry.in_window) shard.window_bytes += size;
+    ++shard.insertions;
+    if (shard.sketch) drain_window_locked(shard);
+    return true;
+}
+
+void CacheManager::drain_window_locked(Shard& shard) {
+    const size_t main_max = shard.max_bytes - shard.window_max_bytes;
+    while (shard.window_bytes > shard.window_max_bytes && !shard.window.empty()) {
+        auto candidate = shard.map.find(shard.window.back());
+        const size_t size = candidate->second.file.size;
+        shard.window.pop_back();
+        shard.window_bytes -= size;
+        shard.size_bytes -= size;
+
+        // Victims the candidate would displace, least recently used first.
+        // It is admitted only if it is more popular than each of them.
+        bool admit = size <= main_max;
+        size_t main_bytes = shard.size_bytes - shard.window_bytes;
+        size_t freed = 0;
+        size_t victims = 0;
+        if (admit && main_bytes + size > main_max) {
+            const uint32_t candidate_freq = shard.sketch->estimate(candidate->first);
+            for (auto it = shard.lru.rbegin(); it != shard.lru.rend() && main_bytes - freed + size > main_max; ++it) {
+                if (shard.sketch->estimate(*it) >= candidate_freq) {
+                    admit = false;
+                    break;
                 }
+                freed += shard.map.find(*it)->second.file.size;
+                ++victims;
             }
-        } else {
-            SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                      "Another thread freed enough space, skipping eviction");
         }
+        if (!admit) {
+            shard.map.erase(candidate);
+            ++shard.rejections;
+            continue;
+        }
+        for (; victims > 0; --victims) {
+            shard.map.erase(shard.lru.back());
+            shard.lru.pop_back();
+            ++shard.evictions;
+        }
+        shard.size_bytes -= freed;
+
+        shard.lru.push_front(candidate->first);
+        candidate->second.lru_iter = shard.lru.begin();
+        candidate->second.in_window = false;
+        shard.size_bytes += size;
     }
+}
 
-    // Re-acquire the lock to add the new file
-    SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-              "Re-acquiring lock to add new file [CONCURRENCY CRITICAL: State may have changed]");
-    lock.lock();
-
-    // Try to add the file again after making space
-    if (current_cache_size_ + data_size <= max_cache_size_bytes_) {
-        SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Sufficient space found after eviction, adding file: " + storage_path);
-        // Add new item
-        auto& entry = cache_map_[storage_path];
-        entry.file.path = storage_path;
-        entry.file.data = data;
-        entry.file.size = data_size;
-        entry.file.tenant = tenant;
-        entry.file.last_accessed = std::chrono::steady_clock::now();
-
-        lru_list_.push_front(storage_path);
-        entry.lru_iter = lru_list_.begin();
-
-        current_cache_size_ += data_size;
-
-        SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Successfully added file to cache after eviction: " + storage_path +
-                  ", final cache size: " + std::to_string(current_cache_size_));
-        return Result<void>::ok();
+void CacheManager::touch_locked(Shard& shard, EntryMap::iterator it) {
+    LruList& list = it->second.in_window ? shard.window : shard.lru;
+    list.splice(list.begin(), list, it->second.lru_iter);
+    it->second.file.last_accessed = std::chrono::steady_clock::now();
+}
+
+void CacheManager::erase_locked(Shard& shard, EntryMap::iterator it) {
+    const size_t size = it->second.file.size;
+    if (it->second.in_window) {
+        shard.window.erase(it->second.lru_iter);
+        shard.window_bytes -= size;
+    } else {
+        shard.lru.erase(it->second.lru_iter);
     }
+    shard.size_bytes -= size;
+    shard.map.erase(it);
+}
 
-    SERVER_LOG_DEBUG("CacheManager::add_file", ServerLogger::getInstance().detailed_log_prefix() +
-              "Still insufficient space after eviction for: " + storage_path +
-              ", cache size: " + std::to_string(current_cache_size_) +
-              ", required: " + std::to_string(data_size));
-    return Result<void>::err("Not enough space in cache even after eviction");
+void CacheManager::evict_to_locked(Shard& shard, size_t limit) {
+    while (shard.size_bytes > limit && !(shard.lru.empty() && shard.window.empty())) {
+        LruList& list = shard.lru.empty() ? shard.window : shard.lru;
+        erase_locked(shard, shard.map.find(list.back()));
+        ++shard.evictions;
+    }
 }
 
 Result<void> CacheManager::remove_file(const std::string& storage_path) {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
+    Shard& shard = shard_for(storage_path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    auto it = cache_map_.find(storage_path);
-    if (it == cache_map_.end()) {
+    auto it = shard.map.find(storage_path);
+    if (it == shard.map.end()) {
         return Result<void>::ok();  // File not in cache, nothing to remove
     }
-    
-    // Update size
-    current_cache_size_ -= it->second.file.size;
-    
-    // Remove from LRU list
-    lru_list_.erase(it->second.lru_iter);
-    
-    // Remove from cache map
-    cache_map_.erase(it);
+    erase_locked(shard, it);
     
     return Result<void>::ok();
 }
 
 bool CacheManager::is_cached(const std::string& storage_path) const {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
-    return cache_map_.find(storage_path) != cache_map_.end();
+    Shard& shard = shard_for(storage_path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.map.find(storage_path) != shard.map.end();
 }
 
 double CacheManager::get_cache_usage_percentage() const {
-    if (max_cache_size_bytes_ == 0) return 0.0;
-    return static_cast<double>(current_cache_size_) / static_cast<double>(max_cache_size_bytes_);
+    const size_t max_bytes = get_max_cache_size_bytes();
+    if (max_bytes == 0) return 0.0;
+    return static_cast<double>(get_cache_size_bytes()) / static_cast<double>(max_bytes);
 }
 
 size_t CacheManager::get_cache_size_bytes() const {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
-    return current_cache_size_;
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->size_bytes;
+    }
+    return total;
 }
 
 size_t CacheManager::get_max_cache_size_bytes() const {
-    return max_cache_size_bytes_;
+    return max_cache_size_bytes_.load(std::memory_order_relaxed);
+}
+
+void CacheManager::set_max_cache_size_bytes(size_t max_cache_size_bytes) {
+    max_cache_size_bytes_.store(max_cache_size_bytes, std::memory_order_relaxed);
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        resize_locked(*shard, max_cache_size_bytes / shards_.size());
+        evict_to_locked(*shard, shard->max_bytes);
+        if (shard->sketch) drain_window_locked(*shard);
+    }
 }
 
 void CacheManager::set_cache_threshold(double threshold) {
     if (threshold >= 0.0 && threshold <= 1.0) {
-        threshold_ = threshold;
+        threshold_.store(threshold, std::memory_order_relaxed);
         // Trigger cleanup if we're over the new threshold
-        if (get_cache_usage_percentage() > threshold_) {
+        if (get_cache_usage_percentage() > threshold) {
             cleanup_cache();
         }
     }
 }
 
 Result<void> CacheManager::cleanup_cache() {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
-    
-    // Evict LRU items until we're below the threshold
-    evict_lru_items();
-    
+    // Evict LRU items until each shard is below the threshold
+    const double threshold = threshold_.load(std::memory_order_relaxed);
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        evict_to_locked(*shard, static_cast<size_t>(shard->max_bytes * threshold));
+    }
     return Result<void>::ok();
 }
 
@@ -348,52 +457,13 @@ Result<std::vector<uint8_t>> CacheManager::fetch_from_object_store_if_missing(co
 }
 
 void CacheManager::update_access_time(const std::string& storage_path) {
-    std::lock_guard<std::mutex> lock(cache_mutex_);
-    
-    auto it = cache_map_.find(storage_path);
-    if (it != cache_map_.end()) {
-        // Update LRU position
-        lru_list_.erase(it->second.lru_iter);
-        lru_list_.push_front(storage_path);
-        it->second.lru_iter = lru_list_.begin();
-        
-        // Update access time
-        it->second.file.last_accessed = std::chrono::steady_clock::now();
-    }
-}
-
-void CacheManager::calculate_max_cache_size() {
-    max_cache_size_bytes_ = get_available_system_storage();
-}
-
-size_t CacheManager::get_available_system_storage() const {
-    struct statvfs fs_info;
-    
-    // Use a default path, or get from configuration in a real implementation
-    const char* path = "/tmp";  // This would be configurable in a real system
-    if (statvfs(path, &fs_info) == 0) {
-        // Return total space (would be configurable in reality)
-        return static_cast<size_t>(fs_info.f_blocks) * fs_info.f_frsize;
-    }
+    Shard& shard = shard_for(storage_path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    // Default to 1 GB if we can't determine
-    return 1024 * 1024 * 1024; // 1 GB
-}
-
-void CacheManager::evict_lru_items() {
-    // Evict items until we're below the threshold
-    while (!lru_list_.empty() &&
-           current_cache_size_ > max_cache_size_bytes_ * threshold_) {
-
-        std::string lru_path = lru_list_.back();
-        lru_list_.pop_back();
-
-        auto lru_it = cache_map_.find(lru_path);
-        if (lru_it != cache_map_.end()) {
-            current_cache_size_ -= lru_it->second.file.size;
-            cache_map_.erase(lru_it);
-        }
+    auto it = shard.map.find(storage_path);
+    if (it != shard.map.end()) {
+        touch_locked(shard, it);
     }
 }
 
-} // namespace fileengine
\ No newline at end of file
+} // namespace fileengine
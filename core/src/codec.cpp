@@ -0,0 +1,202 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/codec.h"
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+namespace fileengine {
+
+#ifdef FILEENGINE_HAS_ZSTD
+std::shared_ptr<const Codec> make_zstd_codec(int level);  // codec_zstd.cpp
+#endif
+#ifdef FILEENGINE_HAS_LZ4
+std::shared_ptr<const Codec> make_lz4_codec(int level);   // codec_lz4.cpp
+#endif
+
+namespace {
+
+class ZlibCodec : public Codec {
+public:
+    // 0 selects zlib's default, level 6.
+    explicit ZlibCodec(int level) : level_(level <= 0 ? 6 : std::min(level, 9)) {}
+
+    CodecId id() const override { return CodecId::Zlib; }
+    int level() const override { return level_; }
+
+    bool compress(const uint8_t* in, size_t n, std::vector<uint8_t>& out) const override {
+        uLongf len = compressBound(n);
+        out.resize(len);
+        if (compress2(out.data(), &len, in, n, level_) != Z_OK || len >= n) return false;
+        out.resize(len);
+        return true;
+    }
+
+    bool decompress(const uint8_t* in, size_t n, uint8_t* out, size_t plain_len) const override {
+        uLongf len = plain_len;
+        return uncompress(out, &len, in, n) == Z_OK && len == plain_len;
+    }
+
+private:
+    int level_;
+};
+
+// Bits per byte above which a sample is treated as already compressed.
+// Text and typical binaries stay well below 7; compressed and encrypted data
+// sit just under 8.
+constexpr double kIncompressibleEntropy = 7.5;
+constexpr size_t kEntropyWindows = 8;
+constexpr size_t kEntropyWindowSize = 512;
+
+} // namespace
+
+std::shared_ptr<const Codec> Codec::make(CodecId id, int level) {
+    switch (id) {
+        case CodecId::Zlib:
+            return std::make_shared<ZlibCodec>(level);
+#ifdef FILEENGINE_HAS_ZSTD
+        case CodecId::Zstd:
+            return make_zstd_codec(level);
+#endif
+#ifdef FILEENGINE_HAS_LZ4
+        case CodecId::Lz4:
+            return make_lz4_codec(level);
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+Result<std::shared_ptr<const Codec>> Codec::from_spec(const std::string& spec) {
+    using R = Result<std::shared_ptr<const Codec>>;
+    std::string name = spec;
+    int level = 0;
+    auto colon = spec.find(':');
+    if (colon != std::string::npos) {
+        name = spec.substr(0, colon);
+        try {
+            level = std::stoi(spec.substr(colon + 1));
+        } catch (...) {
+            return R::err("Invalid compression level in '" + spec + "'");
+        }
+    }
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    CodecId id;
+    if (name == "none") return R::ok(nullptr);
+    else if (name == "zlib") id = CodecId::Zlib;
+    else if (name == "zstd") id = CodecId::Zstd;
+    else if (name == "lz4") id = CodecId::Lz4;
+    else return R::err("Unknown compression codec '" + name + "'");
+
+    auto codec = make(id, level);
+    if (!codec) {
+        return R::err(std::string("Compression codec ") + Codec::name(id) + " is not available in this build");
+    }
+    return R::ok(codec);
+}
+
+const Codec* Codec::decoder(CodecId id) {
+    static const std::array<std::shared_ptr<const Codec>, 4> decoders = {
+        nullptr, make(CodecId::Zlib), make(CodecId::Zstd), make(CodecId::Lz4)};
+    size_t i = static_cast<size_t>(id);
+    return i < decoders.size() ? decoders[i].get() : nullptr;
+}
+
+bool Codec::available(CodecId id) {
+    return id == CodecId::None || decoder(id) != nullptr;
+}
+
+const char* Codec::name(CodecId id) {
+    switch (id) {
+        case CodecId::None: return "none";
+        case CodecId::Zlib: return "zlib";
+        case CodecId::Zstd: return "zstd";
+        case CodecId::Lz4: return "lz4";
+    }
+    return "unknown";
+}
+
+bool has_compressed_signature(const uint8_t* p, size_t n) {
+    auto starts = [&](size_t off, const char* magic, size_t len) {
+        return n >= off + len && std::memcmp(p + off, magic, len) == 0;
+    };
+    return starts(0, "\xFF\xD8\xFF", 3) ||                       // JPEG
+           starts(0, "\x89PNG\r\n\x1A\n", 8) ||                  // PNG
+           starts(0, "GIF8", 4) ||                               // GIF
+           (starts(0, "RIFF", 4) && starts(8, "WEBP", 4)) ||     // WebP
+           starts(4, "ftyp", 4) ||                               // MP4, MOV, HEIC, 3GP
+           starts(0, "\x1A\x45\xDF\xA3", 4) ||                   // Matroska, WebM
+           starts(0, "ID3", 3) || starts(0, "\xFF\xFB", 2) ||    // MP3
+           starts(0, "OggS", 4) || starts(0, "fLaC", 4) ||       // Ogg, FLAC
+           starts(0, "PK\x03\x04", 4) ||                         // ZIP, docx/xlsx, jar, apk
+           starts(0, "\x1F\x8B", 2) ||                           // gzip
+           starts(0, "BZh", 3) ||                                // bzip2
+           starts(0, "\xFD" "7zXZ\x00", 6) ||                    // xz
+           starts(0, "\x28\xB5\x2F\xFD", 4) ||                   // zstd
+           starts(0, "\x04\x22\x4D\x18", 4) ||                   // lz4 frame
+           starts(0, "7z\xBC\xAF\x27\x1C", 6) ||                 // 7z
+           starts(0, "Rar!\x1A\x07", 6);                         // RAR
+}
+
+bool looks_incompressible(const uint8_t* data, size_t n) {
+    if (n < kEntropyWindowSize) return false;  // too little to judge; just try
+
+    // Byte histogram for order-0 entropy, and distinct byte pairs: periodic
+    // or table-like data can use every byte value evenly (entropy near 8)
+    // yet repeat the same few pairs, which is exactly what LZ matching eats.
+    std::array<uint32_t, 256> counts{};
+    std::bitset<65536> pairs_seen;
+    size_t sampled = 0, pairs = 0, distinct_pairs = 0;
+    auto sample = [&](const uint8_t* window, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            ++counts[window[i]];
+            if (i + 1 < len) {
+                size_t pair = static_cast<size_t>(window[i]) << 8 | window[i + 1];
+                ++pairs;
+                if (!pairs_seen.test(pair)) {
+                    pairs_seen.set(pair);
+                    ++distinct_pairs;
+                }
+            }
+        }
+        sampled += len;
+    };
+    if (n <= kEntropyWindows * kEntropyWindowSize) {
+        sample(data, n);
+    } else {
+        const size_t stride = (n - kEntropyWindowSize) / (kEntropyWindows - 1);
+        for (size_t w = 0; w < kEntropyWindows; ++w) sample(data + w * stride, kEntropyWindowSize);
+    }
+
+    // Random data repeats few pairs among a few thousand samples (~97% are
+    // distinct at 4 KiB); anything with structure repeats many.
+    if (distinct_pairs < pairs * 9 / 10) return false;
+
+    double entropy = 0;
+    for (uint32_t c : counts) {
+        if (c == 0) continue;
+        double p = static_cast<double>(c) / static_cast<double>(sampled);
+        entropy -= p * std::log2(p);
+    }
+    return entropy > kIncompressibleEntropy;
+}
+
+} // namespace fileengine
@@ -0,0 +1,69 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/codec.h"
+#include <lz4.h>
+#include <lz4hc.h>
+#include <algorithm>
+#include <limits>
+
+namespace fileengine {
+
+namespace {
+
+// Levels 0-2 use the fast LZ4 compressor; higher levels select LZ4HC, which
+// compresses slower but decodes just as fast.
+class Lz4Codec : public Codec {
+public:
+    explicit Lz4Codec(int level) : level_(std::max(0, std::min(level, LZ4HC_CLEVEL_MAX))) {}
+
+    CodecId id() const override { return CodecId::Lz4; }
+    int level() const override { return level_; }
+
+    bool compress(const uint8_t* in, size_t n, std::vector<uint8_t>& out) const override {
+        if (n > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) return false;
+        const int src_len = static_cast<int>(n);
+        out.resize(static_cast<size_t>(LZ4_compressBound(src_len)));
+        const char* src = reinterpret_cast<const char*>(in);
+        char* dst = reinterpret_cast<char*>(out.data());
+        const int cap = static_cast<int>(out.size());
+        int len = level_ < LZ4HC_CLEVEL_MIN ? LZ4_compress_default(src, dst, src_len, cap)
+                                           : LZ4_compress_HC(src, dst, src_len, cap, level_);
+        if (len <= 0 || static_cast<size_t>(len) >= n) return false;
+        out.resize(static_cast<size_t>(len));
+        return true;
+    }
+
+    bool decompress(const uint8_t* in, size_t n, uint8_t* out, size_t plain_len) const override {
+        if (n > static_cast<size_t>(std::numeric_limits<int>::max()) ||
+            plain_len > static_cast<size_t>(std::numeric_limits<int>::max())) {
+            return false;
+        }
+        int len = LZ4_decompress_safe(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out),
+                                      static_cast<int>(n), static_cast<int>(plain_len));
+        return len >= 0 && static_cast<size_t>(len) == plain_len;
+    }
+
+private:
+    int level_;
+};
+
+} // namespace
+
+std::shared_ptr<const Codec> make_lz4_codec(int level) {
+    return std::make_shared<Lz4Codec>(level);
+}
+
+} // namespace fileengine
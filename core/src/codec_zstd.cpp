@@ -0,0 +1,70 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/codec.h"
+#include <zstd.h>
+#include <algorithm>
+
+namespace fileengine {
+
+namespace {
+
+class ZstdCodec : public Codec {
+public:
+    explicit ZstdCodec(int level)
+        : level_(level <= 0 ? ZSTD_CLEVEL_DEFAULT : std::min(level, ZSTD_maxCLevel())) {}
+
+    CodecId id() const override { return CodecId::Zstd; }
+    int level() const override { return level_; }
+
+    bool compress(const uint8_t* in, size_t n, std::vector<uint8_t>& out) const override {
+        out.resize(ZSTD_compressBound(n));
+        size_t len = ZSTD_compressCCtx(contexts().cctx, out.data(), out.size(), in, n, level_);
+        if (ZSTD_isError(len) || len >= n) return false;
+        out.resize(len);
+        return true;
+    }
+
+    bool decompress(const uint8_t* in, size_t n, uint8_t* out, size_t plain_len) const override {
+        size_t len = ZSTD_decompressDCtx(contexts().dctx, out, plain_len, in, n);
+        return !ZSTD_isError(len) && len == plain_len;
+    }
+
+private:
+    // Contexts are reused per thread: creating one per frame costs more than
+    // compressing a small frame.
+    struct Contexts {
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        ZSTD_DCtx* dctx = ZSTD_createDCtx();
+        ~Contexts() {
+            ZSTD_freeCCtx(cctx);
+            ZSTD_freeDCtx(dctx);
+        }
+    };
+    static Contexts& contexts() {
+        thread_local Contexts ctx;
+        return ctx;
+    }
+
+    int level_;
+};
+
+} // namespace
+
+std::shared_ptr<const Codec> make_zstd_codec(int level) {
+    return std::make_shared<ZstdCodec>(level);
+}
+
+} // namespace fileengine
@@ -85,6 +85,41 @@ static void apply_events_config(const std::map<std::string, std::string>& vars,
     if (auto v = get("FILEENGINE_AUDIT_HIDDEN_CHILDREN")) config.audit_hidden_children = (*v == "true" || *v == "1");
 }
 
+// Apply the optional local-storage tuning keys from a parsed key/value map onto
+// the config. Same shape as apply_events_config so every source (system file,
+// .env, --config file, process env) honors them identically.
+static void apply_storage_config(const std::map<std::string, std::string>& vars, Config& config) {
+    auto get = [&](const char* k) -> const std::string* {
+        auto it = vars.find(k);
+        return it == vars.end() ? nullptr : &it->second;
+    };
+    if (auto v = get("FILEENGINE_STORAGE_DEDUP")) config.storage_deduplicate = (*v == "true" || *v == "TRUE" || *v == "1");
+    if (auto v = get("FILEENGINE_STORAGE_SYNC")) config.storage_sync_mode = *v;
+    if (auto v = get("FILEENGINE_STORAGE_IO")) config.storage_io_backend = *v;
+    if (auto v = get("FILEENGINE_STORAGE_FRAME_KB")) {
+        try { config.storage_frame_kb = std::stoi(*v); } catch (...) {}
+    }
+    if (auto v = get("FILEENGINE_STORAGE_CODEC")) config.storage_codec = *v;
+    if (auto v = get("FILEENGINE_STORAGE_ENCODE_THREADS")) {
+        try { config.storage_encode_threads = std::stoi(*v); } catch (...) {}
+    }
+    if (auto v = get("FILEENGINE_STORAGE_PACK_KB")) {
+        try { config.storage_pack_kb = std::stoi(*v); } catch (...) {}
+    }
+    if (auto v = get("FILEENGINE_STORAGE_PACK_COMPACT_SECONDS")) {
+        try { config.storage_pack_compact_seconds = std::stoi(*v); } catch (...) {}
+    }
+}
+
+// Apply the optional database tuning keys from a parsed key/value map onto the
+// config, the same way as apply_storage_config.
+static void apply_database_config(const std::map<std::string, std::string>& vars, Config& config) {
+    auto it = vars.find("FILEENGINE_DB_PREPARED_STATEMENTS");
+    if (it != vars.end()) {
+        config.db_prepared_statements = (it->second == "true" || it->second == "TRUE" || it->second == "1");
+    }
+}
+
 std::map<std::string, std::string> ConfigLoader::parse_env_file(const std::string& filepath) {
     std::map<std::string, std::string> env_vars;
     std::ifstream file(filepath);
@@ -213,6 +248,30 @@ Config ConfigLoader::load_from_file(const std::string& filepath) {
     it = env_vars.find("FILEENGINE_MAX_CACHE_SIZE_MB");
     if (it != env_vars.end()) config.max_cache_size_mb = std::stoul(it->second);
 
+    it = env_vars.find("FILEENGINE_CACHE_POLICY");
+    if (it != env_vars.end()) config.cache_policy = it->second;
+
+    it = env_vars.find("FILEENGINE_METADATA_CACHE_ENTRIES");
+    if (it != env_vars.end()) config.metadata_cache_entries = std::stoul(it->second);
+
+    it = env_vars.find("FILEENGINE_METADATA_CACHE_TTL_MS");
+    if (it != env_vars.end()) config.metadata_cache_ttl_ms = std::stoi(it->second);
+
+    it = env_vars.find("FILEENGINE_NEGATIVE_CACHE_TTL_MS");
+    if (it != env_vars.end()) config.negative_cache_ttl_ms = std::stoi(it->second);
+
+    it = env_vars.find("FILEENGINE_ACL_CACHE_ENTRIES");
+    if (it != env_vars.end()) config.acl_cache_entries = std::stoul(it->second);
+
+    it = env_vars.find("FILEENGINE_ACL_CACHE_TTL_MS");
+    if (it != env_vars.end()) config.acl_cache_ttl_ms = std::stoi(it->second);
+
+    it = env_vars.find("FILEENGINE_ROLE_CACHE_ENTRIES");
+    if (it != env_vars.end()) config.role_cache_entries = std::stoul(it->second);
+
+    it = env_vars.find("FILEENGINE_ROLE_CACHE_TTL_MS");
+    if (it != env_vars.end()) config.role_cache_ttl_ms = std::stoi(it->second);
+
     it = env_vars.find("FILEENGINE_MULTI_TENANT_ENABLED");
     if (it != env_vars.end()) config.multi_tenant_enabled = (it->second == "true" || it->second == "1");
 
@@ -263,6 +322,10 @@ Config ConfigLoader::load_from_file(const std::string& filepath) {
     // Event queueing (optional). Redis connection uses the REDDIS_* keys.
     apply_events_config(env_vars, config);
 
+    // Local storage tuning (optional)
+    apply_storage_config(env_vars, config);
+    apply_database_config(env_vars, config);
+
     return config;
 }
 
@@ -323,6 +386,30 @@ Config ConfigLoader::load_from_env() {
     env_value = get_env_var("FILEENGINE_MAX_CACHE_SIZE_MB", "");
     if (!env_value.empty()) config.max_cache_size_mb = std::stoul(env_value);
 
+    env_value = get_env_var("FILEENGINE_CACHE_POLICY", "");
+    if (!env_value.empty()) config.cache_policy = env_value;
+
+    env_value = get_env_var("FILEENGINE_METADATA_CACHE_ENTRIES", "");
+    if (!env_value.empty()) config.metadata_cache_entries = std::stoul(env_value);
+
+    env_value = get_env_var("FILEENGINE_METADATA_CACHE_TTL_MS", "");
+    if (!env_value.empty()) config.metadata_cache_ttl_ms = std::stoi(env_value);
+
+    env_value = get_env_var("FILEENGINE_NEGATIVE_CACHE_TTL_MS", "");
+    if (!env_value.empty()) config.negative_cache_ttl_ms = std::stoi(env_value);
+
+    env_value = get_env_var("FILEENGINE_ACL_CACHE_ENTRIES", "");
+    if (!env_value.empty()) config.acl_cache_entries = std::stoul(env_value);
+
+    env_value = get_env_var("FILEENGINE_ACL_CACHE_TTL_MS", "");
+    if (!env_value.empty()) config.acl_cache_ttl_ms = std::stoi(env_value);
+
+    env_value = get_env_var("FILEENGINE_ROLE_CACHE_ENTRIES", "");
+    if (!env_value.empty()) config.role_cache_entries = std::stoul(env_value);
+
+    env_value = get_env_var("FILEENGINE_ROLE_CACHE_TTL_MS", "");
+    if (!env_value.empty()) config.role_cache_ttl_ms = std::stoi(env_value);
+
     env_value = get_env_var("FILEENGINE_MULTI_TENANT_ENABLED", "");
     if (!env_value.empty()) config.multi_tenant_enabled = (env_value == "true" || env_value == "1");
 
@@ -409,6 +496,28 @@ Config ConfigLoader::load_from_env() {
         apply_events_config(ev, config);
     }
 
+    // Local storage tuning (optional), same collect-and-apply approach.
+    {
+        std::map<std::string, std::string> st;
+        for (const char* key : {"FILEENGINE_STORAGE_DEDUP", "FILEENGINE_STORAGE_SYNC", "FILEENGINE_STORAGE_IO",
+                                "FILEENGINE_STORAGE_FRAME_KB", "FILEENGINE_STORAGE_ENCODE_THREADS",
+                                "FILEENGINE_STORAGE_CODEC", "FILEENGINE_STORAGE_PACK_KB",
+                                "FILEENGINE_STORAGE_PACK_COMPACT_SECONDS"}) {
+            const char* v = std::getenv(key);
+            if (v && *v) st[key] = v;
+        }
+        apply_storage_config(st, config);
+    }
+
+    // Database tuning (optional)
+    {
+        std::map<std::string, std::string> db;
+        if (const char* v = std::getenv("FILEENGINE_DB_PREPARED_STATEMENTS"); v && *v) {
+            db["FILEENGINE_DB_PREPARED_STATEMENTS"] = v;
+        }
+        apply_database_config(db, config);
+    }
+
     return config;
 }
 
@@ -540,6 +649,30 @@ Config ConfigLoader::load_config(int argc, char* argv[]) {
     it = default_file_vars.find("FILEENGINE_MAX_CACHE_SIZE_MB");
     if (it != default_file_vars.end()) config.max_cache_size_mb = std::stoul(it->second);
 
+    it = default_file_vars.find("FILEENGINE_CACHE_POLICY");
+    if (it != default_file_vars.end()) config.cache_policy = it->second;
+
+    it = default_file_vars.find("FILEENGINE_METADATA_CACHE_ENTRIES");
+    if (it != default_file_vars.end()) config.metadata_cache_entries = std::stoul(it->second);
+
+    it = default_file_vars.find("FILEENGINE_METADATA_CACHE_TTL_MS");
+    if (it != default_file_vars.end()) config.metadata_cache_ttl_ms = std::stoi(it->second);
+
+    it = default_file_vars.find("FILEENGINE_NEGATIVE_CACHE_TTL_MS");
+    if (it != default_file_vars.end()) config.negative_cache_ttl_ms = std::stoi(it->second);
+
+    it = default_file_vars.find("FILEENGINE_ACL_CACHE_ENTRIES");
+    if (it != default_file_vars.end()) config.acl_cache_entries = std::stoul(it->second);
+
+    it = default_file_vars.find("FILEENGINE_ACL_CACHE_TTL_MS");
+    if (it != default_file_vars.end()) config.acl_cache_ttl_ms = std::stoi(it->second);
+
+    it = default_file_vars.find("FILEENGINE_ROLE_CACHE_ENTRIES");
+    if (it != default_file_vars.end()) config.role_cache_entries = std::stoul(it->second);
+
+    it = default_file_vars.find("FILEENGINE_ROLE_CACHE_TTL_MS");
+    if (it != default_file_vars.end()) config.role_cache_ttl_ms = std::stoi(it->second);
+
     it = default_file_vars.find("FILEENGINE_MULTI_TENANT_ENABLED");
     if (it != default_file_vars.end()) config.multi_tenant_enabled = (it->second == "true" || it->second == "1");
 
@@ -601,6 +734,8 @@ Config ConfigLoader::load_config(int argc, char* argv[]) {
 
     // Event queueing (optional) from .env
     apply_events_config(default_file_vars, config);
+    apply_storage_config(default_file_vars, config);
+    apply_database_config(default_file_vars, config);
 
     // 3. Load from config file specified on command line with --config or -c (overrides .env and system config)
     std::string config_file = ".env"; // Default if no --config specified
@@ -673,6 +808,30 @@ Config ConfigLoader::load_config(int argc, char* argv[]) {
     it = cmdline_file_vars.find("FILEENGINE_MAX_CACHE_SIZE_MB");
     if (it != cmdline_file_vars.end()) config.max_cache_size_mb = std::stoul(it->second);
 
+    it = cmdline_file_vars.find("FILEENGINE_CACHE_POLICY");
+    if (it != cmdline_file_vars.end()) config.cache_policy = it->second;
+
+    it = cmdline_file_vars.find("FILEENGINE_METADATA_CACHE_ENTRIES");
+    if (it != cmdline_file_vars.end()) config.metadata_cache_entries = std::stoul(it->second);
+
+    it = cmdline_file_vars.find("FILEENGINE_METADATA_CACHE_TTL_MS");
+    if (it != cmdline_file_vars.end()) config.metadata_cache_ttl_ms = std::stoi(it->second);
+
+    it = cmdline_file_vars.find("FILEENGINE_NEGATIVE_CACHE_TTL_MS");
+    if (it != cmdline_file_vars.end()) config.negative_cache_ttl_ms = std::stoi(it->second);
+
+    it = cmdline_file_vars.find("FILEENGINE_ACL_CACHE_ENTRIES");
+    if (it != cmdline_file_vars.end()) config.acl_cache_entries = std::stoul(it->second);
+
+    it = cmdline_file_vars.find("FILEENGINE_ACL_CACHE_TTL_MS");
+    if (it != cmdline_file_vars.end()) config.acl_cache_ttl_ms = std::stoi(it->second);
+
+    it = cmdline_file_vars.find("FILEENGINE_ROLE_CACHE_ENTRIES");
+    if (it != cmdline_file_vars.end()) config.role_cache_entries = std::stoul(it->second);
+
+    it = cmdline_file_vars.find("FILEENGINE_ROLE_CACHE_TTL_MS");
+    if (it != cmdline_file_vars.end()) config.role_cache_ttl_ms = std::stoi(it->second);
+
     it = cmdline_file_vars.find("FILEENGINE_MULTI_TENANT_ENABLED");
     if (it != cmdline_file_vars.end()) config.multi_tenant_enabled = (it->second == "true" || it->second == "1");
 
@@ -734,6 +893,8 @@ Config ConfigLoader::load_config(int argc, char* argv[]) {
 
     // Event queueing (optional) from the --config file
     apply_events_config(cmdline_file_vars, config);
+    apply_storage_config(cmdline_file_vars, config);
+    apply_database_config(cmdline_file_vars, config);
 
     // 4. Load from environment variables (overrides config files)
     Config env_config = load_from_env();
@@ -754,6 +915,14 @@ Config ConfigLoader::load_config(int argc, char* argv[]) {
     if (!env_config.s3_path_style) config.s3_path_style = env_config.s3_path_style;
     if (env_config.cache_threshold != 0.8) config.cache_threshold = env_config.cache_threshold;
     if (env_config.max_cache_size_mb != 1024) config.max_cache_size_mb = env_config.max_cache_size_mb;
+    if (env_config.cache_policy != "tinylfu") config.cache_policy = env_config.cache_policy;
+    if (env_config.metadata_cache_entries != 100000) config.metadata_cache_entries = env_config.metadata_cache_entries;
+    if (env_config.metadata_cache_ttl_ms != 5000) config.metadata_cache_ttl_ms = env_config.metadata_cache_ttl_ms;
+    if (env_config.negative_cache_ttl_ms != 1000) config.negative_cache_ttl_ms = env_config.negative_cache_ttl_ms;
+    if (env_config.acl_cache_entries != 100000) config.acl_cache_entries = env_config.acl_cache_entries;
+    if (env_config.acl_cache_ttl_ms != 5000) config.acl_cache_ttl_ms = env_config.acl_cache_ttl_ms;
+    if (env_config.role_cache_entries != 100000) config.role_cache_entries = env_config.role_cache_entries;
+    if (env_config.role_cache_ttl_ms != 5000) config.role_cache_ttl_ms = env_config.role_cache_ttl_ms;
     if (!env_config.multi_tenant_enabled) config.multi_tenant_enabled = env_config.multi_tenant_enabled;
     if (!env_config.server_address.empty() && env_config.server_address != "0.0.0.0") config.server_address = env_config.server_address;
     if (env_config.server_port != 50051) config.server_port = env_config.server_port;
@@ -787,6 +956,17 @@ Config ConfigLoader::load_config(int argc, char* argv[]) {
     if (env_config.events_stream_maxlen != 100000) config.events_stream_maxlen = env_config.events_stream_maxlen;
     if (env_config.events_outbox_capacity != 10000) config.events_outbox_capacity = env_config.events_outbox_capacity;
 
+    // Local storage tuning — process-env overrides files (compared against defaults)
+    if (env_config.storage_deduplicate) config.storage_deduplicate = true;
+    if (env_config.storage_sync_mode != "group") config.storage_sync_mode = env_config.storage_sync_mode;
+    if (env_config.storage_io_backend != "posix") config.storage_io_backend = env_config.storage_io_backend;
+    if (env_config.storage_frame_kb != 256) config.storage_frame_kb = env_config.storage_frame_kb;
+    if (env_config.storage_encode_threads != 0) config.storage_encode_threads = env_config.storage_encode_threads;
+    if (env_config.storage_codec != "zlib") config.storage_codec = env_config.storage_codec;
+    if (env_config.storage_pack_kb != 0) config.storage_pack_kb = env_config.storage_pack_kb;
+    if (env_config.storage_pack_compact_seconds != 600) config.storage_pack_compact_seconds = env_config.storage_pack_compact_seconds;
+    if (!env_config.db_prepared_statements) config.db_prepared_statements = false;
+
     // 5. Load from command-line arguments (highest priority)
     Config cmd_config = load_from_cmd_args(argc, argv);
     if (!cmd_config.db_host.empty()) config.db_host = cmd_config.db_host;
@@ -15,11 +15,13 @@
 
 #include "fileengine/connection_pool.h"
 #include "fileengine/server_logger.h"
+#include <cstring>
 #include <sstream>
 
 namespace fileengine {
 
-DatabaseConnection::DatabaseConnection(const std::string& conninfo) {
+DatabaseConnection::DatabaseConnection(const std::string& conninfo, bool prepare_statements)
+    : prepare_statements_(prepare_statements) {
     SERVER_LOG_DEBUG("DatabaseConnection", "Attempting to connect to database using conninfo: " + conninfo);
     conn_ = PQconnectdb(conninfo.c_str());
     if (!is_valid()) {
@@ -36,6 +38,56 @@ DatabaseConnection::~DatabaseConnection() {
     }
 }
 
+PGresult* DatabaseConnection::exec_cached(const std::string& sql, int n_params,
+                                          const char* const* param_values) {
+    // A broken connection has lost its server session, and with it every
+    // statement prepared on it; the pool replaces it with a fresh
+    // DatabaseConnection (and an empty cache) on release.
+    if (!prepare_statements_ || !is_valid()) {
+        if (!is_valid()) prepared_.clear();
+        return PQexecParams(conn_, sql.c_str(), n_params, nullptr, param_values, nullptr, nullptr, 0);
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        auto it = prepared_.find(sql);
+        if (it == prepared_.end()) {
+            if (prepared_.size() >= kMaxPreparedStatements) {
+                forget_prepared(true);
+            }
+            std::string name = "fe_stmt_" + std::to_string(next_statement_id_++);
+            PGresult* prep = PQprepare(conn_, name.c_str(), sql.c_str(), n_params, nullptr);
+            const bool prepared = PQresultStatus(prep) == PGRES_COMMAND_OK;
+            PQclear(prep);
+            if (!prepared) {
+                // e.g. the tenant's tables do not exist yet. Run it unprepared
+                // so the caller sees the usual error, and try again next time.
+                return PQexecParams(conn_, sql.c_str(), n_params, nullptr, param_values, nullptr, nullptr, 0);
+            }
+            it = prepared_.emplace(sql, std::move(name)).first;
+        }
+
+        PGresult* res = PQexecPrepared(conn_, it->second.c_str(), n_params, param_values, nullptr, nullptr, 0);
+        const char* state = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+        // 26000: the statement is gone server-side (DISCARD ALL, a pooler
+        // handing us another session). 0A000: its cached plan no longer fits
+        // after a schema change. Neither ran anything, so re-prepare once.
+        if (attempt == 0 && state && (std::strcmp(state, "26000") == 0 || std::strcmp(state, "0A000") == 0)) {
+            PQclear(res);
+            prepared_.erase(it);
+            continue;
+        }
+        return res;
+    }
+    return PQexecParams(conn_, sql.c_str(), n_params, nullptr, param_values, nullptr, nullptr, 0);
+}
+
+void DatabaseConnection::forget_prepared(bool deallocate) {
+    if (deallocate && is_valid()) {
+        PQclear(PQexec(conn_, "DEALLOCATE ALL"));
+    }
+    prepared_.clear();
+}
+
 ConnectionPool::ConnectionPool(const std::string& host, int port, const std::string& dbname,
                                const std::string& user, const std::string& password, int pool_size)
     : pool_size_(pool_size), shutdown_flag_(false) {
@@ -55,7 +107,7 @@ bool ConnectionPool::initialize() {
     SERVER_LOG_DEBUG("ConnectionPool", "Initializing connection pool with size: " + std::to_string(pool_size_));
     for (int i = 0; i < pool_size_; ++i) {
         try {
-            auto conn = std::make_shared<DatabaseConnection>(connection_info_);
+            auto conn = std::make_shared<DatabaseConnection>(connection_info_, prepare_statements_);
             available_connections_.push(conn);
             SERVER_LOG_INFO("ConnectionPool", "Successfully initialized connection #" + std::to_string(i + 1) + " for pool.");
         } catch (const std::exception& e) {
@@ -107,7 +159,7 @@ void ConnectionPool::release(std::shared_ptr<DatabaseConnection> conn) {
         // If the connection is invalid, create a new one to replace it
         if (!shutdown_flag_) {
             try {
-                auto new_conn = std::make_shared<DatabaseConnection>(connection_info_);
+                auto new_conn = std::make_shared<DatabaseConnection>(connection_info_, prepare_statements_);
                 std::unique_lock<std::mutex> lock(pool_mutex_);
                 available_connections_.push(new_conn);
             } catch (const std::exception& e) {
@@ -18,16 +18,17 @@
 #include <openssl/evp.h>
 #include <openssl/aes.h>
 #include <openssl/rand.h>
+#include <openssl/core_names.h>
+#include <openssl/kdf.h>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
 
 namespace fileengine {
 
-namespace {
 // Parse a 32-byte AES-256 key from a 64-char hex string or base64 (mirrors the
 // one-shot encrypt_data/decrypt_data logic).
-std::vector<uint8_t> parse_aes256_key(const std::string& key) {
+std::vector<uint8_t> CryptoUtils::parse_aes256_key(const std::string& key) {
     std::vector<uint8_t> key_bytes;
     if (key.length() == 64) {
         key_bytes = CryptoUtils::hex_string_to_bytes(key);
@@ -40,7 +41,28 @@ std::vector<uint8_t> parse_aes256_key(const std::string& key) {
     }
     return key_bytes;
 }
-} // namespace
+
+std::string CryptoUtils::derive_key(const std::string& key, const std::string& label) {
+    std::vector<uint8_t> key_bytes = CryptoUtils::parse_aes256_key(key);
+    EVP_KDF* kdf = EVP_KDF_fetch(NULL, "HKDF", NULL);
+    EVP_KDF_CTX* ctx = kdf ? EVP_KDF_CTX_new(kdf) : nullptr;
+    EVP_KDF_free(kdf);
+    if (!ctx) throw std::runtime_error("Could not initialize HKDF");
+
+    char digest_name[] = "SHA256";
+    std::string info = "fileengine/" + label;
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digest_name, 0),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, key_bytes.data(), key_bytes.size()),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, info.data(), info.size()),
+        OSSL_PARAM_construct_end()
+    };
+    std::string derived(32, '\0');
+    int ok = EVP_KDF_derive(ctx, reinterpret_cast<unsigned char*>(&derived[0]), derived.size(), params);
+    EVP_KDF_CTX_free(ctx);
+    if (ok != 1) throw std::runtime_error("Could not derive key");
+    return derived;
+}
 
 // ----------------------------- CompressStream ------------------------------
 struct CompressStream::Impl {
@@ -150,7 +172,7 @@ struct EncryptStream::Impl {
 };
 
 EncryptStream::EncryptStream(const std::string& key) : impl_(std::make_unique<Impl>()) {
-    std::vector<uint8_t> key_bytes = parse_aes256_key(key);
+    std::vector<uint8_t> key_bytes = CryptoUtils::parse_aes256_key(key);
     impl_->ctx = EVP_CIPHER_CTX_new();
     if (!impl_->ctx) throw std::runtime_error("Could not create cipher context");
     if (EVP_EncryptInit_ex(impl_->ctx, EVP_aes_256_gcm(), NULL, NULL, NULL) != 1 ||
@@ -210,7 +232,7 @@ struct DecryptStream::Impl {
 };
 
 DecryptStream::DecryptStream(const std::string& key) : impl_(std::make_unique<Impl>()) {
-    impl_->key_bytes = parse_aes256_key(key);  // validated up front
+    impl_->key_bytes = CryptoUtils::parse_aes256_key(key);  // validated up front
 }
 
 DecryptStream::~DecryptStream() {
@@ -275,6 +297,71 @@ void DecryptStream::finish(std::vector<uint8_t>& out) {
     if (len > 0) out.insert(out.end(), fin, fin + len);  // GCM final emits 0 bytes
 }
 
+// ----------------------------- ContentHasher -------------------------------
+struct ContentHasher::Impl {
+    EVP_MD_CTX* md = nullptr;     // unkeyed: plain SHA-256
+    EVP_MAC* mac = nullptr;       // keyed: HMAC-SHA256
+    EVP_MAC_CTX* mac_ctx = nullptr;
+};
+
+ContentHasher::ContentHasher(const std::string& key) : impl_(std::make_unique<Impl>()) {
+    if (key.empty()) {
+        impl_->md = EVP_MD_CTX_new();
+        if (!impl_->md || EVP_DigestInit_ex(impl_->md, EVP_sha256(), NULL) != 1) {
+            throw std::runtime_error("Could not initialize SHA-256");
+        }
+        return;
+    }
+    char digest_name[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest_name, 0),
+        OSSL_PARAM_construct_end()
+    };
+    impl_->mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    impl_->mac_ctx = impl_->mac ? EVP_MAC_CTX_new(impl_->mac) : nullptr;
+    if (!impl_->mac_ctx ||
+        EVP_MAC_init(impl_->mac_ctx, reinterpret_cast<const unsigned char*>(key.data()),
+                     key.size(), params) != 1) {
+        throw std::runtime_error("Could not initialize HMAC-SHA256");
+    }
+}
+
+ContentHasher::~ContentHasher() {
+    if (!impl_) return;
+    if (impl_->md) EVP_MD_CTX_free(impl_->md);
+    if (impl_->mac_ctx) EVP_MAC_CTX_free(impl_->mac_ctx);
+    if (impl_->mac) EVP_MAC_free(impl_->mac);
+}
+
+void ContentHasher::update(const uint8_t* data, size_t n) {
+    if (n == 0) return;
+    int ok = impl_->md ? EVP_DigestUpdate(impl_->md, data, n)
+                       : EVP_MAC_update(impl_->mac_ctx, data, n);
+    if (ok != 1) throw std::runtime_error("Could not hash data");
+}
+
+std::string ContentHasher::finish() {
+    std::vector<uint8_t> digest(EVP_MAX_MD_SIZE);
+    size_t len = 0;
+    if (impl_->md) {
+        unsigned int md_len = 0;
+        if (EVP_DigestFinal_ex(impl_->md, digest.data(), &md_len) != 1) {
+            throw std::runtime_error("Could not finalize SHA-256");
+        }
+        len = md_len;
+    } else if (EVP_MAC_final(impl_->mac_ctx, digest.data(), &len, digest.size()) != 1) {
+        throw std::runtime_error("Could not finalize HMAC-SHA256");
+    }
+    digest.resize(len);
+    return CryptoUtils::bytes_to_hex_string(digest);
+}
+
+std::string CryptoUtils::content_digest(const std::vector<uint8_t>& data, const std::string& key) {
+    ContentHasher hasher(key);
+    hasher.update(data.data(), data.size());
+    return hasher.finish();
+}
+
 // Compression functions
 std::vector<uint8_t> CryptoUtils::compress_data(const std::vector<uint8_t>& data) {
     if (data.empty()) {
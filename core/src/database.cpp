@@ -44,6 +44,11 @@ Database::~Database() {
     disconnect();
 }
 
+void Database::set_prepared_statements(bool enabled) {
+    prepared_statements_ = enabled;
+    connection_pool_->set_prepare_statements(enabled);
+}
+
 bool Database::connect() {
     SERVER_LOG_DEBUG("Database", "Attempting to connect to database using connection pool.");
     if (!connection_pool_) {
@@ -174,6 +179,109 @@ Result<void> Database::drop_schema() {
     return Result<void>::err("drop_schema not supported - data storage is immutable");
 }
 
+// SQL expression for the materialized ancestor path of a row whose parent is
+// `parent_param`: the parent's own path plus the parent. A parent with no row
+// (the root) gives an empty path; a parent whose path is still unknown (NULL,
+// not yet backfilled) gives NULL rather than a wrong, truncated path.
+static std::string ancestors_of_sql(const std::string& schema, const std::string& parent_param) {
+    const std::string files = "\"" + schema + "\".files";
+    return "COALESCE("
+           "(SELECT CASE WHEN p.ancestors IS NULL THEN NULL ELSE p.ancestors || p.uid END"
+           "   FROM " + files + " p WHERE p.uid = " + parent_param + "), "
+           "CASE WHEN EXISTS (SELECT 1 FROM " + files + " p WHERE p.uid = " + parent_param + ")"
+           " THEN NULL ELSE '{}'::varchar(64)[] END)";
+}
+
+// Folder rollup: files.subtree_vts / subtree_by hold the newest version (and
+// its reviser) of any non-rendition file beneath a folder, reached through
+// non-deleted sub-folders; '' means the subtree has no versioned file and NULL
+// means "not computed yet" (rows from before the column existed), which makes
+// readers fall back to subtree_newest_version. New versions only ever raise
+// it, so put/restore bump the chain in the same statement as the version
+// insert (rollup_bump_ctes); removals, moves and version deletes can lower it
+// and recompute the affected chain level by level (refresh_folder_rollup).
+//
+// CTEs for a WITH RECURSIVE list that raise the rollup of every folder above
+// the file `file_param` to the version `vts_param` by `by_param`. The walk
+// climbs only while the folder it left is not deleted (a deleted folder's
+// subtree no longer counts for its parent) and UNION dedups so a corrupt
+// parent_uid cycle terminates. Unknown (NULL) rollups are left for the
+// backfill.
+static std::string rollup_bump_ctes(const std::string& schema, const std::string& file_param,
+                                    const std::string& vts_param, const std::string& by_param) {
+    const std::string files = "\"" + schema + "\".files";
+    return
+        "rollup_up(uid, parent_uid, deleted) AS ("
+        "  SELECT p.uid, p.parent_uid, p.deleted FROM " + files + " f"
+        "    JOIN " + files + " p ON p.uid = f.parent_uid"
+        "   WHERE f.uid = " + file_param + " AND f.deleted = FALSE AND f.is_container = FALSE"
+        "     AND p.is_container = TRUE AND p.uid <> f.uid"
+        "  UNION"
+        "  SELECT p.uid, p.parent_uid, p.deleted FROM " + files + " p"
+        "    JOIN rollup_up u ON p.uid = u.parent_uid"
+        "   WHERE u.deleted = FALSE AND p.is_container = TRUE AND p.uid <> u.uid"
+        "), rollup_bumped AS ("
+        "  UPDATE " + files + " a SET subtree_vts = " + vts_param + "::text,"
+        "         subtree_by = " + by_param + "::varchar(255)"
+        "    FROM rollup_up u"
+        "   WHERE a.uid = u.uid AND a.subtree_vts IS NOT NULL AND a.subtree_vts < " + vts_param + "::text"
+        "  RETURNING 1)";
+}
+
+// Recomputes the rollup of `folder_uid` from its direct children (each file's
+// newest version, each sub-folder's stored rollup) and, while that changes
+// the stored value, of each folder above it. Costs one statement per changed
+// level instead of a walk of the whole subtree. A sub-folder whose rollup is
+// still unknown makes the parent unknown too. A write racing a refresh can
+// leave a rollup behind until the next write below it; the backfill tool's
+// --all pass repairs any drift.
+static bool refresh_folder_rollup(PGconn* conn, const std::string& schema, std::string folder_uid) {
+    const std::string files = "\"" + schema + "\".files";
+    const std::string versions = "\"" + schema + "\".versions";
+    const std::string sql =
+        "UPDATE " + files + " d SET subtree_vts = r.vts, subtree_by = r.rby"
+        "  FROM (SELECT CASE WHEN EXISTS (SELECT 1 FROM " + files + " c"
+        "                                  WHERE c.parent_uid = $1 AND c.uid <> $1 AND c.is_container = TRUE"
+        "                                    AND c.deleted = FALSE AND c.subtree_vts IS NULL)"
+        "               THEN NULL ELSE COALESCE(n.vts, '') END AS vts, n.rby"
+        "          FROM (SELECT 1) one LEFT JOIN LATERAL ("
+        "            SELECT x.vts, x.rby FROM ("
+        "              SELECT lv.version_timestamp AS vts, lv.revised_by AS rby FROM " + files + " c"
+        "                JOIN LATERAL (SELECT v.version_timestamp, v.revised_by FROM " + versions + " v"
+        "                               WHERE v.file_uid = c.uid"
+        "                               ORDER BY v.version_timestamp DESC LIMIT 1) lv ON TRUE"
+        "               WHERE c.parent_uid = $1 AND c.uid <> $1 AND c.is_container = FALSE AND c.deleted = FALSE"
+        "              UNION ALL"
+        "              SELECT c.subtree_vts, c.subtree_by FROM " + files + " c"
+        "               WHERE c.parent_uid = $1 AND c.uid <> $1 AND c.is_container = TRUE"
+        "                 AND c.deleted = FALSE AND c.subtree_vts <> ''"
+        "            ) x ORDER BY x.vts DESC LIMIT 1) n ON TRUE) r"
+        " WHERE d.uid = $1 AND d.is_container = TRUE"
+        "   AND (d.subtree_vts, d.subtree_by) IS DISTINCT FROM (r.vts, r.rby)"
+        " RETURNING d.parent_uid, d.deleted;";
+    // Bounded so a corrupt parent_uid cycle cannot spin forever.
+    for (int depth = 0; depth < 4096; ++depth) {
+        const char* params[1] = { folder_uid.c_str() };
+        PGresult* res = PQexecParams(conn, sql.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            SERVER_LOG_WARN("Database::refresh_folder_rollup", ServerLogger::getInstance().detailed_log_prefix() +
+                      "Failed to refresh folder rollup for " + folder_uid + ": " + PQerrorMessage(conn));
+            PQclear(res);
+            return false;
+        }
+        if (PQntuples(res) == 0) {  // unchanged, or not a folder
+            PQclear(res);
+            return true;
+        }
+        std::string parent_uid = PQgetvalue(res, 0, 0);
+        bool deleted = (strcmp(PQgetvalue(res, 0, 1), "t") == 0 || strcmp(PQgetvalue(res, 0, 1), "1") == 0);
+        PQclear(res);
+        if (deleted || parent_uid == folder_uid) return true;
+        folder_uid = parent_uid;
+    }
+    return true;
+}
+
 Result<std::string> Database::insert_file(const std::string& uid, const std::string& name,
                                           const std::string& path, const std::string& parent_uid,
                                           FileType type, const std::string& owner,
@@ -200,11 +308,12 @@ Result<std::string> Database::insert_file(const std::string& uid, const std::str
     std::string schema_name = get_schema_prefix(tenant);
 
     // Prepare SQL with INSERT/ON CONFLICT handling to avoid duplicates
-    std::string insert_sql = "INSERT INTO \"" + schema_name + "\".files (uid, name, parent_uid, size, owner, permission_map, is_container, deleted) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7, $8) "
+    std::string insert_sql = "INSERT INTO \"" + schema_name + "\".files (uid, name, parent_uid, size, owner, permission_map, is_container, deleted, ancestors) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, " + ancestors_of_sql(schema_name, "$3") + ") "
         "ON CONFLICT (uid) DO UPDATE SET "
             "name = EXCLUDED.name, "
             "parent_uid = EXCLUDED.parent_uid, "
+            "ancestors = EXCLUDED.ancestors, "
             "size = EXCLUDED.size, "
             "owner = EXCLUDED.owner, "
             "permission_map = EXCLUDED.permission_map, "
@@ -334,14 +443,16 @@ Result<bool> Database::delete_file(const std::string& uid, const std::string& te
     // Get the schema name for this tenant
     std::string schema_name = get_schema_prefix(tenant);
 
-    // Soft delete - update the deleted flag
-    std::string delete_sql = "UPDATE \"" + schema_name + "\".files SET deleted = TRUE WHERE uid = $1;";
+    // Soft delete - update the deleted flag. The row no longer counts toward
+    // its parent's folder rollup, so that chain is recomputed.
+    std::string delete_sql = "UPDATE \"" + schema_name + "\".files SET deleted = TRUE WHERE uid = $1 RETURNING parent_uid;";
     const char* param_values[1] = {uid.c_str()};
 
     PGresult* res = PQexecParams(pg_conn, delete_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
 
-    if (PQresultStatus(res) == PGRES_COMMAND_OK) {
-        int rows_affected = std::stoi(PQcmdTuples(res));
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        int rows_affected = PQntuples(res);
+        if (rows_affected > 0) refresh_folder_rollup(pg_conn, schema_name, PQgetvalue(res, 0, 0));
         PQclear(res);
         connection_pool_->release(conn);
         return Result<bool>::ok(rows_affected > 0);
@@ -364,13 +475,15 @@ Result<bool> Database::undelete_file(const std::string& uid, const std::string&
     // Get the schema name for this tenant
     std::string schema_name = get_schema_prefix(tenant);
 
-    std::string undelete_sql = "UPDATE \"" + schema_name + "\".files SET deleted = FALSE WHERE uid = $1;";
+    // The restored row counts toward its parent's folder rollup again.
+    std::string undelete_sql = "UPDATE \"" + schema_name + "\".files SET deleted = FALSE WHERE uid = $1 RETURNING parent_uid;";
     const char* param_values[1] = {uid.c_str()};
 
     PGresult* res = PQexecParams(pg_conn, undelete_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
 
-    if (PQresultStatus(res) == PGRES_COMMAND_OK) {
-        int rows_affected = std::stoi(PQcmdTuples(res));
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        int rows_affected = PQntuples(res);
+        if (rows_affected > 0) refresh_folder_rollup(pg_conn, schema_name, PQgetvalue(res, 0, 0));
         PQclear(res);
         connection_pool_->release(conn);
         return Result<bool>::ok(rows_affected > 0);
@@ -388,9 +501,11 @@ static void apply_listing_provenance(FileInfo& info,
                                      int64_t files_created_epoch, int64_t files_updated_epoch,
                                      const char* first_vts, const char* first_by,
                                      const char* last_vts, const char* last_by);
-// A folder's mtime = the newest file anywhere beneath it (recursive). Forward-
-// declared so builders above the definition can apply it to directory rows.
-static void apply_folder_recursive_mtime(FileInfo& info, PGconn* conn, const std::string& schema);
+// A folder's mtime = the newest file anywhere beneath it (recursive), from the
+// row's stored rollup when it has one. Forward-declared so builders above the
+// definition can apply it to directory rows.
+static void apply_folder_recursive_mtime(FileInfo& info, PGconn* conn, const std::string& schema,
+                                         const char* rollup_vts, const char* rollup_by);
 
 Result<std::optional<FileInfo>> Database::get_file_by_uid(const std::string& uid, const std::string& tenant) {
     auto conn = acquire(DbOp::Read);
@@ -425,7 +540,8 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid(const std::string& uid
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_vts, "
                             "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_by, "
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by "
+                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by, "
+                            "f.subtree_vts, f.subtree_by "
                             "FROM \"" + schema_name + "\".files f "
                             "WHERE f.uid = $1 AND f.deleted = FALSE "
                             "LIMIT 1;";
@@ -435,7 +551,7 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid(const std::string& uid
     SERVER_LOG_DEBUG("Database::get_file_by_uid", ServerLogger::getInstance().detailed_log_prefix() +
               "Executing query: " + query_sql + " with param[0]: '" + uid + "'");
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
 
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         if (PQntuples(res) > 0) {
@@ -472,7 +588,9 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid(const std::string& uid
                 last_vts,
                 PQgetisnull(res, 0, 12) ? nullptr : PQgetvalue(res, 0, 12));
             // For a folder, override mtime with the newest file anywhere beneath it.
-            apply_folder_recursive_mtime(info, pg_conn, schema_name);
+            apply_folder_recursive_mtime(info, pg_conn, schema_name,
+                PQgetisnull(res, 0, 13) ? nullptr : PQgetvalue(res, 0, 13),
+                PQgetisnull(res, 0, 14) ? nullptr : PQgetvalue(res, 0, 14));
             // Current version = the latest version-name timestamp (empty if the
             // file has no versions yet, e.g. a freshly touched 0-byte file).
             info.version = last_vts ? std::string(last_vts) : "";
@@ -485,7 +603,7 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid(const std::string& uid
                 std::string rc_query = "SELECT COUNT(*) FROM \"" + schema_name +
                                        "\".files WHERE parent_uid = $1 AND deleted = FALSE;";
                 const char* rc_params[1] = {info.uid.c_str()};
-                PGresult* rc_res = PQexecParams(pg_conn, rc_query.c_str(), 1, nullptr, rc_params, nullptr, nullptr, 0);
+                PGresult* rc_res = conn->exec_cached(rc_query, 1, rc_params);
                 if (PQresultStatus(rc_res) == PGRES_TUPLES_OK && PQntuples(rc_res) > 0) {
                     info.rendition_count = std::stoi(PQgetvalue(rc_res, 0, 0));
                 }
@@ -641,21 +759,36 @@ static std::pair<std::string, std::string> subtree_newest_version(
     return out;
 }
 
-// A directory's mtime is the newest file anywhere in its subtree (recursively),
-// per the "folder mtime = newest contained file" rule. No-op for non-directories
-// or a file-less subtree (an empty folder keeps its own updated_at from
-// apply_listing_provenance). Truncated via parse_vts_epoch so a folder and the
-// file that set its mtime report the identical second on every surface.
-static void apply_folder_recursive_mtime(FileInfo& info, PGconn* conn, const std::string& schema) {
+// Sets a directory's mtime and "modified by" from the newest file in its
+// subtree, given that file's (version_timestamp, revised_by). No-op for
+// non-directories or a file-less subtree (an empty folder keeps its own
+// updated_at from apply_listing_provenance). Truncated via parse_vts_epoch so a
+// folder and the file that set its mtime report the identical second on every
+// surface.
+static void apply_folder_newest(FileInfo& info, const char* newest_vts, const char* newest_by) {
     if (info.type != FileType::DIRECTORY) return;
-    auto nv = subtree_newest_version(conn, schema, info.uid);   // (version_timestamp, revised_by)
     int64_t e;
-    if (parse_vts_epoch(nv.first.c_str(), e)) {
+    if (parse_vts_epoch(newest_vts, e)) {
         // A folder's mtime AND its "modified by" both come from the newest file in
         // its subtree — the file that set the timestamp and who last revised it.
         info.modified_at = std::chrono::system_clock::time_point(std::chrono::seconds(e));
-        if (!nv.second.empty()) info.modified_by = nv.second;
+        if (newest_by && newest_by[0]) info.modified_by = newest_by;
+    }
+}
+
+// A directory's mtime is the newest file anywhere in its subtree (recursively),
+// per the "folder mtime = newest contained file" rule. `rollup_vts`/`rollup_by`
+// are the row's stored folder rollup; only a row whose rollup is not computed
+// yet (NULL) pays for the subtree walk.
+static void apply_folder_recursive_mtime(FileInfo& info, PGconn* conn, const std::string& schema,
+                                         const char* rollup_vts, const char* rollup_by) {
+    if (info.type != FileType::DIRECTORY) return;
+    if (rollup_vts != nullptr) {
+        apply_folder_newest(info, rollup_vts, rollup_by);
+        return;
     }
+    auto nv = subtree_newest_version(conn, schema, info.uid);   // (version_timestamp, revised_by)
+    apply_folder_newest(info, nv.first.c_str(), nv.second.c_str());
 }
 
 // Provenance from the revision history: ctime + creator = first revision,
@@ -676,6 +809,112 @@ static void apply_listing_provenance(FileInfo& info,
     info.modified_by = (last_by  && last_by[0])  ? std::string(last_by)  : info.owner;
 }
 
+// The children of $1 with everything a listing row needs, in ONE statement:
+// the first/last revision come from LATERAL joins (each an index probe on
+// versions(file_uid, version_timestamp)), rendition counts from one grouped
+// scan, and a sub-folder's newest descendant file from its stored rollup. Only
+// sub-folders whose rollup is not computed yet (NULL) seed the recursive walk,
+// so once backfilled a listing costs the same at the root as in a leaf. The
+// per-row follow-up queries this replaces made a 5,000-entry folder cost
+// 5,000+ round trips.
+//
+// uid <> $1 excludes the directory's own record from its child listing. The
+// root record is self-referential (uid='' and parent_uid=''); without this it
+// would appear as a phantom "root" child of itself. rendition_count is the
+// number of non-deleted hidden children, but only for file entities (a
+// directory's children are not hidden renditions, so 0). The subtree walk
+// matches subtree_newest_version: it descends only through non-deleted
+// sub*folders*, so renditions never bump a folder's mtime, and UNION on
+// (root_uid, uid) keeps it terminating on a corrupt parent_uid cycle.
+//
+// With `paged`, only the (at most $4) entries after the keyset cursor
+// ($2, $3) = (name, uid) are selected, so the per-entry joins and the subtree
+// walk cover just that page; idx_files_parent_name serves the range scan.
+//
+// Columns: uid, name, size, owner, permission_map, is_container, deleted,
+// rendition_count, created_epoch, updated_epoch, first_vts, first_by,
+// last_vts, last_by, newest_vts, newest_by (see listing_row_to_info).
+static std::string listing_query_sql(const std::string& schema, bool include_deleted, bool paged = false) {
+    const std::string files = "\"" + schema + "\".files";
+    const std::string versions = "\"" + schema + "\".versions";
+    return
+        "WITH RECURSIVE entries AS ("
+        "  SELECT f.uid, f.name, f.size, f.owner, f.permission_map, f.is_container, f.deleted,"
+        "         f.created_at, f.updated_at, f.subtree_vts, f.subtree_by"
+        "    FROM " + files + " f"
+        "   WHERE f.parent_uid = $1 AND f.uid <> $1" +
+        std::string(include_deleted ? "" : " AND f.deleted = FALSE") +
+        std::string(paged ? " AND (f.name, f.uid) > ($2::text, $3::text)"
+                            " ORDER BY f.name, f.uid LIMIT $4::bigint" : "") +
+        "), subfolders(root_uid, uid) AS ("
+        "  SELECT e.uid, e.uid FROM entries e WHERE e.is_container = TRUE AND e.subtree_vts IS NULL"
+        "  UNION"
+        "  SELECT sf.root_uid, f.uid FROM " + files + " f"
+        "    JOIN subfolders sf ON f.parent_uid = sf.uid"
+        "   WHERE f.is_container = TRUE AND f.deleted = FALSE"
+        "), folder_newest AS ("
+        "  SELECT DISTINCT ON (sf.root_uid) sf.root_uid, v.version_timestamp, v.revised_by"
+        "    FROM subfolders sf"
+        "    JOIN " + files + " fi ON fi.parent_uid = sf.uid"
+        "    JOIN " + versions + " v ON v.file_uid = fi.uid"
+        "   WHERE fi.is_container = FALSE AND fi.deleted = FALSE"
+        "   ORDER BY sf.root_uid, v.version_timestamp DESC"
+        "), renditions AS ("
+        "  SELECT c.parent_uid, COUNT(*) AS n FROM " + files + " c"
+        "    JOIN entries e ON c.parent_uid = e.uid"
+        "   WHERE e.is_container = FALSE AND c.deleted = FALSE"
+        "   GROUP BY c.parent_uid"
+        ") "
+        "SELECT e.uid, e.name, e.size, e.owner, e.permission_map, e.is_container, e.deleted, "
+        "COALESCE(r.n, 0) AS rendition_count, "
+        "FLOOR(EXTRACT(EPOCH FROM e.created_at))::bigint AS created_epoch, "
+        "FLOOR(EXTRACT(EPOCH FROM e.updated_at))::bigint AS updated_epoch, "
+        "fv.version_timestamp AS first_vts, fv.revised_by AS first_by, "
+        "lv.version_timestamp AS last_vts, lv.revised_by AS last_by, "
+        "CASE WHEN e.subtree_vts IS NULL THEN fn.version_timestamp ELSE NULLIF(e.subtree_vts, '') END AS newest_vts, "
+        "CASE WHEN e.subtree_vts IS NULL THEN fn.revised_by ELSE e.subtree_by END AS newest_by "
+        "FROM entries e "
+        "LEFT JOIN LATERAL (SELECT v.version_timestamp, v.revised_by FROM " + versions + " v"
+        "  WHERE v.file_uid = e.uid ORDER BY v.version_timestamp ASC LIMIT 1) fv ON TRUE "
+        "LEFT JOIN LATERAL (SELECT v.version_timestamp, v.revised_by FROM " + versions + " v"
+        "  WHERE v.file_uid = e.uid ORDER BY v.version_timestamp DESC LIMIT 1) lv ON TRUE "
+        "LEFT JOIN renditions r ON r.parent_uid = e.uid "
+        "LEFT JOIN folder_newest fn ON fn.root_uid = e.uid "
+        "ORDER BY e.name, e.uid;";
+}
+
+// One row of listing_query_sql as a FileInfo.
+static FileInfo listing_row_to_info(PGresult* res, int i, const std::string& parent_uid) {
+    auto col = [res, i](int c) -> const char* {
+        return PQgetisnull(res, i, c) ? nullptr : PQgetvalue(res, i, c);
+    };
+    auto flag = [res, i](int c) {
+        return strcmp(PQgetvalue(res, i, c), "t") == 0 || strcmp(PQgetvalue(res, i, c), "1") == 0;
+    };
+    FileInfo info;
+    info.uid = PQgetvalue(res, i, 0);
+    info.name = PQgetvalue(res, i, 1);
+    info.path = "/" + info.name;  // Simple path calculation - in a real system this would be more complex
+    info.parent_uid = parent_uid;
+    info.size = std::stoll(PQgetvalue(res, i, 2));
+    info.owner = PQgetvalue(res, i, 3);
+    info.permissions = std::stoi(PQgetvalue(res, i, 4));
+    info.type = flag(5) ? FileType::DIRECTORY : FileType::REGULAR_FILE;
+    info.deleted = flag(6);
+    info.rendition_count = std::stoi(PQgetvalue(res, i, 7));  // hidden children (files only)
+    // Provenance from revisions (ctime/creator = first, mtime/reviser =
+    // latest), falling back to files.created_at/updated_at + owner. info.owner
+    // is set above so the fallback resolves.
+    apply_listing_provenance(info,
+        std::stoll(PQgetvalue(res, i, 8)), std::stoll(PQgetvalue(res, i, 9)),
+        col(10), col(11), col(12), col(13));
+    // A folder entry's mtime = the newest file anywhere in its subtree.
+    apply_folder_newest(info, col(14), col(15));
+    info.version = col(12) ? std::string(col(12)) : "";  // latest revision
+    info.version_count = 1; // For this implementation, use 1
+    return info;
+}
+
 Result<std::vector<FileInfo>> Database::list_files_in_directory(const std::string& parent_uid, const std::string& tenant) {
     auto conn = acquire(DbOp::Read);
     if (!conn || !conn->is_valid()) {
@@ -695,24 +934,7 @@ Result<std::vector<FileInfo>> Database::list_files_in_directory(const std::strin
         return Result<std::vector<FileInfo>>::err("Invalid parameter: schema_name is empty");
     }
 
-    // uid <> $1 excludes the directory's own record from its child listing. The
-    // root record is self-referential (uid='' and parent_uid=''); without this
-    // it would appear as a phantom "root" child of itself.
-    // rendition_count is the number of non-deleted hidden children, but only for
-    // file entities (a directory's children are not hidden renditions, so 0).
-    std::string query_sql = "SELECT f.uid, f.name, f.size, f.owner, f.permission_map, f.is_container, "
-                            "CASE WHEN f.is_container THEN 0 ELSE "
-                            "(SELECT COUNT(*) FROM \"" + schema_name + "\".files c "
-                            "WHERE c.parent_uid = f.uid AND c.deleted = FALSE) END AS rendition_count, "
-                            "FLOOR(EXTRACT(EPOCH FROM f.created_at))::bigint AS created_epoch, "
-                            "FLOOR(EXTRACT(EPOCH FROM f.updated_at))::bigint AS updated_epoch, "
-                            "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_by, "
-                            "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by "
-                            "FROM \"" + schema_name + "\".files f "
-                            "WHERE f.parent_uid = $1 AND f.uid <> $1 AND f.deleted = FALSE "
-                            "ORDER BY f.name;";
+    std::string query_sql = listing_query_sql(schema_name, /*include_deleted=*/false);
     const char* param_values[1] = {parent_uid.c_str()};
 
     // Validate that the parameter value is not null
@@ -727,49 +949,13 @@ Result<std::vector<FileInfo>> Database::list_files_in_directory(const std::strin
               "Executing SQL query to list files in directory with parent_uid: " + parent_uid +
               ", tenant: " + tenant + ", schema: " + schema_name);
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
 
     std::vector<FileInfo> result_files;
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         int nrows = PQntuples(res);
         for (int i = 0; i < nrows; ++i) {
-            FileInfo info;
-            info.uid = PQgetvalue(res, i, 0);
-            info.name = PQgetvalue(res, i, 1);
-            info.path = "/" + info.name;  // Simple path calculation - in a real system this would be more complex
-            info.parent_uid = parent_uid;
-            int64_t size = std::stoll(PQgetvalue(res, i, 2));
-            info.size = size;
-            info.owner = PQgetvalue(res, i, 3);
-            info.permissions = std::stoi(PQgetvalue(res, i, 4));
-            bool is_container = (strcmp(PQgetvalue(res, i, 5), "t") == 0 || strcmp(PQgetvalue(res, i, 5), "1") == 0);
-            info.type = is_container ? FileType::DIRECTORY : FileType::REGULAR_FILE;
-            info.rendition_count = std::stoi(PQgetvalue(res, i, 6));  // hidden children (files only)
-            // Provenance from revisions (ctime/creator = first, mtime/reviser =
-            // latest), falling back to files.created_at/updated_at + owner. info.owner
-            // is set above (index 3) so the fallback resolves.
-            apply_listing_provenance(info,
-                std::stoll(PQgetvalue(res, i, 7)), std::stoll(PQgetvalue(res, i, 8)),
-                PQgetisnull(res, i, 9)  ? nullptr : PQgetvalue(res, i, 9),
-                PQgetisnull(res, i, 10) ? nullptr : PQgetvalue(res, i, 10),
-                PQgetisnull(res, i, 11) ? nullptr : PQgetvalue(res, i, 11),
-                PQgetisnull(res, i, 12) ? nullptr : PQgetvalue(res, i, 12));
-            // A folder entry's mtime = the newest file anywhere in its subtree.
-            apply_folder_recursive_mtime(info, pg_conn, schema_name);
-            // Get the latest version from the versions table
-            std::string version_query = "SELECT version_timestamp FROM \"" + schema_name + "\".versions WHERE file_uid = $1 ORDER BY version_timestamp DESC LIMIT 1;";
-            const char* version_param_values[1] = {info.uid.c_str()};
-
-            PGresult* version_res = PQexecParams(pg_conn, version_query.c_str(), 1, nullptr, version_param_values, nullptr, nullptr, 0);
-            if (PQresultStatus(version_res) == PGRES_TUPLES_OK && PQntuples(version_res) > 0) {
-                info.version = PQgetvalue(version_res, 0, 0);
-            } else {
-                // If no version is found in the versions table, use a default
-                info.version = "";
-            }
-            PQclear(version_res);
-            info.version_count = 1; // For this implementation, use 1
-
+            FileInfo info = listing_row_to_info(res, i, parent_uid);
             result_files.push_back(info);
         }
         PQclear(res);
@@ -802,21 +988,7 @@ Result<std::vector<FileInfo>> Database::list_files_in_directory_with_deleted(con
         return Result<std::vector<FileInfo>>::err("Invalid parameter: schema_name is empty");
     }
 
-    // uid <> $1 excludes the directory's own self-referential record (the root
-    // record has uid='' and parent_uid='') from its child listing.
-    std::string query_sql = "SELECT f.uid, f.name, f.size, f.owner, f.permission_map, f.is_container, f.deleted, "
-                            "CASE WHEN f.is_container THEN 0 ELSE "
-                            "(SELECT COUNT(*) FROM \"" + schema_name + "\".files c "
-                            "WHERE c.parent_uid = f.uid AND c.deleted = FALSE) END AS rendition_count, "
-                            "FLOOR(EXTRACT(EPOCH FROM f.created_at))::bigint AS created_epoch, "
-                            "FLOOR(EXTRACT(EPOCH FROM f.updated_at))::bigint AS updated_epoch, "
-                            "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_by, "
-                            "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by "
-                            "FROM \"" + schema_name + "\".files f "
-                            "WHERE f.parent_uid = $1 AND f.uid <> $1 "
-                            "ORDER BY f.name;";
+    std::string query_sql = listing_query_sql(schema_name, /*include_deleted=*/true);
     const char* param_values[1] = {parent_uid.c_str()};
 
 
@@ -832,50 +1004,13 @@ Result<std::vector<FileInfo>> Database::list_files_in_directory_with_deleted(con
               "Executing SQL query to list files in directory (with deleted) with parent_uid: " + parent_uid +
               ", tenant: " + tenant + ", schema: " + schema_name);
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
 
     std::vector<FileInfo> result_files;
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         int nrows = PQntuples(res);
         for (int i = 0; i < nrows; ++i) {
-            // Skip deleted files unless specifically requested - this function includes deleted files
-            FileInfo info;
-            info.uid = PQgetvalue(res, i, 0);
-            info.name = PQgetvalue(res, i, 1);
-            info.path = "/" + info.name;  // Simple path calculation - in a real system this would be more complex
-            info.parent_uid = parent_uid;
-            int64_t size = std::stoll(PQgetvalue(res, i, 2));
-            info.size = size;
-            info.owner = PQgetvalue(res, i, 3);
-            info.permissions = std::stoi(PQgetvalue(res, i, 4));
-            bool is_container = (strcmp(PQgetvalue(res, i, 5), "t") == 0 || strcmp(PQgetvalue(res, i, 5), "1") == 0);
-            info.type = is_container ? FileType::DIRECTORY : FileType::REGULAR_FILE;
-            info.deleted = (strcmp(PQgetvalue(res, i, 6), "t") == 0 || strcmp(PQgetvalue(res, i, 6), "1") == 0);  // index 6: f.deleted
-            info.rendition_count = std::stoi(PQgetvalue(res, i, 7));  // index 7: after deleted (6)
-            // Provenance from revisions; files columns (8/9) + owner are the
-            // fallback. VTS/by subqueries are 10..13.
-            apply_listing_provenance(info,
-                std::stoll(PQgetvalue(res, i, 8)), std::stoll(PQgetvalue(res, i, 9)),
-                PQgetisnull(res, i, 10) ? nullptr : PQgetvalue(res, i, 10),
-                PQgetisnull(res, i, 11) ? nullptr : PQgetvalue(res, i, 11),
-                PQgetisnull(res, i, 12) ? nullptr : PQgetvalue(res, i, 12),
-                PQgetisnull(res, i, 13) ? nullptr : PQgetvalue(res, i, 13));
-            // A folder entry's mtime = the newest file anywhere in its subtree.
-            apply_folder_recursive_mtime(info, pg_conn, schema_name);
-            // Get the latest version from the versions table
-            std::string version_query = "SELECT version_timestamp FROM \"" + schema_name + "\".versions WHERE file_uid = $1 ORDER BY version_timestamp DESC LIMIT 1;";
-            const char* version_param_values[1] = {info.uid.c_str()};
-
-            PGresult* version_res = PQexecParams(pg_conn, version_query.c_str(), 1, nullptr, version_param_values, nullptr, nullptr, 0);
-            if (PQresultStatus(version_res) == PGRES_TUPLES_OK && PQntuples(version_res) > 0) {
-                info.version = PQgetvalue(version_res, 0, 0);
-            } else {
-                // If no version is found in the versions table, use a default
-                info.version = "";
-            }
-            PQclear(version_res);
-            info.version_count = 1; // For this implementation, use 1
-
+            FileInfo info = listing_row_to_info(res, i, parent_uid);
             result_files.push_back(info);
         }
         PQclear(res);
@@ -889,6 +1024,49 @@ Result<std::vector<FileInfo>> Database::list_files_in_directory_with_deleted(con
     }
 }
 
+Result<std::vector<FileInfo>> Database::list_files_in_directory_page(const std::string& parent_uid,
+                                                                     const std::string& after_name,
+                                                                     const std::string& after_uid,
+                                                                     size_t limit,
+                                                                     const std::string& tenant) {
+    auto conn = acquire(DbOp::Read);
+    if (!conn || !conn->is_valid()) {
+        return Result<std::vector<FileInfo>>::err("Failed to acquire database connection");
+    }
+
+    PGconn* pg_conn = conn->get_connection();
+    std::string schema_name = get_schema_prefix(tenant);
+    if (schema_name.empty()) {
+        SERVER_LOG_ERROR("Database::list_files_in_directory_page", ServerLogger::getInstance().detailed_log_prefix() +
+                  "Invalid parameter: schema_name is empty for tenant: " + tenant);
+        connection_pool_->release(conn);
+        return Result<std::vector<FileInfo>>::err("Invalid parameter: schema_name is empty");
+    }
+
+    std::string query_sql = listing_query_sql(schema_name, /*include_deleted=*/false, /*paged=*/true);
+    std::string limit_str = std::to_string(limit);
+    const char* param_values[4] = {parent_uid.c_str(), after_name.c_str(), after_uid.c_str(), limit_str.c_str()};
+
+    PGresult* res = conn->exec_cached(query_sql, 4, param_values);
+
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        std::vector<FileInfo> result_files;
+        int nrows = PQntuples(res);
+        result_files.reserve(nrows);
+        for (int i = 0; i < nrows; ++i) {
+            result_files.push_back(listing_row_to_info(res, i, parent_uid));
+        }
+        PQclear(res);
+        connection_pool_->release(conn);
+        return Result<std::vector<FileInfo>>::ok(std::move(result_files));
+    } else {
+        std::string error = PQerrorMessage(pg_conn);
+        PQclear(res);
+        connection_pool_->release(conn);
+        return Result<std::vector<FileInfo>>::err("Failed to list directory page: " + error);
+    }
+}
+
 Result<std::vector<FileInfo>> Database::list_all_files(const std::string& tenant) {
     auto conn = acquire(DbOp::Read);
     if (!conn || !conn->is_valid()) {
@@ -908,9 +1086,14 @@ Result<std::vector<FileInfo>> Database::list_all_files(const std::string& tenant
         return Result<std::vector<FileInfo>>::err("Invalid parameter: schema_name is empty");
     }
 
-    std::string query_sql = "SELECT uid, name, size, owner, permission_map, is_container "
-                            "FROM \"" + schema_name + "\".files "
-                            "ORDER BY uid;";
+    // The latest revision comes from a LATERAL join rather than a follow-up
+    // query per row, so a whole-tenant sweep is a single round trip.
+    std::string query_sql = "SELECT f.uid, f.name, f.size, f.owner, f.permission_map, f.is_container, "
+                            "lv.version_timestamp "
+                            "FROM \"" + schema_name + "\".files f "
+                            "LEFT JOIN LATERAL (SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v "
+                            "WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) lv ON TRUE "
+                            "ORDER BY f.uid;";
     const char* param_values[0] = {}; // No parameters for this query
 
     SERVER_LOG_DEBUG("Database::list_all_files", ServerLogger::getInstance().detailed_log_prefix() +
@@ -938,18 +1121,8 @@ Result<std::vector<FileInfo>> Database::list_all_files(const std::string& tenant
             auto now = std::chrono::system_clock::now();
             info.created_at = now;
             info.modified_at = now;
-            // Get the latest version from the versions table
-            std::string version_query = "SELECT version_timestamp FROM \"" + schema_name + "\".versions WHERE file_uid = $1 ORDER BY version_timestamp DESC LIMIT 1;";
-            const char* version_param_values[1] = {info.uid.c_str()};
-
-            PGresult* version_res = PQexecParams(pg_conn, version_query.c_str(), 1, nullptr, version_param_values, nullptr, nullptr, 0);
-            if (PQresultStatus(version_res) == PGRES_TUPLES_OK && PQntuples(version_res) > 0) {
-                info.version = PQgetvalue(version_res, 0, 0);
-            } else {
-                // If no version is found in the versions table, use a default
-                info.version = "";
-            }
-            PQclear(version_res);
+            // Latest version (NULL when the file has no revisions)
+            info.version = PQgetisnull(res, i, 6) ? "" : PQgetvalue(res, i, 6);
             info.version_count = 1; // For this implementation, use 1
 
             files.push_back(info);
@@ -1002,7 +1175,8 @@ Result<std::optional<FileInfo>> Database::get_file_by_name_and_parent(const std:
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_vts, "
                             "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_by, "
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by "
+                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by, "
+                            "f.subtree_vts, f.subtree_by "
                             "FROM \"" + schema_name + "\".files f "
                             "WHERE f.name = $1 AND f.parent_uid = $2 AND f.deleted = FALSE "
                             "LIMIT 1;";
@@ -1050,7 +1224,10 @@ Result<std::optional<FileInfo>> Database::get_file_by_name_and_parent(const std:
                 PQgetisnull(res, 0, 8)  ? nullptr : PQgetvalue(res, 0, 8),
                 last_vts,
                 PQgetisnull(res, 0, 10) ? nullptr : PQgetvalue(res, 0, 10));
-            apply_folder_recursive_mtime(info, pg_conn, schema_name);  // folder mtime = newest descendant file
+            // Folder mtime = newest descendant file.
+            apply_folder_recursive_mtime(info, pg_conn, schema_name,
+                PQgetisnull(res, 0, 11) ? nullptr : PQgetvalue(res, 0, 11),
+                PQgetisnull(res, 0, 12) ? nullptr : PQgetvalue(res, 0, 12));
             info.version = last_vts ? std::string(last_vts) : "";
             info.version_count = 1; // For this implementation, use 1
 
@@ -1119,7 +1296,8 @@ Result<std::optional<FileInfo>> Database::get_file_by_name_and_parent_include_de
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_vts, "
                             "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_by, "
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by "
+                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by, "
+                            "f.subtree_vts, f.subtree_by "
                             "FROM \"" + schema_name + "\".files f "
                             "WHERE f.name = $1 AND f.parent_uid = $2 "
                             "LIMIT 1;";
@@ -1167,7 +1345,10 @@ Result<std::optional<FileInfo>> Database::get_file_by_name_and_parent_include_de
                 PQgetisnull(res, 0, 8)  ? nullptr : PQgetvalue(res, 0, 8),
                 last_vts,
                 PQgetisnull(res, 0, 10) ? nullptr : PQgetvalue(res, 0, 10));
-            apply_folder_recursive_mtime(info, pg_conn, schema_name);  // folder mtime = newest descendant file
+            // Folder mtime = newest descendant file.
+            apply_folder_recursive_mtime(info, pg_conn, schema_name,
+                PQgetisnull(res, 0, 11) ? nullptr : PQgetvalue(res, 0, 11),
+                PQgetisnull(res, 0, 12) ? nullptr : PQgetvalue(res, 0, 12));
             info.version = last_vts ? std::string(last_vts) : "";
             info.version_count = 1; // For this implementation, use 1
 
@@ -1293,13 +1474,14 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid_include_deleted(const
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_vts, "
                             "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp ASC LIMIT 1) AS first_by, "
                             "(SELECT v.version_timestamp FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_vts, "
-                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by "
+                            "(SELECT v.revised_by FROM \"" + schema_name + "\".versions v WHERE v.file_uid = f.uid ORDER BY v.version_timestamp DESC LIMIT 1) AS last_by, "
+                            "f.subtree_vts, f.subtree_by "
                             "FROM \"" + schema_name + "\".files f "
                             "WHERE f.uid = $1 "
                             "LIMIT 1;";
     const char* param_values[1] = {uid.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
 
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         if (PQntuples(res) > 0) {
@@ -1335,7 +1517,10 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid_include_deleted(const
                 PQgetisnull(res, 0, 10) ? nullptr : PQgetvalue(res, 0, 10),
                 last_vts,
                 PQgetisnull(res, 0, 12) ? nullptr : PQgetvalue(res, 0, 12));
-            apply_folder_recursive_mtime(info, pg_conn, schema_name);  // folder mtime = newest descendant file
+            // Folder mtime = newest descendant file.
+            apply_folder_recursive_mtime(info, pg_conn, schema_name,
+                PQgetisnull(res, 0, 13) ? nullptr : PQgetvalue(res, 0, 13),
+                PQgetisnull(res, 0, 14) ? nullptr : PQgetvalue(res, 0, 14));
             info.version = last_vts ? std::string(last_vts) : "";
             info.version_count = 1; // For this implementation, use 1
 
@@ -1346,7 +1531,7 @@ Result<std::optional<FileInfo>> Database::get_file_by_uid_include_deleted(const
                 std::string rc_query = "SELECT COUNT(*) FROM \"" + schema_name +
                                        "\".files WHERE parent_uid = $1 AND deleted = FALSE;";
                 const char* rc_params[1] = {info.uid.c_str()};
-                PGresult* rc_res = PQexecParams(pg_conn, rc_query.c_str(), 1, nullptr, rc_params, nullptr, nullptr, 0);
+                PGresult* rc_res = conn->exec_cached(rc_query, 1, rc_params);
                 if (PQresultStatus(rc_res) == PGRES_TUPLES_OK && PQntuples(rc_res) > 0) {
                     info.rendition_count = std::stoi(PQgetvalue(rc_res, 0, 0));
                 }
@@ -1381,19 +1566,42 @@ Result<void> Database::update_file_parent(const std::string& uid, const std::str
     // Get the schema name for this tenant
     std::string schema_name = get_schema_prefix(tenant);
 
-    std::string update_sql = "UPDATE \"" + schema_name + "\".files SET parent_uid = $2 WHERE uid = $1;";
+    // Re-parent the row and rewrite the materialized path of its whole subtree
+    // in one statement: every descendant keeps the part of its path below the
+    // moved row and gets the new prefix. Descendants are found through the
+    // GIN index on ancestors. An unknown new prefix (NULL) makes the subtree's
+    // paths unknown too, so readers fall back to walking parent_uid. The old
+    // parent is returned so both folder rollup chains can be recomputed.
+    const std::string files = "\"" + schema_name + "\".files";
+    std::string update_sql =
+        "WITH old_parent AS (SELECT parent_uid FROM " + files + " WHERE uid = $1), "
+        "new_path AS (SELECT " + ancestors_of_sql(schema_name, "$2") + " AS anc), "
+        "moved AS ("
+        "  UPDATE " + files + " SET parent_uid = $2, ancestors = (SELECT anc FROM new_path)"
+        "   WHERE uid = $1 RETURNING uid), "
+        "subtree AS ("
+        "  UPDATE " + files + " d SET ancestors = CASE WHEN np.anc IS NULL THEN NULL"
+        "         ELSE np.anc || $1::varchar(64) || d.ancestors[array_position(d.ancestors, $1::varchar(64)) + 1:] END"
+        "    FROM new_path np"
+        "   WHERE d.ancestors @> ARRAY[$1::varchar(64)] AND EXISTS (SELECT 1 FROM moved)"
+        "  RETURNING 1) "
+        "SELECT (SELECT count(*) FROM moved), (SELECT count(*) FROM subtree),"
+        "       (SELECT parent_uid FROM old_parent);";
     const char* param_values[2] = {uid.c_str(), new_parent_uid.c_str()};
 
     PGresult* res = PQexecParams(pg_conn, update_sql.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
 
-    if (PQresultStatus(res) == PGRES_COMMAND_OK) {
-        int rows_affected = std::stoi(PQcmdTuples(res));
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        int rows_affected = PQntuples(res) > 0 ? std::stoi(PQgetvalue(res, 0, 0)) : 0;
         if (rows_affected == 0) {
             PQclear(res);
             connection_pool_->release(conn);
             return Result<void>::err("File with UID not found: " + uid);
         }
+        std::string old_parent_uid = PQgetisnull(res, 0, 2) ? "" : PQgetvalue(res, 0, 2);
         PQclear(res);
+        refresh_folder_rollup(pg_conn, schema_name, old_parent_uid);
+        if (new_parent_uid != old_parent_uid) refresh_folder_rollup(pg_conn, schema_name, new_parent_uid);
         connection_pool_->release(conn);
         return Result<void>::ok();
     } else {
@@ -1471,8 +1679,10 @@ Result<int64_t> Database::insert_version(const std::string& file_uid, const std:
     std::string schema_name = get_schema_prefix(tenant);
 
     // Insert the version into the versions table with its storage path
-    // Keep the version_timestamp as a string to avoid conversion issues
-    std::string insert_sql = "INSERT INTO \"" + schema_name + "\".versions (file_uid, version_timestamp, size, storage_path, revised_by) "
+    // Keep the version_timestamp as a string to avoid conversion issues. The
+    // same statement raises the folder rollup of every folder above the file.
+    std::string insert_sql = "WITH RECURSIVE " + rollup_bump_ctes(schema_name, "$1", "$2", "$5") + " "
+                             "INSERT INTO \"" + schema_name + "\".versions (file_uid, version_timestamp, size, storage_path, revised_by) "
                              "VALUES ($1, $2, $3, $4, $5) "
                              "ON CONFLICT (file_uid, version_timestamp) DO UPDATE SET "
                              "size = EXCLUDED.size, storage_path = EXCLUDED.storage_path, revised_by = EXCLUDED.revised_by "
@@ -1487,7 +1697,7 @@ Result<int64_t> Database::insert_version(const std::string& file_uid, const std:
         revised_by.c_str()          // acting user who wrote this revision
     };
 
-    PGresult* res = PQexecParams(pg_conn, insert_sql.c_str(), 5, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(insert_sql, 5, param_values);
 
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         if (PQntuples(res) > 0) {
@@ -1508,6 +1718,57 @@ Result<int64_t> Database::insert_version(const std::string& file_uid, const std:
     }
 }
 
+Result<int64_t> Database::commit_new_version(const std::string& file_uid, const std::string& version_timestamp,
+                                             int64_t size, const std::string& storage_path,
+                                             const std::string& revised_by, const std::string& tenant) {
+    auto conn = acquire(DbOp::Write);
+    if (!conn || !conn->is_valid()) {
+        return Result<int64_t>::err("Failed to acquire database connection");
+    }
+
+    PGconn* pg_conn = conn->get_connection();
+    std::string schema_name = get_schema_prefix(tenant);
+
+    // insert_version, update_file_size and the folder rollup bump as one
+    // statement: one round trip and one commit, and a crash leaves either all
+    // of it or none. (update_file_current_version/update_file_modified have
+    // no columns to write; the current version and mtime derive from the
+    // versions table.) The rollup CTEs touch only the folders above the
+    // file, never the file row that `sized` updates.
+    std::string sql = "WITH RECURSIVE " + rollup_bump_ctes(schema_name, "$1", "$2", "$5") + ", "
+                      "inserted AS ("
+                      "  INSERT INTO \"" + schema_name + "\".versions (file_uid, version_timestamp, size, storage_path, revised_by) "
+                      "  VALUES ($1, $2, $3, $4, $5) "
+                      "  ON CONFLICT (file_uid, version_timestamp) DO UPDATE SET "
+                      "  size = EXCLUDED.size, storage_path = EXCLUDED.storage_path, revised_by = EXCLUDED.revised_by "
+                      "  RETURNING id"
+                      "), sized AS ("
+                      "  UPDATE \"" + schema_name + "\".files SET size = $3::bigint WHERE uid = $1 RETURNING 1"
+                      ") "
+                      "SELECT id FROM inserted;";
+    std::string size_str = std::to_string(size);
+    const char* param_values[5] = {
+        file_uid.c_str(),
+        version_timestamp.c_str(),
+        size_str.c_str(),
+        storage_path.c_str(),
+        revised_by.c_str()
+    };
+
+    PGresult* res = conn->exec_cached(sql, 5, param_values);
+
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
+        int64_t id = std::stoll(PQgetvalue(res, 0, 0));
+        PQclear(res);
+        connection_pool_->release(conn);
+        return Result<int64_t>::ok(id);
+    }
+    std::string error = PQresultStatus(res) == PGRES_TUPLES_OK ? "no version row returned" : PQerrorMessage(pg_conn);
+    PQclear(res);
+    connection_pool_->release(conn);
+    return Result<int64_t>::err("Failed to commit version: " + error);
+}
+
 Result<std::optional<std::string>> Database::get_version_storage_path(const std::string& file_uid, const std::string& version_timestamp, const std::string& tenant) {
     auto conn = acquire(DbOp::Read);
     if (!conn || !conn->is_valid()) {
@@ -1523,7 +1784,7 @@ Result<std::optional<std::string>> Database::get_version_storage_path(const std:
     std::string query_sql = "SELECT storage_path FROM \"" + schema_name + "\".versions WHERE file_uid = $1 AND version_timestamp = $2 LIMIT 1;";
     const char* param_values[2] = {file_uid.c_str(), version_timestamp.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 2, param_values);
 
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         if (PQntuples(res) > 0) {
@@ -1560,7 +1821,7 @@ Result<std::vector<std::string>> Database::list_versions(const std::string& file
     std::string query_sql = "SELECT version_timestamp FROM \"" + schema_name + "\".versions WHERE file_uid = $1 ORDER BY version_timestamp DESC;";
     const char* param_values[1] = {file_uid.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
 
     std::vector<std::string> versions;
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
@@ -1589,13 +1850,21 @@ Result<bool> Database::delete_version(const std::string& file_uid, const std::st
     PGconn* pg_conn = conn->get_connection();
     std::string schema_name = get_schema_prefix(tenant);
 
-    std::string sql = "DELETE FROM \"" + schema_name + "\".versions WHERE file_uid = $1 AND version_timestamp = $2;";
+    // Dropping a version can lower the rollup of the folders above the file, so
+    // the file's parent is returned for a refresh.
+    std::string sql = "WITH del AS (DELETE FROM \"" + schema_name + "\".versions "
+                      "WHERE file_uid = $1 AND version_timestamp = $2 RETURNING 1) "
+                      "SELECT (SELECT count(*) FROM del), "
+                      "(SELECT parent_uid FROM \"" + schema_name + "\".files WHERE uid = $1);";
     const char* param_values[2] = {file_uid.c_str(), version_timestamp.c_str()};
 
     PGresult* res = PQexecParams(pg_conn, sql.c_str(), 2, nullptr, param_values, nullptr, nullptr, 0);
 
-    if (PQresultStatus(res) == PGRES_COMMAND_OK) {
-        int rows_affected = std::stoi(PQcmdTuples(res));
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        int rows_affected = PQntuples(res) > 0 ? std::stoi(PQgetvalue(res, 0, 0)) : 0;
+        if (rows_affected > 0 && !PQgetisnull(res, 0, 1)) {
+            refresh_folder_rollup(pg_conn, schema_name, PQgetvalue(res, 0, 1));
+        }
         PQclear(res);
         connection_pool_->release(conn);
         return Result<bool>::ok(rows_affected > 0);
@@ -1662,7 +1931,10 @@ Result<bool> Database::restore_to_version(const std::string& file_uid, const std
                   static_cast<long long>(ms.count()));
     std::string new_ts = ts_buf;
 
-    std::string insert_sql = "INSERT INTO \"" + schema + "\".versions "
+    // Raises the folder rollup above the file in the same statement, as
+    // insert_version does.
+    std::string insert_sql = "WITH RECURSIVE " + rollup_bump_ctes(schema, "$1", "$2", "$5") + " "
+                             "INSERT INTO \"" + schema + "\".versions "
                              "(file_uid, version_timestamp, size, storage_path, revised_by) "
                              "VALUES ($1, $2, $3, $4, $5);";
     const char* insert_params[5] = {
@@ -1746,7 +2018,7 @@ Result<std::optional<std::string>> Database::get_metadata(const std::string& fil
     std::string sql = "SELECT value FROM \"" + escaped_schema + "\".metadata WHERE file_uid = $1 AND version_timestamp = $2 AND key_name = $3;";
     const char* params[3] = {file_uid.c_str(), version_timestamp.c_str(), key.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, sql.c_str(), 3, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(sql, 3, params);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         std::string error = "Failed to get metadata: " + std::string(PQerrorMessage(pg_conn));
@@ -1788,7 +2060,7 @@ Result<std::map<std::string, std::string>> Database::get_all_metadata(const std:
     std::string sql = "SELECT key_name, value FROM \"" + escaped_schema + "\".metadata WHERE file_uid = $1 AND version_timestamp = $2;";
     const char* params[2] = {file_uid.c_str(), version_timestamp.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, sql.c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(sql, 2, params);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         std::string error = "Failed to get all metadata: " + std::string(PQerrorMessage(pg_conn));
@@ -2068,6 +2340,44 @@ Result<void> Database::create_tenant_schema(const std::string& tenant) {
         " ON \"" + escaped_schema + "\".files(uid);";
     std::string create_idx_parent_uid = "CREATE INDEX IF NOT EXISTS idx_files_parent_uid_" + escaped_schema +
         " ON \"" + escaped_schema + "\".files(parent_uid);";
+    // Keyset order of a paged directory listing (list_files_in_directory_page).
+    std::string create_idx_parent_name = "CREATE INDEX IF NOT EXISTS idx_files_parent_name_" + escaped_schema +
+        " ON \"" + escaped_schema + "\".files(parent_uid, name, uid);";
+
+    // Materialized ancestor path: uids of every strict ancestor, root first,
+    // so reachability checks read the whole chain in one query instead of one
+    // per level. NULL means "unknown" (rows written before this column, or by
+    // an older core) and makes readers walk parent_uid. The backfill walks down
+    // from the top-level rows, so it never follows a corrupt parent_uid cycle,
+    // and only runs while some row is still NULL.
+    std::string migrate_files_ancestors =
+        "ALTER TABLE \"" + escaped_schema + "\".files "
+        "ADD COLUMN IF NOT EXISTS ancestors VARCHAR(64)[];";
+    std::string backfill_files_ancestors =
+        "WITH RECURSIVE paths(uid, anc) AS ("
+        "  SELECT f.uid, '{}'::varchar(64)[] FROM \"" + escaped_schema + "\".files f"
+        "   WHERE EXISTS (SELECT 1 FROM \"" + escaped_schema + "\".files WHERE ancestors IS NULL)"
+        "     AND NOT EXISTS (SELECT 1 FROM \"" + escaped_schema + "\".files p WHERE p.uid = f.parent_uid)"
+        "  UNION ALL"
+        "  SELECT f.uid, p.anc || p.uid FROM \"" + escaped_schema + "\".files f"
+        "    JOIN paths p ON f.parent_uid = p.uid"
+        ") "
+        "UPDATE \"" + escaped_schema + "\".files f SET ancestors = p.anc"
+        "  FROM paths p WHERE f.uid = p.uid AND f.ancestors IS NULL;";
+    std::string create_idx_ancestors = "CREATE INDEX IF NOT EXISTS idx_files_ancestors_" + escaped_schema +
+        " ON \"" + escaped_schema + "\".files USING GIN (ancestors);";
+
+    // Folder rollup (see rollup_bump_ctes). Rows that exist when the column is
+    // added get NULL ("not computed yet", filled by fileengine_rollup_backfill);
+    // the default is set afterwards so rows created from then on start out
+    // known and empty.
+    std::string migrate_files_rollup =
+        "ALTER TABLE \"" + escaped_schema + "\".files "
+        "ADD COLUMN IF NOT EXISTS subtree_vts TEXT, "
+        "ADD COLUMN IF NOT EXISTS subtree_by VARCHAR(255);";
+    std::string default_files_rollup =
+        "ALTER TABLE \"" + escaped_schema + "\".files "
+        "ALTER COLUMN subtree_vts SET DEFAULT '';";
 
     std::string create_versions_table = "CREATE TABLE IF NOT EXISTS \"" + escaped_schema + "\".versions ("
         "id BIGSERIAL PRIMARY KEY, "
@@ -2124,6 +2434,24 @@ Result<void> Database::create_tenant_schema(const std::string& tenant) {
     res = PQexec(pg_conn, create_idx_parent_uid.c_str());
     if (PQresultStatus(res) != PGRES_COMMAND_OK) { PQclear(res); } // Index creation failure is non-critical
 
+    res = PQexec(pg_conn, create_idx_parent_name.c_str());
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) { PQclear(res); } // Index creation failure is non-critical
+
+    res = PQexec(pg_conn, migrate_files_ancestors.c_str());
+    PQclear(res);  // column may already exist; status is irrelevant
+
+    res = PQexec(pg_conn, backfill_files_ancestors.c_str());
+    PQclear(res);  // non-critical: rows left NULL are walked instead
+
+    res = PQexec(pg_conn, create_idx_ancestors.c_str());
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) { PQclear(res); } // Index creation failure is non-critical
+
+    res = PQexec(pg_conn, migrate_files_rollup.c_str());
+    PQclear(res);  // columns may already exist; status is irrelevant
+
+    res = PQexec(pg_conn, default_files_rollup.c_str());
+    PQclear(res);  // non-critical: rows left NULL fall back to the subtree walk
+
     res = PQexec(pg_conn, create_versions_table.c_str());
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         std::string error = PQerrorMessage(pg_conn);
@@ -2578,6 +2906,99 @@ Result<void> Database::cleanup_tenant_data(const std::string& tenant) {
     return Result<void>::ok();
 }
 
+Result<int64_t> Database::rebuild_folder_rollups(const std::string& tenant, bool only_missing) {
+    auto conn = acquire(DbOp::Write);
+    if (!conn || !conn->is_valid()) {
+        return Result<int64_t>::err("Failed to acquire database connection");
+    }
+
+    PGconn* pg_conn = conn->get_connection();
+    std::string schema = get_schema_prefix(tenant);
+    const std::string files = "\"" + schema + "\".files";
+    const std::string versions = "\"" + schema + "\".versions";
+
+    // Bottom-up, one depth level per statement: each folder's rollup is
+    // computed from its direct children (each file's newest version, each
+    // non-deleted sub-folder's rollup, already written by the deeper level),
+    // so the work is linear in the tree instead of one row per (folder,
+    // descendant) pair. Depths come from a walk down from the top-level
+    // folders; a folder caught in a parent_uid cycle is never reached and
+    // keeps its value. All in one transaction, so readers see the old
+    // rollups or the new ones.
+    auto fail = [&](const std::string& what) {
+        std::string error = "Failed to rebuild folder rollups (" + what + "): " + PQerrorMessage(pg_conn);
+        PGresult* rollback_res = PQexec(pg_conn, "ROLLBACK;");
+        PQclear(rollback_res);
+        connection_pool_->release(conn);
+        return Result<int64_t>::err(error);
+    };
+    auto run = [&](const std::string& sql) {
+        PGresult* res = PQexec(pg_conn, sql.c_str());
+        bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        PQclear(res);
+        return ok;
+    };
+
+    if (!run("BEGIN;")) return fail("begin");
+    const std::string levels_sql =
+        "CREATE TEMP TABLE rollup_levels ON COMMIT DROP AS "
+        "WITH RECURSIVE tree(uid, depth) AS ("
+        "  SELECT c.uid, 0 FROM " + files + " c"
+        "   WHERE c.is_container = TRUE AND NOT EXISTS ("
+        "     SELECT 1 FROM " + files + " p"
+        "      WHERE p.uid = c.parent_uid AND p.uid <> c.uid AND p.is_container = TRUE)"
+        "  UNION ALL"
+        "  SELECT c.uid, t.depth + 1 FROM " + files + " c"
+        "    JOIN tree t ON c.parent_uid = t.uid"
+        "   WHERE c.is_container = TRUE AND c.uid <> t.uid AND t.depth < 4096"
+        ") "
+        "SELECT t.uid, t.depth, " +
+        std::string(only_missing ? "f.subtree_vts IS NULL" : "TRUE") + " AS target"
+        "  FROM tree t JOIN " + files + " f ON f.uid = t.uid;";
+    if (!run(levels_sql)) return fail("levels");
+    if (!run("CREATE INDEX ON rollup_levels (depth); ANALYZE rollup_levels;")) return fail("levels");
+
+    PGresult* depth_res = PQexec(pg_conn, "SELECT COALESCE(MAX(depth), -1) FROM rollup_levels;");
+    if (PQresultStatus(depth_res) != PGRES_TUPLES_OK) {
+        PQclear(depth_res);
+        return fail("depth");
+    }
+    const int max_depth = std::stoi(PQgetvalue(depth_res, 0, 0));
+    PQclear(depth_res);
+
+    const std::string level_sql =
+        "UPDATE " + files + " d SET subtree_vts = COALESCE(n.vts, ''), subtree_by = n.rby"
+        "  FROM rollup_levels l LEFT JOIN LATERAL ("
+        "    SELECT x.vts, x.rby FROM ("
+        "      SELECT lv.version_timestamp AS vts, lv.revised_by AS rby FROM " + files + " c"
+        "        JOIN LATERAL (SELECT v.version_timestamp, v.revised_by FROM " + versions + " v"
+        "                       WHERE v.file_uid = c.uid"
+        "                       ORDER BY v.version_timestamp DESC LIMIT 1) lv ON TRUE"
+        "       WHERE c.parent_uid = l.uid AND c.uid <> l.uid AND c.is_container = FALSE AND c.deleted = FALSE"
+        "      UNION ALL"
+        "      SELECT c.subtree_vts, c.subtree_by FROM " + files + " c"
+        "       WHERE c.parent_uid = l.uid AND c.uid <> l.uid AND c.is_container = TRUE"
+        "         AND c.deleted = FALSE AND c.subtree_vts <> ''"
+        "    ) x ORDER BY x.vts DESC LIMIT 1) n ON TRUE"
+        " WHERE l.depth = $1::int AND l.target AND d.uid = l.uid;";
+    int64_t updated = 0;
+    for (int depth = max_depth; depth >= 0; --depth) {
+        const std::string depth_param = std::to_string(depth);
+        const char* params[1] = { depth_param.c_str() };
+        PGresult* res = PQexecParams(pg_conn, level_sql.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            PQclear(res);
+            return fail("depth " + depth_param);
+        }
+        updated += std::stoll(PQcmdTuples(res));
+        PQclear(res);
+    }
+
+    if (!run("COMMIT;")) return fail("commit");
+    connection_pool_->release(conn);
+    return Result<int64_t>::ok(updated);
+}
+
 Result<std::vector<std::string>> Database::list_tenants() {
     auto conn = acquire(DbOp::Read);
     if (!conn || !conn->is_valid()) {
@@ -2620,6 +3041,7 @@ void Database::configure_secondary_connection(const std::string& host, int port,
     // over (see acquire()). Initialized eagerly; if the standby is down now it can
     // still be acquired (and retried) later.
     secondary_pool_ = std::make_shared<ConnectionPool>(host, port, database_name, user, password, pool_size_);
+    secondary_pool_->set_prepare_statements(prepared_statements_);
     if (!secondary_pool_->initialize()) {
         std::cerr << "Secondary database pool failed to initialize (will retry on use): "
                   << host << ":" << port << std::endl;
@@ -2788,11 +3210,12 @@ Result<std::string> Database::create_file_with_acls(const std::string& uid,
 
     // 1. INSERT file row (same SQL shape as insert_file).
     std::string insert_file_sql =
-        "INSERT INTO \"" + schema + "\".files (uid, name, parent_uid, size, owner, permission_map, is_container, deleted) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7, $8) "
+        "INSERT INTO \"" + schema + "\".files (uid, name, parent_uid, size, owner, permission_map, is_container, deleted, ancestors) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, " + ancestors_of_sql(schema, "$3") + ") "
         "ON CONFLICT (uid) DO UPDATE SET "
             "name = EXCLUDED.name, "
             "parent_uid = EXCLUDED.parent_uid, "
+            "ancestors = EXCLUDED.ancestors, "
             "size = EXCLUDED.size, "
             "owner = EXCLUDED.owner, "
             "permission_map = EXCLUDED.permission_map, "
@@ -3125,7 +3548,7 @@ Result<std::vector<IDatabase::AclEntry>> Database::get_acls_for_resource(const s
         "FROM " + schema + ".acls WHERE resource_uid = $1;";
     const char* param_values[1] = {resource_uid.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 1, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         std::string error = "Failed to get ACLs for resource: " + std::string(PQerrorMessage(pg_conn));
@@ -3152,6 +3575,89 @@ Result<std::vector<IDatabase::AclEntry>> Database::get_acls_for_resource(const s
     return Result<std::vector<IDatabase::AclEntry>>::ok(acls);
 }
 
+Result<std::optional<std::vector<IDatabase::AncestorEntry>>> Database::get_ancestor_chain(
+        const std::string& resource_uid, const std::string& tenant) {
+    using Chain = std::optional<std::vector<IDatabase::AncestorEntry>>;
+    auto conn = acquire(DbOp::Read);
+    if (!conn || !conn->is_valid()) {
+        return Result<Chain>::err("Failed to acquire database connection");
+    }
+
+    PGconn* pg_conn = conn->get_connection();
+    std::string schema = get_schema_prefix(tenant);
+    const std::string files = "\"" + schema + "\".files";
+
+    // One row per (chain link, ACL row); links without ACLs still appear via
+    // the LEFT JOIN. depth 0 is the resource, 1 its parent, and so on. Every
+    // lookup is by uid (or resource_uid) and index-backed, so the cost does
+    // not depend on how deep the resource is.
+    std::string query_sql =
+        "SELECT c.depth, a.uid, COALESCE(a.parent_uid, ''), a.deleted,"
+        "       EXISTS (SELECT 1 FROM " + files + " pp WHERE pp.uid = a.parent_uid),"
+        "       acl.principal, acl.principal_type, acl.permissions, acl.effect,"
+        "       f.ancestors IS NULL"
+        "  FROM " + files + " f"
+        "  CROSS JOIN LATERAL ("
+        "    SELECT f.uid AS uid, 0::bigint AS depth"
+        "    UNION ALL"
+        "    SELECT x.uid, COALESCE(array_length(f.ancestors, 1), 0) - x.ord + 1"
+        "      FROM unnest(f.ancestors) WITH ORDINALITY AS x(uid, ord)"
+        "  ) c"
+        "  LEFT JOIN " + files + " a ON a.uid = c.uid"
+        "  LEFT JOIN " + schema + ".acls acl ON acl.resource_uid = c.uid"
+        " WHERE f.uid = $1"
+        " ORDER BY c.depth;";
+    const char* param_values[1] = {resource_uid.c_str()};
+
+    PGresult* res = conn->exec_cached(query_sql, 1, param_values);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        std::string error = "Failed to get ancestor chain: " + std::string(PQerrorMessage(pg_conn));
+        PQclear(res);
+        connection_pool_->release(conn);
+        return Result<Chain>::err(error);
+    }
+
+    std::vector<IDatabase::AncestorEntry> chain;
+    const int nrows = PQntuples(res);
+    if (nrows > 0 && std::string(PQgetvalue(res, 0, 9)) == "t") {
+        PQclear(res);
+        connection_pool_->release(conn);
+        return Result<Chain>::ok(std::nullopt);  // path not materialized yet
+    }
+    long last_depth = -1;
+    for (int i = 0; i < nrows; ++i) {
+        const long depth = std::stol(PQgetvalue(res, i, 0));
+        if (depth != last_depth) {
+            if (PQgetisnull(res, i, 1)) {
+                // The path names a row that no longer exists: treat as stale
+                PQclear(res);
+                connection_pool_->release(conn);
+                return Result<Chain>::ok(std::nullopt);
+            }
+            IDatabase::AncestorEntry link;
+            link.uid = PQgetvalue(res, i, 1);
+            link.parent_uid = PQgetvalue(res, i, 2);
+            link.deleted = std::string(PQgetvalue(res, i, 3)) == "t";
+            link.parent_exists = std::string(PQgetvalue(res, i, 4)) == "t";
+            chain.push_back(std::move(link));
+            last_depth = depth;
+        }
+        if (!PQgetisnull(res, i, 5)) {
+            IDatabase::AclEntry acl;
+            acl.resource_uid = chain.back().uid;
+            acl.principal = PQgetvalue(res, i, 5);
+            acl.type = std::stoi(PQgetvalue(res, i, 6));
+            acl.permissions = std::stoi(PQgetvalue(res, i, 7));
+            acl.effect = std::stoi(PQgetvalue(res, i, 8));
+            chain.back().acls.push_back(std::move(acl));
+        }
+    }
+
+    PQclear(res);
+    connection_pool_->release(conn);
+    return Result<Chain>::ok(std::move(chain));
+}
+
 Result<std::vector<IDatabase::AclEntry>> Database::get_user_acls(const std::string& resource_uid,
                                                                  const std::string& principal,
                                                                  int type,
@@ -3175,7 +3681,7 @@ Result<std::vector<IDatabase::AclEntry>> Database::get_user_acls(const std::stri
     std::string type_str = std::to_string(type);
     const char* param_values[3] = {resource_uid.c_str(), principal.c_str(), type_str.c_str()};
 
-    PGresult* res = PQexecParams(pg_conn, query_sql.c_str(), 3, nullptr, param_values, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(query_sql, 3, param_values);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         std::string error = "Failed to get user ACLs: " + std::string(PQerrorMessage(pg_conn));
@@ -3384,7 +3890,7 @@ Result<std::vector<std::string>> Database::get_roles_for_user(const std::string&
 
     std::string sql = "SELECT role_name FROM " + schema + ".user_roles WHERE user_name = $1;";
     const char* params[1] = { user.c_str() };
-    PGresult* res = PQexecParams(pg_conn, sql.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    PGresult* res = conn->exec_cached(sql, 1, params);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         std::string error = "Failed to get roles for user: " + std::string(PQerrorMessage(pg_conn));
         PQclear(res);
@@ -108,10 +108,11 @@ Result<void> FileCuller::perform_culling_for_space(size_t required_bytes) {
         // Verify the file exists in object store before culling
         auto verify_result = verify_file_in_object_store(file_path);
         if (verify_result.success && verify_result.value) {
-            // Get file size to know how much space we'll free
-            std::error_code ec;
-            size_t file_size = std::filesystem::file_size(file_path, ec);
-            if (!ec) {
+            // Get file size to know how much space we'll free (through the
+            // storage: small versions may live in a pack segment)
+            auto size_result = storage_ ? storage_->get_file_size(file_path) : Result<uint64_t>::err("");
+            if (size_result.success) {
+                size_t file_size = static_cast<size_t>(size_result.value);
                 // Remove from local storage
                 if (storage_) {
                     auto delete_result = storage_->delete_file(file_path);
@@ -203,6 +204,12 @@ Result<void> FileCuller::cull_low_priority_files() {
             }
         }
     }
+
+    // With a deduplicated layout, blobs whose last version link was removed
+    // without an inode tag (no xattr support) are only reclaimed by a sweep.
+    if (storage_ && storage_->is_deduplication_enabled()) {
+        storage_->collect_unreferenced_blobs();
+    }
     
     return Result<void>::ok();
 }
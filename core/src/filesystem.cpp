@@ -17,6 +17,7 @@
 #include "fileengine/utils.h"
 #include "fileengine/server_logger.h"
 #include "fileengine/crypto_utils.h"
+#include "fileengine/blob_format.h"
 #include <algorithm>
 #include <optional>
 #include <fstream>
@@ -31,6 +32,26 @@ int64_t to_epoch_seconds(const std::chrono::system_clock::time_point& tp) {
     return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
 }
 
+// A listing row as a DirectoryEntry. Takes the FileInfo by rvalue so its
+// strings move rather than copy into the entry.
+DirectoryEntry to_directory_entry(FileInfo&& file_info) {
+    DirectoryEntry entry;
+    entry.uid = std::move(file_info.uid);
+    entry.name = std::move(file_info.name);
+    entry.type = file_info.type;
+    entry.size = file_info.size;
+    // These int64 fields are otherwise read uninitialized by the gRPC layer.
+    entry.created_at = to_epoch_seconds(file_info.created_at);
+    entry.modified_at = to_epoch_seconds(file_info.modified_at);
+    entry.version_count = file_info.version_count;
+    entry.rendition_count = file_info.rendition_count;
+    entry.deleted = file_info.deleted;
+    entry.owner = std::move(file_info.owner);
+    entry.created_by = std::move(file_info.created_by);
+    entry.modified_by = std::move(file_info.modified_by);
+    return entry;
+}
+
 // Returns true if `candidate` is `ancestor` itself or nested somewhere inside
 // it, by walking the parent chain up to the root (empty parent_uid).
 //
@@ -54,10 +75,71 @@ bool is_within_subtree(const std::shared_ptr<IDatabase>& db,
     }
     return false;
 }
+
+// Codec for newly written blobs: the tenant's (zlib for contexts built
+// without one), or none when compression is off.
+std::shared_ptr<const Codec> frame_codec(const TenantContext& context) {
+    if (!context.storage || !context.storage->is_compression_enabled()) return nullptr;
+    return context.codec ? context.codec : Codec::make(CodecId::Zlib);
+}
+
+// HMAC key naming deduplicated encrypted blobs: derived from the tenant's
+// encryption key, which is only ever used for AES-GCM itself.
+std::string dedup_key(const TenantContext& context) {
+    return CryptoUtils::derive_key(context.config.encryption_key, "dedup");
+}
+
+// Plaintext bytes handed to the caller per get_range_stream() callback, and the
+// stored-blob read size when a range has to be decoded sequentially.
+constexpr size_t kRangeChunkSize = 1024 * 1024;
+
+// Turn a whole stored blob back into plaintext under the tenant's
+// compression/encryption settings (a no-op when both are off).
+Result<std::vector<uint8_t>> decode_stored_blob(const TenantContext& context, std::vector<uint8_t> data) {
+    const bool do_compress = context.storage && context.storage->is_compression_enabled();
+    const bool do_encrypt = context.storage && context.storage->is_encryption_enabled();
+    if (!do_compress && !do_encrypt) {
+        return Result<std::vector<uint8_t>>::ok(std::move(data));
+    }
+    const std::string encryption_key = do_encrypt ? context.config.encryption_key : "";
+    if (do_encrypt && encryption_key.empty()) {
+        return Result<std::vector<uint8_t>>::err("Encryption key not available");
+    }
+    try {
+        return Result<std::vector<uint8_t>>::ok(BlobDecoder::decode(data, do_compress, encryption_key));
+    } catch (const std::exception& e) {
+        return Result<std::vector<uint8_t>>::err("Failed to decode stored data: " + std::string(e.what()));
+    }
+}
+
+// decode_stored_blob() for a shared buffer: an unencoded blob is returned
+// as is rather than copied
+Result<SharedBlob> decode_shared_blob(const TenantContext& context, SharedBlob stored) {
+    const bool do_compress = context.storage && context.storage->is_compression_enabled();
+    const bool do_encrypt = context.storage && context.storage->is_encryption_enabled();
+    if (!do_compress && !do_encrypt) {
+        return Result<SharedBlob>::ok(std::move(stored));
+    }
+    auto decoded = decode_stored_blob(context, *stored);
+    if (!decoded.success) {
+        return Result<SharedBlob>::err(decoded.error);
+    }
+    return Result<SharedBlob>::ok(std::make_shared<const std::vector<uint8_t>>(std::move(decoded.value)));
+}
+
+std::string single_flight_key(const std::string& tenant, const std::string& uid, const std::string& version) {
+    return tenant + '\0' + uid + '\0' + version;
+}
 } // namespace
 
 FileSystem::FileSystem(std::shared_ptr<TenantManager> tenant_manager)
     : tenant_manager_(tenant_manager) {
+    // Shared by every upload, so parallel frame encoding never oversubscribes
+    // the CPUs however many requests are in flight.
+    int encode_threads = tenant_manager_ ? tenant_manager_->get_config().storage_encode_threads : 1;
+    if (encode_threads != 1) {
+        encode_pool_ = std::make_shared<WorkerPool>(encode_threads > 0 ? static_cast<size_t>(encode_threads) : 0);
+    }
     // Initialize file culler (cache management) - will be set by the server with proper dependencies
     // The actual initialization will happen when the server sets it up with storage tracker
     // Start the async backup worker thread
@@ -136,6 +218,7 @@ Result<std::string> FileSystem::mkdir(const std::string& parent_uid, const std::
 
     SERVER_LOG_DEBUG("FileSystem::mkdir", ServerLogger::getInstance().detailed_log_prefix() +
               "Successfully created directory with UID: " + new_uid);
+    invalidate_metadata(tenant, new_uid, parent_uid);
     emit_fs_event(tenant, FileEventType::DirCreated, new_uid, user);
     return Result<std::string>::ok(new_uid);
 }
@@ -185,6 +268,8 @@ Result<void> FileSystem::rmdir(const std::string& dir_uid, const std::string& us
     SERVER_LOG_DEBUG("FileSystem::rmdir", ServerLogger::getInstance().detailed_log_prefix() +
               "Successfully marked directory " + dir_uid + " as deleted");
 
+    invalidate_metadata(tenant, dir_uid);
+    invalidate_permissions(tenant);
     emit_fs_event(tenant, FileEventType::DirDeleted, dir_uid, user);
     return Result<void>::ok();
 }
@@ -193,17 +278,79 @@ Result<std::vector<DirectoryEntry>> FileSystem::listdir(const std::string& dir_u
                                                         const std::string& user,
                                                         const std::vector<std::string>& roles,
                                                         const std::string& tenant) {
+    // The READ check and the is_admin gate resolve the caller's roles once
+    std::optional<AclManager::CacheScope> cache_scope;
+    if (acl_manager_) cache_scope.emplace(*acl_manager_);
+
     auto context = get_tenant_context(tenant);
     if (!context || !context->db) {
         return Result<std::vector<DirectoryEntry>>::err("Database not available for tenant: " + tenant);
     }
-    
+
+    auto listable = check_listable(*context, dir_uid, user, roles, tenant);
+    if (!listable.success) {
+        return Result<std::vector<DirectoryEntry>>::err(listable.error);
+    }
+
+    // List files in the directory
+    auto db_result = context->db->list_files_in_directory(dir_uid, tenant);
+    if (!db_result.success) {
+        return Result<std::vector<DirectoryEntry>>::err("Failed to list directory: " + db_result.error);
+    }
+
+    std::vector<DirectoryEntry> entries;
+    entries.reserve(db_result.value.size());
+    for (auto& file_info : db_result.value) {
+        entries.push_back(to_directory_entry(std::move(file_info)));
+    }
+
+    return Result<std::vector<DirectoryEntry>>::ok(std::move(entries));
+}
+
+Result<std::vector<DirectoryEntry>> FileSystem::listdir_page(const std::string& dir_uid,
+                                                             const std::string& after_name,
+                                                             const std::string& after_uid,
+                                                             size_t limit,
+                                                             const std::string& user,
+                                                             const std::vector<std::string>& roles,
+                                                             const std::string& tenant) {
+    // The READ check and the is_admin gate resolve the caller's roles once
+    std::optional<AclManager::CacheScope> cache_scope;
+    if (acl_manager_) cache_scope.emplace(*acl_manager_);
+
+    auto context = get_tenant_context(tenant);
+    if (!context || !context->db) {
+        return Result<std::vector<DirectoryEntry>>::err("Database not available for tenant: " + tenant);
+    }
+
+    auto listable = check_listable(*context, dir_uid, user, roles, tenant);
+    if (!listable.success) {
+        return Result<std::vector<DirectoryEntry>>::err(listable.error);
+    }
+
+    auto db_result = context->db->list_files_in_directory_page(dir_uid, after_name, after_uid, limit, tenant);
+    if (!db_result.success) {
+        return Result<std::vector<DirectoryEntry>>::err("Failed to list directory: " + db_result.error);
+    }
+
+    std::vector<DirectoryEntry> entries;
+    entries.reserve(db_result.value.size());
+    for (auto& file_info : db_result.value) {
+        entries.push_back(to_directory_entry(std::move(file_info)));
+    }
+
+    return Result<std::vector<DirectoryEntry>>::ok(std::move(entries));
+}
+
+Result<void> FileSystem::check_listable(TenantContext& context, const std::string& dir_uid,
+                                        const std::string& user, const std::vector<std::string>& roles,
+                                        const std::string& tenant) {
     // Check permissions - the user needs read permission on the directory.
     // (validate_user_permissions -> ancestors_readable also hides the directory
     // when one of ITS ancestors is soft-deleted.)
     auto perm_result = validate_user_permissions(dir_uid, user, roles, static_cast<int>(Permission::READ), tenant);
     if (!perm_result.success || !perm_result.value) {
-        return Result<std::vector<DirectoryEntry>>::err("User does not have permission to list directory");
+        return Result<void>::err("User does not have permission to list directory");
     }
 
     // A directory that is itself soft-deleted must not enumerate its children —
@@ -212,40 +359,51 @@ Result<std::vector<DirectoryEntry>> FileSystem::listdir(const std::string& dir_u
     // system_admin bypasses this (and all ACL/reachability hiding) so a superuser
     // is never locked out of inspecting or recovering a deleted subtree.
     if (!acl_manager_ || !acl_manager_->is_admin(user, roles, tenant)) {
-        auto dir_info = context->db->get_file_by_uid_include_deleted(dir_uid, tenant);
+        auto dir_info = lookup_file(context, dir_uid, tenant, true);
         if (dir_info.success && dir_info.value.has_value() && dir_info.value->deleted) {
-            return Result<std::vector<DirectoryEntry>>::err("Directory does not exist");
+            return Result<void>::err("Directory does not exist");
         }
     }
+    return Result<void>::ok();
+}
 
-    // List files in the directory
-    auto db_result = context->db->list_files_in_directory(dir_uid, tenant);
-    if (!db_result.success) {
-        return Result<std::vector<DirectoryEntry>>::err("Failed to list directory: " + db_result.error);
-    }
-    
-    // Convert FileInfo to DirectoryEntry
-    std::vector<DirectoryEntry> entries;
-    for (const auto& file_info : db_result.value) {
-        DirectoryEntry entry;
-        entry.uid = file_info.uid;
-        entry.name = file_info.name;
-        entry.type = file_info.type;
-        entry.size = file_info.size;
-        // These int64 fields are otherwise read uninitialized by the gRPC layer.
-        entry.created_at = to_epoch_seconds(file_info.created_at);
-        entry.modified_at = to_epoch_seconds(file_info.modified_at);
-        entry.version_count = file_info.version_count;
-        entry.rendition_count = file_info.rendition_count;
-        entry.deleted = file_info.deleted;
-        entry.owner = file_info.owner;
-        entry.created_by = file_info.created_by;
-        entry.modified_by = file_info.modified_by;
-
-        entries.push_back(entry);
-    }
+std::string FileSystem::encode_page_token(const std::string& dir_uid, const std::string& name,
+                                          const std::string& uid) {
+    // Hex of "dir_uid NUL name NUL uid": opaque to clients, and binding the
+    // directory lets a token replayed against another directory be rejected.
+    static const char* kHex = "0123456789abcdef";
+    const std::string raw = dir_uid + '\0' + name + '\0' + uid;
+    std::string token;
+    token.reserve(raw.size() * 2);
+    for (unsigned char c : raw) {
+        token.push_back(kHex[c >> 4]);
+        token.push_back(kHex[c & 0x0f]);
+    }
+    return token;
+}
 
-    return Result<std::vector<DirectoryEntry>>::ok(entries);
+bool FileSystem::decode_page_token(const std::string& token, const std::string& dir_uid,
+                                   std::string& name, std::string& uid) {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    if (token.size() % 2 != 0) return false;
+    std::string raw;
+    raw.reserve(token.size() / 2);
+    for (size_t i = 0; i < token.size(); i += 2) {
+        int hi = nibble(token[i]), lo = nibble(token[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        raw.push_back(static_cast<char>((hi << 4) | lo));
+    }
+    size_t first = raw.find('\0');
+    size_t second = first == std::string::npos ? std::string::npos : raw.find('\0', first + 1);
+    if (second == std::string::npos || raw.find('\0', second + 1) != std::string::npos) return false;
+    if (raw.compare(0, first, dir_uid) != 0 || first != dir_uid.size()) return false;
+    name = raw.substr(first + 1, second - first - 1);
+    uid = raw.substr(second + 1);
+    return true;
 }
 
 Result<std::vector<DirectoryEntry>> FileSystem::listdir_with_deleted(const std::string& dir_uid,
@@ -269,28 +427,13 @@ Result<std::vector<DirectoryEntry>> FileSystem::listdir_with_deleted(const std::
         return Result<std::vector<DirectoryEntry>>::err("Failed to list directory with deleted: " + db_result.error);
     }
     
-    // Convert FileInfo to DirectoryEntry
     std::vector<DirectoryEntry> entries;
-    for (const auto& file_info : db_result.value) {
-        DirectoryEntry entry;
-        entry.uid = file_info.uid;
-        entry.name = file_info.name;
-        entry.type = file_info.type;
-        entry.size = file_info.size;
-        // These int64 fields are otherwise read uninitialized by the gRPC layer.
-        entry.created_at = to_epoch_seconds(file_info.created_at);
-        entry.modified_at = to_epoch_seconds(file_info.modified_at);
-        entry.version_count = file_info.version_count;
-        entry.rendition_count = file_info.rendition_count;
-        entry.deleted = file_info.deleted;
-        entry.owner = file_info.owner;
-        entry.created_by = file_info.created_by;
-        entry.modified_by = file_info.modified_by;
-
-        entries.push_back(entry);
+    entries.reserve(db_result.value.size());
+    for (auto& file_info : db_result.value) {
+        entries.push_back(to_directory_entry(std::move(file_info)));
     }
 
-    return Result<std::vector<DirectoryEntry>>::ok(entries);
+    return Result<std::vector<DirectoryEntry>>::ok(std::move(entries));
 }
 
 Result<std::string> FileSystem::touch(const std::string& parent_uid, const std::string& name,
@@ -330,6 +473,7 @@ Result<std::string> FileSystem::touch(const std::string& parent_uid, const std::
         return Result<std::string>::err("Failed to create file in database: " + db_result.error);
     }
 
+    invalidate_metadata(tenant, new_uid, parent_uid);
     emit_fs_event(tenant, FileEventType::FileCreated, new_uid, user);
     return Result<std::string>::ok(new_uid);
 }
@@ -364,9 +508,12 @@ Result<void> FileSystem::remove(const std::string& file_uid, const std::string&
                 SERVER_LOG_ERROR("FileSystem::remove", ServerLogger::getInstance().detailed_log_prefix() +
                           "Failed to remove rendition " + rend.uid + ": " + del.error);
             }
+            invalidate_metadata(tenant, rend.uid, file_uid);
         }
     }
 
+    invalidate_metadata(tenant, file_uid);
+    invalidate_permissions(tenant);
     emit_fs_event(tenant, FileEventType::FileDeleted, file_uid, user);
     return Result<void>::ok();
 }
@@ -391,6 +538,8 @@ Result<void> FileSystem::undelete(const std::string& file_uid, const std::string
         return Result<void>::err("Failed to undelete file in database: " + db_result.error);
     }
 
+    invalidate_metadata(tenant, file_uid);
+    invalidate_permissions(tenant);
     emit_fs_event(tenant, FileEventType::FileRestored, file_uid, user);
     return Result<void>::ok();
 }
@@ -411,7 +560,7 @@ Result<void> FileSystem::put(const std::string& file_uid, const std::vector<uint
     }
     
     // Get the file info to check if it exists
-    auto file_info_result = context->db->get_file_by_uid(file_uid, tenant);
+    auto file_info_result = lookup_file(*context, file_uid, tenant);
     if (!file_info_result.success || !file_info_result.value.has_value()) {
         return Result<void>::err("File does not exist");
     }
@@ -441,40 +590,39 @@ Result<void> FileSystem::put(const std::string& file_uid, const std::vector<uint
         return Result<void>::err("Cache culling requires object store configuration to prevent data loss");
     }
 
-    // Process data for storage (compress and encrypt if enabled)
+    // Process data for storage (compress and encrypt if enabled) into the
+    // framed blob format, or the legacy single-stream one when frames are off
     std::vector<uint8_t> processed_data = data;
-
-    // Check if compression is enabled for this tenant/context
-    if (context->storage && context->storage->is_compression_enabled()) {
-        try {
-            processed_data = fileengine::CryptoUtils::compress_data(processed_data);
-            SERVER_LOG_DEBUG("FileSystem::put", "Data compressed from " + std::to_string(data.size()) +
-                             " to " + std::to_string(processed_data.size()) + " bytes");
-        } catch (const std::exception& e) {
-            SERVER_LOG_ERROR("FileSystem::put", "Compression failed: " + std::string(e.what()));
-            return Result<void>::err("Failed to compress data: " + std::string(e.what()));
+    const bool do_compress = context->storage && context->storage->is_compression_enabled();
+    const bool do_encrypt = context->storage && context->storage->is_encryption_enabled();
+    if (do_compress || do_encrypt) {
+        const std::string encryption_key = do_encrypt ? context->config.encryption_key : "";
+        if (do_encrypt && encryption_key.empty()) {
+            return Result<void>::err("Encryption key not available");
         }
-    }
-
-    // Check if encryption is enabled for this tenant/context
-    if (context->storage && context->storage->is_encryption_enabled()) {
         try {
-            // Get the encryption key from the config
-            std::string encryption_key = context->config.encryption_key;
-            if (encryption_key.empty()) {
-                return Result<void>::err("Encryption key not available");
-            }
-
-            processed_data = fileengine::CryptoUtils::encrypt_data(processed_data, encryption_key);
-            SERVER_LOG_DEBUG("FileSystem::put", "Data encrypted successfully");
+            processed_data = BlobEncoder::encode(data, frame_codec(*context), encryption_key,
+                                                 context->config.storage_frame_size, encode_pool_);
+            SERVER_LOG_DEBUG("FileSystem::put", "Data encoded from " + std::to_string(data.size()) +
+                             " to " + std::to_string(processed_data.size()) + " bytes");
         } catch (const std::exception& e) {
-            SERVER_LOG_ERROR("FileSystem::put", "Encryption failed: " + std::string(e.what()));
-            return Result<void>::err("Failed to encrypt data: " + std::string(e.what()));
+            SERVER_LOG_ERROR("FileSystem::put", "Encoding failed: " + std::string(e.what()));
+            return Result<void>::err("Failed to encode data for storage: " + std::string(e.what()));
         }
     }
 
-    // Store the processed file in storage
-    auto storage_result = context->storage->store_file(file_uid, version_timestamp, processed_data, tenant);
+    // Store the processed file in storage. With deduplication on, encrypted
+    // payloads never repeat byte-for-byte (fresh IV per write), so name the blob
+    // by a keyed digest of the plaintext instead, under a key derived for
+    // that purpose rather than the encryption key itself; unencrypted
+    // payloads are addressed by their stored bytes inside Storage.
+    const bool keyed_dedup = context->storage->is_deduplication_enabled() &&
+                             context->storage->is_encryption_enabled();
+    auto storage_result = keyed_dedup
+        ? context->storage->store_file_deduplicated(file_uid, version_timestamp, processed_data,
+                                                    CryptoUtils::content_digest(data, dedup_key(*context)),
+                                                    tenant)
+        : context->storage->store_file(file_uid, version_timestamp, processed_data, tenant);
     if (!storage_result.success) {
         return Result<void>::err("Failed to store file in storage: " + storage_result.error);
     }
@@ -484,31 +632,14 @@ Result<void> FileSystem::put(const std::string& file_uid, const std::vector<uint
         context->storage_tracker->record_file_creation(storage_result.value, data.size(), tenant);
     }
     
-    // Update the file's current version in the database
-    auto update_result = context->db->update_file_current_version(file_uid, version_timestamp, tenant);
-    if (!update_result.success) {
-        return Result<void>::err("Failed to update current version: " + update_result.error);
-    }
-    
-    // Record the version in the database
-    auto insert_version_result = context->db->insert_version(file_uid, version_timestamp, data.size(),
-                                                             storage_result.value, user, tenant);
-    if (!insert_version_result.success) {
-        return Result<void>::err("Failed to record version: " + insert_version_result.error);
-    }
-
-    // Keep files.size in sync with the current content so stat/listdir report
-    // the real byte size (the version table alone is not read by stat).
-    auto update_size_result = context->db->update_file_size(file_uid, static_cast<int64_t>(data.size()), tenant);
-    if (!update_size_result.success) {
-        SERVER_LOG_ERROR("FileSystem::put", ServerLogger::getInstance().detailed_log_prefix() +
-                  "Failed to update file size for " + file_uid + ": " + update_size_result.error);
-    }
-
-    // Update the modification time
-    auto update_time_result = context->db->update_file_modified(file_uid, tenant);
-    if (!update_time_result.success) {
-        // Log error but don't fail the operation
+    // Record the version and make it current in one atomic step; this also
+    // keeps files.size in sync with the content so stat/listdir report the
+    // real byte size (the version table alone is not read by stat).
+    auto commit_result = context->db->commit_new_version(file_uid, version_timestamp,
+                                                         static_cast<int64_t>(data.size()),
+                                                         storage_result.value, user, tenant);
+    if (!commit_result.success) {
+        return Result<void>::err("Failed to record version: " + commit_result.error);
     }
     
     // If we have an object store, consider backing up asynchronously using the async worker thread
@@ -543,6 +674,12 @@ Result<void> FileSystem::put(const std::string& file_uid, const std::vector<uint
               "Put operation completed successfully for file_uid: " + file_uid +
               " [CONCURRENCY CRITICAL] NOTE: Race conditions possible during async operations after this point");
 
+    // Timestamps are per millisecond, so a rapid rewrite can reuse one
+    if (cache_manager_) {
+        cache_manager_->invalidate(tenant, file_uid, version_timestamp);
+    }
+
+    invalidate_metadata(tenant, file_uid);
     emit_fs_event(tenant, FileEventType::FileUpdated, file_uid, user);
     return Result<void>::ok();
 }
@@ -551,21 +688,32 @@ Result<std::vector<uint8_t>> FileSystem::get(const std::string& file_uid,
                                               const std::string& user,
                                               const std::vector<std::string>& roles,
                                               const std::string& tenant) {
+    auto result = get_shared(file_uid, user, roles, tenant);
+    if (!result.success) {
+        return Result<std::vector<uint8_t>>::err(result.error);
+    }
+    return Result<std::vector<uint8_t>>::ok(*result.value);
+}
+
+Result<SharedBlob> FileSystem::get_shared(const std::string& file_uid,
+                                          const std::string& user,
+                                          const std::vector<std::string>& roles,
+                                          const std::string& tenant) {
     auto context = get_tenant_context(tenant);
     if (!context || !context->db) {
-        return Result<std::vector<uint8_t>>::err("Database not available for tenant: " + tenant);
+        return Result<SharedBlob>::err("Database not available for tenant: " + tenant);
     }
 
     // Check permissions - the user needs read permission on the file
     auto perm_result = validate_user_permissions(file_uid, user, roles, static_cast<int>(Permission::READ), tenant);
     if (!perm_result.success || !perm_result.value) {
-        return Result<std::vector<uint8_t>>::err("User does not have permission to read file");
+        return Result<SharedBlob>::err("User does not have permission to read file");
     }
 
     // Get the file info to determine the current version
-    auto file_info_result = context->db->get_file_by_uid(file_uid, tenant);
+    auto file_info_result = lookup_file(*context, file_uid, tenant);
     if (!file_info_result.success || !file_info_result.value.has_value()) {
-        return Result<std::vector<uint8_t>>::err("File does not exist");
+        return Result<SharedBlob>::err("File does not exist");
     }
 
     std::string current_version = file_info_result.value->version;
@@ -573,11 +721,19 @@ Result<std::vector<uint8_t>> FileSystem::get(const std::string& file_uid,
         // If no version is set, get the latest version
         auto versions_result = list_versions(file_uid, user, roles, tenant);
         if (!versions_result.success || versions_result.value.empty()) {
-            return Result<std::vector<uint8_t>>::err("No versions available for file");
+            return Result<SharedBlob>::err("No versions available for file");
         }
         current_version = versions_result.value[0]; // Latest version
     }
 
+    // Versions are immutable, so a cached copy is served without touching
+    // local storage or the object store
+    if (cache_manager_) {
+        if (auto cached = cache_manager_->lookup(tenant, file_uid, current_version)) {
+            return Result<SharedBlob>::ok(std::move(cached));
+        }
+    }
+
     // Look up the actual stored path from the versions table. The schema's
     // storage_path column is the source of truth — important for restored
     // versions where (uid, new_timestamp) doesn't map to a real file but the
@@ -616,63 +772,29 @@ Result<std::vector<uint8_t>> FileSystem::get(const std::string& file_uid,
         SERVER_LOG_DEBUG("FileSystem::get", "No storage context available");
     }
 
-    // If file doesn't exist locally, attempt to restore from S3
+    // If file doesn't exist locally, attempt to restore from S3. Concurrent
+    // readers of the same cold version (a popular file after a cull) wait on
+    // one restore instead of each fetching and writing the blob.
     if (!file_exists_locally && context->object_store) {
         SERVER_LOG_DEBUG("FileSystem::get", "File does not exist locally, attempting to restore from S3");
-
-        // Compose the path to the remote payload in object store
-        std::string remote_payload_path = context->object_store->get_storage_path(file_uid, current_version, tenant);
-        SERVER_LOG_DEBUG("FileSystem::get", "Remote payload path: " + remote_payload_path);
-
-        // Check if the payload exists in the remote object store
-        SERVER_LOG_DEBUG("FileSystem::get", "Checking if file exists in S3 at: " + remote_payload_path);
-        auto remote_exists_result = context->object_store->file_exists(remote_payload_path, tenant);
-        SERVER_LOG_DEBUG("FileSystem::get", "S3 file exists result: " + std::string(remote_exists_result.success ? "success" : "error"));
-
-        if (remote_exists_result.success && remote_exists_result.value) {
-            SERVER_LOG_DEBUG("FileSystem::get", "S3 file exists: true");
-
-            // Read from the remote object store
-            SERVER_LOG_DEBUG("FileSystem::get", "Reading file from S3 at: " + remote_payload_path);
-            auto object_store_result = context->object_store->read_file(remote_payload_path, tenant);
-            SERVER_LOG_DEBUG("FileSystem::get", "S3 read result: " + std::string(object_store_result.success ? "success" : "error"));
-
-            if (object_store_result.success) {
-                SERVER_LOG_DEBUG("FileSystem::get", "Successfully read " + std::to_string(object_store_result.value.size()) + " bytes from S3");
-
-                // Store the payload locally at the expected local path (for future access)
-                if (context->storage) {
-                    SERVER_LOG_DEBUG("FileSystem::get", "Storing file locally at: " + local_storage_path);
-                    auto store_result = context->storage->store_file(file_uid, current_version,
-                                                                     object_store_result.value, tenant);
-                    SERVER_LOG_DEBUG("FileSystem::get", "Local store result: " + std::string(store_result.success ? "success" : "error"));
-
-                    if (store_result.success) {
-                        SERVER_LOG_DEBUG("FileSystem::get", "File successfully restored to local storage at: " + store_result.value);
-                    } else {
-                        SERVER_LOG_WARN("FileSystem::get", "Failed to store file locally: " + store_result.error + " (continuing with S3 data)");
-                    }
-                } else {
-                    SERVER_LOG_WARN("FileSystem::get", "No storage context available for local storage (continuing with S3 data)");
-                }
-
-                // Add to cache if available
-                if (cache_manager_) {
-                    cache_manager_->add_file(local_storage_path, object_store_result.value, tenant);
-                    SERVER_LOG_DEBUG("FileSystem::get", "Added file to cache");
-                }
-
-                // Return the data directly from S3 (don't re-read from disk)
-                SERVER_LOG_DEBUG("FileSystem::get", "Returning file data restored from S3");
-                return Result<std::vector<uint8_t>>::ok(object_store_result.value);
-            } else {
-                SERVER_LOG_ERROR("FileSystem::get", "Failed to read file from S3: " + object_store_result.error);
+        return cold_reads_.run(single_flight_key(tenant, file_uid, current_version), [&]() -> Result<SharedBlob> {
+            auto stored = fetch_stored_blob(*context, file_uid, current_version, tenant);
+            if (!stored.success) {
+                return stored;
             }
-        } else if (!remote_exists_result.success) {
-            SERVER_LOG_ERROR("FileSystem::get", "Error checking S3 file existence: " + remote_exists_result.error);
-        } else {
-            SERVER_LOG_DEBUG("FileSystem::get", "File does not exist in S3 at the expected path");
-        }
+            // The object store holds the stored (encoded) blob, like local
+            // disk, so decode it before caching and returning it
+            auto decoded = decode_shared_blob(*context, std::move(stored.value));
+            if (!decoded.success) {
+                SERVER_LOG_ERROR("FileSystem::get", "Decoding failed: " + decoded.error);
+                return decoded;
+            }
+            if (cache_manager_) {
+                cache_manager_->insert(tenant, file_uid, current_version, decoded.value);
+            }
+            SERVER_LOG_DEBUG("FileSystem::get", "Returning file data restored from S3");
+            return decoded;
+        });
     } else if (!context->object_store) {
         SERVER_LOG_DEBUG("FileSystem::get", "No object store context available");
     } else {
@@ -687,49 +809,25 @@ Result<std::vector<uint8_t>> FileSystem::get(const std::string& file_uid,
             SERVER_LOG_DEBUG("FileSystem::get", "Successfully read " + std::to_string(storage_result.value.size()) + " bytes from local storage");
 
             // Process data after reading (decrypt and decompress if needed)
-            std::vector<uint8_t> processed_data = storage_result.value;
-
-            // Check if encryption is enabled for this tenant/context
-            if (context->storage && context->storage->is_encryption_enabled()) {
-                try {
-                    // Get the encryption key from the config
-                    std::string encryption_key = context->config.encryption_key;
-                    if (encryption_key.empty()) {
-                        return Result<std::vector<uint8_t>>::err("Encryption key not available");
-                    }
-
-                    processed_data = fileengine::CryptoUtils::decrypt_data(processed_data, encryption_key);
-                    SERVER_LOG_DEBUG("FileSystem::get", "Data decrypted successfully");
-                } catch (const std::exception& e) {
-                    SERVER_LOG_ERROR("FileSystem::get", "Decryption failed: " + std::string(e.what()));
-                    return Result<std::vector<uint8_t>>::err("Failed to decrypt data: " + std::string(e.what()));
-                }
+            auto decoded = decode_stored_blob(*context, std::move(storage_result.value));
+            if (!decoded.success) {
+                SERVER_LOG_ERROR("FileSystem::get", "Decoding failed: " + decoded.error);
+                return Result<SharedBlob>::err(decoded.error);
             }
 
-            // Check if compression is enabled for this tenant/context
-            if (context->storage && context->storage->is_compression_enabled()) {
-                try {
-                    processed_data = fileengine::CryptoUtils::decompress_data(processed_data);
-                    SERVER_LOG_DEBUG("FileSystem::get", "Data decompressed successfully");
-                } catch (const std::exception& e) {
-                    SERVER_LOG_ERROR("FileSystem::get", "Decompression failed: " + std::string(e.what()));
-                    return Result<std::vector<uint8_t>>::err("Failed to decompress data: " + std::string(e.what()));
-                }
-            }
-
-            // Add to cache if available
+            auto blob = std::make_shared<const std::vector<uint8_t>>(std::move(decoded.value));
             if (cache_manager_) {
-                cache_manager_->add_file(local_storage_path, processed_data, tenant);
+                cache_manager_->insert(tenant, file_uid, current_version, blob);
             }
-            return Result<std::vector<uint8_t>>::ok(processed_data);
+            return Result<SharedBlob>::ok(std::move(blob));
         } else {
             SERVER_LOG_ERROR("FileSystem::get", "Failed to read file from local storage: " + storage_result.error);
-            return Result<std::vector<uint8_t>>::err("Failed to read file from local storage: " + storage_result.error);
+            return Result<SharedBlob>::err("Failed to read file from local storage: " + storage_result.error);
         }
     }
 
     SERVER_LOG_ERROR("FileSystem::get", "File content not found in storage or object store");
-    return Result<std::vector<uint8_t>>::err("File content not found in storage or object store");
+    return Result<SharedBlob>::err("File content not found in storage or object store");
 }
 
 Result<void> FileSystem::put_stream(const std::string& file_uid,
@@ -745,7 +843,7 @@ Result<void> FileSystem::put_stream(const std::string& file_uid,
     if (!perm_result.success || !perm_result.value) {
         return Result<void>::err("User does not have permission to write file");
     }
-    auto file_info_result = context->db->get_file_by_uid(file_uid, tenant);
+    auto file_info_result = lookup_file(*context, file_uid, tenant);
     if (!file_info_result.success || !file_info_result.value.has_value()) {
         return Result<void>::err("File does not exist");
     }
@@ -766,83 +864,91 @@ Result<void> FileSystem::put_stream(const std::string& file_uid,
         if (encryption_key.empty()) return Result<void>::err("Encryption key not available");
     }
 
+    // Stream into a staging file and publish it only once complete, so a
+    // crash or failed upload never leaves a truncated blob at storage_path.
+    const std::string staged_path = context->storage->make_staging_path(storage_path);
     try {
-        std::filesystem::create_directories(std::filesystem::path(storage_path).parent_path());
+        std::filesystem::create_directories(std::filesystem::path(staged_path).parent_path());
     } catch (const std::exception& e) {
         return Result<void>::err("Failed to create storage directory: " + std::string(e.what()));
     }
 
-    std::ofstream ofs(storage_path, std::ios::binary | std::ios::trunc);
+    std::ofstream ofs(staged_path, std::ios::binary | std::ios::trunc);
     if (!ofs.is_open()) {
-        return Result<void>::err("Failed to open storage file for writing: " + storage_path);
+        return Result<void>::err("Failed to open storage file for writing: " + staged_path);
     }
 
+    const bool do_dedup = context->storage->is_deduplication_enabled();
+    std::string content_key;
     uint64_t original_size = 0;
     try {
-        std::unique_ptr<CompressStream> compressor;
-        std::unique_ptr<EncryptStream> encryptor;
-        if (do_compress) compressor = std::make_unique<CompressStream>();
-        if (do_encrypt) encryptor = std::make_unique<EncryptStream>(encryption_key);
+        // compress -> encrypt in the framed blob format (or the legacy one);
+        // with neither enabled the bytes are stored as received.
+        std::unique_ptr<BlobEncoder> encoder;
+        if (do_compress || do_encrypt) {
+            encoder = std::make_unique<BlobEncoder>(frame_codec(*context), encryption_key,
+                                                    context->config.storage_frame_size, encode_pool_);
+        }
+
+        // Content key for deduplication, computed as the bytes flow past: the
+        // keyed plaintext digest when encrypting (as in put()), else the digest
+        // of the stored bytes.
+        std::unique_ptr<ContentHasher> hasher;
+        if (do_dedup) hasher = std::make_unique<ContentHasher>(do_encrypt ? dedup_key(*context) : "");
 
-        std::vector<uint8_t> chunk, cbuf, ebuf;
+        std::vector<uint8_t> chunk, ebuf;
         auto sink = [&](const uint8_t* p, size_t n) {
             if (n > 0) ofs.write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(n));
-        };
-        // Push one plaintext chunk through compress -> encrypt -> disk.
-        auto feed = [&](const uint8_t* p, size_t n) {
-            if (do_compress) { compressor->update(p, n, cbuf); p = cbuf.data(); n = cbuf.size(); }
-            if (n == 0) return;
-            if (do_encrypt) { encryptor->update(p, n, ebuf); sink(ebuf.data(), ebuf.size()); }
-            else sink(p, n);
+            if (hasher && !do_encrypt) hasher->update(p, n);
         };
 
         while (next_chunk(chunk)) {
             if (chunk.empty()) continue;
             original_size += chunk.size();
-            feed(chunk.data(), chunk.size());
+            if (hasher && do_encrypt) hasher->update(chunk.data(), chunk.size());
+            if (encoder) { encoder->update(chunk.data(), chunk.size(), ebuf); sink(ebuf.data(), ebuf.size()); }
+            else sink(chunk.data(), chunk.size());
         }
 
-        if (original_size == 0) {
-            // Empty content -> empty blob (matches the one-shot convention where
-            // compress/encrypt of empty data yields an empty stored blob).
-            ofs.close();
-        } else {
-            if (do_compress) {
-                compressor->finish(cbuf);            // flush trailing compressed bytes
-                if (!cbuf.empty()) {
-                    if (do_encrypt) { encryptor->update(cbuf.data(), cbuf.size(), ebuf); sink(ebuf.data(), ebuf.size()); }
-                    else sink(cbuf.data(), cbuf.size());
-                }
-            }
-            if (do_encrypt) {
-                encryptor->finish(ebuf);             // appends the 16-byte GCM tag
-                sink(ebuf.data(), ebuf.size());
-            }
-            ofs.flush();
-            ofs.close();
+        // Empty content -> empty blob (the encoder's finish() emits nothing).
+        if (encoder) {
+            encoder->finish(ebuf);
+            sink(ebuf.data(), ebuf.size());
         }
-        if (ofs.fail()) throw std::runtime_error("write error on " + storage_path);
+        ofs.flush();
+        ofs.close();
+        if (ofs.fail()) throw std::runtime_error("write error on " + staged_path);
+        if (hasher) content_key = hasher->finish();
     } catch (const std::exception& e) {
         if (ofs.is_open()) ofs.close();
         std::error_code ec;
-        std::filesystem::remove(storage_path, ec);   // drop the partial file
+        std::filesystem::remove(staged_path, ec);    // drop the partial file
         return Result<void>::err(std::string("Failed to stream file to storage: ") + e.what());
     }
 
+    auto publish_result = context->storage->publish_staged_file(staged_path, storage_path);
+    if (!publish_result.success) {
+        std::error_code ec;
+        std::filesystem::remove(staged_path, ec);
+        return Result<void>::err("Failed to store file: " + publish_result.error);
+    }
+
+    // Share the blob with any identical content already stored. Failure only
+    // forgoes the space saving; the version file itself is complete.
+    if (do_dedup) {
+        auto dedup_result = context->storage->deduplicate_file(storage_path, content_key, tenant);
+        if (!dedup_result.success) {
+            SERVER_LOG_WARN("FileSystem::put_stream", "Deduplication skipped for " + storage_path + ": " + dedup_result.error);
+        }
+    }
+
     // Bookkeeping — identical to put().
     if (context->storage_tracker) {
         context->storage_tracker->record_file_creation(storage_path, original_size, tenant);
     }
-    auto update_result = context->db->update_file_current_version(file_uid, version_timestamp, tenant);
-    if (!update_result.success) return Result<void>::err("Failed to update current version: " + update_result.error);
-    auto insert_version_result = context->db->insert_version(file_uid, version_timestamp,
-                                                             static_cast<int64_t>(original_size), storage_path, user, tenant);
-    if (!insert_version_result.success) return Result<void>::err("Failed to record version: " + insert_version_result.error);
-    auto update_size_result = context->db->update_file_size(file_uid, static_cast<int64_t>(original_size), tenant);
-    if (!update_size_result.success) {
-        SERVER_LOG_ERROR("FileSystem::put_stream", "Failed to update file size for " + file_uid + ": " + update_size_result.error);
-    }
-    context->db->update_file_modified(file_uid, tenant);
+    auto commit_result = context->db->commit_new_version(file_uid, version_timestamp,
+                                                         static_cast<int64_t>(original_size), storage_path, user, tenant);
+    if (!commit_result.success) return Result<void>::err("Failed to record version: " + commit_result.error);
 
     if (context->object_store) {
         {
@@ -851,6 +957,12 @@ Result<void> FileSystem::put_stream(const std::string& file_uid,
         }
         queue_cv_.notify_one();
     }
+    // Timestamps are per millisecond, so a rapid rewrite can reuse one
+    if (cache_manager_) {
+        cache_manager_->invalidate(tenant, file_uid, version_timestamp);
+    }
+
+    invalidate_metadata(tenant, file_uid);
     emit_fs_event(tenant, FileEventType::FileUpdated, file_uid, user);
     return Result<void>::ok();
 }
@@ -868,7 +980,7 @@ Result<void> FileSystem::get_stream(const std::string& file_uid,
     if (!perm_result.success || !perm_result.value) {
         return Result<void>::err("User does not have permission to read file");
     }
-    auto file_info_result = context->db->get_file_by_uid(file_uid, tenant);
+    auto file_info_result = lookup_file(*context, file_uid, tenant);
     if (!file_info_result.success || !file_info_result.value.has_value()) {
         return Result<void>::err("File does not exist");
     }
@@ -882,6 +994,15 @@ Result<void> FileSystem::get_stream(const std::string& file_uid,
         current_version = versions_result.value[0];
     }
 
+    if (cache_manager_) {
+        if (auto cached = cache_manager_->lookup(tenant, file_uid, current_version)) {
+            for (size_t pos = 0; pos < cached->size(); pos += kRangeChunkSize) {
+                if (!on_chunk(cached->data() + pos, std::min(kRangeChunkSize, cached->size() - pos))) break;
+            }
+            return Result<void>::ok();
+        }
+    }
+
     std::string local_storage_path;
     auto path_result = context->db->get_version_storage_path(file_uid, current_version, tenant);
     if (path_result.success && path_result.value.has_value()) {
@@ -896,13 +1017,13 @@ Result<void> FileSystem::get_stream(const std::string& file_uid,
         if (exists_result.success) file_exists_locally = exists_result.value;
     }
 
-    // Cold path (not on local disk): reuse the whole-buffer get(), which handles
+    // Cold path (not on local disk): reuse the whole-buffer get_shared(), which handles
     // S3 restore + decrypt/decompress, and emit it as a single chunk. This keeps
     // the rare restore path simple; the common local path below streams.
     if (!file_exists_locally) {
-        auto r = get(file_uid, user, roles, tenant);
+        auto r = get_shared(file_uid, user, roles, tenant);
         if (!r.success) return Result<void>::err(r.error);
-        if (!r.value.empty()) on_chunk(r.value.data(), r.value.size());
+        if (!r.value->empty()) on_chunk(r.value->data(), r.value->size());
         return Result<void>::ok();
     }
 
@@ -914,51 +1035,29 @@ Result<void> FileSystem::get_stream(const std::string& file_uid,
         if (encryption_key.empty()) return Result<void>::err("Encryption key not available");
     }
 
-    std::ifstream ifs(local_storage_path, std::ios::binary);
-    if (!ifs.is_open()) {
-        return Result<void>::err("Failed to open file for reading: " + local_storage_path);
-    }
-
     try {
-        std::unique_ptr<DecryptStream> decryptor;
-        std::unique_ptr<DecompressStream> decompressor;
-        if (do_encrypt) decryptor = std::make_unique<DecryptStream>(encryption_key);
-        if (do_compress) decompressor = std::make_unique<DecompressStream>();
+        // Framed blobs are verified frame by frame before any plaintext is
+        // emitted; legacy blobs only authenticate at finish() (see DecryptStream).
+        std::unique_ptr<BlobDecoder> decoder;
+        if (do_compress || do_encrypt) decoder = std::make_unique<BlobDecoder>(do_compress, encryption_key);
 
-        std::vector<char> buf(256 * 1024);
-        std::vector<uint8_t> dbuf, ddbuf;
+        std::vector<uint8_t> dbuf;
         bool aborted = false;
-        // Emit decrypted+decompressed plaintext to the caller.
-        auto emit = [&](const uint8_t* p, size_t n) {
-            if (n == 0 || aborted) return;
-            if (do_compress) {
-                decompressor->update(p, n, ddbuf);
-                if (!ddbuf.empty() && !on_chunk(ddbuf.data(), ddbuf.size())) aborted = true;
-            } else {
-                if (!on_chunk(p, n)) aborted = true;
-            }
-        };
-        // disk bytes -> decrypt -> emit
+        // disk bytes -> decode -> caller
         auto consume = [&](const uint8_t* p, size_t n) {
-            if (do_encrypt) { decryptor->update(p, n, dbuf); emit(dbuf.data(), dbuf.size()); }
-            else emit(p, n);
+            if (decoder) { decoder->update(p, n, dbuf); p = dbuf.data(); n = dbuf.size(); }
+            if (n > 0 && !aborted && !on_chunk(p, n)) aborted = true;
         };
 
-        while (!aborted) {
-            ifs.read(buf.data(), static_cast<std::streamsize>(buf.size()));
-            std::streamsize n = ifs.gcount();
-            if (n <= 0) break;
-            consume(reinterpret_cast<const uint8_t*>(buf.data()), static_cast<size_t>(n));
+        // The storage backend picks the I/O strategy (blocking reads, io_uring).
+        auto read_result = context->storage->read_file_chunks(local_storage_path,
+            [&](const uint8_t* p, size_t n) { consume(p, n); return !aborted; }, tenant);
+        if (!read_result.success) {
+            return Result<void>::err(read_result.error);
         }
-        if (!aborted) {
-            if (do_encrypt) {
-                decryptor->finish(dbuf);     // verifies the GCM tag (throws on mismatch)
-                if (!dbuf.empty()) emit(dbuf.data(), dbuf.size());
-            }
-            if (do_compress) {
-                decompressor->finish(ddbuf);
-                if (!ddbuf.empty()) on_chunk(ddbuf.data(), ddbuf.size());
-            }
+        if (!aborted && decoder) {
+            decoder->finish(dbuf);     // legacy: verifies the GCM tag (throws on mismatch)
+            if (!dbuf.empty()) on_chunk(dbuf.data(), dbuf.size());
         }
     } catch (const std::exception& e) {
         return Result<void>::err(std::string("Failed to stream file from storage: ") + e.what());
@@ -966,6 +1065,194 @@ Result<void> FileSystem::get_stream(const std::string& file_uid,
     return Result<void>::ok();
 }
 
+Result<uint64_t> FileSystem::get_range_stream(const std::string& file_uid, uint64_t offset, uint64_t length,
+                                              const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                              const std::string& user,
+                                              const std::vector<std::string>& roles,
+                                              const std::string& tenant) {
+    using R = Result<uint64_t>;
+    auto context = get_tenant_context(tenant);
+    if (!context || !context->db) {
+        return R::err("Database not available for tenant: " + tenant);
+    }
+    auto perm_result = validate_user_permissions(file_uid, user, roles, static_cast<int>(Permission::READ), tenant);
+    if (!perm_result.success || !perm_result.value) {
+        return R::err("User does not have permission to read file");
+    }
+    auto file_info_result = lookup_file(*context, file_uid, tenant);
+    if (!file_info_result.success || !file_info_result.value.has_value()) {
+        return R::err("File does not exist");
+    }
+
+    std::string current_version = file_info_result.value->version;
+    if (current_version.empty()) {
+        auto versions_result = list_versions(file_uid, user, roles, tenant);
+        if (!versions_result.success || versions_result.value.empty()) {
+            return R::err("No versions available for file");
+        }
+        current_version = versions_result.value[0];
+    }
+
+    std::string local_storage_path;
+    auto path_result = context->db->get_version_storage_path(file_uid, current_version, tenant);
+    if (path_result.success && path_result.value.has_value()) {
+        local_storage_path = path_result.value.value();
+    } else if (context->storage) {
+        local_storage_path = context->storage->get_storage_path(file_uid, current_version, tenant);
+    }
+
+    bool file_exists_locally = false;
+    if (context->storage) {
+        auto exists_result = context->storage->file_exists(local_storage_path, tenant);
+        if (exists_result.success) file_exists_locally = exists_result.value;
+    }
+
+    // Positional reads of the stored blob, wherever it lives. A cold file is
+    // read in place with ranged object-store reads rather than restored, so a
+    // small range of a large file costs a few small requests.
+    FramedBlobReader::ReadAt read_at;
+    uint64_t stored_size = 0;
+    if (file_exists_locally) {
+        auto size_result = context->storage->get_file_size(local_storage_path, tenant);
+        if (!size_result.success) return R::err(size_result.error);
+        stored_size = size_result.value;
+        IStorage* storage = context->storage.get();
+        read_at = [storage, local_storage_path, tenant](uint64_t off, size_t len) {
+            return storage->read_file_range(local_storage_path, off, len, tenant);
+        };
+    } else if (context->object_store) {
+        IObjectStore* object_store = context->object_store.get();
+        std::string remote_payload_path = object_store->get_storage_path(file_uid, current_version, tenant);
+        auto size_result = object_store->get_file_size(remote_payload_path, tenant);
+        if (!size_result.success) {
+            SERVER_LOG_ERROR("FileSystem::get_range_stream", "Object store size lookup failed: " + size_result.error);
+            return R::err("File content not found in storage or object store");
+        }
+        stored_size = size_result.value;
+        read_at = [object_store, remote_payload_path, tenant](uint64_t off, size_t len) {
+            return object_store->read_file_range(remote_payload_path, off, len, tenant);
+        };
+    } else {
+        return R::err("File content not found in storage or object store");
+    }
+
+    // Emit [offset, end) of a `plain_size`-byte plaintext through `read_plain`.
+    auto emit_range = [&](const FramedBlobReader::ReadAt& read_plain, uint64_t plain_size) -> Result<void> {
+        if (offset >= plain_size) return Result<void>::ok();
+        const uint64_t end = (length == 0 || length > plain_size - offset) ? plain_size : offset + length;
+        for (uint64_t pos = offset; pos < end;) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(kRangeChunkSize, end - pos));
+            auto chunk = read_plain(pos, n);
+            if (!chunk.success) return Result<void>::err(chunk.error);
+            if (chunk.value.empty()) return Result<void>::err("Stored data ended before the requested range");
+            if (!on_chunk(chunk.value.data(), chunk.value.size())) break;
+            pos += chunk.value.size();
+        }
+        return Result<void>::ok();
+    };
+
+    const bool do_compress = context->storage ? context->storage->is_compression_enabled() : false;
+    const bool do_encrypt = context->storage ? context->storage->is_encryption_enabled() : false;
+    std::string encryption_key;
+    if (do_encrypt) {
+        encryption_key = context->config.encryption_key;
+        if (encryption_key.empty()) return R::err("Encryption key not available");
+    }
+
+    try {
+        // Plain blobs: the stored bytes are the plaintext.
+        if (!do_compress && !do_encrypt) {
+            auto r = emit_range(read_at, stored_size);
+            if (!r.success) return R::err(r.error);
+            return R::ok(stored_size);
+        }
+        if (stored_size == 0) {
+            return R::ok(0);  // empty content is stored as an empty blob
+        }
+
+        // Framed blobs: decode only the frames overlapping the range. A blob
+        // whose header, index or trailer does not validate is decoded as
+        // legacy instead; legacy bytes can start with the framed magic.
+        auto head = read_at(0, 4);
+        if (!head.success) return R::err(head.error);
+        if (FramedBlobReader::is_framed(head.value.data(), head.value.size())) {
+            auto reader_result = FramedBlobReader::open(stored_size, read_at, encryption_key);
+            if (reader_result.success) {
+                auto reader = reader_result.value;
+                auto r = emit_range([&reader](uint64_t off, size_t len) { return reader->read(off, len); },
+                                    reader->size());
+                if (!r.success) return R::err(r.error);
+                return R::ok(reader->size());
+            }
+        }
+
+        // Legacy blobs have no index: decode sequentially, skip up to `offset`
+        // and stop at the end of the range. An encrypted one carries a single
+        // GCM tag at its end, so it is first decoded in full and checked
+        // (throwing on a bad tag) before any of its bytes are handed out.
+        if (do_encrypt) {
+            BlobDecoder verifier(do_compress, encryption_key, true);
+            std::vector<uint8_t> discard;
+            for (uint64_t pos = 0; pos < stored_size;) {
+                auto chunk = read_at(pos, static_cast<size_t>(std::min<uint64_t>(kRangeChunkSize, stored_size - pos)));
+                if (!chunk.success) return R::err(chunk.error);
+                if (chunk.value.empty()) return R::err("Stored data ended early");
+                verifier.update(chunk.value.data(), chunk.value.size(), discard);
+                pos += chunk.value.size();
+            }
+            verifier.finish(discard);
+        }
+        BlobDecoder decoder(do_compress, encryption_key, true);
+        std::vector<uint8_t> dbuf;
+        uint64_t plain_pos = 0;
+        bool done = false;
+        auto consume = [&](const std::vector<uint8_t>& plain) {
+            const uint64_t chunk_end = plain_pos + plain.size();
+            if (!done && chunk_end > offset) {
+                uint64_t from = offset > plain_pos ? offset - plain_pos : 0;
+                uint64_t to = plain.size();
+                if (length != 0 && chunk_end - offset >= length) {
+                    to = offset + length - plain_pos;
+                    done = true;
+                }
+                if (to > from && !on_chunk(plain.data() + from, static_cast<size_t>(to - from))) done = true;
+            }
+            plain_pos = chunk_end;
+        };
+        for (uint64_t pos = 0; pos < stored_size && !done;) {
+            auto chunk = read_at(pos, static_cast<size_t>(std::min<uint64_t>(kRangeChunkSize, stored_size - pos)));
+            if (!chunk.success) return R::err(chunk.error);
+            if (chunk.value.empty()) return R::err("Stored data ended early");
+            decoder.update(chunk.value.data(), chunk.value.size(), dbuf);
+            consume(dbuf);
+            pos += chunk.value.size();
+        }
+        if (done) {
+            // Stopped early, so the full size is only known from metadata.
+            return R::ok(static_cast<uint64_t>(std::max<int64_t>(file_info_result.value->size, 0)));
+        }
+        decoder.finish(dbuf);
+        consume(dbuf);
+        return R::ok(plain_pos);
+    } catch (const std::exception& e) {
+        return R::err(std::string("Failed to read file range from storage: ") + e.what());
+    }
+}
+
+Result<std::vector<uint8_t>> FileSystem::get_range(const std::string& file_uid, uint64_t offset, uint64_t length,
+                                                   const std::string& user,
+                                                   const std::vector<std::string>& roles,
+                                                   const std::string& tenant) {
+    std::vector<uint8_t> data;
+    auto result = get_range_stream(file_uid, offset, length,
+        [&data](const uint8_t* p, size_t n) { data.insert(data.end(), p, p + n); return true; },
+        user, roles, tenant);
+    if (!result.success) {
+        return Result<std::vector<uint8_t>>::err(result.error);
+    }
+    return Result<std::vector<uint8_t>>::ok(data);
+}
+
 Result<FileInfo> FileSystem::stat(const std::string& file_uid, const std::string& user,
                                   const std::vector<std::string>& roles,
                                   const std::string& tenant) {
@@ -980,7 +1267,7 @@ Result<FileInfo> FileSystem::stat(const std::string& file_uid, const std::string
         return Result<FileInfo>::err("User does not have permission to access file info");
     }
     
-    auto db_result = context->db->get_file_by_uid(file_uid, tenant);
+    auto db_result = lookup_file(*context, file_uid, tenant);
     if (!db_result.success || !db_result.value.has_value()) {
         return Result<FileInfo>::err("File does not exist");
     }
@@ -994,7 +1281,7 @@ Result<bool> FileSystem::exists(const std::string& file_uid, const std::string&
         return Result<bool>::err("Database not available for tenant: " + tenant);
     }
 
-    auto db_result = context->db->get_file_by_uid(file_uid, tenant);
+    auto db_result = lookup_file(*context, file_uid, tenant);
     if (!db_result.success) {
         return Result<bool>::err(db_result.error);
     }
@@ -1065,13 +1352,13 @@ Result<void> FileSystem::move(const std::string& src_uid, const std::string& dst
     }
 
     // Get the source file info to check if it exists and to get its type
-    auto src_info_result = context->db->get_file_by_uid(src_uid, tenant);
+    auto src_info_result = lookup_file(*context, src_uid, tenant);
     if (!src_info_result.success || !src_info_result.value.has_value()) {
         return Result<void>::err("Source file does not exist");
     }
 
     // Get the destination directory info to ensure it's a directory
-    auto dst_info_result = context->db->get_file_by_uid(dst_uid, tenant);
+    auto dst_info_result = lookup_file(*context, dst_uid, tenant);
     if (!dst_info_result.success || !dst_info_result.value.has_value()) {
         return Result<void>::err("Destination directory does not exist");
     }
@@ -1097,6 +1384,10 @@ Result<void> FileSystem::move(const std::string& src_uid, const std::string& dst
     if (!db_result.success) {
         return Result<void>::err("Failed to move file in database: " + db_result.error);
     }
+    // Both the old and the new ancestors now report a different mtime
+    invalidate_metadata(tenant, src_uid, src_info_result.value->parent_uid);
+    invalidate_metadata(tenant, src_uid, dst_uid);
+    invalidate_permissions(tenant);  // new ancestors decide reachability
 
     // De-duplicate the name on collision (best-effort: the move already succeeded).
     if (move_name != src_info_result.value->name) {
@@ -1105,6 +1396,7 @@ Result<void> FileSystem::move(const std::string& src_uid, const std::string& dst
             SERVER_LOG_ERROR("FileSystem::move", ServerLogger::getInstance().detailed_log_prefix() +
                       "Moved but failed to de-duplicate name for " + src_uid + ": " + rn.error);
         }
+        invalidate_metadata(tenant, src_uid, dst_uid);
     }
 
     emit_fs_event(tenant, FileEventType::FileMoved, src_uid, user);
@@ -1138,7 +1430,7 @@ Result<void> FileSystem::copy(const std::string& src_uid, const std::string& dst
     }
 
     // Get the source file info to check if it exists and to get its type
-    auto src_info_result = context->db->get_file_by_uid(src_uid, tenant);
+    auto src_info_result = lookup_file(*context, src_uid, tenant);
     if (!src_info_result.success || !src_info_result.value.has_value()) {
         return Result<void>::err("Source file does not exist");
     }
@@ -1146,7 +1438,7 @@ Result<void> FileSystem::copy(const std::string& src_uid, const std::string& dst
     auto src_info = src_info_result.value.value();
 
     // Get the destination directory info to ensure it's a directory
-    auto dst_info_result = context->db->get_file_by_uid(dst_uid, tenant);
+    auto dst_info_result = lookup_file(*context, dst_uid, tenant);
     if (!dst_info_result.success || !dst_info_result.value.has_value()) {
         return Result<void>::err("Destination directory does not exist");
     }
@@ -1192,6 +1484,7 @@ Result<void> FileSystem::copy(const std::string& src_uid, const std::string& dst
             }
         }
 
+        invalidate_metadata(tenant, new_uid, dst_uid);
         emit_fs_event(tenant, FileEventType::DirCreated, new_uid, user);
         return Result<void>::ok();
     } else {
@@ -1217,27 +1510,30 @@ Result<void> FileSystem::copy(const std::string& src_uid, const std::string& dst
         }
 
         // Copy every version's content (oldest -> newest) under the new UID.
+        // The stored bytes are copied as they are (reflink/copy_file_range
+        // where the storage can), never read into memory here.
         int64_t current_size = 0;
         for (auto it = versions.rbegin(); it != versions.rend(); ++it) {
             const std::string& ver = *it;
             std::string src_storage_path = context->storage->get_storage_path(src_uid, ver, tenant);
-            auto storage_result = context->storage->read_file(src_storage_path, tenant);
-            if (!storage_result.success) {
-                return Result<void>::err("Failed to read source version " + ver + ": " + storage_result.error);
-            }
-            auto store_result = context->storage->store_file(new_uid, ver, storage_result.value, tenant);
+            auto store_result = context->storage->copy_file(src_storage_path, new_uid, ver, tenant);
             if (!store_result.success) {
-                return Result<void>::err("Failed to store copied version " + ver + ": " + store_result.error);
+                return Result<void>::err("Failed to copy version " + ver + ": " + store_result.error);
+            }
+            auto size_result = context->storage->get_file_size(store_result.value, tenant);
+            if (!size_result.success) {
+                return Result<void>::err("Failed to stat copied version " + ver + ": " + size_result.error);
             }
+            const size_t stored_size = static_cast<size_t>(size_result.value);
             if (context->storage_tracker) {
-                context->storage_tracker->record_file_creation(store_result.value, storage_result.value.size(), tenant);
+                context->storage_tracker->record_file_creation(store_result.value, stored_size, tenant);
             }
-            auto insert_version_result = context->db->insert_version(new_uid, ver, storage_result.value.size(),
+            auto insert_version_result = context->db->insert_version(new_uid, ver, stored_size,
                                                                      store_result.value, user, tenant);
             if (!insert_version_result.success) {
                 return Result<void>::err("Failed to record version " + ver + ": " + insert_version_result.error);
             }
-            if (ver == current_version) current_size = static_cast<int64_t>(storage_result.value.size());
+            if (ver == current_version) current_size = static_cast<int64_t>(stored_size);
             // Schedule an object-store backup for this version.
             if (context->object_store) {
                 {
@@ -1281,14 +1577,15 @@ Result<void> FileSystem::copy(const std::string& src_uid, const std::string& dst
                     continue;
                 }
                 std::string r_ver = rv.value.back();
-                auto r_read = context->storage->read_file(
-                    context->storage->get_storage_path(rend.uid, r_ver, tenant), tenant);
-                if (!r_read.success) continue;
                 std::string r_new_uid = Utils::generate_uuid();
-                auto r_store = context->storage->store_file(r_new_uid, r_ver, r_read.value, tenant);
+                auto r_store = context->storage->copy_file(
+                    context->storage->get_storage_path(rend.uid, r_ver, tenant), r_new_uid, r_ver, tenant);
                 if (!r_store.success) continue;
+                auto r_size = context->storage->get_file_size(r_store.value, tenant);
+                if (!r_size.success) continue;
+                const size_t r_stored_size = static_cast<size_t>(r_size.value);
                 if (context->storage_tracker) {
-                    context->storage_tracker->record_file_creation(r_store.value, r_read.value.size(), tenant);
+                    context->storage_tracker->record_file_creation(r_store.value, r_stored_size, tenant);
                 }
                 auto r_grants = compute_initial_acl_grants(new_uid, user, tenant);
                 auto r_db = context->db->create_file_with_acls(
@@ -1300,12 +1597,13 @@ Result<void> FileSystem::copy(const std::string& src_uid, const std::string& dst
                     continue;
                 }
                 context->db->update_file_current_version(r_new_uid, r_ver, tenant);
-                context->db->insert_version(r_new_uid, r_ver, r_read.value.size(), r_store.value, user, tenant);
-                context->db->update_file_size(r_new_uid, static_cast<int64_t>(r_read.value.size()), tenant);
+                context->db->insert_version(r_new_uid, r_ver, r_stored_size, r_store.value, user, tenant);
+                context->db->update_file_size(r_new_uid, static_cast<int64_t>(r_stored_size), tenant);
                 context->db->update_file_modified(r_new_uid, tenant);
             }
         }
 
+        invalidate_metadata(tenant, new_uid, dst_uid);
         emit_fs_event(tenant, FileEventType::FileCreated, new_uid, user);
         return Result<void>::ok();
     }
@@ -1331,6 +1629,7 @@ Result<void> FileSystem::rename(const std::string& uid, const std::string& new_n
         return Result<void>::err("Failed to rename file: " + db_result.error);
     }
 
+    invalidate_metadata(tenant, uid);
     emit_fs_event(tenant, FileEventType::FileRenamed, uid, user);
     return Result<void>::ok();
 }
@@ -1363,30 +1662,41 @@ Result<std::vector<uint8_t>> FileSystem::get_version(const std::string& file_uid
                                                      const std::string& user,
                                                      const std::vector<std::string>& roles,
                                                      const std::string& tenant) {
+    auto result = get_version_shared(file_uid, version_timestamp, user, roles, tenant);
+    if (!result.success) {
+        return Result<std::vector<uint8_t>>::err(result.error);
+    }
+    return Result<std::vector<uint8_t>>::ok(*result.value);
+}
+
+Result<SharedBlob> FileSystem::get_version_shared(const std::string& file_uid,
+                                                  const std::string& version_timestamp,
+                                                  const std::string& user,
+                                                  const std::vector<std::string>& roles,
+                                                  const std::string& tenant) {
     auto context = get_tenant_context(tenant);
     if (!context || !context->db) {
-        return Result<std::vector<uint8_t>>::err("Database not available for tenant: " + tenant);
+        return Result<SharedBlob>::err("Database not available for tenant: " + tenant);
     }
     
     // Check permissions - the user needs read permission on the file
     auto perm_result = validate_user_permissions(file_uid, user, roles, static_cast<int>(Permission::RETRIEVE_BACK_VERSION), tenant); // dedicated RETRIEVE_BACK_VERSION bit (H1)
     if (!perm_result.success || !perm_result.value) {
-        return Result<std::vector<uint8_t>>::err("User does not have permission to access version");
+        return Result<SharedBlob>::err("User does not have permission to access version");
     }
     
     // Get the storage path for this version
     auto path_result = context->db->get_version_storage_path(file_uid, version_timestamp, tenant);
     if (!path_result.success || !path_result.value.has_value()) {
-        return Result<std::vector<uint8_t>>::err("Version storage path not found");
+        return Result<SharedBlob>::err("Version storage path not found");
     }
     
     std::string storage_path = path_result.value.value();
     
     // If we have a cache manager, try to get from cache first
     if (cache_manager_) {
-        auto cache_result = cache_manager_->get_file(storage_path, tenant);
-        if (cache_result.success) {
-            return cache_result;
+        if (auto cached = cache_manager_->lookup(tenant, file_uid, version_timestamp)) {
+            return Result<SharedBlob>::ok(std::move(cached));
         }
     }
     
@@ -1395,45 +1705,21 @@ Result<std::vector<uint8_t>> FileSystem::get_version(const std::string& file_uid
         auto storage_result = context->storage->read_file(storage_path, tenant);
         if (storage_result.success) {
             // Process data after reading (decrypt and decompress if needed)
-            std::vector<uint8_t> processed_data = storage_result.value;
-
-            // Check if encryption is enabled for this tenant/context
-            if (context->storage && context->storage->is_encryption_enabled()) {
-                try {
-                    // Get the encryption key from the config
-                    std::string encryption_key = context->config.encryption_key;
-                    if (encryption_key.empty()) {
-                        return Result<std::vector<uint8_t>>::err("Encryption key not available");
-                    }
-
-                    processed_data = fileengine::CryptoUtils::decrypt_data(processed_data, encryption_key);
-                    SERVER_LOG_DEBUG("FileSystem::get_version", "Version data decrypted successfully");
-                } catch (const std::exception& e) {
-                    SERVER_LOG_ERROR("FileSystem::get_version", "Decryption failed: " + std::string(e.what()));
-                    return Result<std::vector<uint8_t>>::err("Failed to decrypt version data: " + std::string(e.what()));
-                }
+            auto decoded = decode_stored_blob(*context, std::move(storage_result.value));
+            if (!decoded.success) {
+                SERVER_LOG_ERROR("FileSystem::get_version", "Decoding failed: " + decoded.error);
+                return Result<SharedBlob>::err(decoded.error);
             }
 
-            // Check if compression is enabled for this tenant/context
-            if (context->storage && context->storage->is_compression_enabled()) {
-                try {
-                    processed_data = fileengine::CryptoUtils::decompress_data(processed_data);
-                    SERVER_LOG_DEBUG("FileSystem::get_version", "Version data decompressed successfully");
-                } catch (const std::exception& e) {
-                    SERVER_LOG_ERROR("FileSystem::get_version", "Decompression failed: " + std::string(e.what()));
-                    return Result<std::vector<uint8_t>>::err("Failed to decompress version data: " + std::string(e.what()));
-                }
-            }
-
-            // Add to cache if available
+            auto blob = std::make_shared<const std::vector<uint8_t>>(std::move(decoded.value));
             if (cache_manager_) {
-                cache_manager_->add_file(storage_path, processed_data, tenant);
+                cache_manager_->insert(tenant, file_uid, version_timestamp, blob);
             }
-            return Result<std::vector<uint8_t>>::ok(processed_data);
+            return Result<SharedBlob>::ok(std::move(blob));
         }
     }
     
-    return Result<std::vector<uint8_t>>::err("Version content not found");
+    return Result<SharedBlob>::err("Version content not found");
 }
 
 Result<bool> FileSystem::restore_to_version(const std::string& file_uid,
@@ -1455,6 +1741,7 @@ Result<bool> FileSystem::restore_to_version(const std::string& file_uid,
 
     auto result = context->db->restore_to_version(file_uid, version_timestamp, user, tenant);
     if (result.success && result.value) {
+        invalidate_metadata(tenant, file_uid);
         emit_fs_event(tenant, FileEventType::FileUpdated, file_uid, user);
     }
     return result;
@@ -1579,7 +1866,11 @@ Result<void> FileSystem::purge_old_versions(const std::string& file_uid, int kee
             std::string path = context->storage->get_storage_path(file_uid, vts, tenant);
             context->storage->delete_file(path, tenant);  // best-effort
         }
+        if (cache_manager_) {
+            cache_manager_->invalidate(tenant, file_uid, vts);
+        }
         auto del = context->db->delete_version(file_uid, vts, tenant);
+        invalidate_metadata(tenant, file_uid);  // created_at/created_by come from the oldest version
         if (!del.success) {
             return Result<void>::err("Failed to purge version " + vts + ": " + del.error);
         }
@@ -1800,14 +2091,14 @@ void FileSystem::resolve_audit_target(const std::string& uid, const std::string&
     try {
         auto* context = get_tenant_context(tenant);
         if (!context || !context->db) return;
-        auto info = context->db->get_file_by_uid_include_deleted(uid, tenant);
+        auto info = lookup_file(*context, uid, tenant, true);
         if (!info.success || !info.value.has_value()) return;
         out_name = info.value.value().name;
         // A rendition/sidecar is a hidden child of a *file*: detect via parent type
         // (mirrors the is_rendition enrichment on the event envelope).
         const std::string& parent_uid = info.value.value().parent_uid;
         if (parent_uid.empty()) return;
-        auto parent = context->db->get_file_by_uid_include_deleted(parent_uid, tenant);
+        auto parent = lookup_file(*context, parent_uid, tenant, true);
         if (parent.success && parent.value.has_value()) {
             out_is_hidden_child = (parent.value.value().type == FileType::REGULAR_FILE);
         }
@@ -1831,6 +2122,29 @@ void FileSystem::shutdown() {
     }
 }
 
+Result<std::optional<FileInfo>> FileSystem::lookup_file(TenantContext& context, const std::string& uid,
+                                                        const std::string& tenant, bool include_deleted) {
+    if (metadata_cache_) {
+        return include_deleted ? metadata_cache_->get_file_by_uid_include_deleted(*context.db, uid, tenant)
+                               : metadata_cache_->get_file_by_uid(*context.db, uid, tenant);
+    }
+    return include_deleted ? context.db->get_file_by_uid_include_deleted(uid, tenant)
+                           : context.db->get_file_by_uid(uid, tenant);
+}
+
+void FileSystem::invalidate_metadata(const std::string& tenant, const std::string& uid,
+                                     const std::optional<std::string>& parent_uid) {
+    if (metadata_cache_) {
+        metadata_cache_->invalidate(tenant, uid, parent_uid);
+    }
+}
+
+void FileSystem::invalidate_permissions(const std::string& tenant) {
+    if (acl_manager_) {
+        acl_manager_->invalidate_cached_permissions(tenant);
+    }
+}
+
 void FileSystem::emit_fs_event(const std::string& tenant, FileEventType type,
                                const std::string& uid, const std::string& user) noexcept {
     if (!event_sink_) return;  // events disabled — cheap no-op, no DB work
@@ -1847,7 +2161,7 @@ void FileSystem::emit_fs_event(const std::string& tenant, FileEventType type,
         // resolve metadata for the row that was just soft-deleted.
         auto context = get_tenant_context(tenant);
         if (context && context->db) {
-            auto info = context->db->get_file_by_uid_include_deleted(uid, tenant);
+            auto info = lookup_file(*context, uid, tenant, true);
             if (info.success && info.value.has_value()) {
                 const auto& fi = info.value.value();
                 ev.name = fi.name;
@@ -1860,7 +2174,7 @@ void FileSystem::emit_fs_event(const std::string& tenant, FileEventType type,
             // A rendition is a hidden child of a *file*: detect via parent type
             // so consumers can ignore the conversion service's own output.
             if (!ev.parent_uid.empty()) {
-                auto parent = context->db->get_file_by_uid_include_deleted(ev.parent_uid, tenant);
+                auto parent = lookup_file(*context, ev.parent_uid, tenant, true);
                 if (parent.success && parent.value.has_value()) {
                     ev.is_rendition = (parent.value.value().type == FileType::REGULAR_FILE);
                 }
@@ -1889,7 +2203,7 @@ void FileSystem::emit_acl_event(const std::string& tenant, const std::string& re
 
         auto context = get_tenant_context(tenant);
         if (context && context->db) {
-            auto info = context->db->get_file_by_uid_include_deleted(resource_uid, tenant);
+            auto info = lookup_file(*context, resource_uid, tenant, true);
             if (info.success && info.value.has_value()) {
                 const auto& fi = info.value.value();
                 ev.name = fi.name;
@@ -2022,25 +2336,53 @@ Result<std::vector<uint8_t>> FileSystem::fetch_from_object_store_if_missing(cons
         return Result<std::vector<uint8_t>>::err("Object store not available for tenant: " + tenant);
     }
 
-    // Create the storage path for the object store lookup
-    auto obj_store_path = context->object_store->get_storage_path(uid, version_timestamp, tenant);
-
-    // Read from object store
-    auto object_store_result = context->object_store->read_file(obj_store_path, tenant);
-    if (!object_store_result.success) {
-        return Result<std::vector<uint8_t>>::err("File not found in object store: " + object_store_result.error);
+    // Also stores the blob locally. These are the stored (encoded) bytes, so
+    // they stay out of the read cache, which holds decoded content only.
+    auto stored = fetch_stored_blob(*context, uid, version_timestamp, tenant);
+    if (!stored.success) {
+        return Result<std::vector<uint8_t>>::err(stored.error);
     }
+    return Result<std::vector<uint8_t>>::ok(*stored.value);
+}
 
-    // If found in object store, also store in local storage and cache
-    if (context->storage) {
-        auto store_result = context->storage->store_file(uid, version_timestamp,
-                                                         object_store_result.value, tenant);
-        if (store_result.success && cache_manager_) {
-            cache_manager_->add_file(store_result.value, object_store_result.value, tenant);
+Result<SharedBlob> FileSystem::fetch_stored_blob(TenantContext& context, const std::string& file_uid,
+                                                 const std::string& version, const std::string& tenant) {
+    return stored_fetches_.run(single_flight_key(tenant, file_uid, version), [&]() -> Result<SharedBlob> {
+        // Compose the path to the remote payload in object store
+        std::string remote_payload_path = context.object_store->get_storage_path(file_uid, version, tenant);
+        SERVER_LOG_DEBUG("FileSystem::fetch_stored_blob", "Checking if file exists in S3 at: " + remote_payload_path);
+        auto remote_exists_result = context.object_store->file_exists(remote_payload_path, tenant);
+        if (!remote_exists_result.success) {
+            SERVER_LOG_ERROR("FileSystem::fetch_stored_blob", "Error checking S3 file existence: " + remote_exists_result.error);
+            return Result<SharedBlob>::err("File content not found in storage or object store");
+        }
+        if (!remote_exists_result.value) {
+            SERVER_LOG_DEBUG("FileSystem::fetch_stored_blob", "File does not exist in S3 at the expected path");
+            return Result<SharedBlob>::err("File content not found in storage or object store");
         }
-    }
 
-    return Result<std::vector<uint8_t>>::ok(object_store_result.value);
+        auto object_store_result = context.object_store->read_file(remote_payload_path, tenant);
+        if (!object_store_result.success) {
+            SERVER_LOG_ERROR("FileSystem::fetch_stored_blob", "Failed to read file from S3: " + object_store_result.error);
+            return Result<SharedBlob>::err("File not found in object store: " + object_store_result.error);
+        }
+        SERVER_LOG_DEBUG("FileSystem::fetch_stored_blob", "Successfully read " +
+                         std::to_string(object_store_result.value.size()) + " bytes from S3");
+        auto stored = std::make_shared<const std::vector<uint8_t>>(std::move(object_store_result.value));
+
+        // Store the payload locally at the expected local path (for future access)
+        if (context.storage) {
+            auto store_result = context.storage->store_file(file_uid, version, *stored, tenant);
+            if (store_result.success) {
+                SERVER_LOG_DEBUG("FileSystem::fetch_stored_blob", "File successfully restored to local storage at: " + store_result.value);
+            } else {
+                SERVER_LOG_WARN("FileSystem::fetch_stored_blob", "Failed to store file locally: " + store_result.error + " (continuing with S3 data)");
+            }
+        } else {
+            SERVER_LOG_WARN("FileSystem::fetch_stored_blob", "No storage context available for local storage (continuing with S3 data)");
+        }
+        return Result<SharedBlob>::ok(std::move(stored));
+    });
 }
 
 TenantContext* FileSystem::get_tenant_context(const std::string& tenant) {
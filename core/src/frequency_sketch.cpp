@@ -0,0 +1,72 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "fileengine/frequency_sketch.h"
+#include <algorithm>
+#include <functional>
+
+namespace fileengine {
+
+namespace {
+constexpr uint64_t kSeeds[4] = {
+    0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull, 0xd6e8feb86659fd93ull,
+};
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expected_entries) {
+    width_ = 1024;
+    while (width_ < expected_entries) width_ *= 2;
+    table_.assign(width_ * kDepth, 0);
+    sample_size_ = width_ * 10;
+}
+
+size_t FrequencySketch::index_of(uint64_t hash, int row) const {
+    // One string hash per key; each row remixes it with its own seed
+    uint64_t h = (hash + kSeeds[row]) * kSeeds[(row + 1) % kDepth];
+    h ^= h >> 31;
+    return static_cast<size_t>(row) * width_ + (h & (width_ - 1));
+}
+
+void FrequencySketch::increment(const std::string& key) {
+    const uint64_t hash = std::hash<std::string>{}(key);
+    bool added = false;
+    for (int row = 0; row < kDepth; ++row) {
+        uint8_t& counter = table_[index_of(hash, row)];
+        if (counter < kMaxCount) {
+            ++counter;
+            added = true;
+        }
+    }
+    if (added && ++additions_ >= sample_size_) {
+        age();
+    }
+}
+
+uint32_t FrequencySketch::estimate(const std::string& key) const {
+    const uint64_t hash = std::hash<std::string>{}(key);
+    uint8_t count = kMaxCount;
+    for (int row = 0; row < kDepth; ++row) {
+        count = std::min(count, table_[index_of(hash, row)]);
+    }
+    return count;
+}
+
+void FrequencySketch::age() {
+    for (auto& counter : table_) counter >>= 1;
+    additions_ /= 2;
+}
+
+} // namespace fileengine
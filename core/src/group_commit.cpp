@@ -0,0 +1,103 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/group_commit.h"
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <unistd.h>
+
+namespace fileengine {
+
+namespace {
+// Failed batches kept for waiters that have not yet observed their result.
+constexpr size_t kMaxFailedBatches = 64;
+} // namespace
+
+GroupCommit::GroupCommit(const std::string& path)
+    : fd_(::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)), path_(path) {
+}
+
+std::shared_ptr<GroupCommit> GroupCommit::for_filesystem(const std::string& path) {
+    static std::mutex registry_mutex;
+    static std::map<dev_t, std::weak_ptr<GroupCommit>> registry;
+
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return std::make_shared<GroupCommit>(path);  // commit() reports the error
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (auto existing = registry[st.st_dev].lock()) {
+        return existing;
+    }
+    auto instance = std::make_shared<GroupCommit>(path);
+    registry[st.st_dev] = instance;
+    return instance;
+}
+
+GroupCommit::~GroupCommit() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+Result<void> GroupCommit::commit() {
+    if (fd_ < 0) {
+        return Result<void>::err("Cannot sync storage filesystem: failed to open " + path_);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Our writes are complete; any sync that starts from here on covers them.
+    const uint64_t ticket = ++next_ticket_;
+
+    while (completed_ticket_ < ticket) {
+        if (syncing_) {
+            cv_.wait(lock);
+            continue;
+        }
+        // Lead a batch covering every ticket handed out so far.
+        syncing_ = true;
+        const uint64_t first = completed_ticket_ + 1;
+        const uint64_t last = next_ticket_;
+        lock.unlock();
+        int rc = ::syncfs(fd_);
+        int err = errno;
+        lock.lock();
+        syncing_ = false;
+        ++sync_count_;
+        if (rc != 0) {
+            if (failed_batches_.size() >= kMaxFailedBatches) {
+                failed_batches_.erase(failed_batches_.begin());
+            }
+            failed_batches_.push_back({first, last, std::strerror(err)});
+        }
+        completed_ticket_ = last;
+        cv_.notify_all();
+    }
+
+    for (const auto& failed : failed_batches_) {
+        if (ticket >= failed.first_ticket && ticket <= failed.last_ticket) {
+            return Result<void>::err("Failed to sync storage filesystem: " + failed.error);
+        }
+    }
+    return Result<void>::ok();
+}
+
+uint64_t GroupCommit::sync_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sync_count_;
+}
+
+} // namespace fileengine
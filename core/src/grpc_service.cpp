@@ -17,6 +17,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <optional>
 #include <google/protobuf/empty.pb.h>
 #include <chrono>
 #include <ctime>
@@ -36,6 +38,50 @@ inline std::string canonical_uid(const std::string& uid) {
     static const std::string kZeroUuid = "00000000-0000-0000-0000-000000000000";
     return uid == kZeroUuid ? std::string() : uid;
 }
+
+// Paged ListDirectory: page size when the client sends only a token, and the
+// cap on what a client may ask for. StreamListDirectory reads kStreamListBatch
+// entries per round trip when the request leaves page_size unset.
+constexpr int32_t kDefaultListPageSize = 1000;
+constexpr int32_t kMaxListPageSize = 5000;
+constexpr int32_t kStreamListBatch = 500;
+
+size_t list_page_limit(int32_t requested, int32_t fallback) {
+    if (requested <= 0) return static_cast<size_t>(fallback);
+    return static_cast<size_t>(std::min(requested, kMaxListPageSize));
+}
+
+void fill_directory_entry(fileengine_rpc::DirectoryEntry* dir_entry, const DirectoryEntry& entry) {
+    dir_entry->set_uid(entry.uid);
+    dir_entry->set_name(entry.name);
+    // Convert internal file type to gRPC file type
+    fileengine_rpc::FileType grpc_file_type;
+    switch (entry.type) {
+        case fileengine::FileType::REGULAR_FILE:
+            grpc_file_type = fileengine_rpc::FileType::REGULAR_FILE;
+            break;
+        case fileengine::FileType::DIRECTORY:
+            grpc_file_type = fileengine_rpc::FileType::DIRECTORY;
+            break;
+        case fileengine::FileType::SYMLINK:
+            grpc_file_type = fileengine_rpc::FileType::SYMLINK;
+            break;
+        default:
+            grpc_file_type = fileengine_rpc::FileType::REGULAR_FILE; // default
+            break;
+    }
+    dir_entry->set_type(grpc_file_type);
+    dir_entry->set_size(entry.size);
+    // Internal DirectoryEntry already has int64_t values, so assign directly
+    dir_entry->set_created_at(entry.created_at);
+    dir_entry->set_modified_at(entry.modified_at);
+    dir_entry->set_version_count(entry.version_count);
+    dir_entry->set_rendition_count(entry.rendition_count);
+    dir_entry->set_deleted(entry.deleted);
+    dir_entry->set_owner(entry.owner);
+    dir_entry->set_created_by(entry.created_by);
+    dir_entry->set_modified_by(entry.modified_by);
+}
 } // namespace
 
 GRPCFileService::GRPCFileService(std::shared_ptr<FileSystem> filesystem,
@@ -329,6 +375,11 @@ grpc::Status GRPCFileService::ListDirectory(grpc::ServerContext* context,
     std::string user = get_user_from_auth_context(auth_context);
     std::vector<std::string> roles = get_roles_from_auth_context(auth_context);
 
+    // The directory check and the per-entry checks below share one role
+    // lookup and one read of each ACL.
+    std::optional<AclManager::CacheScope> cache_scope;
+    if (acl_manager_) cache_scope.emplace(*acl_manager_);
+
     // Check read permissions on the directory
     if (!validate_user_permissions(dir_uid, auth_context, static_cast<int>(Permission::READ))) { // READ permission
         response->set_success(false);
@@ -338,13 +389,35 @@ grpc::Status GRPCFileService::ListDirectory(grpc::ServerContext* context,
         return grpc::Status::OK;
     }
 
-    auto result = filesystem_->listdir(dir_uid, user, roles, tenant);
+    // A page size or token selects keyset paging; neither keeps the legacy
+    // whole-directory response.
+    const bool paged = request->page_size() > 0 || !request->page_token().empty();
+    std::string after_name, after_uid;
+    if (!request->page_token().empty() &&
+        !FileSystem::decode_page_token(request->page_token(), dir_uid, after_name, after_uid)) {
+        response->set_success(false);
+        response->set_error("Invalid page token");
+        SERVER_LOG_ERROR("GRPCService", "ListDirectory failed for uid: " + dir_uid + ": invalid page token");
+        emit_access_audit(tenant, "list", AuditOutcome::Error, user, roles, dir_uid, AuditTargetType::Dir);
+        return grpc::Status::OK;
+    }
+    const size_t limit = list_page_limit(request->page_size(), kDefaultListPageSize);
+
+    auto result = paged
+        ? filesystem_->listdir_page(dir_uid, after_name, after_uid, limit, user, roles, tenant)
+        : filesystem_->listdir(dir_uid, user, roles, tenant);
 
     response->set_success(result.success);
     if (!result.success) {
         response->set_error(result.error);
         SERVER_LOG_ERROR("GRPCService", "ListDirectory failed for uid: " + dir_uid + " with error: " + result.error);
     } else {
+        // The cursor is the last row read, not the last one returned, so a
+        // page whose tail the caller cannot see still advances.
+        if (paged && result.value.size() == limit) {
+            const auto& last = result.value.back();
+            response->set_next_page_token(FileSystem::encode_page_token(dir_uid, last.name, last.uid));
+        }
         for (const auto& entry : result.value) {
             // Hide entries the caller cannot read (e.g. private home folders), so a
             // listing only shows what the user may actually access. system_admin
@@ -352,36 +425,7 @@ grpc::Status GRPCFileService::ListDirectory(grpc::ServerContext* context,
             if (!validate_user_permissions(entry.uid, auth_context, static_cast<int>(Permission::READ))) {
                 continue;
             }
-            auto* dir_entry = response->add_entries();
-            dir_entry->set_uid(entry.uid);
-            dir_entry->set_name(entry.name);
-            // Convert internal file type to gRPC file type
-            fileengine_rpc::FileType grpc_file_type;
-            switch (entry.type) {
-                case fileengine::FileType::REGULAR_FILE:
-                    grpc_file_type = fileengine_rpc::FileType::REGULAR_FILE;
-                    break;
-                case fileengine::FileType::DIRECTORY:
-                    grpc_file_type = fileengine_rpc::FileType::DIRECTORY;
-                    break;
-                case fileengine::FileType::SYMLINK:
-                    grpc_file_type = fileengine_rpc::FileType::SYMLINK;
-                    break;
-                default:
-                    grpc_file_type = fileengine_rpc::FileType::REGULAR_FILE; // default
-                    break;
-            }
-            dir_entry->set_type(grpc_file_type);
-            dir_entry->set_size(entry.size);
-            // Internal DirectoryEntry already has int64_t values, so assign directly
-            dir_entry->set_created_at(entry.created_at);
-            dir_entry->set_modified_at(entry.modified_at);
-            dir_entry->set_version_count(entry.version_count);
-            dir_entry->set_rendition_count(entry.rendition_count);
-            dir_entry->set_deleted(entry.deleted);
-            dir_entry->set_owner(entry.owner);
-            dir_entry->set_created_by(entry.created_by);
-            dir_entry->set_modified_by(entry.modified_by);
+            fill_directory_entry(response->add_entries(), entry);
         }
         SERVER_LOG_INFO("GRPCService", "ListDirectory successful for uid: " + dir_uid);
     }
@@ -403,6 +447,11 @@ grpc::Status GRPCFileService::ListDirectoryWithDeleted(grpc::ServerContext* cont
     std::string user = get_user_from_auth_context(auth_context);
     std::vector<std::string> roles = get_roles_from_auth_context(auth_context);
 
+    // The directory check and the per-entry checks below share one role
+    // lookup and one read of each ACL.
+    std::optional<AclManager::CacheScope> cache_scope;
+    if (acl_manager_) cache_scope.emplace(*acl_manager_);
+
     // Check read permissions on the directory
     if (!validate_user_permissions(dir_uid, auth_context, static_cast<int>(Permission::READ))) { // READ permission
         response->set_success(false);
@@ -424,36 +473,7 @@ grpc::Status GRPCFileService::ListDirectoryWithDeleted(grpc::ServerContext* cont
             if (!validate_user_permissions(entry.uid, auth_context, static_cast<int>(Permission::READ))) {
                 continue;
             }
-            auto* dir_entry = response->add_entries();
-            dir_entry->set_uid(entry.uid);
-            dir_entry->set_name(entry.name);
-            // Convert internal file type to gRPC file type
-            fileengine_rpc::FileType grpc_file_type;
-            switch (entry.type) {
-                case fileengine::FileType::REGULAR_FILE:
-                    grpc_file_type = fileengine_rpc::FileType::REGULAR_FILE;
-                    break;
-                case fileengine::FileType::DIRECTORY:
-                    grpc_file_type = fileengine_rpc::FileType::DIRECTORY;
-                    break;
-                case fileengine::FileType::SYMLINK:
-                    grpc_file_type = fileengine_rpc::FileType::SYMLINK;
-                    break;
-                default:
-                    grpc_file_type = fileengine_rpc::FileType::REGULAR_FILE; // default
-                    break;
-            }
-            dir_entry->set_type(grpc_file_type);
-            dir_entry->set_size(entry.size);
-            // Internal DirectoryEntry already has int64_t values, so assign directly
-            dir_entry->set_created_at(entry.created_at);
-            dir_entry->set_modified_at(entry.modified_at);
-            dir_entry->set_version_count(entry.version_count);
-            dir_entry->set_rendition_count(entry.rendition_count);
-            dir_entry->set_deleted(entry.deleted);
-            dir_entry->set_owner(entry.owner);
-            dir_entry->set_created_by(entry.created_by);
-            dir_entry->set_modified_by(entry.modified_by);
+            fill_directory_entry(response->add_entries(), entry);
         }
         SERVER_LOG_INFO("GRPCService", "ListDirectoryWithDeleted successful for uid: " + dir_uid);
     }
@@ -739,11 +759,37 @@ grpc::Status GRPCFileService::GetFile(grpc::ServerContext* context,
         return grpc::Status::OK;
     }
 
-    auto result = filesystem_->get(file_uid, user, roles, tenant);
+    // Ranged read: only the bytes (frames, for encoded blobs) covering
+    // [offset, offset + length) are read, locally or from the object store.
+    if (request->offset() != 0 || request->length() != 0) {
+        std::string* data = response->mutable_data();
+        auto range_result = filesystem_->get_range_stream(
+            file_uid, request->offset(), request->length(),
+            [data](const uint8_t* p, size_t n) { data->append(reinterpret_cast<const char*>(p), n); return true; },
+            user, roles, tenant);
+
+        response->set_success(range_result.success);
+        if (range_result.success) {
+            response->set_file_size(range_result.value);
+            response->set_error("");
+            SERVER_LOG_INFO("GRPCService", "GetFile range successful for uid: " + file_uid);
+        } else {
+            response->clear_data();
+            response->set_error(range_result.error);
+            SERVER_LOG_ERROR("GRPCService", "GetFile range failed for uid: " + file_uid + " with error: " + range_result.error);
+        }
+
+        emit_access_audit(tenant, "read", range_result.success ? AuditOutcome::Ok : AuditOutcome::Error,
+                          user, roles, file_uid, AuditTargetType::File);
+        return grpc::Status::OK;
+    }
+
+    auto result = filesystem_->get_shared(file_uid, user, roles, tenant);
 
     response->set_success(result.success);
     if (result.success) {
-        response->set_data(std::string(result.value.begin(), result.value.end()));
+        // The one copy on this path: protobuf owns its bytes field
+        response->set_data(reinterpret_cast<const char*>(result.value->data()), result.value->size());
         response->set_error("");
         SERVER_LOG_INFO("GRPCService", "GetFile successful for uid: " + file_uid);
     } else {
@@ -1052,11 +1098,11 @@ grpc::Status GRPCFileService::GetVersion(grpc::ServerContext* context,
         return grpc::Status::OK;
     }
 
-    auto result = filesystem_->get_version(file_uid, version_timestamp, user, roles, tenant);
+    auto result = filesystem_->get_version_shared(file_uid, version_timestamp, user, roles, tenant);
 
     response->set_success(result.success);
     if (result.success) {
-        response->set_data(std::string(result.value.begin(), result.value.end()));
+        response->set_data(reinterpret_cast<const char*>(result.value->data()), result.value->size());
         SERVER_LOG_INFO("GRPCService", "GetVersion successful for uid: " + file_uid);
     } else {
         response->set_error(result.error);
@@ -1842,15 +1888,30 @@ grpc::Status GRPCFileService::StreamFileDownload(grpc::ServerContext* context,
     // file is never assembled in memory (get_stream re-validates READ access and
     // handles decrypt/decompress + S3 restore). Each chunk is written as it is
     // produced; a Write() failure (client disconnect) aborts early.
-    auto result = filesystem_->get_stream(
-        file_uid,
-        [&](const uint8_t* p, size_t n) -> bool {
+    auto write_chunk = [&](const uint8_t* p, size_t n) -> bool {
+        fileengine_rpc::GetFileResponse response;
+        response.set_success(true);
+        response.set_data(std::string(reinterpret_cast<const char*>(p), n));
+        return writer->Write(response);
+    };
+
+    Result<void> result = Result<void>::ok();
+    if (request->offset() != 0 || request->length() != 0) {
+        // Ranged download: reads only what the range needs (no S3 restore for
+        // cold files) and ends with an empty frame carrying the full file size.
+        auto range_result = filesystem_->get_range_stream(file_uid, request->offset(), request->length(),
+                                                          write_chunk, user, roles, tenant);
+        if (range_result.success) {
             fileengine_rpc::GetFileResponse response;
             response.set_success(true);
-            response.set_data(std::string(reinterpret_cast<const char*>(p), n));
-            return writer->Write(response);
-        },
-        user, roles, tenant);
+            response.set_file_size(range_result.value);
+            writer->Write(response);
+        } else {
+            result = Result<void>::err(range_result.error);
+        }
+    } else {
+        result = filesystem_->get_stream(file_uid, write_chunk, user, roles, tenant);
+    }
 
     if (result.success) {
         SERVER_LOG_INFO("GRPCService", "StreamFileDownload successful for uid: " + file_uid);
@@ -1870,6 +1931,104 @@ grpc::Status GRPCFileService::StreamFileDownload(grpc::ServerContext* context,
     return grpc::Status::OK;
 }
 
+grpc::Status GRPCFileService::StreamListDirectory(grpc::ServerContext* context,
+                                                 const fileengine_rpc::ListDirectoryRequest* request,
+                                                 grpc::ServerWriter<fileengine_rpc::ListDirectoryResponse>* writer) {
+    SERVER_LOG_DEBUG("GRPCService", "StreamListDirectory called for uid: " + request->uid());
+    std::string dir_uid = canonical_uid(request->uid());
+    auto auth_context = request->auth();
+
+    std::string tenant = get_tenant_from_auth_context(auth_context);
+    std::string user = get_user_from_auth_context(auth_context);
+    std::vector<std::string> roles = get_roles_from_auth_context(auth_context);
+
+    auto write_error = [&](const std::string& error) {
+        fileengine_rpc::ListDirectoryResponse response;
+        response.set_success(false);
+        response.set_error(error);
+        writer->Write(response);
+    };
+
+    {
+        std::optional<AclManager::CacheScope> cache_scope;
+        if (acl_manager_) cache_scope.emplace(*acl_manager_);
+        if (!validate_user_permissions(dir_uid, auth_context, static_cast<int>(Permission::READ))) {
+            write_error("User does not have permission to list directory");
+            SERVER_LOG_ERROR("GRPCService", "StreamListDirectory failed: User " + user + " does not have permission to list directory " + dir_uid);
+            emit_access_audit(tenant, "list", AuditOutcome::Denied, user, roles, dir_uid, AuditTargetType::Dir);
+            return grpc::Status::OK;
+        }
+    }
+
+    std::string after_name, after_uid;
+    if (!request->page_token().empty() &&
+        !FileSystem::decode_page_token(request->page_token(), dir_uid, after_name, after_uid)) {
+        write_error("Invalid page token");
+        SERVER_LOG_ERROR("GRPCService", "StreamListDirectory failed for uid: " + dir_uid + ": invalid page token");
+        emit_access_audit(tenant, "list", AuditOutcome::Error, user, roles, dir_uid, AuditTargetType::Dir);
+        return grpc::Status::OK;
+    }
+    const size_t batch = list_page_limit(request->page_size(), kStreamListBatch);
+
+    // Each batch is its own keyset query and Write(), so the first entries
+    // reach the client after one batch is read, memory stays at one batch, and
+    // no pooled connection is held while a slow client drains the stream.
+    // Every frame carries the token to resume after it.
+    Result<void> result = Result<void>::ok();
+    while (true) {
+        if (context->IsCancelled()) {
+            result = Result<void>::err("Client cancelled");
+            break;
+        }
+
+        // Per batch: the batch's entry checks share role and ACL reads, and a
+        // long stream does not keep serving ACLs cached at its start.
+        std::optional<AclManager::CacheScope> cache_scope;
+        if (acl_manager_) cache_scope.emplace(*acl_manager_);
+
+        auto page = filesystem_->listdir_page(dir_uid, after_name, after_uid, batch, user, roles, tenant);
+        if (!page.success) {
+            result = Result<void>::err(page.error);
+            write_error(page.error);
+            break;
+        }
+
+        fileengine_rpc::ListDirectoryResponse response;
+        response.set_success(true);
+        for (const auto& entry : page.value) {
+            // Same visibility policy as ListDirectory.
+            if (!validate_user_permissions(entry.uid, auth_context, static_cast<int>(Permission::READ))) {
+                continue;
+            }
+            fill_directory_entry(response.add_entries(), entry);
+        }
+
+        const bool last_batch = page.value.size() < batch;
+        if (!last_batch) {
+            after_name = page.value.back().name;
+            after_uid = page.value.back().uid;
+            response.set_next_page_token(FileSystem::encode_page_token(dir_uid, after_name, after_uid));
+        }
+        // A batch the caller can see none of is skipped, but the final frame is
+        // always sent so an empty directory still yields one success frame.
+        if ((response.entries_size() > 0 || last_batch) && !writer->Write(response)) {
+            result = Result<void>::err("Client disconnected");
+            break;
+        }
+        if (last_batch) break;
+    }
+
+    if (result.success) {
+        SERVER_LOG_INFO("GRPCService", "StreamListDirectory successful for uid: " + dir_uid);
+    } else {
+        SERVER_LOG_ERROR("GRPCService", "StreamListDirectory failed for uid: " + dir_uid + " with error: " + result.error);
+    }
+
+    emit_access_audit(tenant, "list", result.success ? AuditOutcome::Ok : AuditOutcome::Error,
+                      user, roles, dir_uid, AuditTargetType::Dir);
+    return grpc::Status::OK;
+}
+
 // Administrative operations
 grpc::Status GRPCFileService::GetStorageUsage(grpc::ServerContext* context,
                                             const fileengine_rpc::StorageUsageRequest* request,
@@ -2025,7 +2184,7 @@ grpc::Status GRPCFileService::DeleteRole(grpc::ServerContext* context,
         return grpc::Status::OK;
     }
 
-    auto role_manager = std::make_shared<RoleManager>(tenant_context->db);
+    auto role_manager = std::make_shared<RoleManager>(tenant_context->db, acl_manager_->role_cache());
     auto result = role_manager->delete_role(request->role(), tenant);
 
     response->set_success(result.success);
@@ -2034,6 +2193,7 @@ grpc::Status GRPCFileService::DeleteRole(grpc::ServerContext* context,
         SERVER_LOG_ERROR("GRPCService", "DeleteRole failed for role: " + request->role() + " with error: " + result.error);
     } else {
         SERVER_LOG_INFO("GRPCService", "DeleteRole successful for role: " + request->role());
+        acl_manager_->invalidate_cached_permissions(tenant);
         // Data-governance event: deleting a role revokes its grants from all members.
         filesystem_->publish_role_change(tenant, FileEventType::RoleDeleted,
                                          request->role(), "", user);
@@ -2061,7 +2221,7 @@ grpc::Status GRPCFileService::AssignUserToRole(grpc::ServerContext* context,
         return grpc::Status::OK;
     }
 
-    auto role_manager = std::make_shared<RoleManager>(tenant_context->db);
+    auto role_manager = std::make_shared<RoleManager>(tenant_context->db, acl_manager_->role_cache());
     auto result = role_manager->assign_user_to_role(request->user(), request->role(), tenant);
 
     response->set_success(result.success);
@@ -2070,6 +2230,7 @@ grpc::Status GRPCFileService::AssignUserToRole(grpc::ServerContext* context,
         SERVER_LOG_ERROR("GRPCService", "AssignUserToRole failed for user: " + request->user() + " to role: " + request->role() + " with error: " + result.error);
     } else {
         SERVER_LOG_INFO("GRPCService", "AssignUserToRole successful for user: " + request->user() + " to role: " + request->role());
+        acl_manager_->invalidate_cached_permissions(tenant);
         // Data-governance event: role membership grants effective access.
         filesystem_->publish_role_change(tenant, FileEventType::RoleAssigned,
                                          request->role(), request->user(), user);
@@ -2097,7 +2258,7 @@ grpc::Status GRPCFileService::RemoveUserFromRole(grpc::ServerContext* context,
         return grpc::Status::OK;
     }
 
-    auto role_manager = std::make_shared<RoleManager>(tenant_context->db);
+    auto role_manager = std::make_shared<RoleManager>(tenant_context->db, acl_manager_->role_cache());
     auto result = role_manager->remove_user_from_role(request->user(), request->role(), tenant);
 
     response->set_success(result.success);
@@ -2106,6 +2267,7 @@ grpc::Status GRPCFileService::RemoveUserFromRole(grpc::ServerContext* context,
         SERVER_LOG_ERROR("GRPCService", "RemoveUserFromRole failed for user: " + request->user() + " from role: " + request->role() + " with error: " + result.error);
     } else {
         SERVER_LOG_INFO("GRPCService", "RemoveUserFromRole successful for user: " + request->user() + " from role: " + request->role());
+        acl_manager_->invalidate_cached_permissions(tenant);
         // Data-governance event: removing membership revokes effective access.
         filesystem_->publish_role_change(tenant, FileEventType::RoleMemberRemoved,
                                          request->role(), request->user(), user);
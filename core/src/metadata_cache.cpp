@@ -0,0 +1,257 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/metadata_cache.h"
+#include "fileengine/IDatabase.h"
+#include <algorithm>
+#include <functional>
+
+namespace fileengine {
+
+namespace {
+std::string make_key(const std::string& tenant, const std::string& uid) {
+    return tenant + '\0' + uid;
+}
+
+// Bounds the ancestor walk so a corrupt (cyclic) parent chain can't hang it
+constexpr int kMaxDepth = 4096;
+} // namespace
+
+MetadataCache::MetadataCache(size_t max_entries, std::chrono::milliseconds ttl, size_t shard_count,
+                             std::chrono::milliseconds negative_ttl)
+    : ttl_(ttl), negative_ttl_(ttl.count() > 0 ? std::min(ttl, negative_ttl) : negative_ttl),
+      max_entries_(max_entries) {
+    const size_t count = std::max<size_t>(1, std::min(shard_count, max_entries));
+    shards_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->max_entries = std::max<size_t>(1, max_entries / count);
+    }
+}
+
+MetadataCache::Shard& MetadataCache::shard_for(const std::string& key) {
+    size_t h = std::hash<std::string>{}(key);
+    h ^= h >> 32;
+    return *shards_[h % shards_.size()];
+}
+
+Result<std::optional<FileInfo>> MetadataCache::get_file_by_uid(IDatabase& db, const std::string& uid,
+                                                               const std::string& tenant) {
+    return fetch(db, uid, tenant, false);
+}
+
+Result<std::optional<FileInfo>> MetadataCache::get_file_by_uid_include_deleted(IDatabase& db, const std::string& uid,
+                                                                               const std::string& tenant) {
+    return fetch(db, uid, tenant, true);
+}
+
+Result<std::optional<FileInfo>> MetadataCache::fetch(IDatabase& db, const std::string& uid,
+                                                     const std::string& tenant, bool include_deleted) {
+    const std::string key = make_key(tenant, uid);
+    bool missing = false;
+    auto hit = lookup(tenant, key, missing);
+    if (missing) {
+        negative_hits_.fetch_add(1, std::memory_order_relaxed);
+        return Result<std::optional<FileInfo>>::ok(std::nullopt);
+    }
+    if (hit) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        if (hit->deleted && !include_deleted) {
+            return Result<std::optional<FileInfo>>::ok(std::nullopt);
+        }
+        return Result<std::optional<FileInfo>>::ok(std::move(hit));
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    // Taken before the query: if a row changes (and is invalidated) while
+    // the query runs, what it returned may predate the change
+    const uint64_t epoch = this->epoch(tenant);
+    auto result = db.get_file_by_uid_include_deleted(uid, tenant);
+    if (!result.success) {
+        return result;
+    }
+    if (!result.value.has_value()) {
+        if (negative_ttl_.count() > 0) {
+            insert(tenant, key, std::nullopt, epoch);
+        }
+        return result;
+    }
+    insert(tenant, key, result.value, epoch);
+    if (result.value->deleted && !include_deleted) {
+        return Result<std::optional<FileInfo>>::ok(std::nullopt);
+    }
+    return result;
+}
+
+bool MetadataCache::known_missing(const std::string& tenant, const std::string& uid) {
+    bool missing = false;
+    lookup(tenant, make_key(tenant, uid), missing);
+    if (missing) {
+        negative_hits_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return missing;
+}
+
+void MetadataCache::put_missing(const std::string& tenant, const std::string& uid, uint64_t epoch) {
+    if (negative_ttl_.count() > 0) {
+        insert(tenant, make_key(tenant, uid), std::nullopt, epoch);
+    }
+}
+
+uint64_t MetadataCache::epoch(const std::string& tenant) const {
+    return counters_for(tenant).epoch.load(std::memory_order_acquire);
+}
+
+MetadataCache::TenantCounters& MetadataCache::counters_for(const std::string& tenant) {
+    return counters_[std::hash<std::string>{}(tenant) % kTenantSlots];
+}
+
+const MetadataCache::TenantCounters& MetadataCache::counters_for(const std::string& tenant) const {
+    return counters_[std::hash<std::string>{}(tenant) % kTenantSlots];
+}
+
+std::optional<FileInfo> MetadataCache::lookup(const std::string& tenant, const std::string& key, bool& missing) {
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+        return std::nullopt;
+    }
+    Entry& entry = it->second;
+    if (entry.generation != counters_for(tenant).generation.load(std::memory_order_acquire) ||
+        std::chrono::steady_clock::now() >= entry.expires) {
+        shard.lru.erase(entry.lru_it);
+        shard.map.erase(it);
+        return std::nullopt;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_it);
+    if (entry.missing) {
+        missing = true;
+        return std::nullopt;
+    }
+    return entry.info;
+}
+
+void MetadataCache::insert(const std::string& tenant, const std::string& key, const std::optional<FileInfo>& info,
+                           uint64_t epoch) {
+    const auto now = std::chrono::steady_clock::now();
+    const auto expires = !info ? now + negative_ttl_
+                               : ttl_.count() > 0 ? now + ttl_ : std::chrono::steady_clock::time_point::max();
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // invalidate() bumps the tenant's epoch before it erases, and erases
+    // under this lock, so a fill that sees an unchanged epoch cannot be stale
+    const TenantCounters& counters = counters_for(tenant);
+    if (counters.epoch.load(std::memory_order_acquire) != epoch) {
+        return;
+    }
+    const uint64_t generation = counters.generation.load(std::memory_order_acquire);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        it->second.info = info.value_or(FileInfo{});
+        it->second.missing = !info;
+        it->second.generation = generation;
+        it->second.expires = expires;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+        return;
+    }
+    while (shard.map.size() >= shard.max_entries && !shard.lru.empty()) {
+        shard.map.erase(shard.lru.back());
+        shard.lru.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard.lru.push_front(key);
+    shard.map.emplace(key, Entry{info.value_or(FileInfo{}), !info, generation, expires, shard.lru.begin()});
+}
+
+bool MetadataCache::erase(const std::string& key, std::string& parent_out) {
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+        return false;
+    }
+    const bool had_row = !it->second.missing;
+    parent_out = it->second.info.parent_uid;
+    shard.lru.erase(it->second.lru_it);
+    shard.map.erase(it);
+    return had_row;
+}
+
+bool MetadataCache::erase_chain(const std::string& tenant, std::string uid) {
+    for (int depth = 0; depth < kMaxDepth; ++depth) {
+        std::string parent;
+        if (!erase(make_key(tenant, uid), parent)) {
+            // The root (empty uid) has nothing above it; any other missing
+            // link hides whatever is cached further up
+            return uid.empty();
+        }
+        if (uid.empty()) {
+            return true;  // the root is its own parent
+        }
+        uid = std::move(parent);
+    }
+    return false;
+}
+
+void MetadataCache::invalidate(const std::string& tenant, const std::string& uid,
+                               const std::optional<std::string>& parent_uid) {
+    TenantCounters& counters = counters_for(tenant);
+    counters.epoch.fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+
+    std::string cached_parent;
+    const bool cached = erase(make_key(tenant, uid), cached_parent);
+    if (uid.empty()) {
+        return;  // the root has no ancestors
+    }
+    // Without a cached row or a caller-supplied parent the ancestors are unknown
+    bool complete = cached || parent_uid.has_value();
+    if (cached) {
+        complete = erase_chain(tenant, cached_parent) && complete;
+    }
+    if (parent_uid && !(cached && *parent_uid == cached_parent)) {
+        complete = erase_chain(tenant, *parent_uid) && complete;
+    }
+    if (!complete) {
+        // Some cached ancestor may be out of date: retire the tenant's entries
+        counters.generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+void MetadataCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->map.clear();
+        shard->lru.clear();
+    }
+}
+
+MetadataCacheStats MetadataCache::get_stats() const {
+    MetadataCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.negative_hits = negative_hits_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.max_entries = max_entries_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->map.size();
+    }
+    return stats;
+}
+
+} // namespace fileengine
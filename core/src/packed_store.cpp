@@ -0,0 +1,682 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "fileengine/packed_store.h"
+#include "fileengine/group_commit.h"
+#include "fileengine/server_logger.h"
+#include <zlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace fileengine {
+
+namespace {
+
+constexpr uint8_t kRecordMagic[4] = {'F', 'E', 'P', 'K'};
+constexpr uint8_t kFlagDead = 0x01;
+constexpr size_t kRecordHeaderSize = 24;
+constexpr size_t kFlagsOffset = 4;
+constexpr size_t kMaxKeyLen = 0xffff;
+constexpr const char* kSegmentSuffix = ".seg";
+// Window used to scan segment headers on open
+constexpr size_t kScanWindow = 1024 * 1024;
+
+void put_u16(uint8_t* p, uint16_t v) {
+    for (int i = 0; i < 2; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+void put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+void put_u64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+uint16_t get_u16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+uint32_t get_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+uint64_t get_u64(const uint8_t* p) {
+    return static_cast<uint64_t>(get_u32(p)) | static_cast<uint64_t>(get_u32(p + 4)) << 32;
+}
+
+Result<void> pwrite_all(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return Result<void>::err(std::strerror(errno));
+        }
+        done += static_cast<size_t>(n);
+    }
+    return Result<void>::ok();
+}
+
+// Fewer than `size` bytes only at end of file
+ssize_t pread_all(int fd, uint8_t* data, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+std::string segment_name(uint64_t id) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s", static_cast<unsigned long long>(id), kSegmentSuffix);
+    return name;
+}
+
+} // namespace
+
+struct PackedStore::Segment {
+    uint64_t id = 0;
+    std::string path;
+    int fd = -1;
+    uint64_t size = 0;        // bytes of valid records (append offset)
+    uint64_t dead_bytes = 0;  // bytes of dead records
+    bool damaged = false;     // unreadable bytes kept on disk; never compacted
+    bool flags_dirty = false; // dead flags written since the last flush
+    ~Segment() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+namespace {
+uint64_t record_size(uint32_t key_len, uint32_t data_len) {
+    return kRecordHeaderSize + key_len + data_len;
+}
+} // namespace
+
+Result<std::shared_ptr<PackedStore>> PackedStore::open(const std::string& dir, const PackedStoreOptions& options,
+                                                        StorageSyncMode sync_mode) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::weak_ptr<PackedStore>> registry;
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return Result<std::shared_ptr<PackedStore>>::err("Failed to create pack directory " + dir + ": " + ec.message());
+    }
+    std::string key = std::filesystem::weakly_canonical(dir, ec).string();
+    if (ec) key = dir;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (auto existing = registry[key].lock()) {
+        return Result<std::shared_ptr<PackedStore>>::ok(existing);
+    }
+
+    std::shared_ptr<PackedStore> store(new PackedStore(dir, options, sync_mode));
+    auto load_result = store->load();
+    if (!load_result.success) {
+        return Result<std::shared_ptr<PackedStore>>::err(load_result.error);
+    }
+    if (options.compact_interval_seconds > 0) {
+        store->compactor_ = std::thread(&PackedStore::compactor_loop, store.get());
+    }
+    registry[key] = store;
+    return Result<std::shared_ptr<PackedStore>>::ok(store);
+}
+
+PackedStore::PackedStore(const std::string& dir, const PackedStoreOptions& options, StorageSyncMode sync_mode)
+    : dir_(dir), options_(options), sync_mode_(sync_mode) {
+    // A blob must fit in a segment, and record lengths are 32-bit.
+    options_.threshold = std::min<uint64_t>({options_.threshold, options_.segment_size, UINT32_MAX});
+    if (sync_mode_ == StorageSyncMode::Group) {
+        group_commit_ = GroupCommit::for_filesystem(dir_);
+    }
+}
+
+PackedStore::~PackedStore() {
+    {
+        std::lock_guard<std::mutex> lock(compactor_mutex_);
+        stopping_ = true;
+    }
+    compactor_cv_.notify_all();
+    if (compactor_.joinable()) compactor_.join();
+}
+
+Result<void> PackedStore::load() {
+    std::map<uint64_t, std::string> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        const auto& p = entry.path();
+        if (!entry.is_regular_file() || p.extension() != kSegmentSuffix) continue;
+        try {
+            files[std::stoull(p.stem().string(), nullptr, 16)] = p.string();
+        } catch (...) {
+            // not one of ours
+        }
+    }
+    if (ec) {
+        return Result<void>::err("Failed to list pack directory " + dir_ + ": " + ec.message());
+    }
+
+    std::vector<uint8_t> window(kScanWindow);
+    std::vector<uint8_t> body;  // records that do not fit in the window
+    const uint64_t newest = files.empty() ? 0 : files.rbegin()->first;
+    std::unordered_map<std::string, uint64_t> tombstones;  // key -> highest dead seq
+    for (const auto& [id, path] : files) {
+        auto segment = std::make_shared<Segment>();
+        segment->id = id;
+        segment->path = path;
+        segment->fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        struct stat st;
+        if (segment->fd < 0 || ::fstat(segment->fd, &st) != 0) {
+            return Result<void>::err("Failed to open pack segment " + path + ": " + std::strerror(errno));
+        }
+        const uint64_t file_size = static_cast<uint64_t>(st.st_size);
+
+        // Walk the records. Only the newest segment can end in a write torn
+        // by a crash (never acknowledged; a segment is flushed before the
+        // next one starts), so there the first record that is not intact,
+        // by header or CRC, ends the segment and is trimmed. Sealed segments
+        // hold only acknowledged records: a record failing its CRC is skipped
+        // by its header length, and bytes that do not parse are left on disk
+        // and the segment kept out of compaction.
+        uint64_t window_start = 0;
+        size_t window_len = 0;
+        uint64_t offset = 0;
+        while (offset + kRecordHeaderSize <= file_size) {
+            const uint64_t window_end = window_start + window_len;
+            if (offset + kRecordHeaderSize + kMaxKeyLen > window_end && window_end < file_size) {
+                ssize_t n = pread_all(segment->fd, window.data(), window.size(), offset);
+                if (n < 0) {
+                    return Result<void>::err("Failed to read pack segment " + path + ": " + std::strerror(errno));
+                }
+                window_start = offset;
+                window_len = static_cast<size_t>(n);
+            }
+            const uint8_t* h = window.data() + (offset - window_start);
+            if (std::memcmp(h, kRecordMagic, 4) != 0) break;
+            const uint8_t flags = h[kFlagsOffset];
+            const uint32_t key_len = get_u16(h + 6);
+            const uint32_t data_len = get_u32(h + 8);
+            const uint64_t seq = get_u64(h + 12);
+            const uint64_t rec_size = record_size(key_len, data_len);
+            if (offset + rec_size > file_size || offset + kRecordHeaderSize + key_len > window_start + window_len) break;
+
+            const size_t body_len = key_len + data_len;
+            uLong crc;
+            if (offset + rec_size <= window_start + window_len) {
+                crc = crc32(0L, h + kRecordHeaderSize, static_cast<uInt>(body_len));
+            } else {
+                body.resize(body_len);
+                if (pread_all(segment->fd, body.data(), body_len, offset + kRecordHeaderSize) !=
+                    static_cast<ssize_t>(body_len)) {
+                    break;
+                }
+                crc = crc32(0L, body.data(), static_cast<uInt>(body_len));
+            }
+            if (static_cast<uint32_t>(crc) != get_u32(h + 20)) {
+                if (id == newest) {
+                    SERVER_LOG_WARN("PackedStore", "Dropping pack segment " + path + " from offset " +
+                                    std::to_string(offset) + ": record fails its CRC");
+                    break;
+                }
+                SERVER_LOG_ERROR("PackedStore", "Skipping corrupt record at offset " + std::to_string(offset) +
+                                 " of sealed pack segment " + path + ": record fails its CRC");
+                segment->dead_bytes += rec_size;
+                offset += rec_size;
+                continue;
+            }
+
+            Location loc{segment, offset, key_len, data_len, seq};
+            next_seq_ = std::max(next_seq_, seq + 1);
+            std::string key(reinterpret_cast<const char*>(h + kRecordHeaderSize), key_len);
+            if (flags & kFlagDead) {
+                segment->dead_bytes += rec_size;
+                uint64_t& dead_seq = tombstones[key];
+                dead_seq = std::max(dead_seq, seq);
+            } else {
+                auto it = index_.find(key);
+                if (it == index_.end()) {
+                    index_.emplace(std::move(key), loc);
+                } else if (it->second.seq < seq) {
+                    // In memory only: seq settles it again on every open, and
+                    // the newer copy may not be durable yet.
+                    mark_dead_locked(it->second, false);
+                    it->second = loc;
+                } else {
+                    mark_dead_locked(loc, false);
+                }
+            }
+            offset += rec_size;
+        }
+        if (offset < file_size && id != newest) {
+            SERVER_LOG_ERROR("PackedStore", "Sealed pack segment " + path + " is unreadable from offset " +
+                             std::to_string(offset) + "; keeping its " + std::to_string(file_size - offset) +
+                             " remaining bytes and excluding it from compaction");
+            segment->damaged = true;
+            offset = file_size;
+        } else if (offset < file_size && ::ftruncate(segment->fd, static_cast<off_t>(offset)) != 0) {
+            return Result<void>::err("Failed to trim pack segment " + path + ": " + std::strerror(errno));
+        }
+        segment->size = offset;
+        segments_[id] = segment;
+        next_segment_id_ = id + 1;
+    }
+
+    // A dead record also retires every older copy of its key, whose own flag
+    // may have been lost: otherwise a deleted blob would come back. Persist
+    // the flag, so the copy stays dead once the dead record is compacted away.
+    for (auto it = index_.begin(); it != index_.end();) {
+        auto dead = tombstones.find(it->first);
+        if (dead != tombstones.end() && dead->second > it->second.seq) {
+            mark_dead_locked(it->second, true);
+            it = index_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Keep appending to the newest segment while it has room.
+    if (!segments_.empty() && segments_.rbegin()->second->size < options_.segment_size) {
+        active_ = segments_.rbegin()->second;
+    }
+    return Result<void>::ok();
+}
+
+Result<std::shared_ptr<PackedStore::Segment>> PackedStore::start_segment_locked() {
+    // Seal the current segment first: load() trusts every segment but the
+    // newest to hold no torn writes.
+    if (active_) {
+        auto flush_result = flush(active_->fd);
+        if (!flush_result.success) {
+            return Result<std::shared_ptr<Segment>>::err(flush_result.error);
+        }
+    }
+    auto segment = std::make_shared<Segment>();
+    segment->id = next_segment_id_++;
+    segment->path = dir_ + "/" + segment_name(segment->id);
+    segment->fd = ::open(segment->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (segment->fd < 0) {
+        return Result<std::shared_ptr<Segment>>::err("Failed to create pack segment " + segment->path + ": " +
+                                                     std::strerror(errno));
+    }
+    auto sync_result = sync_dir();
+    if (!sync_result.success) {
+        return Result<std::shared_ptr<Segment>>::err(sync_result.error);
+    }
+    segments_[segment->id] = segment;
+    return Result<std::shared_ptr<Segment>>::ok(segment);
+}
+
+Result<std::optional<PackedStore::Location>> PackedStore::append_locked(const std::string& key, const uint8_t* data,
+                                                                       size_t size) {
+    using R = Result<std::optional<Location>>;
+    if (key.size() > kMaxKeyLen) {
+        return R::err("Pack key too long: " + key);
+    }
+    if (size > UINT32_MAX) {
+        return R::err("Blob too large to pack: " + key);
+    }
+    if (!active_ || active_->size >= options_.segment_size) {
+        auto segment_result = start_segment_locked();
+        if (!segment_result.success) {
+            return R::err(segment_result.error);
+        }
+        active_ = segment_result.value;
+    }
+
+    const uint32_t key_len = static_cast<uint32_t>(key.size());
+    const uint32_t data_len = static_cast<uint32_t>(size);
+    std::vector<uint8_t> record(record_size(key_len, data_len));
+    std::memcpy(record.data(), kRecordMagic, 4);
+    put_u16(record.data() + 6, static_cast<uint16_t>(key_len));
+    put_u32(record.data() + 8, data_len);
+    put_u64(record.data() + 12, next_seq_);
+    std::memcpy(record.data() + kRecordHeaderSize, key.data(), key_len);
+    if (size > 0) std::memcpy(record.data() + kRecordHeaderSize + key_len, data, size);
+    uLong crc = crc32(0L, record.data() + kRecordHeaderSize, static_cast<uInt>(key_len + data_len));
+    put_u32(record.data() + 20, static_cast<uint32_t>(crc));
+
+    auto write_result = pwrite_all(active_->fd, record.data(), record.size(), active_->size);
+    if (!write_result.success) {
+        // Drop the partial record so the next append starts on a boundary.
+        if (::ftruncate(active_->fd, static_cast<off_t>(active_->size)) != 0) {
+            active_.reset();
+        }
+        return R::err("Failed to append to pack segment " + dir_ + ": " + write_result.error);
+    }
+
+    Location loc{active_, active_->size, key_len, data_len, next_seq_++};
+    active_->size += record.size();
+
+    std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        index_.emplace(key, loc);
+        return R::ok(std::nullopt);
+    }
+    Location previous = it->second;
+    it->second = loc;
+    return R::ok(previous);
+}
+
+void PackedStore::mark_dead_locked(const Location& loc, bool persist) {
+    // Not flushed here. A superseded record is also retired by seq on open;
+    // remove() flushes its flags before returning, and compact() flushes all
+    // pending flags before unlinking a segment whose dead records could be
+    // all that retires an older copy.
+    if (persist) {
+        const uint8_t flags = kFlagDead;
+        pwrite_all(loc.segment->fd, &flags, 1, loc.offset + kFlagsOffset);
+        loc.segment->flags_dirty = true;
+    }
+    loc.segment->dead_bytes += record_size(loc.key_len, loc.data_len);
+}
+
+Result<void> PackedStore::flush_dead_flags() {
+    std::vector<std::shared_ptr<Segment>> dirty;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        for (const auto& [id, segment] : segments_) {
+            if (!segment->flags_dirty) continue;
+            segment->flags_dirty = false;
+            dirty.push_back(segment);
+        }
+    }
+    for (size_t i = 0; i < dirty.size(); ++i) {
+        auto flush_result = flush(dirty[i]->fd);
+        if (!flush_result.success) {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            for (size_t j = i; j < dirty.size(); ++j) dirty[j]->flags_dirty = true;
+            return flush_result;
+        }
+        if (sync_mode_ == StorageSyncMode::Group) break;  // one syncfs covers them all
+    }
+    return Result<void>::ok();
+}
+
+Result<void> PackedStore::put(const std::string& key, const uint8_t* data, size_t size) {
+    std::shared_ptr<Segment> written;
+    std::optional<Location> previous;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto result = append_locked(key, data, size);
+        if (!result.success) {
+            return Result<void>::err(result.error);
+        }
+        written = active_;
+        previous = std::move(result.value);
+    }
+    // Flushed outside the lock so concurrent writers share group commits.
+    auto flush_result = flush(written->fd);
+
+    // The replaced record is flagged only once the new one is durable; if
+    // the flush failed it stays intact on disk and seq decides on reopen.
+    if (previous) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        mark_dead_locked(*previous, flush_result.success);
+    }
+    return flush_result;
+}
+
+bool PackedStore::contains(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    return index_.count(key) != 0;
+}
+
+Result<uint64_t> PackedStore::size(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return Result<uint64_t>::err("Not in pack: " + key);
+    }
+    return Result<uint64_t>::ok(it->second.data_len);
+}
+
+Result<std::vector<uint8_t>> PackedStore::read(const std::string& key, uint64_t offset, size_t length) const {
+    Location loc;
+    {
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return Result<std::vector<uint8_t>>::err("Not in pack: " + key);
+        }
+        loc = it->second;
+    }
+
+    // The segment stays readable through its descriptor even if compaction
+    // unlinks it meanwhile. The whole record is read so its CRC can be checked.
+    const size_t body_len = loc.key_len + loc.data_len;
+    std::vector<uint8_t> record(kRecordHeaderSize + body_len);
+    ssize_t n = pread_all(loc.segment->fd, record.data(), record.size(), loc.offset);
+    if (n != static_cast<ssize_t>(record.size()) || std::memcmp(record.data(), kRecordMagic, 4) != 0 ||
+        static_cast<uint32_t>(crc32(0L, record.data() + kRecordHeaderSize, static_cast<uInt>(body_len))) !=
+            get_u32(record.data() + 20)) {
+        return Result<std::vector<uint8_t>>::err("Corrupt packed blob " + key + " in " + loc.segment->path);
+    }
+
+    if (offset >= loc.data_len) {
+        return Result<std::vector<uint8_t>>::ok({});
+    }
+    const size_t n_out = static_cast<size_t>(std::min<uint64_t>(length, loc.data_len - offset));
+    auto begin = record.begin() + kRecordHeaderSize + loc.key_len + offset;
+    return Result<std::vector<uint8_t>>::ok(std::vector<uint8_t>(begin, begin + n_out));
+}
+
+bool PackedStore::remove(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        Location loc = it->second;
+        index_.erase(it);
+        index_lock.unlock();
+        mark_dead_locked(loc);
+    }
+    // A lost flag would bring the blob back on the next open.
+    auto flush_result = flush_dead_flags();
+    if (!flush_result.success) {
+        SERVER_LOG_ERROR("PackedStore", "Delete of " + key + " may not survive a crash: " + flush_result.error);
+    }
+    return true;
+}
+
+size_t PackedStore::remove_prefix(const std::string& prefix) {
+    std::vector<Location> removed;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        {
+            std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+            for (auto it = index_.begin(); it != index_.end();) {
+                if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                    removed.push_back(it->second);
+                    it = index_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (const auto& loc : removed) mark_dead_locked(loc);
+    }
+    if (!removed.empty()) {
+        auto flush_result = flush_dead_flags();
+        if (!flush_result.success) {
+            SERVER_LOG_ERROR("PackedStore", "Delete of " + prefix + "* may not survive a crash: " + flush_result.error);
+        }
+    }
+    return removed.size();
+}
+
+std::vector<std::string> PackedStore::list(const std::string& prefix) const {
+    std::vector<std::string> keys;
+    {
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        for (const auto& [key, loc] : index_) {
+            if (key.compare(0, prefix.size(), prefix) == 0) keys.push_back(key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+Result<size_t> PackedStore::compact(bool force) {
+    std::vector<std::shared_ptr<Segment>> victims;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        for (const auto& [id, segment] : segments_) {
+            if (segment == active_ || segment->damaged) continue;
+            const bool all_dead = segment->dead_bytes >= segment->size;
+            const bool mostly_dead = segment->dead_bytes > 0 &&
+                (force || segment->dead_bytes >= options_.compact_garbage_ratio * segment->size);
+            if (all_dead || mostly_dead) victims.push_back(segment);
+        }
+    }
+
+    size_t freed = 0;
+    for (const auto& victim : victims) {
+        std::vector<std::pair<std::string, uint64_t>> live;
+        {
+            std::shared_lock<std::shared_mutex> lock(index_mutex_);
+            for (const auto& [key, loc] : index_) {
+                if (loc.segment == victim) live.emplace_back(key, loc.offset);
+            }
+        }
+
+        // Copy record by record, so writers are held up for one small blob
+        // at a time; a key deleted or rewritten meanwhile is skipped.
+        std::vector<std::shared_ptr<Segment>> written;
+        for (const auto& [key, offset] : live) {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            {
+                std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+                auto it = index_.find(key);
+                if (it == index_.end() || it->second.segment != victim || it->second.offset != offset) continue;
+            }
+            auto data = read(key);
+            if (!data.success) {
+                return Result<size_t>::err(data.error);
+            }
+            auto append_result = append_locked(key, data.value.data(), data.value.size());
+            if (!append_result.success) {
+                return Result<size_t>::err(append_result.error);
+            }
+            // No dead flag in the victim: it is unlinked below, and until then
+            // the copy's higher seq wins on reopen. Flagging it before the copy
+            // is flushed could lose the blob in a crash.
+            if (append_result.value) mark_dead_locked(*append_result.value, false);
+            if (written.empty() || written.back() != active_) written.push_back(active_);
+        }
+
+        // The copies must be durable before the originals go, and so must
+        // every dead flag: the victim's dead records may be what retires an
+        // older copy of their key elsewhere.
+        for (const auto& segment : written) {
+            auto flush_result = flush(segment->fd);
+            if (!flush_result.success) {
+                return Result<size_t>::err(flush_result.error);
+            }
+        }
+        auto flags_result = flush_dead_flags();
+        if (!flags_result.success) {
+            return Result<size_t>::err(flags_result.error);
+        }
+        {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            segments_.erase(victim->id);
+            ::unlink(victim->path.c_str());
+        }
+        auto sync_result = sync_dir();
+        if (!sync_result.success) {
+            return Result<size_t>::err(sync_result.error);
+        }
+        ++freed;
+    }
+    return Result<size_t>::ok(freed);
+}
+
+PackedStore::Stats PackedStore::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        stats.segments = segments_.size();
+        for (const auto& [id, segment] : segments_) {
+            stats.live_bytes += segment->size - segment->dead_bytes;
+            stats.dead_bytes += segment->dead_bytes;
+        }
+    }
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    stats.blobs = index_.size();
+    return stats;
+}
+
+Result<void> PackedStore::flush(int fd) {
+    if (sync_mode_ == StorageSyncMode::Group) {
+        return group_commit_->commit();
+    }
+    if (sync_mode_ == StorageSyncMode::Fsync && ::fdatasync(fd) != 0) {
+        return Result<void>::err("Failed to sync pack segment in " + dir_ + ": " + std::strerror(errno));
+    }
+    return Result<void>::ok();
+}
+
+Result<void> PackedStore::sync_dir() {
+    if (sync_mode_ == StorageSyncMode::Group) {
+        return group_commit_->commit();
+    }
+    if (sync_mode_ != StorageSyncMode::Fsync) {
+        return Result<void>::ok();
+    }
+    int dir_fd = ::open(dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return Result<void>::err("Failed to open directory " + dir_ + ": " + std::strerror(errno));
+    }
+    int rc = ::fsync(dir_fd);
+    std::string reason = std::strerror(errno);
+    ::close(dir_fd);
+    if (rc != 0) {
+        return Result<void>::err("Failed to sync directory " + dir_ + ": " + reason);
+    }
+    return Result<void>::ok();
+}
+
+void PackedStore::compactor_loop() {
+    std::unique_lock<std::mutex> lock(compactor_mutex_);
+    while (!compactor_cv_.wait_for(lock, std::chrono::seconds(options_.compact_interval_seconds),
+                                   [this] { return stopping_; })) {
+        lock.unlock();
+        auto result = compact();
+        if (!result.success) {
+            SERVER_LOG_WARN("PackedStore", "Compaction of " + dir_ + " failed: " + result.error);
+        } else if (result.value > 0) {
+            SERVER_LOG_INFO("PackedStore", "Compacted " + std::to_string(result.value) + " segment(s) in " + dir_);
+        }
+        lock.lock();
+    }
+}
+
+} // namespace fileengine
@@ -16,6 +16,9 @@
 #include "fileengine/rest_server.h"
 #include "fileengine/cache_manager.h"
 #include "fileengine/file_culler.h"
+#include "fileengine/metadata_cache.h"
+#include "fileengine/acl_cache.h"
+#include "fileengine/role_cache.h"
 #include "fileengine/server_logger.h"
 #include "fileengine/build_info.h"
 
@@ -134,13 +137,68 @@ void RestServer::install_routes() {
 
         // Cache state, if a CacheManager was wired in.
         if (cache_manager_) {
+            const CacheStats stats = cache_manager_->get_stats();
             json c;
-            c["size_bytes"]     = cache_manager_->get_cache_size_bytes();
-            c["max_bytes"]      = cache_manager_->get_max_cache_size_bytes();
-            c["usage_pct"]      = cache_manager_->get_cache_usage_percentage() * 100.0;
+            c["size_bytes"]     = stats.size_bytes;
+            c["max_bytes"]      = stats.max_bytes;
+            c["usage_pct"]      = stats.max_bytes
+                ? 100.0 * static_cast<double>(stats.size_bytes) / static_cast<double>(stats.max_bytes) : 0.0;
+            c["entries"]        = stats.entries;
+            c["hits"]           = stats.hits;
+            c["misses"]         = stats.misses;
+            c["evictions"]      = stats.evictions;
+            c["rejections"]     = stats.rejections;
+            c["hit_ratio"]      = (stats.hits + stats.misses)
+                ? static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses) : 0.0;
             j["cache"] = std::move(c);
         }
 
+        // FileInfo cache state, if one was wired in.
+        if (metadata_cache_) {
+            const MetadataCacheStats stats = metadata_cache_->get_stats();
+            json m;
+            m["entries"]       = stats.entries;
+            m["max_entries"]   = stats.max_entries;
+            m["hits"]          = stats.hits;
+            m["misses"]        = stats.misses;
+            m["negative_hits"] = stats.negative_hits;
+            m["evictions"]     = stats.evictions;
+            m["invalidations"] = stats.invalidations;
+            m["hit_ratio"]     = (stats.hits + stats.misses)
+                ? static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses) : 0.0;
+            j["metadata_cache"] = std::move(m);
+        }
+
+        // Shared ACL cache state, if one was wired in.
+        if (acl_cache_) {
+            const AclCacheStats stats = acl_cache_->get_stats();
+            json a;
+            a["entries"]       = stats.entries;
+            a["max_entries"]   = stats.max_entries;
+            a["hits"]          = stats.hits;
+            a["misses"]        = stats.misses;
+            a["evictions"]     = stats.evictions;
+            a["invalidations"] = stats.invalidations;
+            a["hit_ratio"]     = (stats.hits + stats.misses)
+                ? static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses) : 0.0;
+            j["acl_cache"] = std::move(a);
+        }
+
+        // Role membership cache state, if one was wired in.
+        if (role_cache_) {
+            const RoleCacheStats stats = role_cache_->get_stats();
+            json r;
+            r["entries"]       = stats.entries;
+            r["max_entries"]   = stats.max_entries;
+            r["hits"]          = stats.hits;
+            r["misses"]        = stats.misses;
+            r["evictions"]     = stats.evictions;
+            r["invalidations"] = stats.invalidations;
+            r["hit_ratio"]     = (stats.hits + stats.misses)
+                ? static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses) : 0.0;
+            j["role_cache"] = std::move(r);
+        }
+
         // Culler state.
         if (file_culler_) {
             json cu;
@@ -0,0 +1,135 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/role_cache.h"
+#include <algorithm>
+#include <functional>
+
+namespace fileengine {
+
+namespace {
+std::string role_key(const std::string& tenant, const std::string& user) {
+    return tenant + '\0' + user;
+}
+} // namespace
+
+RoleCache::RoleCache(size_t max_entries, std::chrono::milliseconds ttl, size_t shard_count)
+    : ttl_(ttl), max_entries_(max_entries) {
+    const size_t count = std::max<size_t>(1, std::min(shard_count, max_entries));
+    shards_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->max_entries = std::max<size_t>(1, max_entries / count);
+    }
+}
+
+RoleCache::Shard& RoleCache::shard_for(const std::string& key) {
+    size_t h = std::hash<std::string>{}(key);
+    h ^= h >> 32;
+    return *shards_[h % shards_.size()];
+}
+
+std::optional<std::vector<std::string>> RoleCache::get(const std::string& tenant, const std::string& user) {
+    const std::string key = role_key(tenant, user);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        if (std::chrono::steady_clock::now() < it->second.expires) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second.roles;
+        }
+        shard.lru.erase(it->second.lru_it);
+        shard.map.erase(it);
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+void RoleCache::put(const std::string& tenant, const std::string& user,
+                    const std::vector<std::string>& roles, uint64_t epoch) {
+    const std::string key = role_key(tenant, user);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // An invalidation ran since the database was read; the roles may be stale.
+    // Checked under the shard lock so it cannot slip in before the insert.
+    if (epoch != this->epoch()) {
+        return;
+    }
+    const auto expires = ttl_.count() > 0 ? std::chrono::steady_clock::now() + ttl_
+                                          : std::chrono::steady_clock::time_point::max();
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+    } else {
+        while (shard.map.size() >= shard.max_entries && !shard.lru.empty()) {
+            shard.map.erase(shard.lru.back());
+            shard.lru.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.lru.push_front(key);
+        it = shard.map.emplace(key, Entry{}).first;
+        it->second.lru_it = shard.lru.begin();
+    }
+    it->second.roles = roles;
+    it->second.expires = expires;
+}
+
+void RoleCache::invalidate(const std::string& tenant, const std::string& user) {
+    const std::string key = role_key(tenant, user);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    epoch_.fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        shard.lru.erase(it->second.lru_it);
+        shard.map.erase(it);
+    }
+}
+
+void RoleCache::invalidate_tenant(const std::string& tenant) {
+    epoch_.fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+    const std::string prefix = tenant + '\0';
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->map.begin(); it != shard->map.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                shard->lru.erase(it->second.lru_it);
+                it = shard->map.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+RoleCacheStats RoleCache::get_stats() const {
+    RoleCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.max_entries = max_entries_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->map.size();
+    }
+    return stats;
+}
+
+} // namespace fileengine
@@ -15,10 +15,12 @@
 
 #include "fileengine/role_manager.h"
 #include "fileengine/IDatabase.h"
+#include "fileengine/role_cache.h"
 
 namespace fileengine {
 
-RoleManager::RoleManager(std::shared_ptr<IDatabase> db) : db_(db) {
+RoleManager::RoleManager(std::shared_ptr<IDatabase> db, std::shared_ptr<RoleCache> role_cache)
+    : db_(db), role_cache_(std::move(role_cache)) {
 }
 
 Result<void> RoleManager::create_role(const std::string& role, const std::string& tenant) {
@@ -32,7 +34,12 @@ Result<void> RoleManager::delete_role(const std::string& role, const std::string
     if (role.empty()) {
         return Result<void>::err("Role name cannot be empty");
     }
-    return db_->delete_role(role, tenant);
+    auto result = db_->delete_role(role, tenant);
+    // Any user of the tenant may have held the role
+    if (result.success && role_cache_) {
+        role_cache_->invalidate_tenant(tenant);
+    }
+    return result;
 }
 
 Result<void> RoleManager::assign_user_to_role(const std::string& user, const std::string& role,
@@ -40,7 +47,11 @@ Result<void> RoleManager::assign_user_to_role(const std::string& user, const std
     if (user.empty() || role.empty()) {
         return Result<void>::err("User and role names cannot be empty");
     }
-    return db_->assign_user_to_role(user, role, tenant);
+    auto result = db_->assign_user_to_role(user, role, tenant);
+    if (result.success && role_cache_) {
+        role_cache_->invalidate(tenant, user);
+    }
+    return result;
 }
 
 Result<void> RoleManager::remove_user_from_role(const std::string& user, const std::string& role,
@@ -48,7 +59,11 @@ Result<void> RoleManager::remove_user_from_role(const std::string& user, const s
     if (user.empty() || role.empty()) {
         return Result<void>::err("User and role names cannot be empty");
     }
-    return db_->remove_user_from_role(user, role, tenant);
+    auto result = db_->remove_user_from_role(user, role, tenant);
+    if (result.success && role_cache_) {
+        role_cache_->invalidate(tenant, user);
+    }
+    return result;
 }
 
 Result<std::vector<std::string>> RoleManager::get_roles_for_user(const std::string& user,
@@ -0,0 +1,85 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// One-time backfill of the stored folder rollup (files.subtree_vts /
+// subtree_by) for tenants created before it existed. Until a folder's rollup
+// is filled in, reads fall back to walking its subtree, so the server works
+// before, during and after the backfill; this only makes those reads cheap.
+//
+// Usage: fileengine_rollup_backfill [--tenant ID] [--all] [server config flags]
+// Database settings are read like the server's (core.conf, .env, environment,
+// --db-host/--db-port/...). Without --tenant every registered tenant is
+// processed. --all recomputes every folder instead of only the missing ones,
+// which also repairs drift; run it while the tenant is quiet, since writes
+// landing mid-pass can be overwritten by the pass's older view.
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fileengine/config_loader.h"
+#include "fileengine/database.h"
+
+int main(int argc, char** argv) {
+    std::string only_tenant;
+    bool all = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--tenant" && i + 1 < argc) only_tenant = argv[++i];
+        else if (arg == "--all") all = true;
+    }
+
+    fileengine::Config config = fileengine::ConfigLoader::load_config(argc, argv);
+    fileengine::Database database(config.db_host, config.db_port, config.db_name,
+                                  config.db_user, config.db_password, 1);
+    if (!database.connect()) {
+        std::cerr << "Failed to connect to database" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> tenants;
+    if (!only_tenant.empty()) {
+        tenants.push_back(only_tenant);
+    } else {
+        auto listed = database.list_tenants();
+        if (!listed.success) {
+            std::cerr << listed.error << std::endl;
+            return 1;
+        }
+        tenants = listed.value;
+    }
+
+    int rc = 0;
+    for (const auto& tenant : tenants) {
+        auto exists = database.tenant_schema_exists(tenant);
+        if (!exists.success || !exists.value) {
+            std::cerr << "Tenant " << tenant << ": no such tenant schema" << std::endl;
+            rc = 1;
+            continue;
+        }
+        // Runs the tenant migrations first so the rollup columns exist.
+        auto schema = database.create_tenant_schema(tenant);
+        auto result = schema.success ? database.rebuild_folder_rollups(tenant, !all)
+                                     : fileengine::Result<int64_t>::err(schema.error);
+        if (!result.success) {
+            std::cerr << "Tenant " << tenant << ": " << result.error << std::endl;
+            rc = 1;
+            continue;
+        }
+        std::cout << "Tenant " << tenant << ": " << result.value << " folder(s) updated" << std::endl;
+    }
+
+    database.disconnect();
+    return rc;
+}
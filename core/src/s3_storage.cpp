@@ -304,6 +304,73 @@ Result<std::vector<uint8_t>> S3Storage::read_file(const std::string& storage_pat
 #endif
 }
 
+Result<std::vector<uint8_t>> S3Storage::read_file_range(const std::string& storage_path, uint64_t offset,
+                                                        size_t length, const std::string& tenant) {
+    if (!initialized_) {
+        return Result<std::vector<uint8_t>>::err("S3 storage not initialized");
+    }
+    if (length == 0) {
+        return Result<std::vector<uint8_t>>::ok({});
+    }
+
+#ifdef USE_AWS_SDK
+    if (!s3_client_) {
+        return Result<std::vector<uint8_t>>::err("S3 client not initialized");
+    }
+
+    Aws::S3::Model::GetObjectRequest request;
+    request.SetBucket(Aws::String(bucket_));
+    request.SetKey(Aws::String(storage_path));
+    // HTTP byte ranges are inclusive; a range past the end is clipped by S3.
+    request.SetRange(Aws::String("bytes=" + std::to_string(offset) + "-" +
+                                 std::to_string(offset + length - 1)));
+
+    auto outcome = s3_client_->GetObject(request);
+    if (!outcome.IsSuccess()) {
+        // 416: the range starts at or past the end of the object
+        if (outcome.GetError().GetResponseCode() ==
+            Aws::Http::HttpResponseCode::REQUESTED_RANGE_NOT_SATISFIABLE) {
+            return Result<std::vector<uint8_t>>::ok({});
+        }
+        return Result<std::vector<uint8_t>>::err("Failed to download file range from S3: " +
+                                                outcome.GetError().GetMessage());
+    }
+
+    auto& body = outcome.GetResult().GetBody();
+    std::vector<uint8_t> data(length);
+    body.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(length));
+    data.resize(static_cast<size_t>(body.gcount()));
+    return Result<std::vector<uint8_t>>::ok(data);
+#else
+    return Result<std::vector<uint8_t>>::err("AWS SDK not available - S3 storage requires USE_AWS_SDK to be defined");
+#endif
+}
+
+Result<uint64_t> S3Storage::get_file_size(const std::string& storage_path, const std::string& tenant) {
+    if (!initialized_) {
+        return Result<uint64_t>::err("S3 storage not initialized");
+    }
+
+#ifdef USE_AWS_SDK
+    if (!s3_client_) {
+        return Result<uint64_t>::err("S3 client not initialized");
+    }
+
+    Aws::S3::Model::HeadObjectRequest request;
+    request.SetBucket(Aws::String(bucket_));
+    request.SetKey(Aws::String(storage_path));
+
+    auto outcome = s3_client_->HeadObject(request);
+    if (!outcome.IsSuccess()) {
+        return Result<uint64_t>::err("Failed to get file size from S3: " +
+                                     outcome.GetError().GetMessage());
+    }
+    return Result<uint64_t>::ok(static_cast<uint64_t>(outcome.GetResult().GetContentLength()));
+#else
+    return Result<uint64_t>::err("AWS SDK not available - S3 storage requires USE_AWS_SDK to be defined");
+#endif
+}
+
 Result<bool> S3Storage::file_exists(const std::string& storage_path, const std::string& tenant) {
     if (!initialized_) {
         return Result<bool>::err("S3 storage not initialized");
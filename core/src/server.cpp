@@ -13,6 +13,8 @@
 // You should have received a copy of the GNU Affero General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -27,10 +29,14 @@
 #include "fileengine/filesystem.h"
 #include "fileengine/database.h"
 #include "fileengine/storage.h"
+#include "fileengine/storage_factory.h"
 #include "fileengine/s3_storage.h"
 #include "fileengine/tenant_manager.h"
 #include "fileengine/acl_manager.h"
 #include "fileengine/cache_manager.h"
+#include "fileengine/metadata_cache.h"
+#include "fileengine/acl_cache.h"
+#include "fileengine/role_cache.h"
 #include "fileengine/utils.h"
 #include "fileengine/object_store_sync.h"
 #include "fileengine/grpc_service.h"
@@ -96,6 +102,7 @@ int main(int argc, char** argv) {
     auto database = std::make_shared<fileengine::Database>(config.db_host, config.db_port, config.db_name,
                                                          config.db_user, config.db_password,
                                                          config.thread_pool_size); // Use configured thread pool size
+    database->set_prepared_statements(config.db_prepared_statements);
     if (!database->connect()) {
         std::cerr << "Failed to connect to database" << std::endl;
         return -1;
@@ -144,7 +151,21 @@ int main(int argc, char** argv) {
 
     // Initialize storage
     std::cout << "Initializing local storage..." << std::endl;
-    auto storage = std::make_unique<fileengine::Storage>(config.storage_base_path, config.encrypt_data, config.compress_data);
+    fileengine::PackedStoreOptions packing;
+    packing.threshold = config.storage_pack_kb > 0 ? static_cast<size_t>(config.storage_pack_kb) * 1024 : 0;
+    packing.compact_interval_seconds = config.storage_pack_compact_seconds;
+    auto storage = fileengine::make_local_storage(config.storage_base_path, config.encrypt_data, config.compress_data,
+                                                  config.storage_deduplicate,
+                                                  fileengine::Storage::parse_sync_mode(config.storage_sync_mode),
+                                                  config.storage_io_backend, packing);
+    // Temp files beside their targets are never listed or culled; drop the
+    // ones a crash left behind.
+    auto swept = storage->sweep_temp_files();
+    if (!swept.success) {
+        std::cerr << "Warning: " << swept.error << std::endl;
+    } else if (swept.value > 0) {
+        std::cout << "Removed " << swept.value << " stale temp files from local storage." << std::endl;
+    }
 
     // Initialize tenant manager
     std::cout << "Initializing tenant manager..." << std::endl;
@@ -164,6 +185,14 @@ int main(int argc, char** argv) {
     tenant_config.encrypt_data = config.encrypt_data;
     tenant_config.compress_data = config.compress_data;
     tenant_config.encryption_key = config.encryption_key;  // Added for encryption support
+    tenant_config.storage_deduplicate = config.storage_deduplicate;
+    tenant_config.storage_sync_mode = config.storage_sync_mode;
+    tenant_config.storage_io_backend = config.storage_io_backend;
+    tenant_config.storage_frame_size = config.storage_frame_kb > 0 ? static_cast<size_t>(config.storage_frame_kb) * 1024 : 0;
+    tenant_config.storage_encode_threads = config.storage_encode_threads;
+    tenant_config.storage_codec = config.storage_codec;
+    tenant_config.storage_pack_threshold = packing.threshold;
+    tenant_config.storage_pack_compact_seconds = config.storage_pack_compact_seconds;
 
     auto tenant_manager = std::make_shared<fileengine::TenantManager>(tenant_config, database, storage_tracker.get());
 
@@ -173,13 +202,54 @@ int main(int argc, char** argv) {
     // The system_admin bypass is role-driven (no config flag) — upstream is
     // trusted to only attach kSystemAdminRole to legitimately admin requests.
 
-    // Initialize cache manager
-    auto cache_manager = std::make_unique<fileengine::CacheManager>(storage.get(), s3_storage.get(), config.cache_threshold);
+    // Initialize the read cache of decoded file content; a budget of 0 MB
+    // turns it off
+    std::shared_ptr<fileengine::CacheManager> cache_manager;
+    if (config.max_cache_size_mb > 0) {
+        cache_manager = std::make_shared<fileengine::CacheManager>(
+            storage.get(), s3_storage.get(), config.cache_threshold,
+            config.max_cache_size_mb * 1024 * 1024, 0,
+            fileengine::CacheManager::parse_policy(config.cache_policy));
+    }
 
     // Initialize filesystem
     std::cout << "Initializing filesystem..." << std::endl;
     auto filesystem = std::make_shared<fileengine::FileSystem>(tenant_manager);
     filesystem->set_acl_manager(acl_manager);
+    filesystem->set_cache_manager(cache_manager);
+
+    // FileInfo cache shared by the filesystem (which invalidates it) and the
+    // ACL manager's ancestor walks; 0 entries turns it off
+    std::shared_ptr<fileengine::MetadataCache> metadata_cache;
+    if (config.metadata_cache_entries > 0) {
+        metadata_cache = std::make_shared<fileengine::MetadataCache>(
+            config.metadata_cache_entries,
+            std::chrono::milliseconds(std::max(0, config.metadata_cache_ttl_ms)),
+            /*shard_count=*/16,
+            std::chrono::milliseconds(std::max(0, config.negative_cache_ttl_ms)));
+    }
+    filesystem->set_metadata_cache(metadata_cache);
+    acl_manager->set_metadata_cache(metadata_cache);
+
+    // Permission decisions and ACL rules shared across requests; 0 entries
+    // leaves only the per-request cache
+    std::shared_ptr<fileengine::AclCache> acl_cache;
+    if (config.acl_cache_entries > 0) {
+        acl_cache = std::make_shared<fileengine::AclCache>(
+            config.acl_cache_entries,
+            std::chrono::milliseconds(std::max(0, config.acl_cache_ttl_ms)));
+    }
+    acl_manager->set_acl_cache(acl_cache);
+
+    // Each user's stored roles, read on every permission check; the gRPC
+    // role handlers invalidate it through RoleManager. 0 entries turns it off
+    std::shared_ptr<fileengine::RoleCache> role_cache;
+    if (config.role_cache_entries > 0) {
+        role_cache = std::make_shared<fileengine::RoleCache>(
+            config.role_cache_entries,
+            std::chrono::milliseconds(std::max(0, config.role_cache_ttl_ms)));
+    }
+    acl_manager->set_role_cache(role_cache);
 
     // Optional file-activity event emission (Redis). make_event_sink returns
     // nullptr when disabled/not compiled in, so this is a no-op by default.
@@ -279,6 +349,9 @@ int main(int argc, char** argv) {
     if (config.http_metrics_enabled) {
         rest_listener = std::make_unique<fileengine::RestServer>(
             database, cache_manager.get(), file_culler.get());
+        rest_listener->set_metadata_cache(metadata_cache.get());
+        rest_listener->set_acl_cache(acl_cache.get());
+        rest_listener->set_role_cache(role_cache.get());
         // Optional client-IP allowlist for the unauthenticated monitor (L2):
         // split FILEENGINE_HTTP_METRICS_ALLOW_IPS on commas, trimming blanks.
         if (!config.http_metrics_allow_ips.empty()) {
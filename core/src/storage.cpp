@@ -15,6 +15,18 @@
 
 #include "fileengine/storage.h"
 #include "fileengine/utils.h"
+#include "fileengine/crypto_utils.h"
+#include "fileengine/group_commit.h"
+#include "fileengine/packed_store.h"
+#include "fileengine/server_logger.h"
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <linux/fs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -23,16 +35,88 @@
 
 namespace fileengine {
 
-Storage::Storage(const std::string& base_path, bool encrypt_data, bool compress_data)
-    : base_path_(base_path), encrypt_data_(encrypt_data), compress_data_(compress_data), object_store_(nullptr) {
+namespace {
+// Extended attribute stamped on every deduplicated blob inode, holding the
+// blob's own path. Hard links share the inode, so delete_file can find the
+// blob behind any version path without knowing its content key or tenant.
+constexpr const char* kBlobPathXattr = "user.fileengine.blob";
+} // namespace
+
+Storage::Storage(const std::string& base_path, bool encrypt_data, bool compress_data, bool deduplicate,
+                 StorageSyncMode sync_mode)
+    : base_path_(base_path), encrypt_data_(encrypt_data), compress_data_(compress_data),
+      deduplicate_(deduplicate), sync_mode_(sync_mode), object_store_(nullptr) {
     // Create base directory if it doesn't exist
     std::filesystem::create_directories(base_path_);
+
+    if (sync_mode_ == StorageSyncMode::Group) {
+        group_commit_ = GroupCommit::for_filesystem(base_path_);
+    }
+}
+
+StorageSyncMode Storage::parse_sync_mode(const std::string& mode) {
+    if (mode == "none") return StorageSyncMode::None;
+    if (mode == "fsync") return StorageSyncMode::Fsync;
+    if (mode != "group") {
+        SERVER_LOG_WARN("Storage", "Unknown FILEENGINE_STORAGE_SYNC value '" + mode + "'; using group");
+    }
+    return StorageSyncMode::Group;
 }
 
 Storage::~Storage() {
     // Cleanup operations if needed
 }
 
+Result<void> Storage::enable_packing(const PackedStoreOptions& options) {
+    if (options.threshold == 0) {
+        packed_.reset();
+        return Result<void>::ok();
+    }
+    auto result = PackedStore::open(base_path_ + "/" + kPackDirName, options, sync_mode_);
+    if (!result.success) {
+        return Result<void>::err(result.error);
+    }
+    packed_ = result.value;
+    return Result<void>::ok();
+}
+
+std::string Storage::pack_key(const std::string& storage_path) const {
+    if (!packed_ || storage_path.size() <= base_path_.size() + 1 ||
+        storage_path.compare(0, base_path_.size(), base_path_) != 0 || storage_path[base_path_.size()] != '/') {
+        return "";
+    }
+    return storage_path.substr(base_path_.size() + 1);
+}
+
+bool Storage::is_packed(const std::string& storage_path) const {
+    std::string key = pack_key(storage_path);
+    return !key.empty() && packed_->contains(key);
+}
+
+Result<bool> Storage::store_packed(const std::string& full_path, const uint8_t* data, size_t size) {
+    std::string key = pack_key(full_path);
+    if (key.empty() || !packed_->accepts(size)) {
+        return Result<bool>::ok(false);
+    }
+    auto result = packed_->put(key, data, size);
+    if (!result.success) {
+        return Result<bool>::err(result.error);
+    }
+    // A rewrite of a version that used to be large leaves a shadowed file.
+    struct stat st;
+    if (::lstat(full_path.c_str(), &st) == 0) {
+        delete_local_file(full_path);
+    }
+    return Result<bool>::ok(true);
+}
+
+void Storage::drop_packed(const std::string& full_path) {
+    std::string key = pack_key(full_path);
+    if (!key.empty()) {
+        packed_->remove(key);
+    }
+}
+
 std::string Storage::get_sha256_desaturated_path(const std::string& uid) const {
     // For this implementation, we'll use the first few characters of the UUID to create multiple subdirectories
     // This helps prevent filesystem performance issues with many files in one directory
@@ -69,34 +153,189 @@ std::string Storage::get_storage_path(const std::string& uid, const std::string&
 
 Result<std::string> Storage::store_file(const std::string& uid, const std::string& version_timestamp,
                                         const std::vector<uint8_t>& data, const std::string& tenant) {
-    std::lock_guard<std::mutex> lock(storage_mutex_);
-    
     std::string full_path = get_storage_path(uid, version_timestamp, tenant);
+    auto packed = store_packed(full_path, data.data(), data.size());
+    if (!packed.success) {
+        return Result<std::string>::err(packed.error);
+    }
+    if (packed.value) {
+        return Result<std::string>::ok(full_path);
+    }
+
+    if (deduplicate_) {
+        // No caller-supplied key: address the blob by the bytes as stored.
+        return store_file_deduplicated(uid, version_timestamp, data, CryptoUtils::content_digest(data), tenant);
+    }
+
+    auto result = write_file_atomic(full_path, data);
+    if (!result.success) {
+        return Result<std::string>::err(result.error);
+    }
+    drop_packed(full_path);
+
+    return Result<std::string>::ok(full_path);
+}
+
+std::string Storage::make_temp_path(const std::string& full_path) {
+    std::filesystem::path p(full_path);
+    return (p.parent_path() / ("." + p.filename().string() + ".tmp" +
+                               std::to_string(temp_seq_.fetch_add(1, std::memory_order_relaxed)))).string();
+}
+
+Result<void> Storage::write_file_atomic(const std::string& full_path, const std::vector<uint8_t>& data) {
     std::string dir_path = std::filesystem::path(full_path).parent_path();
-    
-    // Ensure directory exists
-    auto result = ensure_directory_exists(dir_path);
+    std::string temp_path = make_temp_path(full_path);
+
+    // A concurrent delete_file may prune the (momentarily empty) directory
+    // between creating it and opening the temp file; recreate and retry.
+    int fd = -1;
+    for (int attempt = 0; attempt < 3 && fd < 0; ++attempt) {
+        auto result = ensure_directory_exists(dir_path);
+        if (!result.success) {
+            return Result<void>::err("Failed to create directory: " + result.error);
+        }
+        fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        return Result<void>::err("Failed to open file for writing: " + full_path);
+    }
+
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::string reason = std::strerror(errno);
+            ::close(fd);
+            ::unlink(temp_path.c_str());
+            return Result<void>::err("Failed to write file: " + full_path + ": " + reason);
+        }
+        written += static_cast<size_t>(n);
+    }
+
+    auto result = publish_file(temp_path, full_path, fd);
+    ::close(fd);
     if (!result.success) {
-        return Result<std::string>::err("Failed to create directory: " + result.error);
+        ::unlink(temp_path.c_str());
     }
-    
-    // Write data to file
-    std::ofstream file(full_path, std::ios::binary);
-    if (!file.is_open()) {
-        return Result<std::string>::err("Failed to open file for writing: " + full_path);
+    return result;
+}
+
+Result<void> Storage::publish_file(const std::string& temp_path, const std::string& full_path, int fd) {
+    // 1. The contents must be durable before the name can point at them,
+    //    otherwise a crash can leave a complete-looking but empty file at a
+    //    path the database may already reference (a restored or rewritten
+    //    version). Group mode flushes just this file here and leaves the
+    //    filesystem-wide syncfs() to step 3, so a write costs one group
+    //    commit.
+    if (sync_mode_ == StorageSyncMode::Fsync || sync_mode_ == StorageSyncMode::Group) {
+        int sync_fd = fd >= 0 ? fd : ::open(temp_path.c_str(), O_RDONLY | O_CLOEXEC);
+        int rc = sync_fd >= 0 ? ::fdatasync(sync_fd) : -1;
+        std::string reason = std::strerror(errno);
+        if (sync_fd >= 0 && sync_fd != fd) ::close(sync_fd);
+        if (rc != 0) {
+            return Result<void>::err("Failed to sync " + temp_path + ": " + reason);
+        }
     }
-    
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
-    file.close();
-    
-    if (!file.good()) {
-        return Result<std::string>::err("Failed to write file: " + full_path);
+
+    // 2. rename() is atomic: readers see the old file or the new one.
+    if (::rename(temp_path.c_str(), full_path.c_str()) != 0) {
+        return Result<void>::err("Failed to move file into place: " + full_path + ": " + std::strerror(errno));
     }
-    
-    return Result<std::string>::ok(full_path);
+
+    // 3. Flush the directory entry so the rename survives a crash too.
+    return sync_directory(std::filesystem::path(full_path).parent_path());
+}
+
+Result<void> Storage::sync_directory(const std::string& dir_path) {
+    if (sync_mode_ == StorageSyncMode::Group) {
+        return group_commit_->commit();
+    }
+    if (sync_mode_ != StorageSyncMode::Fsync) {
+        return Result<void>::ok();
+    }
+
+    int dir_fd = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return Result<void>::err("Failed to open directory " + dir_path + ": " + std::strerror(errno));
+    }
+    int rc = ::fsync(dir_fd);
+    std::string reason = std::strerror(errno);
+    ::close(dir_fd);
+    if (rc != 0) {
+        return Result<void>::err("Failed to sync directory " + dir_path + ": " + reason);
+    }
+    return Result<void>::ok();
+}
+
+std::string Storage::make_staging_path(const std::string& storage_path) {
+    // Dot-prefixed like other temp files, so listings and sweeps skip it.
+    std::string staged = make_temp_path(storage_path);
+    ensure_directory_exists(std::filesystem::path(staged).parent_path());
+    return staged;
+}
+
+Result<size_t> Storage::sweep_temp_files(std::chrono::seconds min_age) {
+    const auto cutoff = std::chrono::system_clock::now() - min_age;
+    size_t removed = 0;
+    std::error_code ec;
+    try {
+        for (auto it = std::filesystem::recursive_directory_iterator(base_path_);
+             it != std::filesystem::recursive_directory_iterator(); ++it) {
+            // Segments are appended in place; nothing is staged there.
+            if (it->is_directory()) {
+                if (it->path().filename() == kPackDirName) it.disable_recursion_pending();
+                continue;
+            }
+            const std::string name = it->path().filename().string();
+            if (name[0] != '.' || name.find(".tmp") == std::string::npos || !it->is_regular_file()) continue;
+            struct stat st;
+            if (::lstat(it->path().c_str(), &st) != 0 ||
+                std::chrono::system_clock::from_time_t(st.st_mtime) > cutoff) {
+                continue;
+            }
+            if (std::filesystem::remove(it->path(), ec)) ++removed;
+        }
+    } catch (const std::exception& ex) {
+        return Result<size_t>::err("Failed to sweep temp files: " + std::string(ex.what()));
+    }
+    return Result<size_t>::ok(removed);
+}
+
+Result<void> Storage::publish_staged_file(const std::string& staged_path, const std::string& storage_path) {
+    struct stat st;
+    if (packed_ && ::stat(staged_path.c_str(), &st) == 0 && packed_->accepts(static_cast<size_t>(st.st_size))) {
+        auto staged = read_file(staged_path);
+        if (!staged.success) {
+            return Result<void>::err(staged.error);
+        }
+        auto packed = store_packed(storage_path, staged.value.data(), staged.value.size());
+        if (!packed.success) {
+            return Result<void>::err(packed.error);
+        }
+        if (packed.value) {
+            ::unlink(staged_path.c_str());
+            return Result<void>::ok();
+        }
+    }
+
+    auto dir_result = ensure_directory_exists(std::filesystem::path(storage_path).parent_path());
+    if (!dir_result.success) {
+        return dir_result;
+    }
+    auto result = publish_file(staged_path, storage_path);
+    if (result.success) {
+        drop_packed(storage_path);
+    }
+    return result;
 }
 
 Result<std::vector<uint8_t>> Storage::read_file(const std::string& storage_path, const std::string& tenant) {
+    std::string key = pack_key(storage_path);
+    if (!key.empty() && packed_->contains(key)) {
+        return packed_->read(key);
+    }
+
     std::ifstream file(storage_path, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         return Result<std::vector<uint8_t>>::err("Failed to open file for reading: " + storage_path);
@@ -115,17 +354,125 @@ Result<std::vector<uint8_t>> Storage::read_file(const std::string& storage_path,
     return Result<std::vector<uint8_t>>::ok(buffer);
 }
 
+Result<void> Storage::read_file_chunks(const std::string& storage_path,
+                                      const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                      const std::string& tenant) {
+    std::string key = pack_key(storage_path);
+    if (!key.empty() && packed_->contains(key)) {
+        auto result = packed_->read(key);
+        if (!result.success) {
+            return Result<void>::err(result.error);
+        }
+        if (!result.value.empty()) on_chunk(result.value.data(), result.value.size());
+        return Result<void>::ok();
+    }
+
+    std::ifstream file(storage_path, std::ios::binary);
+    if (!file.is_open()) {
+        return Result<void>::err("Failed to open file for reading: " + storage_path);
+    }
+
+    std::vector<char> buffer(kReadChunkSize);
+    while (true) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize n = file.gcount();
+        if (n <= 0) break;
+        if (!on_chunk(reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(n))) break;
+    }
+    if (file.bad()) {
+        return Result<void>::err("Failed to read file: " + storage_path);
+    }
+    return Result<void>::ok();
+}
+
+Result<uint64_t> Storage::get_file_size(const std::string& storage_path, const std::string& tenant) {
+    std::string key = pack_key(storage_path);
+    if (!key.empty() && packed_->contains(key)) {
+        return packed_->size(key);
+    }
+
+    struct stat st;
+    if (::stat(storage_path.c_str(), &st) != 0) {
+        return Result<uint64_t>::err("Failed to stat file: " + storage_path + ": " + std::strerror(errno));
+    }
+    return Result<uint64_t>::ok(static_cast<uint64_t>(st.st_size));
+}
+
+Result<std::vector<uint8_t>> Storage::read_file_range(const std::string& storage_path, uint64_t offset,
+                                                      size_t length, const std::string& tenant) {
+    std::string key = pack_key(storage_path);
+    if (!key.empty() && packed_->contains(key)) {
+        return packed_->read(key, offset, length);
+    }
+
+    int fd = ::open(storage_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return Result<std::vector<uint8_t>>::err("Failed to open file for reading: " + storage_path);
+    }
+
+    std::vector<uint8_t> buffer(length);
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(fd, buffer.data() + done, length - done, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int saved = errno;
+            ::close(fd);
+            return Result<std::vector<uint8_t>>::err("Failed to read file: " + storage_path + ": " +
+                                                     std::strerror(saved));
+        }
+        if (n == 0) break;  // end of file
+        done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    buffer.resize(done);
+    return Result<std::vector<uint8_t>>::ok(buffer);
+}
+
 Result<void> Storage::delete_file(const std::string& storage_path, const std::string& tenant) {
-    std::lock_guard<std::mutex> lock(storage_mutex_);
-    
+    // A packed version may still have a file of its own from before packing
+    // was enabled; both go.
+    drop_packed(storage_path);
+    return delete_local_file(storage_path);
+}
+
+Result<void> Storage::delete_local_file(const std::string& storage_path) {
     try {
-        if (std::filesystem::exists(storage_path)) {
+        // A deduplicated version path is one link of a shared blob, tagged
+        // with the blob's path. The blob's stripe lock keeps the link count
+        // stable against a concurrent store linking the same content.
+        std::string blob_path;
+        std::unique_lock<std::mutex> blob_lock;
+        if (deduplicate_) {
+            char buf[4096];
+            ssize_t n = ::getxattr(storage_path.c_str(), kBlobPathXattr, buf, sizeof(buf));
+            if (n > 0 && std::string(buf, n) != storage_path) {
+                blob_path.assign(buf, n);
+                blob_lock = std::unique_lock<std::mutex>(
+                    blob_lock_for(std::filesystem::path(blob_path).filename().string()));
+            }
+        }
+
+        struct stat st;
+        bool had_file = ::lstat(storage_path.c_str(), &st) == 0;
+        if (had_file) {
             std::filesystem::remove(storage_path);
         }
-        // If the directory is now empty, we might want to remove it as well
+        // Last version referencing the blob (links: this path + the blob
+        // entry) takes the blob with it.
+        if (had_file && !blob_path.empty() && st.st_nlink == 2) {
+            struct stat bst;
+            if (::lstat(blob_path.c_str(), &bst) == 0 && bst.st_ino == st.st_ino &&
+                bst.st_dev == st.st_dev && bst.st_nlink == 1) {
+                std::filesystem::remove(blob_path);
+            }
+        }
+        // Prune the directory if it is now empty. Best-effort: a concurrent
+        // writer may have just added a file to it.
         auto parent_path = std::filesystem::path(storage_path).parent_path();
-        if (std::filesystem::exists(parent_path) && std::filesystem::is_empty(parent_path)) {
-            std::filesystem::remove(parent_path);
+        std::error_code ec;
+        if (std::filesystem::is_empty(parent_path, ec) && !ec) {
+            std::filesystem::remove(parent_path, ec);
         }
     } catch (const std::filesystem::filesystem_error& ex) {
         return Result<void>::err("Failed to delete file: " + std::string(ex.what()));
@@ -134,8 +481,115 @@ Result<void> Storage::delete_file(const std::string& storage_path, const std::st
     return Result<void>::ok();
 }
 
+Result<std::string> Storage::copy_file(const std::string& src_storage_path, const std::string& uid,
+                                       const std::string& version_timestamp, const std::string& tenant) {
+    std::string full_path = get_storage_path(uid, version_timestamp, tenant);
+
+    // Another link to the source's blob costs no data at all.
+    if (deduplicate_ && !is_packed(src_storage_path)) {
+        char buf[4096];
+        ssize_t n = ::getxattr(src_storage_path.c_str(), kBlobPathXattr, buf, sizeof(buf));
+        if (n > 0) {
+            std::string blob_path(buf, n);
+            std::lock_guard<std::mutex> lock(blob_lock_for(std::filesystem::path(blob_path).filename().string()));
+            std::error_code ec;
+            if (std::filesystem::exists(blob_path, ec) && replace_with_link(blob_path, full_path).success) {
+                drop_packed(full_path);
+                return Result<std::string>::ok(full_path);
+            }
+        }
+    }
+
+    int src_fd = ::open(src_storage_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (src_fd < 0 || ::fstat(src_fd, &st) != 0) {
+        if (src_fd >= 0) ::close(src_fd);
+        // Packed (or unreadable) sources take the generic path.
+        return IStorage::copy_file(src_storage_path, uid, version_timestamp, tenant);
+    }
+    if (packed_ && packed_->accepts(static_cast<size_t>(st.st_size))) {
+        ::close(src_fd);
+        return IStorage::copy_file(src_storage_path, uid, version_timestamp, tenant);
+    }
+
+    // Same staging as write_file_atomic, including the directory-pruning retry.
+    std::string dir_path = std::filesystem::path(full_path).parent_path();
+    std::string temp_path = make_temp_path(full_path);
+    int fd = -1;
+    for (int attempt = 0; attempt < 3 && fd < 0; ++attempt) {
+        auto dir_result = ensure_directory_exists(dir_path);
+        if (!dir_result.success) {
+            ::close(src_fd);
+            return Result<std::string>::err("Failed to create directory: " + dir_result.error);
+        }
+        fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        ::close(src_fd);
+        return Result<std::string>::err("Failed to open file for writing: " + full_path);
+    }
+
+    auto result = clone_file_contents(src_fd, fd, static_cast<uint64_t>(st.st_size), full_path);
+    ::close(src_fd);
+    if (result.success) {
+        result = publish_file(temp_path, full_path, fd);
+    }
+    ::close(fd);
+    if (!result.success) {
+        ::unlink(temp_path.c_str());
+        return Result<std::string>::err(result.error);
+    }
+    drop_packed(full_path);
+    return Result<std::string>::ok(full_path);
+}
+
+Result<void> Storage::clone_file_contents(int src_fd, int dst_fd, uint64_t size, const std::string& what) {
+    // 1. Reflink: the copy shares the source's extents until either is written.
+#ifdef FICLONE
+    if (::ioctl(dst_fd, FICLONE, src_fd) == 0) {
+        return Result<void>::ok();
+    }
+#endif
+
+    // 2. copy_file_range: the kernel copies (or offloads) the data; 3. where
+    //    the filesystem pair does not support it, a plain read/write loop.
+    bool in_kernel = true;
+    std::vector<uint8_t> buffer;
+    uint64_t done = 0;
+    while (done < size) {
+        ssize_t n;
+        if (in_kernel) {
+            n = ::copy_file_range(src_fd, nullptr, dst_fd, nullptr, size - done, 0);
+            if (n < 0 && done == 0 &&
+                (errno == ENOSYS || errno == EXDEV || errno == EOPNOTSUPP || errno == EINVAL)) {
+                in_kernel = false;
+                continue;
+            }
+        } else {
+            buffer.resize(kReadChunkSize);
+            n = ::pread(src_fd, buffer.data(), std::min<uint64_t>(buffer.size(), size - done),
+                        static_cast<off_t>(done));
+            for (ssize_t written = 0; n > 0 && written < n;) {
+                ssize_t w = ::write(dst_fd, buffer.data() + written, static_cast<size_t>(n - written));
+                if (w < 0 && errno != EINTR) {
+                    n = -1;
+                    break;
+                }
+                if (w > 0) written += w;
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return Result<void>::err("Failed to copy file: " + what + ": " + std::strerror(errno));
+        }
+        if (n == 0) break;  // source shorter than its stat size
+        done += static_cast<uint64_t>(n);
+    }
+    return Result<void>::ok();
+}
+
 Result<bool> Storage::file_exists(const std::string& storage_path, const std::string& tenant) {
-    bool exists = std::filesystem::exists(storage_path);
+    bool exists = is_packed(storage_path) || std::filesystem::exists(storage_path);
     return Result<bool>::ok(exists);
 }
 
@@ -182,6 +636,9 @@ Result<void> Storage::cleanup_tenant_directory(const std::string& tenant) {
     std::string tenant_path = base_path_ + "/" + tenant;
     
     try {
+        if (packed_) {
+            packed_->remove_prefix(tenant + "/");
+        }
         if (std::filesystem::exists(tenant_path)) {
             std::filesystem::remove_all(tenant_path);
         }
@@ -235,14 +692,29 @@ Result<std::vector<std::string>> Storage::get_local_file_paths(const std::string
     }
     
     try {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(search_path)) {
-            if (entry.is_regular_file()) {
-                paths.push_back(entry.path().string());
+        for (auto it = std::filesystem::recursive_directory_iterator(search_path);
+             it != std::filesystem::recursive_directory_iterator(); ++it) {
+            // Blobs are reachable through their version links; listing them
+            // too would hand sync/culling paths that carry no uid/version.
+            // Packed segments are listed by version path below.
+            if (it->is_directory() &&
+                (it->path().filename() == kBlobDirName || it->path().filename() == kPackDirName)) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            // Dot-prefixed names are in-flight temp files, not versions.
+            if (it->is_regular_file() && it->path().filename().string()[0] != '.') {
+                paths.push_back(it->path().string());
             }
         }
     } catch (const std::exception& ex) {
         return Result<std::vector<std::string>>::err("Failed to get local file paths: " + std::string(ex.what()));
     }
+    if (packed_) {
+        for (const auto& key : packed_->list(tenant.empty() ? "" : tenant + "/")) {
+            paths.push_back(base_path_ + "/" + key);
+        }
+    }
     
     return Result<std::vector<std::string>>::ok(paths);
 }
@@ -268,6 +740,171 @@ Result<void> Storage::clear_storage(const std::string& tenant) {
     return Result<void>::ok();
 }
 
+bool Storage::is_deduplication_enabled() const {
+    return deduplicate_;
+}
+
+std::string Storage::get_blob_path(const std::string& content_key, const std::string& tenant) const {
+    std::string path = base_path_;
+    if (!tenant.empty()) {
+        path += "/" + tenant;
+    }
+    path += std::string("/") + kBlobDirName;
+    if (content_key.length() >= 4) {
+        path += "/" + content_key.substr(0, 2) + "/" + content_key.substr(2, 2);
+    }
+    return path + "/" + content_key;
+}
+
+std::mutex& Storage::blob_lock_for(const std::string& content_key) const {
+    return blob_locks_[std::hash<std::string>{}(content_key) % kBlobLockStripes];
+}
+
+Result<std::string> Storage::store_file_deduplicated(const std::string& uid, const std::string& version_timestamp,
+                                                     const std::vector<uint8_t>& data, const std::string& content_key,
+                                                     const std::string& tenant) {
+    if (!deduplicate_ || content_key.empty()) {
+        return store_file(uid, version_timestamp, data, tenant);
+    }
+
+    // Packed blobs are too small for sharing to pay off.
+    std::string full_path = get_storage_path(uid, version_timestamp, tenant);
+    auto packed = store_packed(full_path, data.data(), data.size());
+    if (!packed.success) {
+        return Result<std::string>::err(packed.error);
+    }
+    if (packed.value) {
+        return Result<std::string>::ok(full_path);
+    }
+
+    std::string blob_path = get_blob_path(content_key, tenant);
+
+    // Known content: link the version to the existing blob, skip the write.
+    {
+        std::lock_guard<std::mutex> lock(blob_lock_for(content_key));
+        std::error_code ec;
+        if (std::filesystem::exists(blob_path, ec) && replace_with_link(blob_path, full_path).success) {
+            drop_packed(full_path);
+            return Result<std::string>::ok(full_path);
+        }
+        // Could not link (e.g. blob just reclaimed): store a fresh copy.
+    }
+
+    auto write_result = write_file_atomic(full_path, data);
+    if (!write_result.success) {
+        return Result<std::string>::err(write_result.error);
+    }
+    drop_packed(full_path);
+    // The version is complete as a plain file already; failing to fold it into
+    // the blob store only forgoes the space saving.
+    std::lock_guard<std::mutex> lock(blob_lock_for(content_key));
+    link_into_blob_store_locked(full_path, content_key, tenant);
+    return Result<std::string>::ok(full_path);
+}
+
+Result<void> Storage::deduplicate_file(const std::string& storage_path, const std::string& content_key,
+                                       const std::string& tenant) {
+    if (!deduplicate_ || content_key.empty() || is_packed(storage_path)) {
+        return Result<void>::ok();
+    }
+    std::lock_guard<std::mutex> lock(blob_lock_for(content_key));
+    return link_into_blob_store_locked(storage_path, content_key, tenant);
+}
+
+Result<void> Storage::replace_with_link(const std::string& blob_path, const std::string& full_path) {
+    std::string dir_path = std::filesystem::path(full_path).parent_path();
+    std::string link_path = make_temp_path(full_path);
+
+    // Same directory-pruning race as write_file_atomic: retry after recreating.
+    std::error_code ec;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        auto dir_result = ensure_directory_exists(dir_path);
+        if (!dir_result.success) {
+            return dir_result;
+        }
+        std::filesystem::create_hard_link(blob_path, link_path, ec);
+        if (ec != std::errc::no_such_file_or_directory || !std::filesystem::exists(blob_path)) break;
+    }
+    if (ec) {
+        return Result<void>::err("Failed to link blob " + blob_path + ": " + ec.message());
+    }
+
+    // rename() is atomic, so readers never see the version path missing.
+    std::filesystem::rename(link_path, full_path, ec);
+    if (ec) {
+        std::error_code ignored;
+        std::filesystem::remove(link_path, ignored);
+        return Result<void>::err("Failed to replace " + full_path + " with blob link: " + ec.message());
+    }
+    // The blob's data is already durable; only the new entry needs flushing.
+    return sync_directory(dir_path);
+}
+
+Result<void> Storage::link_into_blob_store_locked(const std::string& full_path, const std::string& content_key,
+                                                  const std::string& tenant) {
+    std::string blob_path = get_blob_path(content_key, tenant);
+    auto dir_result = ensure_directory_exists(std::filesystem::path(blob_path).parent_path());
+    if (!dir_result.success) {
+        return dir_result;
+    }
+
+    // First copy of this content: the version file becomes the blob.
+    std::error_code ec;
+    std::filesystem::create_hard_link(full_path, blob_path, ec);
+    if (!ec) {
+        // Best-effort: without xattr support unreferenced blobs are reclaimed
+        // by collect_unreferenced_blobs() instead of on delete.
+        ::setxattr(blob_path.c_str(), kBlobPathXattr, blob_path.data(), blob_path.size(), 0);
+        return Result<void>::ok();
+    }
+    if (ec != std::errc::file_exists) {
+        return Result<void>::err("Failed to link blob " + blob_path + ": " + ec.message());
+    }
+
+    // Content already stored: replace this copy with a link to the shared blob.
+    return replace_with_link(blob_path, full_path);
+}
+
+Result<size_t> Storage::collect_unreferenced_blobs(const std::string& tenant) {
+    if (!deduplicate_) {
+        return Result<size_t>::ok(0);
+    }
+
+    // Blob stores to sweep: the given tenant's, or every tenant's plus the
+    // tenant-less one under the base path.
+    std::vector<std::filesystem::path> roots;
+    std::error_code ec;
+    if (!tenant.empty()) {
+        roots.push_back(std::filesystem::path(base_path_) / tenant / kBlobDirName);
+    } else {
+        roots.push_back(std::filesystem::path(base_path_) / kBlobDirName);
+        for (const auto& entry : std::filesystem::directory_iterator(base_path_, ec)) {
+            if (entry.is_directory() && entry.path().filename() != kBlobDirName) {
+                roots.push_back(entry.path() / kBlobDirName);
+            }
+        }
+    }
+
+    size_t removed = 0;
+    try {
+        for (const auto& root : roots) {
+            if (!std::filesystem::is_directory(root, ec)) continue;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+                if (!entry.is_regular_file()) continue;
+                std::lock_guard<std::mutex> lock(blob_lock_for(entry.path().filename().string()));
+                struct stat st;
+                // Link count 1 = only the blob entry itself; no version uses it.
+                if (::lstat(entry.path().c_str(), &st) == 0 && st.st_nlink == 1) {
+                    if (std::filesystem::remove(entry.path(), ec)) ++removed;
+                }
+            }
+        }
+    } catch (const std::exception& ex) {
+        return Result<size_t>::err("Failed to collect unreferenced blobs: " + std::string(ex.what()));
+    }
+    return Result<size_t>::ok(removed);
+}
+
 Result<void> Storage::ensure_directory_exists(const std::string& dir_path) {
     try {
         std::filesystem::create_directories(dir_path);
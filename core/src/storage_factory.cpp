@@ -0,0 +1,62 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "storage_factory.h"
+
+#include "server_logger.h"
+
+#ifdef FILEENGINE_HAS_IO_URING
+#include "uring_storage.h"
+#endif
+
+namespace fileengine {
+
+namespace {
+
+std::unique_ptr<Storage> with_packing(std::unique_ptr<Storage> storage, const PackedStoreOptions& packing) {
+    if (packing.threshold > 0) {
+        auto result = storage->enable_packing(packing);
+        if (!result.success) {
+            SERVER_LOG_WARN("Storage", "Small-blob packing disabled: " + result.error);
+        }
+    }
+    return storage;
+}
+
+} // namespace
+
+std::unique_ptr<Storage> make_local_storage(const std::string& base_path, bool encrypt_data, bool compress_data,
+                                            bool deduplicate, StorageSyncMode sync_mode,
+                                            const std::string& io_backend, const PackedStoreOptions& packing) {
+    if (io_backend == "uring") {
+#ifdef FILEENGINE_HAS_IO_URING
+        auto storage = std::make_unique<UringStorage>(base_path, encrypt_data, compress_data, deduplicate, sync_mode);
+        if (storage->is_active()) {
+            SERVER_LOG_INFO("Storage", "io_uring read path enabled for " + base_path);
+        } else {
+            SERVER_LOG_WARN("Storage", "io_uring unavailable on this kernel; using blocking reads for " + base_path);
+        }
+        return with_packing(std::move(storage), packing);
+#else
+        SERVER_LOG_WARN("Storage",
+                        "FILEENGINE_STORAGE_IO=uring but core was built without io_uring support "
+                        "(FILEENGINE_ENABLE_IO_URING=OFF); using blocking reads");
+#endif
+    }
+    return with_packing(std::make_unique<Storage>(base_path, encrypt_data, compress_data, deduplicate, sync_mode),
+                        packing);
+}
+
+} // namespace fileengine
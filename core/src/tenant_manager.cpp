@@ -16,7 +16,9 @@
 #include "fileengine/tenant_manager.h"
 #include "fileengine/database.h"
 #include "fileengine/storage.h"
+#include "fileengine/storage_factory.h"
 #include "fileengine/s3_storage.h"
+#include "fileengine/server_logger.h"
 
 namespace fileengine {
 
@@ -136,11 +138,19 @@ TenantContext* TenantManager::create_tenant_context(const std::string& tenant_id
             // Log the error but continue - some operations might still work
         }
 
-        // Create storage instance for the tenant
-        auto storage = std::make_unique<Storage>(
+        // Create storage instance for the tenant. Storages over one base path
+        // share its pack segments (PackedStore::open).
+        PackedStoreOptions packing;
+        packing.threshold = config_.storage_pack_threshold;
+        packing.compact_interval_seconds = config_.storage_pack_compact_seconds;
+        auto storage = make_local_storage(
             config_.storage_base_path,
             config_.encrypt_data,
-            config_.compress_data
+            config_.compress_data,
+            config_.storage_deduplicate,
+            Storage::parse_sync_mode(config_.storage_sync_mode),
+            config_.storage_io_backend,
+            packing
         );
 
         // Create object store instance
@@ -166,6 +176,19 @@ TenantContext* TenantManager::create_tenant_context(const std::string& tenant_id
         context->object_store = std::move(object_store);
         context->storage_tracker = storage_tracker_;
         context->config = config_;  // Copy the tenant configuration
+        if (config_.compress_data) {
+            // An unknown or compiled-out codec falls back to zlib, so
+            // compression is never silently dropped.
+            auto codec_result = Codec::from_spec(config_.storage_codec);
+            if (codec_result.success && codec_result.value) {
+                context->codec = codec_result.value;
+            } else {
+                SERVER_LOG_WARN("TenantManager", (codec_result.success
+                                    ? std::string("Codec 'none' with compression enabled")
+                                    : codec_result.error) + "; using zlib");
+                context->codec = Codec::make(CodecId::Zlib);
+            }
+        }
 
         // Create the tenant directory in storage if it doesn't exist
         if (!tenant_id.empty() && tenant_id != "default") {
@@ -0,0 +1,586 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "fileengine/uring_storage.h"
+#include "fileengine/server_logger.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace fileengine {
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// Where a caller sleeps until its reads complete. Shared by all reads of
+// one request so a batch costs one wakeup per completion, not one cv each.
+struct IoWaiter {
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+// One submitted read; `res` is the CQE result (bytes read or -errno).
+struct IoOp {
+    IoWaiter* waiter = nullptr;
+    int32_t res = 0;
+    bool done = false;
+};
+
+struct ReadRequest {
+    int fd;
+    uint64_t offset;
+    uint8_t* dst;
+    uint32_t len;
+    int buffer_index;  // registered buffer holding `dst`, or -1
+    IoOp* op;
+};
+
+// Finish `op` with `res`. Notifies under the lock: the waiter may destroy
+// the IoWaiter as soon as it observes done.
+void complete_op(IoOp* op, int32_t res) {
+    std::lock_guard<std::mutex> lock(op->waiter->mutex);
+    op->res = res;
+    op->done = true;
+    op->waiter->cv.notify_all();
+}
+
+void wait_op(IoOp& op) {
+    std::unique_lock<std::mutex> lock(op.waiter->mutex);
+    op.waiter->cv.wait(lock, [&] { return op.done; });
+}
+
+// Fill [dst+done, dst+len) with blocking pread; used to finish short reads.
+bool pread_fully(int fd, uint8_t* dst, size_t len, uint64_t offset, size_t done) {
+    while (done < len) {
+        ssize_t n = ::pread(fd, dst + done, len - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;  // error, or the file shrank under us
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// A single io_uring instance shared by every UringStorage with the same
+// options, so per-tenant storages do not each pin their own buffer pool.
+// Submissions are serialized by submit_mutex_ (the SQ has one producer at a
+// time); completions are drained by the reaper thread, the only CQ consumer.
+// In-flight I/Os are capped at the SQ size, so the CQ (twice as large)
+// cannot overflow.
+class UringStorage::Ring {
+public:
+    ~Ring();
+
+    // The ring for `options`, set up on first use; null (with `error` set)
+    // when io_uring is unavailable.
+    static std::shared_ptr<Ring> shared(const UringStorageOptions& options, std::string& error);
+
+    // Set up the ring, its reaper thread and registered buffers. On failure
+    // returns false and the object must be discarded.
+    bool init(const UringStorageOptions& options, std::string& error);
+
+    // Queue `count` reads in as few io_uring_enter calls as the in-flight cap
+    // allows. Every op ends up completed: by the kernel, or with -errno here.
+    void submit(const ReadRequest* reads, size_t count);
+
+    // Registered buffer pool. try_acquire_buffer returns -1 when none is
+    // free; callers fall back to their own memory rather than wait.
+    int try_acquire_buffer();
+    void release_buffer(int index);
+    uint8_t* buffer(int index) const { return arena_ + static_cast<size_t>(index) * buffer_size_; }
+    bool buffers_registered() const { return buffers_registered_; }
+
+private:
+    void reap_loop();
+    void fill_sqe(unsigned slot, const ReadRequest& read);
+
+    int fd_ = -1;
+    unsigned entries_ = 0;
+
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::mutex submit_mutex_;
+    std::condition_variable slot_cv_;
+    unsigned in_flight_ = 0;
+    std::thread reaper_;
+
+    uint8_t* arena_ = nullptr;
+    size_t arena_size_ = 0;
+    size_t buffer_size_ = 0;
+    bool buffers_registered_ = false;
+    std::mutex buffer_mutex_;
+    std::vector<int> free_buffers_;
+};
+
+bool UringStorage::Ring::init(const UringStorageOptions& options, std::string& error) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = sys_io_uring_setup(std::max(1u, options.queue_depth), &params);
+    if (fd_ < 0) {
+        error = std::string("io_uring_setup: ") + std::strerror(errno);
+        return false;
+    }
+    entries_ = params.sq_entries;
+
+    // Plain and fixed-buffer reads need 5.6+; probe rather than trust uname.
+    std::vector<uint8_t> probe_mem(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(probe_mem.data());
+    if (sys_io_uring_register(fd_, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+        probe->last_op < IORING_OP_READ ||
+        !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) ||
+        !(probe->ops[IORING_OP_READ_FIXED].flags & IO_URING_OP_SUPPORTED)) {
+        error = "io_uring lacks IORING_OP_READ (kernel too old)";
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                      IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        error = std::string("mmap SQ ring: ") + std::strerror(errno);
+        return false;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                          IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            error = std::string("mmap CQ ring: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                        IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        error = std::string("mmap SQEs: ") + std::strerror(errno);
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<uint8_t*>(sq_ring_);
+    auto* cq = static_cast<uint8_t*>(cq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Buffer pool. Registration pins the pages once instead of per I/O and
+    // counts against RLIMIT_MEMLOCK (8 MiB by default), as do the rings
+    // themselves on older kernels, so the pool is trimmed to what is left.
+    // If registration still fails the same buffers are used with plain reads.
+    buffer_size_ = options.buffer_size;
+    size_t count = std::max<size_t>(1, options.buffer_count);
+    struct rlimit memlock;
+    if (::getrlimit(RLIMIT_MEMLOCK, &memlock) == 0 && memlock.rlim_cur != RLIM_INFINITY) {
+        const size_t rings = sq_ring_size_ + (cq_ring_ == sq_ring_ ? 0 : cq_ring_size_) + sqes_size_;
+        const size_t budget = memlock.rlim_cur > rings ? static_cast<size_t>(memlock.rlim_cur) - rings : 0;
+        const size_t fits = budget / buffer_size_;
+        if (fits < count) {
+            SERVER_LOG_WARN("Storage", "io_uring buffer pool cut from " + std::to_string(count) + " to " +
+                                           std::to_string(std::max<size_t>(1, fits)) +
+                                           " buffers to fit RLIMIT_MEMLOCK (" +
+                                           std::to_string(memlock.rlim_cur) + " bytes)");
+            count = std::max<size_t>(1, fits);
+        }
+    }
+    arena_size_ = count * buffer_size_;
+    void* arena = ::mmap(nullptr, arena_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+        error = std::string("mmap read buffers: ") + std::strerror(errno);
+        return false;
+    }
+    arena_ = static_cast<uint8_t*>(arena);
+    std::vector<iovec> iovs(count);
+    for (size_t i = 0; i < count; ++i) {
+        iovs[i].iov_base = buffer(static_cast<int>(i));
+        iovs[i].iov_len = buffer_size_;
+        free_buffers_.push_back(static_cast<int>(i));
+    }
+    buffers_registered_ =
+        sys_io_uring_register(fd_, IORING_REGISTER_BUFFERS, iovs.data(), static_cast<unsigned>(count)) == 0;
+    if (!buffers_registered_) {
+        SERVER_LOG_WARN("Storage", std::string("io_uring buffer registration failed (") + std::strerror(errno) +
+                                       "); streamed reads use unregistered buffers");
+    }
+
+    reaper_ = std::thread(&Ring::reap_loop, this);
+    return true;
+}
+
+std::shared_ptr<UringStorage::Ring> UringStorage::Ring::shared(const UringStorageOptions& options,
+                                                               std::string& error) {
+    static std::mutex registry_mutex;
+    static std::map<std::tuple<unsigned, size_t, size_t>, std::weak_ptr<Ring>> registry;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[std::make_tuple(options.queue_depth, options.buffer_count, options.buffer_size)];
+    if (auto ring = slot.lock()) {
+        return ring;
+    }
+    auto ring = std::make_shared<Ring>();
+    if (!ring->init(options, error)) {
+        return nullptr;
+    }
+    slot = ring;
+    return ring;
+}
+
+UringStorage::Ring::~Ring() {
+    if (reaper_.joinable()) {
+        // A NOP with user_data 0 tells the reaper to exit once it is drained.
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        unsigned tail = *sq_tail_;
+        unsigned slot = tail & sq_mask_;
+        std::memset(&sqes_[slot], 0, sizeof(io_uring_sqe));
+        sqes_[slot].opcode = IORING_OP_NOP;
+        sq_array_[slot] = slot;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        while (sys_io_uring_enter(fd_, 1, 0, 0) < 0 && errno == EINTR) {}
+    }
+    if (reaper_.joinable()) reaper_.join();
+
+    if (arena_) ::munmap(arena_, arena_size_);
+    if (sqes_) ::munmap(sqes_, sqes_size_);
+    if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_) ::munmap(sq_ring_, sq_ring_size_);
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void UringStorage::Ring::fill_sqe(unsigned slot, const ReadRequest& read) {
+    io_uring_sqe& sqe = sqes_[slot];
+    std::memset(&sqe, 0, sizeof(sqe));
+    const bool fixed = read.buffer_index >= 0 && buffers_registered_;
+    sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = read.fd;
+    sqe.off = read.offset;
+    sqe.addr = reinterpret_cast<uint64_t>(read.dst);
+    sqe.len = read.len;
+    if (fixed) sqe.buf_index = static_cast<uint16_t>(read.buffer_index);
+    sqe.user_data = reinterpret_cast<uint64_t>(read.op);
+    sq_array_[slot] = slot;
+}
+
+void UringStorage::Ring::submit(const ReadRequest* reads, size_t count) {
+    std::unique_lock<std::mutex> lock(submit_mutex_);
+    size_t next = 0;
+    while (next < count) {
+        slot_cv_.wait(lock, [&] { return in_flight_ < entries_; });
+        const unsigned batch = static_cast<unsigned>(std::min<size_t>(count - next, entries_ - in_flight_));
+
+        // Only submit() writes the SQ tail, and without SQPOLL the kernel
+        // consumes entries only inside io_uring_enter, so the ring is empty here.
+        const unsigned tail = *sq_tail_;
+        for (unsigned i = 0; i < batch; ++i) {
+            fill_sqe((tail + i) & sq_mask_, reads[next + i]);
+        }
+        __atomic_store_n(sq_tail_, tail + batch, __ATOMIC_RELEASE);
+
+        unsigned submitted = 0;
+        int error = 0;
+        while (submitted < batch) {
+            int rc = sys_io_uring_enter(fd_, batch - submitted, 0, 0);
+            if (rc < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) continue;
+            if (rc <= 0) {
+                error = rc < 0 ? errno : EIO;
+                break;
+            }
+            submitted += static_cast<unsigned>(rc);
+        }
+        in_flight_ += submitted;
+        next += submitted;
+
+        if (error != 0) {
+            // Withdraw what the kernel did not take and fail those reads
+            // along with the rest of the request.
+            __atomic_store_n(sq_tail_, tail + submitted, __ATOMIC_RELEASE);
+            lock.unlock();
+            for (; next < count; ++next) complete_op(reads[next].op, -error);
+            return;
+        }
+    }
+}
+
+void UringStorage::Ring::reap_loop() {
+    bool stopping = false;
+    while (!stopping) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (sys_io_uring_enter(fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN &&
+                errno != EBUSY) {
+                return;  // ring unusable; nothing more will complete
+            }
+            continue;
+        }
+
+        unsigned reaped = 0;
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data == 0) {
+                stopping = true;
+                continue;
+            }
+            complete_op(reinterpret_cast<IoOp*>(cqe.user_data), cqe.res);
+            ++reaped;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+        if (reaped > 0) {
+            std::lock_guard<std::mutex> lock(submit_mutex_);
+            in_flight_ -= reaped;
+            slot_cv_.notify_all();
+        }
+    }
+}
+
+int UringStorage::Ring::try_acquire_buffer() {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    if (free_buffers_.empty()) {
+        return -1;
+    }
+    int index = free_buffers_.back();
+    free_buffers_.pop_back();
+    return index;
+}
+
+void UringStorage::Ring::release_buffer(int index) {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    free_buffers_.push_back(index);
+}
+
+UringStorage::UringStorage(const std::string& base_path, bool encrypt_data, bool compress_data, bool deduplicate,
+                           StorageSyncMode sync_mode, const UringStorageOptions& options)
+    : Storage(base_path, encrypt_data, compress_data, deduplicate, sync_mode), options_(options) {
+    options_.buffer_size = std::max<size_t>(4096, options_.buffer_size);
+    options_.read_ahead = std::max<size_t>(1, options_.read_ahead);
+
+    std::string error;
+    ring_ = Ring::shared(options_, error);
+}
+
+UringStorage::~UringStorage() = default;
+
+Result<std::vector<uint8_t>> UringStorage::read_file(const std::string& storage_path, const std::string& tenant) {
+    // Packed blobs are a single small pread; no point batching them.
+    if (!ring_ || is_packed(storage_path)) {
+        return Storage::read_file(storage_path, tenant);
+    }
+
+    int fd = ::open(storage_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return Result<std::vector<uint8_t>>::err("Failed to open file for reading: " + storage_path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return Result<std::vector<uint8_t>>::err("Failed to stat file: " + storage_path);
+    }
+
+    // Read straight into the result, all chunks submitted as one batch.
+    const size_t size = static_cast<size_t>(st.st_size);
+    const size_t chunk = options_.buffer_size;
+    std::vector<uint8_t> data(size);
+    IoWaiter waiter;
+    std::vector<IoOp> ops((size + chunk - 1) / chunk);
+    std::vector<ReadRequest> reads;
+    reads.reserve(ops.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        ops[i].waiter = &waiter;
+        const size_t offset = i * chunk;
+        reads.push_back({fd, offset, data.data() + offset,
+                         static_cast<uint32_t>(std::min(chunk, size - offset)), -1, &ops[i]});
+    }
+    ring_->submit(reads.data(), reads.size());
+
+    bool ok = true;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        wait_op(ops[i]);
+        if (ok && ops[i].res >= 0 && static_cast<uint32_t>(ops[i].res) < reads[i].len) {
+            ok = pread_fully(fd, reads[i].dst, reads[i].len, reads[i].offset, static_cast<size_t>(ops[i].res));
+        } else if (ops[i].res < 0) {
+            ok = false;
+        }
+    }
+    ::close(fd);
+
+    if (!ok) {
+        return Result<std::vector<uint8_t>>::err("Failed to read file: " + storage_path);
+    }
+    return Result<std::vector<uint8_t>>::ok(std::move(data));
+}
+
+Result<void> UringStorage::read_file_chunks(const std::string& storage_path,
+                                           const std::function<bool(const uint8_t*, size_t)>& on_chunk,
+                                           const std::string& tenant) {
+    if (!ring_ || is_packed(storage_path)) {
+        return Storage::read_file_chunks(storage_path, on_chunk, tenant);
+    }
+
+    int fd = ::open(storage_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return Result<void>::err("Failed to open file for reading: " + storage_path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return Result<void>::err("Failed to stat file: " + storage_path);
+    }
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+    const size_t chunk = options_.buffer_size;
+    const uint64_t chunk_count = (size + chunk - 1) / chunk;
+
+    // A pipeline of read-ahead slots. Chunk c lives in slot c % depth; it is
+    // handed to on_chunk in place and refilled with chunk c + depth once
+    // on_chunk returns, while the other slots' reads stay in flight. A read
+    // goes into a registered buffer when one is free and into the slot's
+    // own heap buffer otherwise, so a busy pool never blocks a GET. A
+    // registered buffer goes back to the pool as soon as its chunk has been
+    // consumed, so a reader holds at most `depth` of them.
+    struct Slot {
+        int buffer = -1;
+        std::vector<uint8_t> heap;
+        uint64_t offset = 0;
+        uint32_t len = 0;
+        bool pending = false;
+        bool ok = true;
+        IoOp op;
+    };
+    IoWaiter waiter;
+    const size_t depth = static_cast<size_t>(std::min<uint64_t>(options_.read_ahead, chunk_count));
+    std::vector<Slot> slots(depth);
+
+    // Drain and release on every exit path, including on_chunk throwing:
+    // the kernel may still be writing into the buffers.
+    struct Cleanup {
+        Ring* ring;
+        std::vector<Slot>& slots;
+        int fd;
+        ~Cleanup() {
+            for (auto& slot : slots) {
+                if (slot.pending) wait_op(slot.op);
+                if (slot.buffer >= 0) ring->release_buffer(slot.buffer);
+            }
+            ::close(fd);
+        }
+    } cleanup{ring_.get(), slots, fd};
+
+    auto prepare = [&](Slot& slot, uint64_t index) -> ReadRequest {
+        slot.offset = index * chunk;
+        slot.len = static_cast<uint32_t>(std::min<uint64_t>(chunk, size - slot.offset));
+        slot.op = IoOp{};
+        slot.op.waiter = &waiter;
+        slot.pending = true;
+        slot.buffer = ring_->try_acquire_buffer();
+        uint8_t* dst;
+        if (slot.buffer >= 0) {
+            dst = ring_->buffer(slot.buffer);
+        } else {
+            slot.heap.resize(chunk);
+            dst = slot.heap.data();
+        }
+        return ReadRequest{fd, slot.offset, dst, slot.len, slot.buffer, &slot.op};
+    };
+
+    auto data = [&](Slot& slot) { return slot.buffer >= 0 ? ring_->buffer(slot.buffer) : slot.heap.data(); };
+
+    // Wait for the slot's read and finish a short one.
+    auto settle = [&](Slot& slot) {
+        if (!slot.pending) return;
+        wait_op(slot.op);
+        slot.pending = false;
+        slot.ok = slot.op.res >= 0 &&
+                  pread_fully(fd, data(slot), slot.len, slot.offset, static_cast<size_t>(slot.op.res));
+    };
+
+    std::vector<ReadRequest> initial;
+    for (size_t i = 0; i < depth; ++i) {
+        initial.push_back(prepare(slots[i], i));
+    }
+    ring_->submit(initial.data(), initial.size());
+
+    for (uint64_t c = 0; c < chunk_count; ++c) {
+        Slot& slot = slots[c % depth];
+        settle(slot);
+        if (!slot.ok) {
+            return Result<void>::err("Failed to read file: " + storage_path);
+        }
+        if (!on_chunk(data(slot), slot.len)) {
+            break;
+        }
+        if (slot.buffer >= 0) {
+            ring_->release_buffer(slot.buffer);
+            slot.buffer = -1;
+        }
+        if (c + depth < chunk_count) {
+            ReadRequest read = prepare(slot, c + depth);
+            ring_->submit(&read, 1);
+        }
+    }
+    return Result<void>::ok();
+}
+
+} // namespace fileengine
@@ -112,6 +112,7 @@ install -d -o fileengine -g fileengine -m 750 /var/log/fileengine
 %files -n fileengine-server
 %defattr(-,root,root,-)
 %attr(755,root,root) %{_bindir}/fileengine_server
+%attr(755,root,root) %{_bindir}/fileengine_rollup_backfill
 %config(noreplace) /etc/fileengine/core.conf
 %config(noreplace) /etc/logrotate.d/fileengine
 %{_unitdir}/fileengine.service
@@ -0,0 +1,278 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for AclCache, the cross-request cache of ACL rules and
+// permission decisions behind AclManager. Repeat checks must not reach the
+// database, and any grant, revoke or explicit invalidation must take effect
+// on the very next check: an entry computed before a change, or while one
+// was in flight, must never be served. Uses a counting mock database.
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/acl_cache.h"
+#include "fileengine/acl_manager.h"
+#include "fileengine/types.h"
+
+using namespace fileengine;
+
+class CountingDatabase : public IDatabase {
+public:
+    struct Node { std::string parent; bool is_dir; bool deleted; };
+    std::map<std::string, Node> tree_;
+    std::map<std::string, std::vector<AclEntry>> acls_;
+    int acl_reads = 0;
+    std::function<void()> during_acl_read;  // runs while an ACL read is "in flight"
+
+    void add_node(const std::string& uid, const std::string& parent, bool is_dir) {
+        tree_[uid] = Node{parent, is_dir, false};
+    }
+
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string& uid, const std::string& = "") override {
+        auto it = tree_.find(uid);
+        if (it == tree_.end()) return Result<std::optional<FileInfo>>::ok(std::nullopt);
+        FileInfo info;
+        info.uid = uid;
+        info.name = uid;
+        info.parent_uid = it->second.parent;
+        info.type = it->second.is_dir ? FileType::DIRECTORY : FileType::REGULAR_FILE;
+        info.deleted = it->second.deleted;
+        return Result<std::optional<FileInfo>>::ok(info);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string& uid, const std::string& tenant = "") override {
+        auto r = get_file_by_uid_include_deleted(uid, tenant);
+        if (r.value && r.value->deleted) return Result<std::optional<FileInfo>>::ok(std::nullopt);
+        return r;
+    }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string& resource_uid, const std::string& = "") override {
+        ++acl_reads;
+        std::vector<AclEntry> out;
+        auto it = acls_.find(resource_uid);
+        if (it != acls_.end()) out = it->second;
+        if (during_acl_read) {
+            auto hook = std::move(during_acl_read);
+            during_acl_read = nullptr;
+            hook();
+        }
+        return Result<std::vector<AclEntry>>::ok(out);
+    }
+    Result<void> add_acl(const std::string& r, const std::string& p, int t, int perm, const std::string& = "", const std::string& = "", int eff = 0) override {
+        AclEntry e;
+        e.resource_uid = r;
+        e.principal = p;
+        e.type = t;
+        e.permissions = perm;
+        e.effect = eff;
+        acls_[r].push_back(e);
+        return Result<void>::ok();
+    }
+    Result<void> remove_acl(const std::string& r, const std::string& p, int t, int, const std::string& = "", const std::string& = "", int = 0) override {
+        auto& rules = acls_[r];
+        for (auto it = rules.begin(); it != rules.end();) {
+            it = (it->principal == p && it->type == t) ? rules.erase(it) : it + 1;
+        }
+        return Result<void>::ok();
+    }
+    Result<std::vector<std::string>> get_roles_for_user(const std::string&, const std::string& = "") override {
+        return Result<std::vector<std::string>>::ok(std::vector<std::string>{});
+    }
+
+    // ---- everything below is an unused no-op for these tests ----
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> delete_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> assign_user_to_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> remove_user_from_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+static const int READ = static_cast<int>(Permission::READ);
+static const int WRITE = static_cast<int>(Permission::WRITE);
+
+// root ── F (dir) ── C (file); alice holds READ|WRITE on both
+struct Fixture {
+    std::shared_ptr<CountingDatabase> db = std::make_shared<CountingDatabase>();
+    std::shared_ptr<AclCache> cache = std::make_shared<AclCache>(100);
+    AclManager acl{db};
+
+    Fixture() {
+        db->add_node("F", "", true);
+        db->add_node("C", "F", false);
+        db->add_acl("F", "alice", static_cast<int>(PrincipalType::USER), READ | WRITE);
+        db->add_acl("C", "alice", static_cast<int>(PrincipalType::USER), READ | WRITE);
+        acl.set_acl_cache(cache);
+    }
+    bool can(int bits, const std::vector<std::string>& roles = {}) {
+        return acl.check_permission("C", "alice", roles, bits, "t").value;
+    }
+};
+
+static void test_repeat_checks_are_served_from_memory() {
+    std::cout << "test_repeat_checks_are_served_from_memory" << std::endl;
+    Fixture f;
+    assert(f.can(WRITE));
+    const int cold = f.db->acl_reads;
+    assert(cold > 0);
+    for (int i = 0; i < 5; ++i) {
+        assert(f.can(WRITE));
+        assert(f.can(READ));
+        assert(f.acl.get_effective_permissions("C", "alice", {}, "t").value == (READ | WRITE));
+    }
+    assert(f.db->acl_reads == cold);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_revoke_applies_to_the_next_check() {
+    std::cout << "test_revoke_applies_to_the_next_check" << std::endl;
+    Fixture f;
+    assert(f.can(WRITE));
+    f.acl.revoke_permission("C", "alice", PrincipalType::USER, READ | WRITE, "t");
+    f.acl.grant_permission("C", "alice", PrincipalType::USER, READ, "t");
+    assert(!f.can(WRITE));
+    assert(f.can(READ));
+
+    // A DENY READ on the folder hides everything beneath it.
+    f.acl.grant_permission("F", "alice", PrincipalType::USER, READ, "t", "", AclEffect::DENY);
+    assert(!f.can(READ));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_decisions_computed_during_a_change_are_not_cached() {
+    std::cout << "test_decisions_computed_during_a_change_are_not_cached" << std::endl;
+    Fixture f;
+    // The grant is removed, and the cache invalidated, after the check has
+    // read C's old rules: its (now wrong) answer must not be kept.
+    f.db->during_acl_read = [&] {
+        f.db->acls_["C"].clear();
+        f.db->add_acl("C", "alice", static_cast<int>(PrincipalType::USER), READ, "", "", 0);
+        f.acl.invalidate_cached_permissions("t");
+    };
+    assert(f.can(WRITE));
+    assert(!f.can(WRITE));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_principal_sets_are_cached_separately() {
+    std::cout << "test_principal_sets_are_cached_separately" << std::endl;
+    Fixture f;
+    f.db->add_acl("C", "editors", static_cast<int>(PrincipalType::ROLE), READ | WRITE | static_cast<int>(Permission::DELETE));
+    const int DELETE = static_cast<int>(Permission::DELETE);
+    assert(!f.can(DELETE));
+    assert(f.can(DELETE, {"editors", "viewers"}));
+    const int reads = f.db->acl_reads;
+    assert(f.can(DELETE, {"viewers", "editors"}));  // same set, other order
+    assert(!f.can(DELETE));
+    assert(f.db->acl_reads == reads);
+
+    assert(AclCache::principal_key("u", {"a", "b"}, {}) == AclCache::principal_key("u", {"b", "a"}, {}));
+    assert(AclCache::principal_key("u", {"ab"}, {}) != AclCache::principal_key("u", {"a", "b"}, {}));
+    assert(AclCache::principal_key("u", {}, {{"dept", "x"}}) != AclCache::principal_key("u", {}, {}));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_tree_changes_need_an_invalidation() {
+    std::cout << "test_tree_changes_need_an_invalidation" << std::endl;
+    Fixture f;
+    assert(f.can(READ));
+    f.db->tree_["F"].deleted = true;  // FileSystem::rmdir, then...
+    f.acl.invalidate_cached_permissions("t");
+    assert(!f.can(READ));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_generation_and_ttl() {
+    std::cout << "test_generation_and_ttl" << std::endl;
+    AclCache cache(100, std::chrono::milliseconds(20));
+    const uint64_t before = cache.generation("t");
+    cache.invalidate("t");
+    cache.put_permissions("t", "C", "k", CachedPermissions{READ, true}, before);  // stale fill
+    assert(!cache.get_permissions("t", "C", "k"));
+
+    cache.put_permissions("t", "C", "k", CachedPermissions{READ, true}, cache.generation("t"));
+    auto hit = cache.get_permissions("t", "C", "k");
+    assert(hit && hit->permissions == READ && hit->reachable);
+    assert(!cache.get_permissions("t", "C", "other"));
+    assert(!cache.get_rules("t", "C"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    assert(!cache.get_permissions("t", "C", "k"));
+
+    auto stats = cache.get_stats();
+    assert(stats.hits == 1 && stats.invalidations == 1);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_repeat_checks_are_served_from_memory();
+    test_revoke_applies_to_the_next_check();
+    test_decisions_computed_during_a_change_are_not_cached();
+    test_principal_sets_are_cached_separately();
+    test_tree_changes_need_an_invalidation();
+    test_generation_and_ttl();
+    std::cout << "All ACL cache tests passed!" << std::endl;
+    return 0;
+}
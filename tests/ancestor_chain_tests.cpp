@@ -0,0 +1,290 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for reachability checks over a materialized ancestor path
+// (IDatabase::get_ancestor_chain). AclManager must reach the same answers as
+// the level-by-level parent_uid walk, in a number of queries that does not
+// grow with depth, and must fall back to the walk when the path is missing
+// or disagrees with parent_uid. Uses a counting mock database.
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/acl_manager.h"
+#include "fileengine/metadata_cache.h"
+#include "fileengine/types.h"
+
+using namespace fileengine;
+
+class ChainDatabase : public IDatabase {
+public:
+    struct Node { std::string parent; bool deleted = false; std::vector<std::string> path; };
+    std::map<std::string, Node> tree_;
+    std::map<std::string, std::vector<AclEntry>> acls_;
+    bool materialized = true;
+    int queries = 0;
+
+    // `path` is maintained the way Database::insert_file does it
+    void add_node(const std::string& uid, const std::string& parent) {
+        Node n;
+        n.parent = parent;
+        auto p = tree_.find(parent);
+        if (p != tree_.end()) {
+            n.path = p->second.path;
+            n.path.push_back(parent);
+        }
+        tree_[uid] = n;
+    }
+    // Re-parent without touching any materialized path, as an older core would
+    void move_without_path(const std::string& uid, const std::string& parent) {
+        tree_[uid].parent = parent;
+    }
+    void deny_read(const std::string& uid) {
+        AclEntry e;
+        e.resource_uid = uid;
+        e.principal = "everyone";
+        e.type = static_cast<int>(PrincipalType::OTHER);
+        e.permissions = static_cast<int>(Permission::READ);
+        e.effect = static_cast<int>(AclEffect::DENY);
+        acls_[uid].push_back(e);
+    }
+
+    Result<std::optional<std::vector<AncestorEntry>>> get_ancestor_chain(const std::string& uid, const std::string& = "") override {
+        ++queries;
+        using Chain = std::optional<std::vector<AncestorEntry>>;
+        if (!materialized) return Result<Chain>::ok(std::nullopt);
+        std::vector<AncestorEntry> chain;
+        auto it = tree_.find(uid);
+        if (it == tree_.end()) return Result<Chain>::ok(chain);
+        std::vector<std::string> links{uid};
+        links.insert(links.end(), it->second.path.rbegin(), it->second.path.rend());
+        for (const auto& link : links) {
+            auto n = tree_.find(link);
+            if (n == tree_.end()) return Result<Chain>::ok(std::nullopt);
+            AncestorEntry e;
+            e.uid = link;
+            e.parent_uid = n->second.parent;
+            e.deleted = n->second.deleted;
+            e.parent_exists = tree_.count(n->second.parent) > 0;
+            e.acls = acls_[link];
+            chain.push_back(e);
+        }
+        return Result<Chain>::ok(chain);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string& uid, const std::string& = "") override {
+        ++queries;
+        auto it = tree_.find(uid);
+        if (it == tree_.end()) return Result<std::optional<FileInfo>>::ok(std::nullopt);
+        FileInfo info;
+        info.uid = uid;
+        info.name = uid;
+        info.parent_uid = it->second.parent;
+        info.type = FileType::DIRECTORY;
+        info.deleted = it->second.deleted;
+        return Result<std::optional<FileInfo>>::ok(info);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string& uid, const std::string& tenant = "") override {
+        auto r = get_file_by_uid_include_deleted(uid, tenant);
+        if (r.value && r.value->deleted) return Result<std::optional<FileInfo>>::ok(std::nullopt);
+        return r;
+    }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string& uid, const std::string& = "") override {
+        ++queries;
+        return Result<std::vector<AclEntry>>::ok(acls_[uid]);
+    }
+    Result<void> add_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<void> remove_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_roles_for_user(const std::string&, const std::string& = "") override {
+        return Result<std::vector<std::string>>::ok(std::vector<std::string>{});
+    }
+
+    // ---- everything below is an unused no-op for these tests ----
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> delete_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> assign_user_to_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> remove_user_from_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+static const int READ = static_cast<int>(Permission::READ);
+
+// d1 ── d2 ── ... ── d12 ── leaf
+static std::shared_ptr<ChainDatabase> deep_tree() {
+    auto db = std::make_shared<ChainDatabase>();
+    std::string parent;
+    for (int i = 1; i <= 12; ++i) {
+        const std::string uid = "d" + std::to_string(i);
+        db->add_node(uid, parent);
+        parent = uid;
+    }
+    db->add_node("leaf", parent);
+    return db;
+}
+
+static bool can_read(AclManager& acl, const std::string& uid) {
+    return acl.check_permission(uid, "alice", {}, READ, "t").value;
+}
+
+static void test_query_count_is_independent_of_depth() {
+    std::cout << "test_query_count_is_independent_of_depth" << std::endl;
+    auto db = deep_tree();
+    AclManager acl(db);
+    assert(can_read(acl, "leaf"));
+    const int with_path = db->queries;
+    assert(with_path <= 2);  // the resource's ACLs + the chain
+
+    db->queries = 0;
+    db->materialized = false;
+    assert(can_read(acl, "leaf"));
+    assert(db->queries > 20);  // walked one level at a time
+    std::cout << "  ok (" << with_path << " vs " << db->queries << " queries)" << std::endl;
+}
+
+static void test_same_answers_as_the_walk() {
+    std::cout << "test_same_answers_as_the_walk" << std::endl;
+    for (bool materialized : {true, false}) {
+        auto db = deep_tree();
+        db->materialized = materialized;
+        AclManager acl(db);
+        assert(can_read(acl, "leaf"));
+        assert(!acl.has_deleted_ancestor("leaf", "t"));
+
+        db->deny_read("d6");  // hides everything below d6, not d6 itself
+        assert(!can_read(acl, "leaf"));
+        assert(!can_read(acl, "d7"));
+        assert(!can_read(acl, "d6"));  // its own DENY
+        assert(can_read(acl, "d5"));
+        db->acls_.clear();
+
+        db->tree_["d3"].deleted = true;
+        assert(acl.has_deleted_ancestor("leaf", "t"));
+        assert(!can_read(acl, "leaf"));
+        assert(!acl.has_deleted_ancestor("d3", "t"));  // strict ancestors only
+        assert(can_read(acl, "d2"));
+
+        assert(can_read(acl, "missing"));  // bare resource, as before
+    }
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_stale_paths_are_walked() {
+    std::cout << "test_stale_paths_are_walked" << std::endl;
+    auto db = deep_tree();
+    db->add_node("hidden", "");
+    db->deny_read("hidden");
+    AclManager acl(db);
+    assert(can_read(acl, "leaf"));
+
+    // d10 moves under "hidden" but no path is rewritten: the chain still
+    // claims d9 is its parent, which the link check rejects
+    db->move_without_path("d10", "hidden");
+    assert(!can_read(acl, "leaf"));
+    assert(!can_read(acl, "d11"));
+
+    db->acls_.clear();
+    db->tree_["hidden"].deleted = true;
+    assert(acl.has_deleted_ancestor("leaf", "t"));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_chain_seeds_the_request_cache() {
+    std::cout << "test_chain_seeds_the_request_cache" << std::endl;
+    auto db = deep_tree();
+    AclManager acl(db);
+    AclManager::CacheScope scope(acl);
+    assert(can_read(acl, "leaf"));
+    db->queries = 0;
+    auto rules = acl.get_acls_for_resource("d4", "t");
+    assert(rules.success);
+    assert(db->queries == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_missing_resources_are_remembered() {
+    std::cout << "test_missing_resources_are_remembered" << std::endl;
+    auto db = deep_tree();
+    auto cache = std::make_shared<MetadataCache>(100, std::chrono::milliseconds(0), 16,
+                                                 std::chrono::milliseconds(1000));
+    AclManager acl(db);
+    acl.set_metadata_cache(cache);
+    assert(!acl.has_deleted_ancestor("lock.tmp", "t"));
+    const int cold = db->queries;
+    for (int i = 0; i < 10; ++i) {
+        assert(!acl.has_deleted_ancestor("lock.tmp", "t"));
+    }
+    assert(db->queries == cold);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_query_count_is_independent_of_depth();
+    test_same_answers_as_the_walk();
+    test_stale_paths_are_walked();
+    test_chain_seeds_the_request_cache();
+    test_missing_resources_are_remembered();
+    std::cout << "All ancestor chain tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,318 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for the framed blob container (BlobEncoder / BlobDecoder /
+// FramedBlobReader): round trips for every compress/encrypt combination and
+// chunking, random-access reads that touch only the covering frames,
+// detection of tampered, reordered and truncated frames, parallel encoding on
+// a WorkerPool, and decoding of blobs in the legacy single-stream format,
+// including legacy blobs whose bytes happen to start with the framed magic.
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/blob_format.h"
+#include "fileengine/crypto_utils.h"
+
+#include <openssl/evp.h>
+
+using fileengine::BlobDecoder;
+using fileengine::BlobEncoder;
+using fileengine::CryptoUtils;
+using fileengine::FramedBlobReader;
+using fileengine::Result;
+using fileengine::WorkerPool;
+
+// 32-byte key as 64 hex chars.
+static const std::string KEY = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+static const size_t FRAME = 4096;
+
+static std::vector<uint8_t> make_data(size_t n) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 31 + 7) & 0xff);
+    return v;
+}
+
+// Pseudo-random, so zlib cannot shrink it.
+static std::vector<uint8_t> make_noise(size_t n) {
+    std::vector<uint8_t> v(n);
+    uint32_t x = 2463534242u;
+    for (auto& b : v) { x ^= x << 13; x ^= x >> 17; x ^= x << 5; b = static_cast<uint8_t>(x); }
+    return v;
+}
+
+template <typename Stream>
+static std::vector<uint8_t> run_stream(Stream& s, const std::vector<uint8_t>& in, size_t chunk) {
+    std::vector<uint8_t> out, total;
+    for (size_t off = 0; off < in.size(); off += chunk) {
+        s.update(in.data() + off, std::min(chunk, in.size() - off), out);
+        total.insert(total.end(), out.begin(), out.end());
+    }
+    s.finish(out);
+    total.insert(total.end(), out.begin(), out.end());
+    return total;
+}
+
+static std::vector<uint8_t> decode_streaming(const std::vector<uint8_t>& blob, bool compress,
+                                             const std::string& key, size_t chunk) {
+    BlobDecoder decoder(compress, key);
+    return run_stream(decoder, blob, chunk);
+}
+
+static std::shared_ptr<FramedBlobReader> open_reader(const std::vector<uint8_t>& blob, const std::string& key,
+                                                     size_t* reads = nullptr) {
+    auto r = FramedBlobReader::open(blob.size(), [&blob, reads](uint64_t off, size_t len) {
+        if (reads) ++*reads;
+        if (off + len > blob.size()) return Result<std::vector<uint8_t>>::err("short read");
+        return Result<std::vector<uint8_t>>::ok(std::vector<uint8_t>(blob.begin() + off, blob.begin() + off + len));
+    }, key);
+    assert(r.success);
+    return r.value;
+}
+
+static void test_round_trip() {
+    std::cout << "framed: round trip for all modes and chunkings..." << std::endl;
+    const size_t sizes[] = {1, FRAME - 1, FRAME, FRAME + 1, 10 * FRAME + 123};
+    for (bool compress : {false, true}) {
+        for (const std::string& key : {std::string(), KEY}) {
+            for (size_t size : sizes) {
+                auto data = make_data(size);
+                auto blob = BlobEncoder::encode(data, compress, key, FRAME);
+                assert(FramedBlobReader::is_framed(blob.data(), blob.size()));
+
+                BlobEncoder encoder(compress, key, FRAME);
+                auto streamed = run_stream(encoder, data, 1000);
+                assert(BlobDecoder::decode(streamed, compress, key) == data);
+
+                assert(BlobDecoder::decode(blob, compress, key) == data);
+                for (size_t chunk : {size_t(1), size_t(17), size_t(FRAME), size_t(1 << 20)}) {
+                    assert(decode_streaming(blob, compress, key, chunk) == data);
+                }
+            }
+        }
+    }
+    // Empty content stays an empty blob.
+    assert(BlobEncoder::encode({}, true, KEY, FRAME).empty());
+    assert(BlobDecoder::decode({}, true, KEY).empty());
+}
+
+static void test_compression_and_raw_frames() {
+    std::cout << "framed: compressible data shrinks, noise is stored raw..." << std::endl;
+    auto text = make_data(20 * FRAME);
+    assert(BlobEncoder::encode(text, true, "", FRAME).size() < text.size() / 4);
+    // Deterministic without encryption, so deduplication by stored bytes works.
+    assert(BlobEncoder::encode(text, true, "", FRAME) == BlobEncoder::encode(text, true, "", FRAME));
+
+    auto noise = make_noise(20 * FRAME);
+    auto blob = BlobEncoder::encode(noise, true, KEY, FRAME);
+    // Raw frames cost only headers, IV, tag and index entries.
+    assert(blob.size() < noise.size() + 20 * 64 + 64);
+    assert(BlobDecoder::decode(blob, true, KEY) == noise);
+}
+
+static void test_random_access() {
+    std::cout << "framed: random-access reads decode only covering frames..." << std::endl;
+    auto data = make_data(25 * FRAME + 99);
+    auto blob = BlobEncoder::encode(data, true, KEY, FRAME);
+    size_t reads = 0;
+    auto reader = open_reader(blob, KEY, &reads);
+    assert(reader->size() == data.size());
+    assert(reader->frame_count() == 26);
+
+    struct Range { uint64_t off; size_t len; };
+    const Range ranges[] = {{0, 1}, {0, FRAME}, {FRAME - 1, 2}, {7 * FRAME + 5, 3 * FRAME},
+                            {data.size() - 10, 100}, {data.size(), 10}, {123, 0}};
+    for (const auto& r : ranges) {
+        auto got = reader->read(r.off, r.len);
+        assert(got.success);
+        size_t end = std::min<size_t>(data.size(), r.off + r.len);
+        size_t begin = std::min<size_t>(data.size(), r.off);
+        assert(got.value == std::vector<uint8_t>(data.begin() + begin, data.begin() + end));
+    }
+
+    reads = 0;
+    assert(reader->read(10 * FRAME + 1, 10).success);
+    assert(reads == 1);  // one frame record, nothing else
+}
+
+static void test_tamper_detection() {
+    std::cout << "framed: tampering, reordering and truncation are rejected..." << std::endl;
+    auto data = make_data(4 * FRAME);
+    for (const std::string& key : {std::string(), KEY}) {
+        auto blob = BlobEncoder::encode(data, true, key, FRAME);
+
+        // Flip one payload byte of the second frame: the streaming decoder
+        // must fail before releasing that frame's plaintext.
+        auto reader = open_reader(blob, key);
+        auto second = reader->read(FRAME, 1);
+        assert(second.success);
+        size_t flip = 0;
+        {
+            // Locate frame 1's payload via the header layout: 32-byte file
+            // header, then [16-byte record header | payload] per frame.
+            size_t off = 32;
+            uint32_t len0 = blob[off] | blob[off + 1] << 8 | blob[off + 2] << 16 | blob[off + 3] << 24;
+            flip = off + 16 + len0 + 16 + 5;
+        }
+        auto bad = blob;
+        bad[flip] ^= 0x40;
+        BlobDecoder decoder(true, key);
+        std::vector<uint8_t> out;
+        bool threw = false;
+        try {
+            decoder.update(bad.data(), bad.size(), out);
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(!open_reader(bad, key)->read(FRAME, 1).success);
+        assert(open_reader(bad, key)->read(0, FRAME).success);  // frame 0 is intact
+
+        // Truncation before the last frame.
+        std::vector<uint8_t> cut(blob.begin(), blob.begin() + static_cast<std::ptrdiff_t>(blob.size() / 2));
+        threw = false;
+        try { BlobDecoder::decode(cut, true, key); } catch (const std::exception&) { threw = true; }
+        assert(threw);
+        assert(!FramedBlobReader::open(cut.size(), [&](uint64_t off, size_t len) {
+            return Result<std::vector<uint8_t>>::ok(std::vector<uint8_t>(cut.begin() + off, cut.begin() + off + len));
+        }, key).success);
+    }
+
+    // Swapping two equal-length encrypted frames fails authentication even
+    // though each frame is individually valid.
+    auto noise = make_noise(3 * FRAME);
+    auto blob = BlobEncoder::encode(noise, false, KEY, FRAME);
+    const size_t rec = 16 + 12 + FRAME + 16;
+    auto swapped = blob;
+    std::copy(blob.begin() + 32, blob.begin() + 32 + rec, swapped.begin() + 32 + rec);
+    std::copy(blob.begin() + 32 + rec, blob.begin() + 32 + 2 * rec, swapped.begin() + 32);
+    bool threw = false;
+    try { BlobDecoder::decode(swapped, false, KEY); } catch (const std::exception&) { threw = true; }
+    assert(threw);
+
+    // An unencrypted framed blob is refused when a key is configured.
+    threw = false;
+    try { BlobDecoder::decode(BlobEncoder::encode(noise, true, "", FRAME), true, KEY); }
+    catch (const std::exception&) { threw = true; }
+    assert(threw);
+}
+
+static void test_parallel_encoding() {
+    std::cout << "framed: parallel encoding matches serial output..." << std::endl;
+    auto pool = std::make_shared<WorkerPool>(4);
+    const size_t sizes[] = {1, FRAME, FRAME + 1, 37 * FRAME + 5};
+    for (size_t size : sizes) {
+        auto data = make_data(size);
+        // Unencrypted output is deterministic: byte-identical to the serial encoder.
+        assert(BlobEncoder::encode(data, true, "", FRAME, pool) == BlobEncoder::encode(data, true, "", FRAME));
+
+        // Encrypted: the blob id is random, so check frames decode in order.
+        for (bool compress : {false, true}) {
+            BlobEncoder encoder(compress, KEY, FRAME, pool);
+            auto blob = run_stream(encoder, data, 3 * FRAME + 11);
+            assert(BlobDecoder::decode(blob, compress, KEY) == data);
+            auto reader = open_reader(blob, KEY);
+            assert(reader->frame_count() == (size + FRAME - 1) / FRAME);
+        }
+    }
+
+    // Several encoders sharing one pool, as concurrent uploads do.
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&pool, t] {
+            auto data = make_data(20 * FRAME + static_cast<size_t>(t));
+            BlobEncoder encoder(true, KEY, FRAME, pool);
+            assert(BlobDecoder::decode(run_stream(encoder, data, 5000), true, KEY) == data);
+        });
+    }
+    for (auto& w : writers) w.join();
+
+    // An encoder abandoned mid-stream waits for its frames before going away.
+    {
+        BlobEncoder encoder(true, KEY, FRAME, pool);
+        std::vector<uint8_t> out;
+        auto data = make_data(16 * FRAME);
+        encoder.update(data.data(), data.size(), out);
+    }
+}
+
+// A legacy AES-256-GCM blob (IV | ciphertext | tag, as CryptoUtils writes
+// it) with a chosen IV, so its first bytes can mimic a framed header.
+static std::vector<uint8_t> legacy_encrypt_with_iv(const std::vector<uint8_t>& data, const uint8_t (&iv)[12]) {
+    auto key = CryptoUtils::parse_aes256_key(KEY);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    std::vector<uint8_t> out(iv, iv + 12);
+    out.resize(12 + data.size() + 16);
+    int len = 0;
+    assert(EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key.data(), iv) == 1);
+    assert(EVP_EncryptUpdate(ctx, out.data() + 12, &len, data.data(), static_cast<int>(data.size())) == 1);
+    assert(EVP_EncryptFinal_ex(ctx, out.data() + 12 + len, &len) == 1);
+    assert(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, out.data() + 12 + data.size()) == 1);
+    EVP_CIPHER_CTX_free(ctx);
+    return out;
+}
+
+static void test_legacy_blobs() {
+    std::cout << "framed: legacy single-stream blobs still decode..." << std::endl;
+    auto data = make_data(50000);
+    auto legacy_both = CryptoUtils::encrypt_data(CryptoUtils::compress_data(data), KEY);
+    auto legacy_enc = CryptoUtils::encrypt_data(data, KEY);
+    auto legacy_zip = CryptoUtils::compress_data(data);
+
+    assert(!FramedBlobReader::is_framed(legacy_both.data(), legacy_both.size()));
+    assert(BlobDecoder::decode(legacy_both, true, KEY) == data);
+    assert(BlobDecoder::decode(legacy_enc, false, KEY) == data);
+    assert(BlobDecoder::decode(legacy_zip, true, "") == data);
+    for (size_t chunk : {size_t(1), size_t(3), size_t(4096)}) {
+        assert(decode_streaming(legacy_both, true, KEY, chunk) == data);
+        assert(decode_streaming(legacy_zip, true, "", chunk) == data);
+    }
+
+    // A legacy IV can start with the framed magic. With an invalid version
+    // the header is rejected up front; with a plausible header the framed
+    // decode fails later and decode() falls back.
+    const uint8_t bad_version[12] = {'F', 'E', 'F', 'R', 9, 1, 0, 0, 0, 0x10, 0, 0};
+    const uint8_t plausible[12] = {'F', 'E', 'F', 'R', 1, 1, 0, 0, 0, 0x10, 0, 0};
+    for (const auto* iv : {&bad_version, &plausible}) {
+        auto blob = legacy_encrypt_with_iv(CryptoUtils::compress_data(data), *iv);
+        assert(FramedBlobReader::is_framed(blob.data(), blob.size()));
+        assert(!FramedBlobReader::open(blob.size(), [&](uint64_t off, size_t len) {
+            return Result<std::vector<uint8_t>>::ok(std::vector<uint8_t>(blob.begin() + off, blob.begin() + off + len));
+        }, KEY).success);
+        assert(BlobDecoder::decode(blob, true, KEY) == data);
+        if (iv == &bad_version) assert(decode_streaming(blob, true, KEY, 7) == data);
+    }
+
+    // frame_size 0 keeps writing the legacy format.
+    auto written = BlobEncoder::encode(data, true, KEY, 0);
+    assert(!FramedBlobReader::is_framed(written.data(), written.size()));
+    assert(CryptoUtils::decompress_data(CryptoUtils::decrypt_data(written, KEY)) == data);
+}
+
+int main() {
+    test_round_trip();
+    test_compression_and_raw_frames();
+    test_random_access();
+    test_tamper_detection();
+    test_parallel_encoding();
+    test_legacy_blobs();
+    std::cout << "All blob format tests passed." << std::endl;
+    return 0;
+}
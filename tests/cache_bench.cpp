@@ -0,0 +1,131 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Concurrent lookup/insert throughput of CacheManager's keyed read cache.
+// Threads hit a shared, pre-filled key space with a read-mostly mix (one
+// insert per `--write-every` operations). Every thread count is run twice:
+// once with a single shard (one lock for the whole cache, the former
+// CacheManager layout) and once with the sharded default, so the table shows
+// how throughput scales with readers.
+//
+// Usage: cache_bench [--shards N] [--entries N] [--size-kb N] [--ops N]
+//                    [--write-every N] [--max-threads N]
+// Not a pass/fail test. Thread counts beyond the core count oversubscribe the
+// host, so measure scaling on a machine with at least --max-threads cores.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/cache_manager.h"
+
+using fileengine::CacheManager;
+
+struct BenchOptions {
+    size_t shards = 0;  // 0 = CacheManager's default for the host
+    size_t entries = 8192;
+    size_t size_kb = 4;
+    size_t ops_per_thread = 200000;
+    size_t write_every = 10;
+    size_t max_threads = 32;
+};
+
+static BenchOptions parse_args(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--shards") opt.shards = std::stoul(argv[i + 1]);
+        else if (arg == "--entries") opt.entries = std::stoul(argv[i + 1]);
+        else if (arg == "--size-kb") opt.size_kb = std::stoul(argv[i + 1]);
+        else if (arg == "--ops") opt.ops_per_thread = std::stoul(argv[i + 1]);
+        else if (arg == "--write-every") opt.write_every = std::max<size_t>(1, std::stoul(argv[i + 1]));
+        else if (arg == "--max-threads") opt.max_threads = std::stoul(argv[i + 1]);
+    }
+    return opt;
+}
+
+// Returns operations per second for `threads` workers against a cache with
+// `shards` shards (0 = default). The budget is the server default (or more,
+// for large key spaces) so every entry fits and the default shard count is
+// the one a server on this host would use.
+static double run_once(const BenchOptions& opt, size_t threads, size_t shards, size_t* shard_count) {
+    const size_t budget = std::max(CacheManager::kDefaultMaxCacheSize, opt.entries * opt.size_kb * 1024 * 4);
+    CacheManager cache(nullptr, nullptr, 0.8, budget, shards);
+    *shard_count = cache.shard_count();
+    const fileengine::SharedBlob payload =
+        std::make_shared<const std::vector<uint8_t>>(opt.size_kb * 1024, 0x5a);
+
+    std::vector<std::string> uids;
+    for (size_t i = 0; i < opt.entries; ++i) {
+        uids.push_back("uid-" + std::to_string(i));
+        cache.insert("bench", uids.back(), "v1", payload);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(t + 1);
+            std::uniform_int_distribution<size_t> pick(0, uids.size() - 1);
+            for (size_t i = 0; i < opt.ops_per_thread; ++i) {
+                const std::string& uid = uids[pick(rng)];
+                if (i % opt.write_every == 0) cache.insert("bench", uid, "v1", payload);
+                else cache.lookup("bench", uid, "v1");
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(threads * opt.ops_per_thread) / secs;
+}
+
+static std::string ratio(double r) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(2) << r << "x";
+    return ss.str();
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt = parse_args(argc, argv);
+    std::cout << "CacheManager lookup/insert throughput: " << opt.entries << " entries of "
+              << opt.size_kb << " KiB, 1 insert per " << opt.write_every << " ops, "
+              << opt.ops_per_thread << " ops/thread, " << std::thread::hardware_concurrency()
+              << " cores" << std::endl;
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(20) << "1 shard ops/s"
+              << std::setw(20) << "sharded ops/s" << std::setw(10) << "shards"
+              << std::setw(12) << "speedup" << "scaling" << std::endl;
+
+    double sharded_base = 0;
+    for (size_t threads = 1; threads <= opt.max_threads; threads *= 2) {
+        size_t one = 0, many = 0;
+        double single = run_once(opt, threads, 1, &one);
+        double sharded = run_once(opt, threads, opt.shards, &many);
+        if (threads == 1) sharded_base = sharded;
+        std::cout << std::left << std::fixed << std::setprecision(0)
+                  << std::setw(10) << threads
+                  << std::setw(20) << single << std::setw(20) << sharded << std::setw(10) << many
+                  << std::setw(12) << ratio(sharded / single) << ratio(sharded / sharded_base) << std::endl;
+    }
+    return 0;
+}
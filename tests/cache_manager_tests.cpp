@@ -0,0 +1,254 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Unit tests for the keyed read cache (CacheManager::lookup/insert). Entries
+// are keyed by (tenant, uid, version), bounded by the configured byte budget
+// and evicted least recently used first; the counters must track every hit,
+// miss and eviction. In-memory only; no storage, DB or object store.
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/cache_manager.h"
+
+using fileengine::CacheManager;
+using fileengine::CachePolicy;
+
+static std::vector<uint8_t> make_data(size_t n, uint8_t seed) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 31 + seed) & 0xff);
+    return v;
+}
+
+static fileengine::SharedBlob make_blob(size_t n, uint8_t seed) {
+    return std::make_shared<const std::vector<uint8_t>>(make_data(n, seed));
+}
+
+static void test_lookup_after_insert() {
+    std::cout << "test_lookup_after_insert" << std::endl;
+    CacheManager cache(nullptr, nullptr, 0.8, 1024 * 1024);
+
+    assert(cache.lookup("t1", "uid", "v1") == nullptr);
+    cache.insert("t1", "uid", "v1", make_blob(100, 1));
+    auto hit = cache.lookup("t1", "uid", "v1");
+    assert(hit != nullptr && *hit == make_data(100, 1));
+
+    // Every key component matters.
+    assert(cache.lookup("t2", "uid", "v1") == nullptr);
+    assert(cache.lookup("t1", "uid", "v2") == nullptr);
+    assert(cache.lookup("t1", "other", "v1") == nullptr);
+
+    // Replacing an entry keeps the accounting exact.
+    cache.insert("t1", "uid", "v1", make_blob(40, 2));
+    assert(*cache.lookup("t1", "uid", "v1") == make_data(40, 2));
+    assert(cache.get_cache_size_bytes() == 40);
+
+    cache.invalidate("t1", "uid", "v1");
+    assert(cache.lookup("t1", "uid", "v1") == nullptr);
+    assert(cache.get_cache_size_bytes() == 0);
+
+    auto stats = cache.get_stats();
+    assert(stats.hits == 2);
+    assert(stats.misses == 5);
+    assert(stats.insertions == 2);
+    assert(stats.evictions == 0);
+    assert(stats.entries == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_budget_evicts_lru() {
+    std::cout << "test_budget_evicts_lru" << std::endl;
+    // 8 KiB budget: 1 KiB entries fit eight at a time.
+    CacheManager cache(nullptr, nullptr, 0.8, 8 * 1024, 0, CachePolicy::Lru);
+    for (int i = 0; i < 8; ++i) {
+        cache.insert("t", "uid" + std::to_string(i), "v", make_blob(1024, i));
+    }
+    assert(cache.get_stats().entries == 8);
+
+    // Touch uid0 so uid1 becomes the least recently used.
+    assert(cache.lookup("t", "uid0", "v") != nullptr);
+    cache.insert("t", "uid8", "v", make_blob(1024, 8));
+
+    assert(cache.lookup("t", "uid0", "v") != nullptr);
+    assert(cache.lookup("t", "uid1", "v") == nullptr);
+    assert(cache.lookup("t", "uid8", "v") != nullptr);
+    auto stats = cache.get_stats();
+    assert(stats.evictions == 1);
+    assert(stats.size_bytes <= stats.max_bytes);
+    assert(stats.max_bytes == 8 * 1024);
+
+    // Shrinking the budget evicts down to it.
+    cache.set_max_cache_size_bytes(2 * 1024);
+    assert(cache.get_stats().entries == 2);
+    assert(cache.get_cache_size_bytes() <= 2 * 1024);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_oversized_entries_are_skipped() {
+    std::cout << "test_oversized_entries_are_skipped" << std::endl;
+    CacheManager cache(nullptr, nullptr, 0.8, 8 * 1024);
+    cache.insert("t", "small", "v", make_blob(512, 1));
+    // Over 1/8 of the budget: must not flush the small entry or be cached.
+    cache.insert("t", "large", "v", make_blob(2 * 1024, 2));
+    assert(cache.lookup("t", "large", "v") == nullptr);
+    assert(cache.lookup("t", "small", "v") != nullptr);
+    assert(cache.get_stats().insertions == 1);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_path_keyed_interface() {
+    std::cout << "test_path_keyed_interface" << std::endl;
+    CacheManager cache(nullptr, nullptr, 0.5, 4 * 1024);
+    assert(cache.add_file("/base/t/a", make_data(1024, 1), "t").success);
+    assert(cache.add_file("/base/t/b", make_data(1024, 2), "t").success);
+    assert(cache.is_cached("/base/t/a"));
+    assert(cache.get_file("/base/t/b", "t").value == make_data(1024, 2));
+
+    // Re-adding a path replaces it rather than counting it twice.
+    assert(cache.add_file("/base/t/a", make_data(1024, 3), "t").success);
+    assert(cache.get_cache_size_bytes() == 2048);
+    assert(!cache.add_file("/base/t/huge", make_data(8 * 1024, 4), "t").success);
+
+    // Cleanup evicts down to threshold * budget, oldest first.
+    assert(cache.cleanup_cache().success);
+    assert(cache.get_cache_size_bytes() <= 2048);
+    assert(cache.remove_file("/base/t/a").success);
+    assert(!cache.is_cached("/base/t/a"));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_sharded_concurrent_access() {
+    std::cout << "test_sharded_concurrent_access" << std::endl;
+    const size_t budget = 64 * 1024 * 1024;
+    CacheManager cache(nullptr, nullptr, 0.8, budget, 16);
+    assert(cache.shard_count() == 16);
+
+    // Writers and readers race on overlapping keys; every hit must return the
+    // bytes that were stored under that key.
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([&cache, t] {
+            for (int i = 0; i < 2000; ++i) {
+                const int k = (i * 7 + t) % 256;
+                const std::string uid = "uid" + std::to_string(k);
+                if (i % 3 == 0) {
+                    cache.insert("t", uid, "v", make_blob(4096, static_cast<uint8_t>(k)));
+                } else if (auto hit = cache.lookup("t", uid, "v")) {
+                    assert(*hit == make_data(4096, static_cast<uint8_t>(k)));
+                }
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    auto stats = cache.get_stats();
+    assert(stats.entries <= 256);
+    assert(stats.size_bytes == stats.entries * 4096);
+    assert(stats.hits + stats.misses == 8 * 2000 - 8 * 667);
+
+    // Each shard gets an equal slice of the budget and evicts within it.
+    for (int k = 0; k < 64; ++k) {
+        cache.insert("t", "big" + std::to_string(k), "v", make_blob(1024 * 1024, 1));
+    }
+    assert(cache.get_cache_size_bytes() <= budget);
+    std::cout << "  ok" << std::endl;
+}
+
+// Read through the cache the way FileSystem does: lookup, insert on a miss.
+static bool read_through(CacheManager& cache, const std::string& uid, size_t size) {
+    if (cache.lookup("t", uid, "v")) return true;
+    cache.insert("t", uid, "v", make_blob(size, 1));
+    return false;
+}
+
+static void test_tinylfu_resists_scans() {
+    std::cout << "test_tinylfu_resists_scans" << std::endl;
+    // 64 KiB, one shard: room for about sixty 1 KiB entries.
+    CacheManager lfu(nullptr, nullptr, 0.8, 64 * 1024, 1, CachePolicy::TinyLfu);
+    CacheManager lru(nullptr, nullptr, 0.8, 64 * 1024, 1, CachePolicy::Lru);
+    for (auto* cache : {&lfu, &lru}) {
+        for (int round = 0; round < 4; ++round) {
+            for (int i = 0; i < 32; ++i) read_through(*cache, "hot" + std::to_string(i), 1024);
+        }
+        // A one-pass scan of many more files than fit.
+        for (int i = 0; i < 500; ++i) read_through(*cache, "scan" + std::to_string(i), 1024);
+    }
+
+    int lfu_hot = 0, lru_hot = 0;
+    for (int i = 0; i < 32; ++i) {
+        if (lfu.lookup("t", "hot" + std::to_string(i), "v")) ++lfu_hot;
+        if (lru.lookup("t", "hot" + std::to_string(i), "v")) ++lru_hot;
+    }
+    assert(lfu_hot == 32);
+    assert(lru_hot == 0);
+    assert(lfu.get_stats().rejections > 0);
+    assert(lfu.get_cache_size_bytes() <= 64 * 1024);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_tinylfu_is_size_aware() {
+    std::cout << "test_tinylfu_is_size_aware" << std::endl;
+    CacheManager cache(nullptr, nullptr, 0.8, 64 * 1024, 1, CachePolicy::TinyLfu);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 60; ++i) read_through(cache, "small" + std::to_string(i), 1024);
+    }
+    // Admitting this would evict several popular entries for one read once.
+    read_through(cache, "large", 8 * 1024);
+    assert(cache.lookup("t", "large", "v") == nullptr);
+    for (int i = 0; i < 60; ++i) assert(cache.lookup("t", "small" + std::to_string(i), "v") != nullptr);
+
+    // Once it is read more often than they are, it gets in.
+    for (int round = 0; round < 6; ++round) read_through(cache, "large", 8 * 1024);
+    assert(cache.lookup("t", "large", "v") != nullptr);
+    assert(cache.get_cache_size_bytes() <= 64 * 1024);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_hits_share_the_buffer() {
+    std::cout << "test_hits_share_the_buffer" << std::endl;
+    CacheManager cache(nullptr, nullptr, 0.8, 1024 * 1024);
+    auto blob = make_blob(4096, 9);
+    cache.insert("t", "uid", "v", blob);
+
+    // Every hit is the inserted buffer itself, not a copy.
+    auto first = cache.lookup("t", "uid", "v");
+    auto second = cache.lookup("t", "uid", "v");
+    assert(first.get() == blob.get());
+    assert(second.get() == blob.get());
+
+    // A reader's reference outlives the entry.
+    cache.invalidate("t", "uid", "v");
+    assert(cache.lookup("t", "uid", "v") == nullptr);
+    assert(*first == make_data(4096, 9));
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_lookup_after_insert();
+    test_budget_evicts_lru();
+    test_oversized_entries_are_skipped();
+    test_path_keyed_interface();
+    test_sharded_concurrent_access();
+    test_tinylfu_resists_scans();
+    test_tinylfu_is_size_aware();
+    test_hits_share_the_buffer();
+    std::cout << "All cache manager tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Replays a file-access trace through CacheManager under each eviction policy
+// and reports hit ratios, to compare LRU with TinyLFU admission on real
+// workloads before changing FILEENGINE_CACHE_POLICY.
+//
+// Trace format: one read per line, "<key> <size_bytes>", where the key is
+// anything identifying a file version (e.g. "tenant/uid/version"); blank
+// lines and lines starting with '#' are skipped. Each read is a lookup, and
+// a miss inserts the file, as FileSystem::get does.
+//
+// Usage: cache_trace_replay [--trace FILE] [--budget-mb N[,N...]] [--shards N]
+//        cache_trace_replay --synthetic [--files N] [--reads N] [--scan-every N]
+// Without --trace, a synthetic trace is generated: Zipf-distributed reads of
+// --files small files, interrupted every --scan-every reads by a one-pass
+// scan of as many cold files (a sync job or crawler). Not a pass/fail test.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fileengine/cache_manager.h"
+
+using fileengine::CacheManager;
+using fileengine::CachePolicy;
+
+struct Access {
+    std::string key;
+    size_t size;
+};
+
+struct ReplayOptions {
+    std::string trace;
+    std::vector<size_t> budgets_mb = {16, 64, 256};
+    size_t shards = 1;  // one shard: policy differences, not sharding noise
+    size_t files = 20000;
+    size_t reads = 500000;
+    size_t scan_every = 50000;
+};
+
+static ReplayOptions parse_args(int argc, char* argv[]) {
+    ReplayOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--synthetic") continue;
+        if (i + 1 >= argc) break;
+        std::string value = argv[++i];
+        if (arg == "--trace") opt.trace = value;
+        else if (arg == "--shards") opt.shards = std::stoul(value);
+        else if (arg == "--files") opt.files = std::stoul(value);
+        else if (arg == "--reads") opt.reads = std::stoul(value);
+        else if (arg == "--scan-every") opt.scan_every = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--budget-mb") {
+            opt.budgets_mb.clear();
+            std::stringstream ss(value);
+            for (std::string part; std::getline(ss, part, ',');) opt.budgets_mb.push_back(std::stoul(part));
+        }
+    }
+    return opt;
+}
+
+static bool load_trace(const std::string& path, std::vector<Access>& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    for (std::string line; std::getline(in, line);) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ls(line);
+        Access a;
+        if (ls >> a.key >> a.size) out.push_back(std::move(a));
+    }
+    return true;
+}
+
+// Zipf(0.9) over `files` hot files of 4-64 KiB, plus periodic scans of
+// never-repeated cold files.
+static std::vector<Access> synthetic_trace(const ReplayOptions& opt) {
+    std::mt19937_64 rng(42);
+    std::vector<double> weights(opt.files);
+    for (size_t i = 0; i < opt.files; ++i) weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 0.9);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    std::uniform_int_distribution<size_t> size_kb(4, 64);
+    std::vector<size_t> sizes(opt.files);
+    for (auto& s : sizes) s = size_kb(rng) * 1024;
+
+    std::vector<Access> trace;
+    size_t cold = 0;
+    for (size_t i = 0; i < opt.reads; ++i) {
+        if (i > 0 && i % opt.scan_every == 0) {
+            for (size_t j = 0; j < opt.files; ++j) {
+                trace.push_back({"cold/" + std::to_string(cold++), size_kb(rng) * 1024});
+            }
+        }
+        size_t f = pick(rng);
+        trace.push_back({"hot/" + std::to_string(f), sizes[f]});
+    }
+    return trace;
+}
+
+struct ReplayResult {
+    double hit_ratio = 0;
+    double byte_hit_ratio = 0;
+    fileengine::CacheStats stats;
+};
+
+static ReplayResult replay(const std::vector<Access>& trace, size_t budget, size_t shards, CachePolicy policy) {
+    CacheManager cache(nullptr, nullptr, 0.8, budget, shards, policy);
+    uint64_t hits = 0, hit_bytes = 0, total_bytes = 0;
+    for (const auto& a : trace) {
+        total_bytes += a.size;
+        if (cache.lookup("trace", a.key, "")) {
+            ++hits;
+            hit_bytes += a.size;
+            continue;
+        }
+        cache.insert("trace", a.key, "", std::make_shared<const std::vector<uint8_t>>(a.size));
+    }
+    ReplayResult r;
+    r.hit_ratio = trace.empty() ? 0 : static_cast<double>(hits) / trace.size();
+    r.byte_hit_ratio = total_bytes ? static_cast<double>(hit_bytes) / total_bytes : 0;
+    r.stats = cache.get_stats();
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions opt = parse_args(argc, argv);
+    std::vector<Access> trace;
+    if (!opt.trace.empty()) {
+        if (!load_trace(opt.trace, trace)) {
+            std::cerr << "cannot read trace " << opt.trace << std::endl;
+            return 1;
+        }
+        std::cout << "Trace " << opt.trace << ": " << trace.size() << " reads" << std::endl;
+    } else {
+        trace = synthetic_trace(opt);
+        std::cout << "Synthetic trace: " << trace.size() << " reads, Zipf(0.9) over " << opt.files
+                  << " files, scan of " << opt.files << " cold files every " << opt.scan_every
+                  << " reads" << std::endl;
+    }
+
+    std::cout << std::left << std::setw(12) << "budget MB" << std::setw(10) << "policy"
+              << std::setw(12) << "hit ratio" << std::setw(14) << "byte hit" << std::setw(12) << "evictions"
+              << "rejections" << std::endl;
+    for (size_t mb : opt.budgets_mb) {
+        for (CachePolicy policy : {CachePolicy::Lru, CachePolicy::TinyLfu}) {
+            ReplayResult r = replay(trace, mb * 1024 * 1024, opt.shards, policy);
+            std::cout << std::left << std::fixed << std::setprecision(4)
+                      << std::setw(12) << mb << std::setw(10) << (policy == CachePolicy::Lru ? "lru" : "tinylfu")
+                      << std::setw(12) << r.hit_ratio << std::setw(14) << r.byte_hit_ratio
+                      << std::setw(12) << r.stats.evictions << r.stats.rejections << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for the frame codecs: "name[:level]" parsing, round trips for
+// every codec this build includes, refusal to expand incompressible input,
+// detection of compressed-format signatures and high-entropy content, and how
+// BlobEncoder applies all of it per frame (raw frames for media, compressed
+// frames for text, a clear error for a codec the build lacks).
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fileengine/blob_format.h"
+#include "fileengine/codec.h"
+
+using fileengine::BlobDecoder;
+using fileengine::BlobEncoder;
+using fileengine::Codec;
+using fileengine::CodecId;
+
+static const std::string KEY = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+static const size_t FRAME = 16 * 1024;
+
+// Repetitive text: compresses well, low entropy.
+static std::vector<uint8_t> make_text(size_t n) {
+    static const char* words[] = {"alpha ", "beta ", "gamma ", "delta\n", "epsilon ", "42 ", "1970 "};
+    std::vector<uint8_t> out;
+    uint32_t x = 7;
+    while (out.size() < n) {
+        x = x * 1103515245u + 12345u;
+        const char* w = words[(x >> 16) % 7];
+        out.insert(out.end(), w, w + std::strlen(w));
+    }
+    out.resize(n);
+    return out;
+}
+
+static std::vector<uint8_t> make_noise(size_t n) {
+    std::vector<uint8_t> v(n);
+    uint32_t x = 2463534242u;
+    for (auto& b : v) { x ^= x << 13; x ^= x >> 17; x ^= x << 5; b = static_cast<uint8_t>(x); }
+    return v;
+}
+
+static void test_spec_parsing() {
+    std::cout << "codec: spec parsing..." << std::endl;
+    auto zlib = Codec::from_spec("zlib");
+    assert(zlib.success && zlib.value && zlib.value->id() == CodecId::Zlib && zlib.value->level() == 6);
+    auto zlib9 = Codec::from_spec("ZLIB:9");
+    assert(zlib9.success && zlib9.value->level() == 9);
+    auto none = Codec::from_spec("none");
+    assert(none.success && !none.value);
+    assert(!Codec::from_spec("brotli").success);
+    assert(!Codec::from_spec("zlib:fast").success);
+
+    for (CodecId id : {CodecId::Zstd, CodecId::Lz4}) {
+        auto r = Codec::from_spec(std::string(Codec::name(id)) + ":3");
+        assert(r.success == Codec::available(id));
+        if (r.success) assert(r.value->id() == id);
+    }
+    assert(Codec::available(CodecId::None) && Codec::available(CodecId::Zlib));
+}
+
+static void test_round_trips() {
+    std::cout << "codec: round trips for built-in codecs..." << std::endl;
+    auto text = make_text(100000);
+    auto noise = make_noise(100000);
+    for (CodecId id : {CodecId::Zlib, CodecId::Zstd, CodecId::Lz4}) {
+        if (!Codec::available(id)) {
+            std::cout << "  (" << Codec::name(id) << " not built in, skipped)" << std::endl;
+            continue;
+        }
+        for (int level : {0, 1, 9}) {
+            auto codec = Codec::make(id, level);
+            std::vector<uint8_t> packed;
+            assert(codec->compress(text.data(), text.size(), packed));
+            assert(packed.size() < text.size() / 2);
+            std::vector<uint8_t> plain(text.size());
+            assert(codec->decompress(packed.data(), packed.size(), plain.data(), plain.size()));
+            assert(plain == text);
+            // Wrong expected length is rejected, not truncated.
+            std::vector<uint8_t> short_buf(text.size() - 1);
+            assert(!codec->decompress(packed.data(), packed.size(), short_buf.data(), short_buf.size()));
+            // Random bytes never come out smaller.
+            assert(!codec->compress(noise.data(), noise.size(), packed));
+        }
+    }
+}
+
+static void test_detection() {
+    std::cout << "codec: signature and entropy detection..." << std::endl;
+    const std::vector<std::string> media = {
+        std::string("\xFF\xD8\xFF\xE0", 4) + "JFIF",
+        "\x89PNG\r\n\x1A\n....",
+        std::string("\0\0\0\x18", 4) + "ftypmp42",
+        std::string("PK\x03\x04", 4) + "zipdata",
+        "\x1F\x8B\x08\x00gz",
+        std::string("\x28\xB5\x2F\xFD", 4) + "zst",
+    };
+    for (const auto& m : media) {
+        assert(fileengine::has_compressed_signature(reinterpret_cast<const uint8_t*>(m.data()), m.size()));
+    }
+    auto text = make_text(64 * 1024);
+    assert(!fileengine::has_compressed_signature(text.data(), text.size()));
+    assert(!fileengine::has_compressed_signature(text.data(), 0));
+
+    auto noise = make_noise(64 * 1024);
+    assert(fileengine::looks_incompressible(noise.data(), noise.size()));
+    assert(fileengine::looks_incompressible(noise.data(), 2000));
+    assert(!fileengine::looks_incompressible(text.data(), text.size()));
+    assert(!fileengine::looks_incompressible(noise.data(), 100));  // too small to judge
+    // Every byte value equally often, but periodic: flat histogram, yet
+    // highly compressible, so it must not be mistaken for noise.
+    std::vector<uint8_t> periodic(64 * 1024);
+    for (size_t i = 0; i < periodic.size(); ++i) periodic[i] = static_cast<uint8_t>((i * 31 + 7) & 0xff);
+    assert(!fileengine::looks_incompressible(periodic.data(), periodic.size()));
+}
+
+static void test_encoder_per_frame() {
+    std::cout << "codec: encoder stores media raw, compresses text..." << std::endl;
+    auto zlib = Codec::make(CodecId::Zlib);
+    auto text = make_text(8 * FRAME);
+
+    // Same compressible body, once behind a JPEG signature: the encoder
+    // trusts the signature and skips the codec for the whole blob.
+    auto jpeg = text;
+    std::memcpy(jpeg.data(), "\xFF\xD8\xFF\xE0", 4);
+    auto text_blob = BlobEncoder::encode(text, zlib, "", FRAME);
+    auto jpeg_blob = BlobEncoder::encode(jpeg, zlib, "", FRAME);
+    assert(text_blob.size() < text.size() / 2);
+    assert(jpeg_blob.size() > jpeg.size());
+    assert(BlobDecoder::decode(jpeg_blob, true, "") == jpeg);
+
+    // Mixed content: noise frames raw, text frames compressed, all decodable.
+    std::vector<uint8_t> mixed = make_text(3 * FRAME);
+    auto noise = make_noise(3 * FRAME);
+    mixed.insert(mixed.end(), noise.begin(), noise.end());
+    auto more = make_text(3 * FRAME);
+    mixed.insert(mixed.end(), more.begin(), more.end());
+    for (CodecId id : {CodecId::Zlib, CodecId::Zstd, CodecId::Lz4}) {
+        auto codec = Codec::make(id);
+        if (!codec) continue;
+        for (const std::string& key : {std::string(), KEY}) {
+            auto blob = BlobEncoder::encode(mixed, codec, key, FRAME);
+            assert(blob.size() < noise.size() + mixed.size() / 3);
+            assert(BlobDecoder::decode(blob, true, key) == mixed);
+        }
+    }
+}
+
+static void test_unavailable_codec() {
+    std::cout << "codec: frames with an unknown or missing codec fail..." << std::endl;
+    auto text = make_text(FRAME / 2);
+    auto blob = BlobEncoder::encode(text, Codec::make(CodecId::Zlib), "", FRAME);
+    const size_t codec_byte = 32 + 12;  // file header, then the record's codec field
+    assert(blob[codec_byte] == static_cast<uint8_t>(CodecId::Zlib));
+
+    blob[codec_byte] = static_cast<uint8_t>(CodecId::Zstd);  // not what the payload is
+    try {
+        BlobDecoder::decode(blob, true, "");
+        assert(false);
+    } catch (const std::runtime_error& e) {
+        if (!Codec::available(CodecId::Zstd)) assert(std::string(e.what()).find("zstd") != std::string::npos);
+    }
+
+    blob[codec_byte] = 0x7f;  // not a codec at all
+    try {
+        BlobDecoder::decode(blob, true, "");
+        assert(false);
+    } catch (const std::runtime_error&) {
+    }
+}
+
+int main() {
+    test_spec_parsing();
+    test_round_trips();
+    test_detection();
+    test_encoder_per_frame();
+    test_unavailable_codec();
+    std::cout << "All codec tests passed." << std::endl;
+    return 0;
+}
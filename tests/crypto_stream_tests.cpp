@@ -150,11 +150,25 @@ static void test_tag_tamper_detected() {
     std::cout << "  ok" << std::endl;
 }
 
+static void test_derived_keys() {
+    std::cout << "derive_key: stable per label, independent of the AES key..." << std::endl;
+    auto dedup = CryptoUtils::derive_key(KEY, "dedup");
+    assert(dedup.size() == 32);
+    assert(dedup == CryptoUtils::derive_key(KEY, "dedup"));
+    assert(dedup != CryptoUtils::derive_key(KEY, "other"));
+    auto raw = CryptoUtils::parse_aes256_key(KEY);
+    assert(dedup != std::string(raw.begin(), raw.end()));
+    // The same key in base64 derives the same subkey.
+    assert(dedup == CryptoUtils::derive_key("AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGxwdHh8=", "dedup"));
+    std::cout << "  ok" << std::endl;
+}
+
 int main() {
     test_compress_cross_compat();
     test_encrypt_cross_compat();
     test_full_pipeline();
     test_tag_tamper_detected();
+    test_derived_keys();
     std::cout << "All crypto streaming tests passed!" << std::endl;
     return 0;
 }
@@ -0,0 +1,127 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Stored folder rollup (files.subtree_vts / subtree_by) against a live
+// PostgreSQL: a new version raises it up the chain, a move and a delete
+// lower it again, and rebuild_folder_rollups (the backfill) recomputes the
+// same values from scratch. Works in a throwaway tenant dropped at exit.
+//
+// Connection settings come from FILEENGINE_PG_HOST/PORT/DATABASE/USER/PASSWORD;
+// exits 0 without testing when no server is reachable.
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <unistd.h>
+
+#include "fileengine/database.h"
+#include "fileengine/utils.h"
+
+using fileengine::Database;
+using fileengine::FileType;
+using fileengine::Utils;
+
+static std::string env_or(const char* name, const std::string& fallback) {
+    const char* v = std::getenv(name);
+    return (v && v[0]) ? std::string(v) : fallback;
+}
+
+static const std::string TENANT = "rollup_tests_" + std::to_string(::getpid());
+
+// (subtree_vts, subtree_by) of `uid`; by is "" when NULL.
+static std::pair<std::string, std::string> rollup(Database& db, const std::string& uid) {
+    auto rows = db.query("SELECT subtree_vts, COALESCE(subtree_by, '') FROM \"tenant_" + TENANT +
+                         "\".files WHERE uid = '" + uid + "';", TENANT);
+    assert(rows.success && rows.value.size() == 1);
+    return {rows.value[0][0], rows.value[0][1]};
+}
+
+static std::string add_folder(Database& db, const std::string& parent_uid, const std::string& name) {
+    const std::string uid = Utils::generate_uuid();
+    assert(db.insert_file(uid, name, "/" + name, parent_uid, FileType::DIRECTORY, "tests", 0755, TENANT).success);
+    return uid;
+}
+
+static std::string add_file(Database& db, const std::string& parent_uid, const std::string& name,
+                            const std::string& vts, const std::string& by) {
+    const std::string uid = Utils::generate_uuid();
+    assert(db.insert_file(uid, name, "/" + name, parent_uid, FileType::REGULAR_FILE, "tests", 0644, TENANT).success);
+    assert(db.insert_version(uid, vts, 1, "tests/" + uid, by, TENANT).success);
+    return uid;
+}
+
+int main() {
+    Database db(env_or("FILEENGINE_PG_HOST", "localhost"), std::stoi(env_or("FILEENGINE_PG_PORT", "5432")),
+                env_or("FILEENGINE_PG_DATABASE", "fileengine"), env_or("FILEENGINE_PG_USER", "fileengine_user"),
+                env_or("FILEENGINE_PG_PASSWORD", ""), 1);
+    if (!db.connect()) {
+        std::cout << "folder_rollup_tests: no PostgreSQL (set FILEENGINE_PG_*); skipping" << std::endl;
+        return 0;
+    }
+    auto global = db.create_schema();
+    assert(global.success && db.create_tenant_schema(TENANT).success);
+
+    using Rollup = std::pair<std::string, std::string>;
+    const Rollup none{"", ""};
+    const Rollup v1{"20260101_000001_000001", "alice"};
+    const Rollup v2{"20260101_000002_000002", "bob"};
+
+    // root -> a -> a1, root -> b
+    const std::string root = add_folder(db, "", "root");
+    const std::string a = add_folder(db, root, "a");
+    const std::string a1 = add_folder(db, a, "a1");
+    const std::string b = add_folder(db, root, "b");
+
+    std::cout << "rollup: a put raises every folder above the file..." << std::endl;
+    add_file(db, a1, "f1", v1.first, v1.second);
+    assert(rollup(db, a1) == v1 && rollup(db, a) == v1 && rollup(db, root) == v1);
+    assert(rollup(db, b) == none);
+    const std::string f2 = add_file(db, b, "f2", v2.first, v2.second);
+    assert(rollup(db, b) == v2 && rollup(db, root) == v2 && rollup(db, a) == v1);
+    std::cout << "  ok" << std::endl;
+
+    std::cout << "rollup: a move lowers the old chain and raises the new one..." << std::endl;
+    assert(db.update_file_parent(f2, a1, TENANT).success);
+    assert(rollup(db, b) == none);
+    assert(rollup(db, a1) == v2 && rollup(db, a) == v2 && rollup(db, root) == v2);
+    std::cout << "  ok" << std::endl;
+
+    std::cout << "rollup: a delete falls back to the next newest file..." << std::endl;
+    assert(db.delete_file(f2, TENANT).success);
+    assert(rollup(db, a1) == v1 && rollup(db, a) == v1 && rollup(db, root) == v1);
+    std::cout << "  ok" << std::endl;
+
+    std::cout << "rollup: the backfill recomputes the same values..." << std::endl;
+    const std::string files = "\"tenant_" + TENANT + "\".files";
+    assert(db.execute("UPDATE " + files + " SET subtree_vts = NULL, subtree_by = NULL "
+                      "WHERE is_container = TRUE;", TENANT).success);
+    auto missing = db.rebuild_folder_rollups(TENANT, true);
+    assert(missing.success && missing.value == 4);
+    assert(rollup(db, a1) == v1 && rollup(db, a) == v1 && rollup(db, root) == v1 && rollup(db, b) == none);
+
+    // Only the missing ones, then every folder.
+    assert(db.execute("UPDATE " + files + " SET subtree_vts = NULL WHERE uid = '" + a + "';", TENANT).success);
+    missing = db.rebuild_folder_rollups(TENANT, true);
+    assert(missing.success && missing.value == 1 && rollup(db, a) == v1);
+    auto all = db.rebuild_folder_rollups(TENANT, false);
+    assert(all.success && all.value == 4 && rollup(db, root) == v1);
+    std::cout << "  ok" << std::endl;
+
+    db.cleanup_tenant_data(TENANT);
+    db.disconnect();
+    std::cout << "All folder rollup tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Directory-listing latency against a live PostgreSQL. Seeds a throwaway
+// tenant with one directory holding --files files and --folders sub-folders
+// (each sub-folder holding --nested files, so every folder row has a subtree
+// mtime to compute), then times Database::list_files_in_directory and
+// list_files_in_directory_with_deleted. The tenant schema is dropped at exit.
+//
+// Usage: listing_bench [--host H] [--port N] [--dbname D] [--user U] [--password P]
+//                      [--files N] [--folders N] [--nested N] [--iterations N]
+// Connection defaults come from FILEENGINE_PG_HOST/PORT/DATABASE/USER/PASSWORD.
+// Not a pass/fail test; exits 0 without measuring when no server is reachable.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/database.h"
+#include "fileengine/utils.h"
+
+using fileengine::Database;
+using fileengine::FileType;
+using fileengine::Utils;
+
+static std::string env_or(const char* name, const std::string& fallback) {
+    const char* v = std::getenv(name);
+    return (v && v[0]) ? std::string(v) : fallback;
+}
+
+struct BenchOptions {
+    std::string host = env_or("FILEENGINE_PG_HOST", "localhost");
+    int port = std::stoi(env_or("FILEENGINE_PG_PORT", "5432"));
+    std::string dbname = env_or("FILEENGINE_PG_DATABASE", "fileengine");
+    std::string user = env_or("FILEENGINE_PG_USER", "fileengine_user");
+    std::string password = env_or("FILEENGINE_PG_PASSWORD", "");
+    size_t files = 10000;
+    size_t folders = 1000;
+    size_t nested = 1;
+    size_t iterations = 5;
+};
+
+static BenchOptions parse_args(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--host") opt.host = argv[i + 1];
+        else if (arg == "--port") opt.port = std::stoi(argv[i + 1]);
+        else if (arg == "--dbname") opt.dbname = argv[i + 1];
+        else if (arg == "--user") opt.user = argv[i + 1];
+        else if (arg == "--password") opt.password = argv[i + 1];
+        else if (arg == "--files") opt.files = std::stoul(argv[i + 1]);
+        else if (arg == "--folders") opt.folders = std::stoul(argv[i + 1]);
+        else if (arg == "--nested") opt.nested = std::stoul(argv[i + 1]);
+        else if (arg == "--iterations") opt.iterations = std::max<size_t>(1, std::stoul(argv[i + 1]));
+    }
+    return opt;
+}
+
+// Distinct, parseable version timestamps (the listing derives mtimes from them).
+static std::string version_timestamp(size_t n) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "20260101_%02zu%02zu%02zu_%06zu",
+                  (n / 3600) % 24, (n / 60) % 60, n % 60, n);
+    return buf;
+}
+
+static bool add_file(Database& db, const std::string& parent_uid, const std::string& name,
+                     size_t n, const std::string& tenant) {
+    const std::string uid = Utils::generate_uuid();
+    auto r = db.insert_file(uid, name, "/" + name, parent_uid, FileType::REGULAR_FILE,
+                            "bench", 0644, tenant);
+    if (!r.success) return false;
+    return db.insert_version(uid, version_timestamp(n), 0, "bench/" + uid, "bench", tenant).success;
+}
+
+// Lists `dir_uid` opt.iterations times; prints entry count and min/median ms.
+template <typename ListFn>
+static bool time_listing(const char* label, const BenchOptions& opt, ListFn list) {
+    std::vector<double> ms;
+    size_t entries = 0;
+    for (size_t i = 0; i < opt.iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        auto r = list();
+        auto elapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        if (!r.success) {
+            std::cerr << label << " failed: " << r.error << std::endl;
+            return false;
+        }
+        entries = r.value.size();
+        ms.push_back(elapsed);
+    }
+    std::sort(ms.begin(), ms.end());
+    std::cout << std::left << std::setw(34) << label << std::right
+              << std::setw(8) << entries
+              << std::setw(12) << std::fixed << std::setprecision(1) << ms.front()
+              << std::setw(12) << ms[ms.size() / 2] << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt = parse_args(argc, argv);
+
+    Database db(opt.host, opt.port, opt.dbname, opt.user, opt.password, 2);
+    if (!db.connect()) {
+        std::cout << "listing_bench: no PostgreSQL at " << opt.host << ":" << opt.port
+                  << " (set FILEENGINE_PG_* or --host/--port); skipping" << std::endl;
+        return 0;
+    }
+
+    const std::string tenant = "listing_bench_" + std::to_string(::getpid());
+    auto global = db.create_schema();
+    auto schema = global.success ? db.create_tenant_schema(tenant) : global;
+    if (!schema.success) {
+        std::cerr << "Failed to create tenant schema: " << schema.error << std::endl;
+        return 1;
+    }
+
+    int rc = 0;
+    const std::string dir_uid = Utils::generate_uuid();
+    std::cout << "Seeding " << opt.files << " files and " << opt.folders << " sub-folders ("
+              << opt.nested << " file(s) each)..." << std::endl;
+    size_t n = 0;
+    bool seeded = db.insert_file(dir_uid, "bench", "/bench", "", FileType::DIRECTORY,
+                                 "bench", 0755, tenant).success;
+    for (size_t i = 0; seeded && i < opt.files; ++i) {
+        seeded = add_file(db, dir_uid, "file_" + std::to_string(i), n++, tenant);
+    }
+    for (size_t i = 0; seeded && i < opt.folders; ++i) {
+        const std::string sub_uid = Utils::generate_uuid();
+        const std::string name = "folder_" + std::to_string(i);
+        seeded = db.insert_file(sub_uid, name, "/bench/" + name, dir_uid, FileType::DIRECTORY,
+                                "bench", 0755, tenant).success;
+        for (size_t j = 0; seeded && j < opt.nested; ++j) {
+            seeded = add_file(db, sub_uid, "nested_" + std::to_string(j), n++, tenant);
+        }
+    }
+
+    if (!seeded) {
+        std::cerr << "Seeding failed" << std::endl;
+        rc = 1;
+    } else {
+        std::cout << std::left << std::setw(34) << "listing" << std::right
+                  << std::setw(8) << "entries" << std::setw(12) << "min ms"
+                  << std::setw(12) << "median ms" << std::endl;
+        if (!time_listing("list_files_in_directory", opt,
+                          [&] { return db.list_files_in_directory(dir_uid, tenant); }) ||
+            !time_listing("list_files_in_directory_with_deleted", opt,
+                          [&] { return db.list_files_in_directory_with_deleted(dir_uid, tenant); })) {
+            rc = 1;
+        }
+    }
+
+    db.cleanup_tenant_data(tenant);
+    db.disconnect();
+    return rc;
+}
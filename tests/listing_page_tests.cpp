@@ -0,0 +1,219 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for keyset-paginated directory listings: the IDatabase default
+// list_files_in_directory_page (used by any backend without a native keyset
+// query) and the FileSystem page-token encoding behind ListDirectory and
+// StreamListDirectory. Walking a directory page by page must visit every
+// entry exactly once, in (name, uid) order, whatever the page size.
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/filesystem.h"
+#include "fileengine/types.h"
+
+using namespace fileengine;
+
+class ListingDatabase : public IDatabase {
+public:
+    std::map<std::string, std::vector<FileInfo>> children_;
+    int list_calls = 0;
+
+    void add_child(const std::string& parent, const std::string& uid, const std::string& name) {
+        FileInfo info;
+        info.uid = uid;
+        info.name = name;
+        info.parent_uid = parent;
+        info.type = FileType::REGULAR_FILE;
+        children_[parent].push_back(info);
+    }
+
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string& parent_uid, const std::string& = "") override {
+        ++list_calls;
+        auto it = children_.find(parent_uid);
+        if (it == children_.end()) return Result<std::vector<FileInfo>>::ok({});
+        return Result<std::vector<FileInfo>>::ok(it->second);
+    }
+
+    // ---- everything below is an unused no-op for these tests ----
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string&, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<void> add_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<void> remove_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_roles_for_user(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> delete_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> assign_user_to_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> remove_user_from_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+// Walk `parent` with pages of `limit`, returning every entry in visit order.
+static std::vector<FileInfo> walk(ListingDatabase& db, const std::string& parent, size_t limit) {
+    std::vector<FileInfo> seen;
+    std::string after_name, after_uid;
+    while (true) {
+        auto page = db.list_files_in_directory_page(parent, after_name, after_uid, limit);
+        assert(page.success);
+        assert(page.value.size() <= limit);
+        seen.insert(seen.end(), page.value.begin(), page.value.end());
+        if (page.value.size() < limit) break;
+        after_name = page.value.back().name;
+        after_uid = page.value.back().uid;
+    }
+    return seen;
+}
+
+static void test_pages_cover_the_directory_in_order() {
+    std::cout << "test_pages_cover_the_directory_in_order" << std::endl;
+    ListingDatabase db;
+    std::vector<std::pair<std::string, std::string>> rows;
+    for (int i = 0; i < 2500; ++i) {
+        // Every fifth name repeats, so ties must be broken by uid.
+        rows.emplace_back("uid-" + std::to_string(i), "name-" + std::to_string(i % 5 == 4 ? i - 1 : i));
+    }
+    std::shuffle(rows.begin(), rows.end(), std::mt19937(42));
+    for (const auto& r : rows) db.add_child("D", r.first, r.second);
+    db.add_child("other", "uid-x", "name-0");
+
+    for (size_t limit : {size_t(1000), size_t(7), size_t(2500), size_t(1)}) {
+        auto seen = walk(db, "D", limit);
+        assert(seen.size() == 2500);
+        std::set<std::string> uids;
+        for (size_t i = 0; i < seen.size(); ++i) {
+            assert(seen[i].parent_uid == "D");
+            assert(uids.insert(seen[i].uid).second);
+            if (i > 0) {
+                assert(std::tie(seen[i - 1].name, seen[i - 1].uid) < std::tie(seen[i].name, seen[i].uid));
+            }
+        }
+    }
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_exact_multiple_ends_with_an_empty_page() {
+    std::cout << "test_exact_multiple_ends_with_an_empty_page" << std::endl;
+    ListingDatabase db;
+    for (int i = 0; i < 10; ++i) db.add_child("D", "u" + std::to_string(i), "n" + std::to_string(i));
+    auto first = db.list_files_in_directory_page("D", "", "", 10);
+    assert(first.success && first.value.size() == 10);
+    auto rest = db.list_files_in_directory_page("D", first.value.back().name, first.value.back().uid, 10);
+    assert(rest.success && rest.value.empty());
+
+    auto empty = db.list_files_in_directory_page("missing", "", "", 10);
+    assert(empty.success && empty.value.empty());
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_page_token_round_trip() {
+    std::cout << "test_page_token_round_trip" << std::endl;
+    const std::string dir = "3f1c2d9e-0000-4000-8000-000000000001";
+    for (const std::string& name : {std::string("report.pdf"), std::string(""), std::string("with\0nul", 8),
+                                     std::string("\xc3\xa9t\xc3\xa9 \xe2\x9c\x93")}) {
+        std::string token = FileSystem::encode_page_token(dir, name, "uid-7");
+        std::string out_name, out_uid;
+        bool ok = FileSystem::decode_page_token(token, dir, out_name, out_uid);
+        if (name.find('\0') != std::string::npos) {
+            // A NUL cannot be told apart from the separator; such names are
+            // refused rather than misread.
+            assert(!ok);
+            continue;
+        }
+        assert(ok && out_name == name && out_uid == "uid-7");
+    }
+
+    // The root directory is the empty uid.
+    std::string name, uid;
+    assert(FileSystem::decode_page_token(FileSystem::encode_page_token("", "a", "b"), "", name, uid));
+    assert(name == "a" && uid == "b");
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_page_token_rejects_foreign_and_malformed_tokens() {
+    std::cout << "test_page_token_rejects_foreign_and_malformed_tokens" << std::endl;
+    std::string token = FileSystem::encode_page_token("dir-a", "n", "u");
+    std::string name, uid;
+    assert(!FileSystem::decode_page_token(token, "dir-b", name, uid));
+    assert(!FileSystem::decode_page_token(token, "dir-", name, uid));
+    assert(!FileSystem::decode_page_token(token, "", name, uid));
+    assert(!FileSystem::decode_page_token(token.substr(1), "dir-a", name, uid));
+    assert(!FileSystem::decode_page_token("zz" + token.substr(2), "dir-a", name, uid));
+    assert(!FileSystem::decode_page_token("", "dir-a", name, uid));
+    assert(!FileSystem::decode_page_token(FileSystem::encode_page_token("dir-a", "n", "") + "00", "dir-a", name, uid));
+    assert(FileSystem::decode_page_token(token, "dir-a", name, uid));
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_pages_cover_the_directory_in_order();
+    test_exact_multiple_ends_with_an_empty_page();
+    test_page_token_round_trip();
+    test_page_token_rejects_foreign_and_malformed_tokens();
+    std::cout << "All listing page tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,415 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for MetadataCache, the FileInfo cache in front of
+// IDatabase::get_file_by_uid(_include_deleted). Repeat lookups must not reach
+// the database, the plain lookup must still hide soft-deleted rows, and an
+// invalidation must drop the row together with every ancestor whose metadata
+// it feeds (folder mtime, rendition count). Uses a counting mock database.
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/acl_manager.h"
+#include "fileengine/metadata_cache.h"
+#include "fileengine/types.h"
+
+using namespace fileengine;
+
+class CountingDatabase : public IDatabase {
+public:
+    struct Node { std::string parent; bool is_dir; bool deleted; int64_t size; };
+    std::map<std::string, Node> tree_;
+    int lookups = 0;
+    bool fail = false;
+    std::function<void()> during_lookup;  // runs while a lookup is "in flight"
+
+    void add_node(const std::string& uid, const std::string& parent, bool is_dir) {
+        tree_[uid] = Node{parent, is_dir, false, 0};
+    }
+
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string& uid, const std::string& = "") override {
+        ++lookups;
+        if (fail) return Result<std::optional<FileInfo>>::err("connection lost");
+        auto it = tree_.find(uid);
+        std::optional<FileInfo> out;
+        if (it != tree_.end()) {
+            FileInfo info;
+            info.uid = uid;
+            info.name = uid;
+            info.parent_uid = it->second.parent;
+            info.type = it->second.is_dir ? FileType::DIRECTORY : FileType::REGULAR_FILE;
+            info.size = it->second.size;
+            info.deleted = it->second.deleted;
+            out = info;
+        }
+        if (during_lookup) during_lookup();
+        return Result<std::optional<FileInfo>>::ok(out);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string& uid, const std::string& tenant = "") override {
+        auto r = get_file_by_uid_include_deleted(uid, tenant);
+        if (r.success && r.value && r.value->deleted) return Result<std::optional<FileInfo>>::ok(std::nullopt);
+        return r;
+    }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string&, const std::string& = "") override {
+        return Result<std::vector<AclEntry>>::ok(std::vector<AclEntry>{});
+    }
+    Result<std::vector<std::string>> get_roles_for_user(const std::string&, const std::string& = "") override {
+        return Result<std::vector<std::string>>::ok(std::vector<std::string>{});
+    }
+
+    // ---- everything below is an unused no-op for these tests ----
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> add_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<void> remove_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> delete_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> assign_user_to_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> remove_user_from_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+// root ── F (dir) ── G (dir) ── C (file)
+static void build_tree(CountingDatabase& db) {
+    db.add_node("", "", true);
+    db.add_node("F", "", true);
+    db.add_node("G", "F", true);
+    db.add_node("C", "G", false);
+}
+
+static int64_t size_of(MetadataCache& cache, CountingDatabase& db, const std::string& uid) {
+    auto r = cache.get_file_by_uid(db, uid, "t");
+    assert(r.success && r.value.has_value());
+    return r.value->size;
+}
+
+static void test_repeat_lookups_are_served_from_memory() {
+    std::cout << "test_repeat_lookups_are_served_from_memory" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache cache(100);
+
+    for (int i = 0; i < 5; ++i) {
+        auto r = cache.get_file_by_uid(db, "C", "t");
+        assert(r.success && r.value.has_value() && r.value->parent_uid == "G");
+        auto d = cache.get_file_by_uid_include_deleted(db, "C", "t");
+        assert(d.success && d.value.has_value());
+    }
+    assert(db.lookups == 1);
+
+    // Tenants are separate key spaces.
+    cache.get_file_by_uid(db, "C", "other");
+    assert(db.lookups == 2);
+
+    auto stats = cache.get_stats();
+    assert(stats.hits == 9 && stats.misses == 2 && stats.entries == 2);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_deleted_rows_are_hidden_from_the_plain_lookup() {
+    std::cout << "test_deleted_rows_are_hidden_from_the_plain_lookup" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    db.tree_["G"].deleted = true;
+    MetadataCache cache(100);
+
+    auto d = cache.get_file_by_uid_include_deleted(db, "G", "t");
+    assert(d.success && d.value.has_value() && d.value->deleted);
+    auto r = cache.get_file_by_uid(db, "G", "t");
+    assert(r.success && !r.value.has_value());
+    assert(db.lookups == 1);
+
+    // Unknown rows and errors are not cached.
+    assert(!cache.get_file_by_uid(db, "missing", "t").value.has_value());
+    assert(!cache.get_file_by_uid(db, "missing", "t").value.has_value());
+    assert(db.lookups == 3);
+    db.fail = true;
+    assert(!cache.get_file_by_uid(db, "F", "t").success);
+    db.fail = false;
+    assert(cache.get_file_by_uid(db, "F", "t").success);
+    assert(db.lookups == 5);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_invalidate_drops_the_ancestor_chain() {
+    std::cout << "test_invalidate_drops_the_ancestor_chain" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache cache(100);
+    for (const char* uid : {"", "F", "G", "C"}) size_of(cache, db, uid);
+    db.add_node("S", "", true);
+    size_of(cache, db, "S");
+
+    // A write to C changes the folders above it (their mtime).
+    db.tree_["C"].size = 10;
+    db.tree_["G"].size = 10;
+    db.tree_["F"].size = 10;
+    db.tree_[""].size = 10;
+    cache.invalidate("t", "C");
+    const int before = db.lookups;
+    for (const char* uid : {"", "F", "G", "C"}) assert(size_of(cache, db, uid) == 10);
+    assert(db.lookups == before + 4);
+
+    // The unrelated sibling stays cached.
+    size_of(cache, db, "S");
+    assert(db.lookups == before + 4);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_new_rows_drop_their_parent_chain() {
+    std::cout << "test_new_rows_drop_their_parent_chain" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache cache(100);
+    for (const char* uid : {"F", "G", "C"}) size_of(cache, db, uid);
+
+    // A rendition created under file C changes C's rendition count. It was
+    // never cached, so the caller supplies its parent.
+    db.add_node("R", "C", false);
+    db.tree_["C"].size = 7;
+    cache.invalidate("t", "R", std::string("C"));
+    assert(size_of(cache, db, "C") == 7);
+    const int before = db.lookups;
+    size_of(cache, db, "F");  // F was dropped too
+    assert(db.lookups == before + 1);
+
+    // Without a parent the ancestors are unknown, so the tenant's entries
+    // are all retired.
+    size_of(cache, db, "G");
+    const int after = db.lookups;
+    cache.invalidate("t", "unknown");
+    size_of(cache, db, "G");
+    assert(db.lookups == after + 1);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_fill_racing_an_invalidation_is_discarded() {
+    std::cout << "test_fill_racing_an_invalidation_is_discarded" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache cache(100);
+
+    // The row changes, and is invalidated, after the query read it.
+    db.during_lookup = [&] {
+        db.during_lookup = nullptr;
+        db.tree_["C"].size = 3;
+        cache.invalidate("t", "C");
+    };
+    assert(size_of(cache, db, "C") == 0);
+    assert(size_of(cache, db, "C") == 3);
+    assert(db.lookups == 2);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_invalidation_is_scoped_to_the_tenant() {
+    std::cout << "test_invalidation_is_scoped_to_the_tenant" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache cache(100);
+    size_of(cache, db, "G");
+    cache.get_file_by_uid(db, "G", "other");
+    const int before = db.lookups;
+
+    // An unknown chain in "t" retires "t" alone.
+    cache.invalidate("t", "unknown");
+    cache.get_file_by_uid(db, "G", "other");
+    assert(db.lookups == before);
+    size_of(cache, db, "G");
+    assert(db.lookups == before + 1);
+
+    // Nor does a write in "t" discard a concurrent fill for "other".
+    db.during_lookup = [&] {
+        db.during_lookup = nullptr;
+        cache.invalidate("t", "C");
+    };
+    cache.get_file_by_uid(db, "F", "other");
+    cache.get_file_by_uid(db, "F", "other");
+    assert(db.lookups == before + 2);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_ttl_and_entry_bound() {
+    std::cout << "test_ttl_and_entry_bound" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache ttl_cache(100, std::chrono::milliseconds(20));
+    size_of(ttl_cache, db, "C");
+    db.tree_["C"].size = 4;  // changed by another server: no invalidation
+    assert(size_of(ttl_cache, db, "C") == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    assert(size_of(ttl_cache, db, "C") == 4);
+
+    MetadataCache small(2, std::chrono::milliseconds(0), 1);
+    for (const char* uid : {"F", "G", "C"}) size_of(small, db, uid);
+    auto stats = small.get_stats();
+    assert(stats.entries == 2 && stats.evictions == 1);
+    const int before = db.lookups;
+    size_of(small, db, "F");  // least recently used, so it was the one evicted
+    assert(db.lookups == before + 1);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_acl_ancestor_walk_uses_the_cache() {
+    std::cout << "test_acl_ancestor_walk_uses_the_cache" << std::endl;
+    auto db = std::make_shared<CountingDatabase>();
+    build_tree(*db);
+    auto cache = std::make_shared<MetadataCache>(100);
+    AclManager acl(db);
+    acl.set_metadata_cache(cache);
+    const int READ = static_cast<int>(Permission::READ);
+
+    assert(acl.check_permission("C", "alice", {}, READ, "t").value);
+    const int cold = db->lookups;
+    assert(cold > 0);
+    assert(acl.check_permission("C", "alice", {}, READ, "t").value);
+    assert(db->lookups == cold);
+
+    // Deleting a folder is seen by the next walk once it is invalidated.
+    db->tree_["F"].deleted = true;
+    cache->invalidate("t", "F");
+    assert(!acl.check_permission("C", "alice", {}, READ, "t").value);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_missing_rows_are_remembered_briefly() {
+    std::cout << "test_missing_rows_are_remembered_briefly" << std::endl;
+    CountingDatabase db;
+    build_tree(db);
+    MetadataCache cache(100, std::chrono::milliseconds(0), 16, std::chrono::milliseconds(30));
+
+    for (int i = 0; i < 5; ++i) {
+        auto r = cache.get_file_by_uid(db, "ghost", "t");
+        assert(r.success && !r.value.has_value());
+    }
+    assert(db.lookups == 1);
+    assert(cache.get_stats().negative_hits == 4);
+    assert(cache.known_missing("t", "ghost"));
+    assert(!cache.known_missing("other", "ghost"));
+
+    // Created through this server: the miss is forgotten at once
+    db.add_node("ghost", "F", false);
+    cache.invalidate("t", "ghost", std::string("F"));
+    assert(cache.get_file_by_uid(db, "ghost", "t").value.has_value());
+
+    // Created behind the cache's back: seen once the negative TTL expires
+    assert(!cache.get_file_by_uid(db, "late", "t").value.has_value());
+    db.add_node("late", "F", false);
+    assert(!cache.get_file_by_uid(db, "late", "t").value.has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    assert(cache.get_file_by_uid(db, "late", "t").value.has_value());
+
+    // A miss read before an invalidation is not remembered
+    const uint64_t epoch = cache.epoch("t");
+    cache.invalidate("t", "F");
+    cache.put_missing("t", "probe", epoch);
+    assert(!cache.known_missing("t", "probe"));
+
+    // Off unless a negative TTL is given
+    MetadataCache plain(100);
+    plain.get_file_by_uid(db, "ghost2", "t");
+    const int before = db.lookups;
+    plain.get_file_by_uid(db, "ghost2", "t");
+    assert(db.lookups == before + 1);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_probe_storms_stay_off_the_database() {
+    std::cout << "test_probe_storms_stay_off_the_database" << std::endl;
+    auto db = std::make_shared<CountingDatabase>();
+    build_tree(*db);
+    auto cache = std::make_shared<MetadataCache>(100, std::chrono::milliseconds(0), 16,
+                                                 std::chrono::milliseconds(1000));
+    AclManager acl(db);
+    acl.set_metadata_cache(cache);
+    const int READ = static_cast<int>(Permission::READ);
+
+    acl.check_permission("desktop.ini", "alice", {}, READ, "t");
+    cache->get_file_by_uid(*db, "desktop.ini", "t");
+    const int cold = db->lookups;
+    for (int i = 0; i < 20; ++i) {
+        acl.check_permission("desktop.ini", "alice", {}, READ, "t");
+        assert(!cache->get_file_by_uid(*db, "desktop.ini", "t").value.has_value());
+        assert(!acl.has_deleted_ancestor("desktop.ini", "t"));
+    }
+    assert(db->lookups == cold);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_repeat_lookups_are_served_from_memory();
+    test_deleted_rows_are_hidden_from_the_plain_lookup();
+    test_invalidate_drops_the_ancestor_chain();
+    test_new_rows_drop_their_parent_chain();
+    test_fill_racing_an_invalidation_is_discarded();
+    test_invalidation_is_scoped_to_the_tenant();
+    test_ttl_and_entry_bound();
+    test_acl_ancestor_walk_uses_the_cache();
+    test_missing_rows_are_remembered_briefly();
+    test_probe_storms_stay_off_the_database();
+    std::cout << "All metadata cache tests passed!" << std::endl;
+    return 0;
+}
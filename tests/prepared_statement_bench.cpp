@@ -0,0 +1,191 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Per-query latency of hot Database calls with and without prepared
+// statements. Two Database instances share one throwaway tenant: one with
+// set_prepared_statements(false), which sends every query through
+// PQexecParams, and one with the default per-connection statement cache.
+// Each times get_file_by_uid, get_acls_for_resource and insert_version over
+// --iterations calls after a short warm-up. The tenant schema is dropped at
+// exit.
+//
+// Usage: prepared_statement_bench [--host H] [--port N] [--dbname D] [--user U]
+//                                 [--password P] [--iterations N]
+// Connection defaults come from FILEENGINE_PG_HOST/PORT/DATABASE/USER/PASSWORD.
+// Not a pass/fail test; exits 0 without measuring when no server is reachable.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/database.h"
+#include "fileengine/utils.h"
+
+using fileengine::Database;
+using fileengine::FileType;
+using fileengine::Utils;
+
+static std::string env_or(const char* name, const std::string& fallback) {
+    const char* v = std::getenv(name);
+    return (v && v[0]) ? std::string(v) : fallback;
+}
+
+struct BenchOptions {
+    std::string host = env_or("FILEENGINE_PG_HOST", "localhost");
+    int port = std::stoi(env_or("FILEENGINE_PG_PORT", "5432"));
+    std::string dbname = env_or("FILEENGINE_PG_DATABASE", "fileengine");
+    std::string user = env_or("FILEENGINE_PG_USER", "fileengine_user");
+    std::string password = env_or("FILEENGINE_PG_PASSWORD", "");
+    size_t iterations = 2000;
+};
+
+static BenchOptions parse_args(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--host") opt.host = argv[i + 1];
+        else if (arg == "--port") opt.port = std::stoi(argv[i + 1]);
+        else if (arg == "--dbname") opt.dbname = argv[i + 1];
+        else if (arg == "--user") opt.user = argv[i + 1];
+        else if (arg == "--password") opt.password = argv[i + 1];
+        else if (arg == "--iterations") opt.iterations = std::max<size_t>(1, std::stoul(argv[i + 1]));
+    }
+    return opt;
+}
+
+// Distinct version timestamps, so every timed insert_version adds a row.
+static std::string version_timestamp(size_t n) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "20260101_%02zu%02zu%02zu_%06zu",
+                  (n / 3600) % 24, (n / 60) % 60, n % 60, n);
+    return buf;
+}
+
+struct Timing {
+    double mean_us = 0;
+    double median_us = 0;
+    double p99_us = 0;
+};
+
+// Runs `op` 50 times untimed (so the prepared run measures reuse, not the
+// first PQprepare), then opt.iterations times timed. `op` gets the call
+// index and returns false on failure.
+static bool time_op(const BenchOptions& opt, const std::function<bool(size_t)>& op, Timing& out) {
+    size_t n = 0;
+    for (size_t i = 0; i < 50; ++i) {
+        if (!op(n++)) return false;
+    }
+    std::vector<double> us;
+    us.reserve(opt.iterations);
+    for (size_t i = 0; i < opt.iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!op(n++)) return false;
+        us.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    double total = 0;
+    for (double v : us) total += v;
+    std::sort(us.begin(), us.end());
+    out.mean_us = total / us.size();
+    out.median_us = us[us.size() / 2];
+    out.p99_us = us[std::min(us.size() - 1, us.size() * 99 / 100)];
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt = parse_args(argc, argv);
+
+    // One connection each, so every call in a run reuses the same session.
+    Database plain(opt.host, opt.port, opt.dbname, opt.user, opt.password, 1);
+    Database prepared(opt.host, opt.port, opt.dbname, opt.user, opt.password, 1);
+    plain.set_prepared_statements(false);
+    if (!plain.connect() || !prepared.connect()) {
+        std::cout << "prepared_statement_bench: no PostgreSQL at " << opt.host << ":" << opt.port
+                  << " (set FILEENGINE_PG_* or --host/--port); skipping" << std::endl;
+        return 0;
+    }
+
+    const std::string tenant = "prepared_bench_" + std::to_string(::getpid());
+    auto global = prepared.create_schema();
+    auto schema = global.success ? prepared.create_tenant_schema(tenant) : global;
+    if (!schema.success) {
+        std::cerr << "Failed to create tenant schema: " << schema.error << std::endl;
+        return 1;
+    }
+
+    int rc = 0;
+    const std::string dir_uid = Utils::generate_uuid();
+    const std::string file_uid = Utils::generate_uuid();
+    bool seeded = prepared.insert_file(dir_uid, "bench", "/bench", "", FileType::DIRECTORY,
+                                       "bench", 0755, tenant).success &&
+                  prepared.insert_file(file_uid, "file", "/bench/file", dir_uid, FileType::REGULAR_FILE,
+                                       "bench", 0644, tenant).success &&
+                  prepared.insert_version(file_uid, version_timestamp(0), 0, "bench/" + file_uid,
+                                          "bench", tenant).success &&
+                  prepared.add_acl(file_uid, "bench", 0, 7, tenant).success;
+    if (!seeded) {
+        std::cerr << "Seeding failed" << std::endl;
+        prepared.cleanup_tenant_data(tenant);
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(24) << "query" << std::setw(12) << "mode" << std::right
+              << std::setw(10) << "mean us" << std::setw(12) << "median us"
+              << std::setw(10) << "p99 us" << std::endl;
+
+    // insert_version timestamps keep counting across both runs.
+    size_t next_version = 1;
+    struct Mode { const char* label; Database* db; };
+    for (const char* query : {"get_file_by_uid", "get_acls_for_resource", "insert_version"}) {
+        for (const Mode& mode : {Mode{"unprepared", &plain}, Mode{"prepared", &prepared}}) {
+            Database& db = *mode.db;
+            std::function<bool(size_t)> op;
+            const std::string name = query;
+            if (name == "get_file_by_uid") {
+                op = [&](size_t) { return db.get_file_by_uid(file_uid, tenant).success; };
+            } else if (name == "get_acls_for_resource") {
+                op = [&](size_t) { return db.get_acls_for_resource(file_uid, tenant).success; };
+            } else {
+                op = [&](size_t) {
+                    return db.insert_version(file_uid, version_timestamp(next_version++), 0,
+                                             "bench/" + file_uid, "bench", tenant).success;
+                };
+            }
+            Timing t;
+            if (!time_op(opt, op, t)) {
+                std::cerr << query << " (" << mode.label << ") failed" << std::endl;
+                rc = 1;
+                break;
+            }
+            std::cout << std::left << std::setw(24) << query << std::setw(12) << mode.label << std::right
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(10) << t.mean_us << std::setw(12) << t.median_us
+                      << std::setw(10) << t.p99_us << std::endl;
+        }
+        if (rc != 0) break;
+    }
+
+    prepared.cleanup_tenant_data(tenant);
+    plain.disconnect();
+    prepared.disconnect();
+    return rc;
+}
@@ -0,0 +1,237 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for IDatabase::commit_new_version, the one-step bookkeeping
+// after a PUT: FileSystem::put and put_stream must record each upload with a
+// single commit_new_version call (no separate version insert or size update
+// round trips), fail the upload when that commit fails, and the IDatabase
+// default must still compose the individual calls for other backends.
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/acl_manager.h"
+#include "fileengine/filesystem.h"
+#include "fileengine/tenant_manager.h"
+
+using namespace fileengine;
+
+static const char* kFileUid = "eeeeeeee-1111-2222-3333-555555555555";
+
+// One file row; records every bookkeeping call a PUT makes.
+class RecordingDatabase : public IDatabase {
+public:
+    struct Commit { std::string uid, version, storage_path, revised_by; int64_t size; };
+    std::vector<Commit> commits;
+    bool override_commit = true;   // false: exercise the IDatabase default
+    bool fail_commit = false;
+    bool fail_insert = false;
+    int current_version_calls = 0, insert_calls = 0, size_calls = 0, modified_calls = 0;
+    int64_t last_size = -1;
+
+    Result<int64_t> commit_new_version(const std::string& uid, const std::string& version, int64_t size,
+                                       const std::string& storage_path, const std::string& revised_by = "",
+                                       const std::string& tenant = "") override {
+        if (!override_commit) {
+            return IDatabase::commit_new_version(uid, version, size, storage_path, revised_by, tenant);
+        }
+        if (fail_commit) return Result<int64_t>::err("commit refused");
+        commits.push_back(Commit{uid, version, storage_path, revised_by, size});
+        return Result<int64_t>::ok(static_cast<int64_t>(commits.size()));
+    }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override {
+        ++current_version_calls;
+        return Result<void>::ok();
+    }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override {
+        ++insert_calls;
+        if (fail_insert) return Result<int64_t>::err("insert refused");
+        return Result<int64_t>::ok(42);
+    }
+    Result<void> update_file_size(const std::string&, int64_t size, const std::string& = "") override {
+        ++size_calls;
+        last_size = size;
+        return Result<void>::ok();
+    }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override {
+        ++modified_calls;
+        return Result<void>::ok();
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string& uid, const std::string& = "") override {
+        FileInfo info;
+        info.uid = uid;
+        info.name = "bench.bin";
+        info.type = FileType::REGULAR_FILE;
+        return Result<std::optional<FileInfo>>::ok(info);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string& uid, const std::string& t = "") override { return get_file_by_uid(uid, t); }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string&, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> get_roles_for_user(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> add_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> remove_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> delete_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> assign_user_to_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> remove_user_from_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+struct Fixture {
+    std::string dir = (std::filesystem::temp_directory_path() /
+                       ("fileengine_put_commit_tests_" + std::to_string(::getpid()))).string();
+    std::shared_ptr<RecordingDatabase> db = std::make_shared<RecordingDatabase>();
+    std::shared_ptr<TenantManager> tenants;
+    std::unique_ptr<FileSystem> fs;
+
+    Fixture() {
+        std::filesystem::remove_all(dir);
+        TenantConfig config;
+        config.storage_base_path = dir;
+        config.encrypt_data = false;
+        config.compress_data = false;
+        config.s3_path_style = true;
+        config.storage_sync_mode = "none";
+        tenants = std::make_shared<TenantManager>(config, db);
+        // No object store: the backup worker would only log failed uploads.
+        if (auto* context = tenants->get_tenant_context("t")) context->object_store.reset();
+        fs = std::make_unique<FileSystem>(tenants);
+        fs->set_acl_manager(std::make_shared<AclManager>(db));
+    }
+    ~Fixture() {
+        fs->shutdown();
+        std::filesystem::remove_all(dir);
+    }
+};
+
+static void test_put_commits_once() {
+    std::cout << "test_put_commits_once" << std::endl;
+    Fixture f;
+    std::vector<uint8_t> data(1000, 'x');
+    auto r = f.fs->put(kFileUid, data, "alice", {kSystemAdminRole}, "t");
+    assert(r.success);
+    assert(f.db->commits.size() == 1);
+    const auto& c = f.db->commits[0];
+    assert(c.uid == kFileUid && c.size == 1000 && c.revised_by == "alice");
+    assert(!c.version.empty() && !c.storage_path.empty());
+    // Nothing went around the single commit.
+    assert(f.db->insert_calls == 0 && f.db->size_calls == 0);
+    assert(f.db->current_version_calls == 0 && f.db->modified_calls == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_put_stream_commits_once() {
+    std::cout << "test_put_stream_commits_once" << std::endl;
+    Fixture f;
+    int chunks = 0;
+    auto r = f.fs->put_stream(kFileUid, [&](std::vector<uint8_t>& chunk) {
+        if (chunks == 3) return false;
+        ++chunks;
+        chunk.assign(4096, static_cast<uint8_t>('a' + chunks));
+        return true;
+    }, "bob", {kSystemAdminRole}, "t");
+    assert(r.success);
+    assert(f.db->commits.size() == 1);
+    assert(f.db->commits[0].size == 3 * 4096 && f.db->commits[0].revised_by == "bob");
+    assert(f.db->insert_calls == 0 && f.db->size_calls == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_failed_commit_fails_the_put() {
+    std::cout << "test_failed_commit_fails_the_put" << std::endl;
+    Fixture f;
+    f.db->fail_commit = true;
+    auto r = f.fs->put(kFileUid, std::vector<uint8_t>(10, 'y'), "alice", {kSystemAdminRole}, "t");
+    assert(!r.success);
+    assert(r.error.find("commit refused") != std::string::npos);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_default_composes_the_individual_calls() {
+    std::cout << "test_default_composes_the_individual_calls" << std::endl;
+    RecordingDatabase db;
+    db.override_commit = false;
+    auto r = db.commit_new_version(kFileUid, "20260101_000000.000", 77, "p", "alice", "t");
+    assert(r.success && r.value == 42);
+    assert(db.current_version_calls == 1 && db.insert_calls == 1);
+    assert(db.size_calls == 1 && db.last_size == 77 && db.modified_calls == 1);
+
+    // A failed version insert stops before the size is touched.
+    RecordingDatabase failing;
+    failing.override_commit = false;
+    failing.fail_insert = true;
+    auto f = failing.commit_new_version(kFileUid, "20260101_000000.000", 77, "p", "alice", "t");
+    assert(!f.success && f.error.find("insert refused") != std::string::npos);
+    assert(failing.size_calls == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_put_commits_once();
+    test_put_stream_commits_once();
+    test_failed_commit_fails_the_put();
+    test_default_composes_the_individual_calls();
+    std::cout << "All put commit tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// put_stream throughput against the size of the frame encode pool
+// (FILEENGINE_STORAGE_ENCODE_THREADS). One large upload is streamed through
+// FileSystem::put_stream in 1 MiB chunks, as the upload RPC delivers it, with
+// compression alone and with compression + encryption; every pool size is a
+// fresh FileSystem so each run starts cold. Pool size 1 is the serial
+// encoder on the request thread. The database is an in-memory stub, so the
+// numbers cover encoding and the local write only.
+//
+// Usage: put_stream_bench [--dir PATH] [--size-mb N] [--max-threads N]
+// Not a pass/fail test; run on the storage volume you want to measure.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/acl_manager.h"
+#include "fileengine/filesystem.h"
+#include "fileengine/tenant_manager.h"
+
+using namespace fileengine;
+
+static const char* kFileUid = "eeeeeeee-1111-2222-3333-444444444444";
+static const std::string KEY = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+
+// Just enough database for put_stream: one file row; every write succeeds.
+class BenchDatabase : public IDatabase {
+public:
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string& uid, const std::string& = "") override {
+        FileInfo info;
+        info.uid = uid;
+        info.name = "bench.bin";
+        info.type = FileType::REGULAR_FILE;
+        return Result<std::optional<FileInfo>>::ok(info);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string& uid, const std::string& t = "") override { return get_file_by_uid(uid, t); }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string&, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> get_roles_for_user(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> add_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> remove_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> delete_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> assign_user_to_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> remove_user_from_role(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+struct BenchOptions {
+    std::string dir = (std::filesystem::temp_directory_path() /
+                       ("fileengine_put_stream_bench_" + std::to_string(::getpid()))).string();
+    size_t size_mb = 256;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+static BenchOptions parse_args(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--dir") opt.dir = argv[i + 1];
+        else if (arg == "--size-mb") opt.size_mb = std::stoul(argv[i + 1]);
+        else if (arg == "--max-threads") opt.max_threads = std::stoul(argv[i + 1]);
+    }
+    return opt;
+}
+
+// Log-like content: repetitive text with random fields, so zlib has real
+// work to do (roughly 3-4x) rather than skipping over constant bytes.
+static std::vector<uint8_t> make_chunk(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    static const char* words[] = {"GET", "PUT", "/api/v1/files/", "200", "404", "user=", "tenant=", "bytes=",
+                                  "latency_ms=", "INFO", "WARN", " ", " ", "\n"};
+    std::vector<uint8_t> out;
+    out.reserve(n);
+    while (out.size() < n) {
+        std::string w = words[rng() % (sizeof(words) / sizeof(words[0]))];
+        if (rng() % 3 == 0) w += std::to_string(rng() % 100000);
+        out.insert(out.end(), w.begin(), w.end());
+    }
+    out.resize(n);
+    return out;
+}
+
+static std::string ratio(double r) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2) << r << "x";
+    return os.str();
+}
+
+// Seconds to put_stream the whole payload with a pool of `threads`.
+static double run_once(const BenchOptions& opt, size_t threads, bool encrypt,
+                       const std::vector<std::vector<uint8_t>>& chunks) {
+    std::filesystem::remove_all(opt.dir);
+    TenantConfig config;
+    config.storage_base_path = opt.dir;
+    config.encrypt_data = encrypt;
+    config.compress_data = true;
+    config.encryption_key = encrypt ? KEY : "";
+    config.s3_path_style = true;
+    config.storage_sync_mode = "none";
+    config.storage_encode_threads = static_cast<int>(threads);
+
+    auto db = std::make_shared<BenchDatabase>();
+    auto tenants = std::make_shared<TenantManager>(config, db);
+    // No object store: the backup worker would only log failed uploads.
+    if (auto* context = tenants->get_tenant_context("bench")) context->object_store.reset();
+    FileSystem fs(tenants);
+    fs.set_acl_manager(std::make_shared<AclManager>(db));
+
+    size_t next = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto r = fs.put_stream(kFileUid, [&](std::vector<uint8_t>& chunk) {
+        if (next == chunks.size()) return false;
+        chunk = chunks[next++];
+        return true;
+    }, "bench", {kSystemAdminRole}, "bench");
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!r.success) {
+        std::cerr << "put_stream failed: " << r.error << std::endl;
+        std::exit(1);
+    }
+    fs.shutdown();
+    std::filesystem::remove_all(opt.dir);
+    return secs;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt = parse_args(argc, argv);
+    const size_t chunk_size = 1024 * 1024;
+    std::vector<std::vector<uint8_t>> chunks;
+    for (size_t i = 0; i < opt.size_mb; ++i) chunks.push_back(make_chunk(chunk_size, static_cast<uint32_t>(i)));
+
+    std::cout << "put_stream throughput: one " << opt.size_mb << " MiB upload in 1 MiB chunks, "
+              << "dir " << opt.dir << std::endl;
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(18) << "compress MB/s" << std::setw(12) << "speedup"
+              << std::setw(26) << "compress+encrypt MB/s" << "speedup" << std::endl;
+
+    double base_plain = 0, base_enc = 0;
+    for (size_t threads = 1; threads <= opt.max_threads; threads *= 2) {
+        double plain = opt.size_mb / run_once(opt, threads, false, chunks);
+        double enc = opt.size_mb / run_once(opt, threads, true, chunks);
+        if (threads == 1) { base_plain = plain; base_enc = enc; }
+        std::cout << std::left << std::fixed << std::setprecision(1)
+                  << std::setw(10) << threads
+                  << std::setw(18) << plain << std::setw(12) << ratio(plain / base_plain)
+                  << std::setw(26) << enc << ratio(enc / base_enc) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for RoleCache and the role memo of AclManager::CacheScope.
+// A user's stored roles must be read from the database once, not on every
+// permission check, and a role assigned, removed or deleted through
+// RoleManager must take effect on the very next check. Uses a counting mock
+// database.
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/IDatabase.h"
+#include "fileengine/acl_manager.h"
+#include "fileengine/role_cache.h"
+#include "fileengine/role_manager.h"
+#include "fileengine/types.h"
+
+using namespace fileengine;
+
+class CountingDatabase : public IDatabase {
+public:
+    std::map<std::string, std::set<std::string>> members_;  // user -> roles
+    int role_reads = 0;
+    bool fail_role_reads = false;
+    std::function<void()> during_role_read;  // runs while a role read is "in flight"
+
+    Result<std::vector<std::string>> get_roles_for_user(const std::string& user, const std::string& = "") override {
+        ++role_reads;
+        if (fail_role_reads) return Result<std::vector<std::string>>::err("database down");
+        auto& roles = members_[user];
+        std::vector<std::string> out(roles.begin(), roles.end());
+        if (during_role_read) {
+            auto hook = std::move(during_role_read);
+            during_role_read = nullptr;
+            hook();
+        }
+        return Result<std::vector<std::string>>::ok(out);
+    }
+    Result<void> assign_user_to_role(const std::string& user, const std::string& role, const std::string& = "") override {
+        members_[user].insert(role);
+        return Result<void>::ok();
+    }
+    Result<void> remove_user_from_role(const std::string& user, const std::string& role, const std::string& = "") override {
+        members_[user].erase(role);
+        return Result<void>::ok();
+    }
+    Result<void> delete_role(const std::string& role, const std::string& = "") override {
+        for (auto& [user, roles] : members_) roles.erase(role);
+        return Result<void>::ok();
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid(const std::string&, const std::string& = "") override {
+        return Result<std::optional<FileInfo>>::ok(std::nullopt);
+    }
+    Result<std::optional<FileInfo>> get_file_by_uid_include_deleted(const std::string&, const std::string& = "") override {
+        return Result<std::optional<FileInfo>>::ok(std::nullopt);
+    }
+    Result<std::vector<AclEntry>> get_acls_for_resource(const std::string&, const std::string& = "") override {
+        return Result<std::vector<AclEntry>>::ok({});
+    }
+    Result<void> add_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+    Result<void> remove_acl(const std::string&, const std::string&, int, int, const std::string& = "", const std::string& = "", int = 0) override { return Result<void>::ok(); }
+
+    // ---- everything below is an unused no-op for these tests ----
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool is_connected() const override { return true; }
+    Result<void> create_schema() override { return Result<void>::ok(); }
+    Result<void> drop_schema() override { return Result<void>::ok(); }
+    Result<std::string> insert_file(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<std::string> create_file_with_acls(const std::string& uid, const std::string&, const std::string&, const std::string&, FileType, const std::string&, int, const std::vector<AclGrant>&, const std::string& = "") override { return Result<std::string>::ok(uid); }
+    Result<void> update_file_modified(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> update_file_current_version(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<bool> delete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<bool> undelete_file(const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<std::optional<FileInfo>> get_file_by_path(const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<void> update_file_name(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<FileInfo>> list_files_in_directory(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_files_in_directory_with_deleted(const std::string&, const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::vector<FileInfo>> list_all_files(const std::string& = "") override { return Result<std::vector<FileInfo>>::ok({}); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<std::optional<FileInfo>> get_file_by_name_and_parent_include_deleted(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<FileInfo>>::ok(std::nullopt); }
+    Result<int64_t> get_file_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_directory_size(const std::string&, const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> update_file_parent(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::string> path_to_uid(const std::string&, const std::string& = "") override { return Result<std::string>::ok(""); }
+    Result<std::vector<std::string>> uid_to_path(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> insert_version(const std::string&, const std::string&, int64_t, const std::string&, const std::string& = "", const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<std::optional<std::string>> get_version_storage_path(const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::vector<std::string>> list_versions(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<bool> restore_to_version(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<bool>::ok(true); }
+    Result<void> set_metadata(const std::string&, const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::optional<std::string>> get_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<std::optional<std::string>>::ok(std::nullopt); }
+    Result<std::map<std::string, std::string>> get_all_metadata(const std::string&, const std::string&, const std::string& = "") override { return Result<std::map<std::string, std::string>>::ok({}); }
+    Result<void> delete_metadata(const std::string&, const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<void> execute(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::vector<std::string>>> query(const std::string&, const std::string& = "") override { return Result<std::vector<std::vector<std::string>>>::ok({}); }
+    Result<void> update_file_access_stats(const std::string&, const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_least_accessed_files(int = 10, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_infrequently_accessed_files(int = 30, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<int64_t> get_storage_usage(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<int64_t> get_storage_capacity(const std::string& = "") override { return Result<int64_t>::ok(0); }
+    Result<void> create_tenant_schema(const std::string&) override { return Result<void>::ok(); }
+    Result<bool> tenant_schema_exists(const std::string&) override { return Result<bool>::ok(true); }
+    Result<void> cleanup_tenant_data(const std::string&) override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> list_tenants() override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<AclEntry>> get_user_acls(const std::string&, const std::string&, int, const std::string& = "") override { return Result<std::vector<AclEntry>>::ok({}); }
+    Result<std::vector<std::string>> list_claims(const std::string&, int, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<void> create_role(const std::string&, const std::string& = "") override { return Result<void>::ok(); }
+    Result<std::vector<std::string>> get_users_for_role(const std::string&, const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+    Result<std::vector<std::string>> get_all_roles(const std::string& = "") override { return Result<std::vector<std::string>>::ok({}); }
+};
+
+struct Fixture {
+    std::shared_ptr<CountingDatabase> db = std::make_shared<CountingDatabase>();
+    std::shared_ptr<RoleCache> cache = std::make_shared<RoleCache>(100);
+    AclManager acl{db};
+    RoleManager roles{db, cache};
+
+    Fixture() { acl.set_role_cache(cache); }
+    bool admin(const std::string& user, const std::string& tenant = "t") {
+        return acl.is_admin(user, {}, tenant);
+    }
+};
+
+static void test_repeat_checks_read_roles_once() {
+    std::cout << "test_repeat_checks_read_roles_once" << std::endl;
+    Fixture f;
+    f.db->members_["alice"] = {kTenantAdminRole};
+    for (int i = 0; i < 10; ++i) {
+        assert(f.admin("alice"));
+        assert(f.acl.is_tenant_admin("alice", {}, "t"));
+        assert(!f.acl.is_system_admin("alice", {}, "t"));
+    }
+    assert(f.db->role_reads == 1);
+    // Tenants are cached separately
+    assert(f.admin("alice", "u"));
+    assert(f.db->role_reads == 2);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_scope_memoises_without_a_shared_cache() {
+    std::cout << "test_scope_memoises_without_a_shared_cache" << std::endl;
+    auto db = std::make_shared<CountingDatabase>();
+    AclManager acl(db);
+    acl.is_admin("bob", {}, "t");
+    acl.check_permission("F", "bob", {}, static_cast<int>(Permission::READ), "t");
+    assert(db->role_reads == 2);
+    {
+        AclManager::CacheScope scope(acl);
+        acl.is_admin("bob", {}, "t");
+        acl.check_permission("F", "bob", {}, static_cast<int>(Permission::READ), "t");
+        acl.get_effective_permissions("F", "bob", {}, "t");
+        assert(db->role_reads == 3);
+    }
+    acl.is_admin("bob", {}, "t");
+    assert(db->role_reads == 4);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_membership_changes_apply_to_the_next_check() {
+    std::cout << "test_membership_changes_apply_to_the_next_check" << std::endl;
+    Fixture f;
+    assert(!f.admin("alice"));
+    assert(f.roles.assign_user_to_role("alice", kTenantAdminRole, "t").success);
+    assert(f.admin("alice"));
+    assert(f.roles.remove_user_from_role("alice", kTenantAdminRole, "t").success);
+    assert(!f.admin("alice"));
+
+    // Deleting a role drops every user of the tenant
+    f.roles.assign_user_to_role("alice", kTenantAdminRole, "t");
+    f.roles.assign_user_to_role("carol", kTenantAdminRole, "t");
+    assert(f.admin("alice") && f.admin("carol"));
+    assert(f.roles.delete_role(kTenantAdminRole, "t").success);
+    assert(!f.admin("alice") && !f.admin("carol"));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_fills_racing_an_invalidation_are_dropped() {
+    std::cout << "test_fills_racing_an_invalidation_are_dropped" << std::endl;
+    Fixture f;
+    f.db->members_["alice"] = {kTenantAdminRole};
+    // The role is removed after this check read the old membership
+    f.db->during_role_read = [&] { f.roles.remove_user_from_role("alice", kTenantAdminRole, "t"); };
+    assert(f.admin("alice"));
+    assert(!f.admin("alice"));
+    assert(f.db->role_reads == 2);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_failed_lookups_are_not_cached() {
+    std::cout << "test_failed_lookups_are_not_cached" << std::endl;
+    Fixture f;
+    f.db->members_["alice"] = {kTenantAdminRole};
+    f.db->fail_role_reads = true;
+    assert(!f.admin("alice"));
+    assert(f.acl.is_admin("alice", {kTenantAdminRole}, "t"));  // request roles still count
+    f.db->fail_role_reads = false;
+    assert(f.admin("alice"));
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_ttl_and_stats() {
+    std::cout << "test_ttl_and_stats" << std::endl;
+    RoleCache cache(100, std::chrono::milliseconds(20));
+    cache.put("t", "alice", {"editors"}, cache.epoch());
+    auto hit = cache.get("t", "alice");
+    assert(hit && hit->size() == 1 && (*hit)[0] == "editors");
+    assert(!cache.get("u", "alice"));
+
+    const uint64_t before = cache.epoch();
+    cache.invalidate("t", "bob");
+    cache.put("t", "bob", {"editors"}, before);
+    assert(!cache.get("t", "bob"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    assert(!cache.get("t", "alice"));
+
+    auto stats = cache.get_stats();
+    assert(stats.hits == 1 && stats.invalidations == 1 && stats.entries == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_repeat_checks_read_roles_once();
+    test_scope_memoises_without_a_shared_cache();
+    test_membership_changes_apply_to_the_next_check();
+    test_fills_racing_an_invalidation_are_dropped();
+    test_failed_lookups_are_not_cached();
+    test_ttl_and_stats();
+    std::cout << "All role cache tests passed!" << std::endl;
+    return 0;
+}
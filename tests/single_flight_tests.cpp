@@ -0,0 +1,140 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Unit tests for SingleFlight, the duplicate-call suppression used by
+// FileSystem cold reads: concurrent calls for one key must run the work
+// once and all see its result, distinct keys must not wait on each other,
+// and nothing may be remembered once a call completes. In-memory only.
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileengine/single_flight.h"
+
+using fileengine::Result;
+using fileengine::SingleFlight;
+
+// Spin until `pred` holds; the leader uses this to keep its call in flight
+// until every follower has joined it.
+template <typename Pred>
+static void wait_for(Pred pred) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!pred()) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static void test_concurrent_calls_share_one_run() {
+    std::cout << "test_concurrent_calls_share_one_run" << std::endl;
+    SingleFlight<std::string> flight;
+    const int kThreads = 8;
+    std::atomic<int> runs{0};
+
+    std::vector<std::string> results(kThreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&, i] {
+            auto r = flight.run("key", [&]() -> Result<std::string> {
+                runs.fetch_add(1);
+                wait_for([&] { return flight.coalesced() == kThreads - 1; });
+                return Result<std::string>::ok("payload");
+            });
+            assert(r.success);
+            results[i] = r.value;
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    assert(runs.load() == 1);
+    assert(flight.coalesced() == kThreads - 1);
+    for (const auto& r : results) assert(r == "payload");
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_errors_reach_every_caller() {
+    std::cout << "test_errors_reach_every_caller" << std::endl;
+    SingleFlight<int> flight;
+    std::atomic<int> runs{0};
+    std::atomic<int> failures{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            auto r = flight.run("key", [&]() -> Result<int> {
+                runs.fetch_add(1);
+                wait_for([&] { return flight.coalesced() == 3; });
+                throw std::runtime_error("object store unavailable");
+            });
+            if (!r.success && r.error == "object store unavailable") failures.fetch_add(1);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    assert(runs.load() == 1);
+    assert(failures.load() == 4);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_distinct_keys_run_independently() {
+    std::cout << "test_distinct_keys_run_independently" << std::endl;
+    SingleFlight<int> flight;
+    std::atomic<int> started{0};
+
+    // Each call waits for the other to start, so this only finishes if the
+    // two keys run side by side.
+    auto work = [&](int v) {
+        return [&, v]() -> Result<int> {
+            started.fetch_add(1);
+            wait_for([&] { return started.load() == 2; });
+            return Result<int>::ok(v);
+        };
+    };
+    int a = 0, b = 0;
+    std::thread ta([&] { a = flight.run("a", work(1)).value; });
+    std::thread tb([&] { b = flight.run("b", work(2)).value; });
+    ta.join();
+    tb.join();
+
+    assert(a == 1 && b == 2);
+    assert(flight.coalesced() == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_completed_calls_are_not_cached() {
+    std::cout << "test_completed_calls_are_not_cached" << std::endl;
+    SingleFlight<int> flight;
+    int runs = 0;
+    auto fn = [&]() -> Result<int> { return Result<int>::ok(++runs); };
+
+    assert(flight.run("key", fn).value == 1);
+    assert(flight.run("key", fn).value == 2);
+    assert(flight.coalesced() == 0);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_concurrent_calls_share_one_run();
+    test_errors_reach_every_caller();
+    test_distinct_keys_run_independently();
+    test_completed_calls_are_not_cached();
+    std::cout << "All single flight tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Cost of durable PUTs in Storage::store_file. For each thread count the
+// same workload runs under every StorageSyncMode: "none" (rename only),
+// "fsync" (fdatasync + directory fsync per write) and "group" (batched
+// syncfs shared by concurrent writers), reporting throughput and per-write
+// p50/p99 latency. Group commit should approach "none" as writers increase
+// while "fsync" stays bound by one flush per write.
+//
+// Usage: storage_durability_bench [--dir PATH] [--size-kb N] [--files N] [--max-threads N]
+// Not a pass/fail test; run on the storage volume you want to measure
+// (tmpfs makes every flush free and the modes indistinguishable).
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/storage.h"
+#include "fileengine/utils.h"
+
+using fileengine::Storage;
+using fileengine::StorageSyncMode;
+
+struct BenchOptions {
+    std::string dir = (std::filesystem::temp_directory_path() /
+                       ("fileengine_durability_bench_" + std::to_string(::getpid()))).string();
+    size_t size_kb = 16;
+    size_t files_per_thread = 100;
+    size_t max_threads = 16;
+};
+
+struct RunResult {
+    double seconds;
+    double p50_ms;
+    double p99_ms;
+};
+
+static BenchOptions parse_args(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--dir") opt.dir = argv[i + 1];
+        else if (arg == "--size-kb") opt.size_kb = std::stoul(argv[i + 1]);
+        else if (arg == "--files") opt.files_per_thread = std::stoul(argv[i + 1]);
+        else if (arg == "--max-threads") opt.max_threads = std::stoul(argv[i + 1]);
+    }
+    return opt;
+}
+
+static RunResult run_once(const BenchOptions& opt, size_t threads, StorageSyncMode mode) {
+    std::filesystem::remove_all(opt.dir);
+    Storage storage(opt.dir, false, false, false, mode);
+    std::vector<uint8_t> payload(opt.size_kb * 1024, 0x5a);
+
+    std::vector<std::vector<std::string>> uids(threads);
+    for (auto& v : uids) {
+        for (size_t i = 0; i < opt.files_per_thread; ++i) v.push_back(fileengine::Utils::generate_uuid());
+    }
+    std::vector<std::vector<double>> latencies(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            latencies[t].reserve(uids[t].size());
+            for (const auto& uid : uids[t]) {
+                auto op_start = std::chrono::steady_clock::now();
+                auto r = storage.store_file(uid, "20260101_000000.000", payload, "bench");
+                if (!r.success) {
+                    std::cerr << "store_file failed: " << r.error << std::endl;
+                    std::exit(1);
+                }
+                latencies[t].push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - op_start).count());
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::filesystem::remove_all(opt.dir);
+
+    std::vector<double> all;
+    for (const auto& v : latencies) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+    return {secs, pct(0.50), pct(0.99)};
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt = parse_args(argc, argv);
+    std::cout << "store_file durability cost: " << opt.size_kb << " KiB payloads, "
+              << opt.files_per_thread << " files/thread, dir " << opt.dir << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(8) << "mode"
+              << std::setw(14) << "ops/s" << std::setw(12) << "p50 ms" << "p99 ms" << std::endl;
+
+    const std::pair<const char*, StorageSyncMode> modes[] = {
+        {"none", StorageSyncMode::None},
+        {"fsync", StorageSyncMode::Fsync},
+        {"group", StorageSyncMode::Group},
+    };
+    for (size_t threads = 1; threads <= opt.max_threads; threads *= 2) {
+        double total_ops = static_cast<double>(threads * opt.files_per_thread);
+        for (const auto& [name, mode] : modes) {
+            RunResult r = run_once(opt, threads, mode);
+            std::cout << std::left << std::fixed << std::setprecision(1)
+                      << std::setw(10) << threads << std::setw(8) << name
+                      << std::setw(14) << total_ops / r.seconds
+                      << std::setprecision(3) << std::setw(12) << r.p50_ms << r.p99_ms << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,410 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Unit tests for small-blob packing (Storage::enable_packing / PackedStore).
+// Small versions must live in segment files, not files of their own, yet read
+// back through the usual version paths; deletes, rewrites and compaction must
+// survive reopening the store. Runs against a scratch directory; no DB.
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/storage.h"
+#include "fileengine/packed_store.h"
+
+using fileengine::PackedStore;
+using fileengine::PackedStoreOptions;
+using fileengine::Storage;
+
+static const std::string TENANT = "tenant_a";
+
+static std::vector<uint8_t> make_data(size_t n, uint8_t seed) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 31 + seed) & 0xff);
+    return v;
+}
+
+static std::string uid_for(int i) {
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%08x-1111-2222-3333-444444444444", i);
+    return buf;
+}
+
+static std::string scratch_dir(const std::string& name) {
+    auto dir = std::filesystem::temp_directory_path() /
+               ("fileengine_" + name + "_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir);
+    return dir.string();
+}
+
+static PackedStoreOptions pack_options(size_t threshold, uint64_t segment_size = 64ull * 1024 * 1024) {
+    PackedStoreOptions options;
+    options.threshold = threshold;
+    options.segment_size = segment_size;
+    options.compact_interval_seconds = 0;  // tests compact explicitly
+    return options;
+}
+
+static size_t count_segments(const std::string& base) {
+    size_t n = 0;
+    for (const auto& e : std::filesystem::directory_iterator(std::filesystem::path(base) / Storage::kPackDirName)) {
+        if (e.path().extension() == ".seg") ++n;
+    }
+    return n;
+}
+
+static void test_small_blobs_are_packed() {
+    std::cout << "pack: small blobs go to segments, large ones to files..." << std::endl;
+    std::string base = scratch_dir("pack_small");
+    Storage storage(base);
+    assert(storage.enable_packing(pack_options(4096)).success);
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < 200; ++i) {
+        auto r = storage.store_file(uid_for(i), "20260101_000000.000", make_data(100 + i, i), TENANT);
+        assert(r.success);
+        assert(!std::filesystem::exists(r.value));  // no inode of its own
+        paths.push_back(r.value);
+    }
+    auto large = storage.store_file(uid_for(1000), "20260101_000000.000", make_data(10000, 3), TENANT);
+    assert(large.success && std::filesystem::exists(large.value));
+    assert(count_segments(base) == 1);
+
+    for (int i = 0; i < 200; ++i) {
+        auto expected = make_data(100 + i, i);
+        auto read = storage.read_file(paths[i], TENANT);
+        assert(read.success && read.value == expected);
+        assert(storage.file_exists(paths[i], TENANT).value);
+        auto size = storage.get_file_size(paths[i], TENANT);
+        assert(size.success && size.value == expected.size());
+    }
+
+    auto expected = make_data(150, 50);
+    auto range = storage.read_file_range(paths[50], 10, 20, TENANT);
+    assert(range.success && range.value == std::vector<uint8_t>(expected.begin() + 10, expected.begin() + 30));
+    auto tail = storage.read_file_range(paths[50], 140, 100, TENANT);
+    assert(tail.success && tail.value.size() == 10);
+    std::vector<uint8_t> streamed;
+    assert(storage.read_file_chunks(paths[50], [&](const uint8_t* p, size_t n) {
+        streamed.insert(streamed.end(), p, p + n);
+        return true;
+    }, TENANT).success);
+    assert(streamed == expected);
+
+    // Listings see packed versions by their version path, and no segments.
+    auto listed = storage.get_local_file_paths(TENANT);
+    assert(listed.success && listed.value.size() == 201);
+    for (const auto& p : paths) {
+        assert(std::find(listed.value.begin(), listed.value.end(), p) != listed.value.end());
+    }
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_staged_and_rewritten_versions() {
+    std::cout << "pack: staged writes are packed, rewrites replace the old layout..." << std::endl;
+    std::string base = scratch_dir("pack_staged");
+    Storage storage(base);
+    assert(storage.enable_packing(pack_options(4096)).success);
+
+    std::string path = storage.get_storage_path(uid_for(1), "20260101_000000.000", TENANT);
+    std::string staged = storage.make_staging_path(path);
+    {
+        std::ofstream out(staged, std::ios::binary);
+        auto data = make_data(500, 1);
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+    assert(storage.publish_staged_file(staged, path).success);
+    assert(!std::filesystem::exists(staged) && !std::filesystem::exists(path));
+    assert(storage.read_file(path, TENANT).value == make_data(500, 1));
+
+    // Small -> large: the file takes over and the packed copy is dropped.
+    assert(storage.store_file(uid_for(1), "20260101_000000.000", make_data(8000, 2), TENANT).success);
+    assert(std::filesystem::exists(path));
+    assert(storage.read_file(path, TENANT).value == make_data(8000, 2));
+    assert(storage.packed_store()->stats().blobs == 0);
+
+    // Large -> small: packed again, the file is removed.
+    assert(storage.store_file(uid_for(1), "20260101_000000.000", make_data(300, 3), TENANT).success);
+    assert(!std::filesystem::exists(path));
+    assert(storage.read_file(path, TENANT).value == make_data(300, 3));
+
+    assert(storage.delete_file(path, TENANT).success);
+    assert(!storage.file_exists(path, TENANT).value);
+    assert(!storage.read_file(path, TENANT).success);
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_reopen_restores_index() {
+    std::cout << "pack: index is rebuilt from segments on reopen..." << std::endl;
+    std::string base = scratch_dir("pack_reopen");
+    std::vector<std::string> paths;
+    {
+        Storage storage(base, false, false, false, fileengine::StorageSyncMode::Fsync);
+        assert(storage.enable_packing(pack_options(4096)).success);
+        for (int i = 0; i < 50; ++i) {
+            paths.push_back(storage.store_file(uid_for(i), "20260101_000000.000", make_data(200, i), TENANT).value);
+        }
+        for (int i = 0; i < 50; i += 5) assert(storage.delete_file(paths[i], TENANT).success);
+        // Overwrite: the later record must win after reopening.
+        assert(storage.store_file(uid_for(1), "20260101_000000.000", make_data(222, 99), TENANT).success);
+    }
+
+    // A torn append at the tail (crash mid-write) is dropped on open.
+    std::string segment;
+    for (const auto& e : std::filesystem::directory_iterator(std::filesystem::path(base) / Storage::kPackDirName)) {
+        segment = e.path().string();
+    }
+    auto before = std::filesystem::file_size(segment);
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::app);
+        out.write("FEPK\0\0\0\0", 8);
+    }
+
+    Storage storage(base);
+    assert(storage.enable_packing(pack_options(4096)).success);
+    assert(std::filesystem::file_size(segment) == before);
+    for (int i = 0; i < 50; ++i) {
+        auto read = storage.read_file(paths[i], TENANT);
+        if (i % 5 == 0) {
+            assert(!read.success);
+        } else if (i == 1) {
+            assert(read.success && read.value == make_data(222, 99));
+        } else {
+            assert(read.success && read.value == make_data(200, i));
+        }
+    }
+    assert(storage.packed_store()->stats().blobs == 40);
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_corrupt_copy_keeps_previous_record() {
+    std::cout << "pack: a newer record failing its CRC does not shadow the old one..." << std::endl;
+    std::string base = scratch_dir("pack_crc");
+    std::string path;
+    {
+        Storage storage(base, false, false, false, fileengine::StorageSyncMode::Fsync);
+        assert(storage.enable_packing(pack_options(4096)).success);
+        path = storage.store_file(uid_for(3), "20260101_000000.000", make_data(300, 3), TENANT).value;
+    }
+
+    // Simulate a crash that left a rewrite's header on disk but not all of
+    // its data: duplicate the record with a higher seq and a damaged body.
+    std::string segment;
+    for (const auto& e : std::filesystem::directory_iterator(std::filesystem::path(base) / Storage::kPackDirName)) {
+        segment = e.path().string();
+    }
+    auto before = std::filesystem::file_size(segment);
+    std::vector<char> record(before);
+    {
+        std::ifstream in(segment, std::ios::binary);
+        in.read(record.data(), static_cast<std::streamsize>(record.size()));
+    }
+    record[12] = 0x7f;  // seq, little-endian low byte
+    record.back() ^= 0x5a;
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::app);
+        out.write(record.data(), static_cast<std::streamsize>(record.size()));
+    }
+
+    Storage storage(base);
+    assert(storage.enable_packing(pack_options(4096)).success);
+    assert(std::filesystem::file_size(segment) == before);
+    auto read = storage.read_file(path, TENANT);
+    assert(read.success && read.value == make_data(300, 3));
+    assert(storage.packed_store()->stats().dead_bytes == 0);
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_corrupt_record_in_sealed_segment_is_skipped() {
+    std::cout << "pack: a corrupt record in a sealed segment costs only that record..." << std::endl;
+    std::string base = scratch_dir("pack_sealed_crc");
+    std::vector<std::string> paths;
+    {
+        Storage storage(base, false, false, false, fileengine::StorageSyncMode::Fsync);
+        assert(storage.enable_packing(pack_options(1024, 8 * 1024)).success);
+        for (int i = 0; i < 40; ++i) {
+            paths.push_back(storage.store_file(uid_for(i), "20260101_000000.000", make_data(500, i), TENANT).value);
+        }
+    }
+    assert(count_segments(base) > 2);
+
+    // Bit rot in the first record of the oldest segment.
+    std::string oldest;
+    for (const auto& e : std::filesystem::directory_iterator(std::filesystem::path(base) / Storage::kPackDirName)) {
+        if (oldest.empty() || e.path().string() < oldest) oldest = e.path().string();
+    }
+    auto before = std::filesystem::file_size(oldest);
+    {
+        std::fstream f(oldest, std::ios::binary | std::ios::in | std::ios::out);
+        char key_len[2];
+        f.seekg(6);
+        f.read(key_len, 2);
+        const std::streamoff at = 24 + (static_cast<uint8_t>(key_len[0]) | static_cast<uint8_t>(key_len[1]) << 8) + 10;
+        char c;
+        f.seekg(at);
+        f.read(&c, 1);
+        c ^= 0x20;
+        f.seekp(at);
+        f.write(&c, 1);
+    }
+
+    Storage storage(base);
+    assert(storage.enable_packing(pack_options(1024, 8 * 1024)).success);
+    assert(std::filesystem::file_size(oldest) == before);
+    assert(!storage.read_file(paths[0], TENANT).success);
+    for (int i = 1; i < 40; ++i) {
+        assert(storage.read_file(paths[i], TENANT).value == make_data(500, i));
+    }
+    assert(storage.packed_store()->stats().blobs == 39);
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_delete_retires_older_copies() {
+    std::cout << "pack: a deleted blob stays deleted even if an older copy lost its flag..." << std::endl;
+    std::string base = scratch_dir("pack_tombstone");
+    std::string path;
+    {
+        Storage storage(base, false, false, false, fileengine::StorageSyncMode::Fsync);
+        assert(storage.enable_packing(pack_options(4096)).success);
+        path = storage.store_file(uid_for(5), "20260101_000000.000", make_data(300, 5), TENANT).value;
+        assert(storage.store_file(uid_for(5), "20260101_000000.000", make_data(300, 6), TENANT).success);
+        assert(storage.delete_file(path, TENANT).success);
+    }
+
+    // Simulate a crash that lost the first copy's dead flag: only the newer,
+    // deleted copy still says the key is gone.
+    std::string segment;
+    for (const auto& e : std::filesystem::directory_iterator(std::filesystem::path(base) / Storage::kPackDirName)) {
+        segment = e.path().string();
+    }
+    {
+        std::fstream io(segment, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(4);
+        io.put(0);
+    }
+
+    {
+        Storage storage(base);
+        assert(storage.enable_packing(pack_options(4096)).success);
+        assert(!storage.read_file(path, TENANT).success);
+        assert(storage.packed_store()->stats().blobs == 0);
+    }
+
+    // Reopening persisted the flag again.
+    {
+        std::ifstream in(segment, std::ios::binary);
+        in.seekg(4);
+        assert(in.get() != 0);
+    }
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_compaction_reclaims_dead_segments() {
+    std::cout << "pack: compaction rewrites mostly-dead segments..." << std::endl;
+    std::string base = scratch_dir("pack_compact");
+    std::vector<std::string> paths;
+    {
+        Storage storage(base);
+        assert(storage.enable_packing(pack_options(1024, 8 * 1024)).success);
+        for (int i = 0; i < 100; ++i) {
+            paths.push_back(storage.store_file(uid_for(i), "20260101_000000.000", make_data(500, i), TENANT).value);
+        }
+        size_t segments = count_segments(base);
+        assert(segments > 5);
+
+        // Delete 3 of every 4; every sealed segment is now mostly dead.
+        for (int i = 0; i < 100; ++i) {
+            if (i % 4 != 0) assert(storage.delete_file(paths[i], TENANT).success);
+        }
+        PackedStore* pack = storage.packed_store();
+        assert(pack->stats().dead_bytes > pack->stats().live_bytes);
+
+        auto compacted = pack->compact();
+        assert(compacted.success && compacted.value > 0);
+        assert(count_segments(base) < segments);
+        assert(pack->stats().blobs == 25);
+        for (int i = 0; i < 100; i += 4) {
+            assert(storage.read_file(paths[i], TENANT).value == make_data(500, i));
+        }
+    }
+
+    // Compacted copies are what a reopen finds.
+    Storage storage(base);
+    assert(storage.enable_packing(pack_options(1024, 8 * 1024)).success);
+    assert(storage.packed_store()->stats().blobs == 25);
+    for (int i = 0; i < 100; ++i) {
+        assert(storage.read_file(paths[i], TENANT).success == (i % 4 == 0));
+    }
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+static void test_storages_share_one_store() {
+    std::cout << "pack: storages over one base share the segments..." << std::endl;
+    std::string base = scratch_dir("pack_shared");
+    Storage writer(base);
+    Storage reader(base);
+    assert(writer.enable_packing(pack_options(4096)).success);
+    assert(reader.enable_packing(pack_options(4096)).success);
+    assert(writer.packed_store() == reader.packed_store());
+
+    auto path = writer.store_file(uid_for(7), "20260101_000000.000", make_data(64, 7), TENANT).value;
+    assert(reader.read_file(path, TENANT).value == make_data(64, 7));
+    assert(reader.delete_file(path, TENANT).success);
+    assert(!writer.file_exists(path, TENANT).value);
+
+    // Tenant cleanup drops the tenant's packed versions too.
+    writer.store_file(uid_for(8), "20260101_000000.000", make_data(64, 8), TENANT);
+    writer.store_file(uid_for(9), "20260101_000000.000", make_data(64, 9), "tenant_b");
+    assert(writer.cleanup_tenant_directory(TENANT).success);
+    assert(writer.packed_store()->list(TENANT + "/").empty());
+    assert(writer.packed_store()->list("tenant_b/").size() == 1);
+
+    std::filesystem::remove_all(base);
+    std::cout << "  ok" << std::endl;
+}
+
+int main() {
+    test_small_blobs_are_packed();
+    test_staged_and_rewritten_versions();
+    test_reopen_restores_index();
+    test_corrupt_copy_keeps_previous_record();
+    test_corrupt_record_in_sealed_segment_is_skipped();
+    test_delete_retires_older_copies();
+    test_compaction_reclaims_dead_segments();
+    test_storages_share_one_store();
+    std::cout << "All storage packing tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2026 James Hickman
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// PUT throughput benchmark for Storage::store_file under concurrent writers.
+// Each writer thread stores its own files (distinct uids, as concurrent gRPC
+// PUTs do). Every thread count is run twice: once with all writers funnelled
+// through one process-wide mutex (the former Storage::storage_mutex_
+// behaviour) and once against Storage directly, so the table shows how
+// throughput scales with writers now that writes no longer serialize.
+//
+// Usage: storage_put_bench [--dir PATH] [--size-kb N] [--files N] [--max-threads N]
+// Not a pass/fail test; run on the storage volume you want to measure.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "fileengine/storage.h"
+#include "fileengine/utils.h"
+
+using fileengine::Storage;
+
+struct BenchOptions {
+    std::string dir = (std::filesystem::temp_directory_path() /
+                       ("fileengine_put_bench_" + std::to_string(::getpid()))).string();
+    size_t size_kb = 64;
+    size_t files_per_thread = 200;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+static BenchOptions parse_args(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--dir") opt.dir = argv[i + 1];
+        else if (arg == "--size-kb") opt.size_kb = std::stoul(argv[i + 1]);
+        else if (arg == "--files") opt.files_per_thread = std::stoul(argv[i + 1]);
+        else if (arg == "--max-threads") opt.max_threads = std::stoul(argv[i + 1]);
+    }
+    return opt;
+}
+
+// Returns seconds taken for `threads` writers to each store `files` payloads.
+static double run_once(const BenchOptions& opt, size_t threads, bool global_lock) {
+    std::filesystem::remove_all(opt.dir);
+    Storage storage(opt.dir);
+    std::mutex global_mutex;
+    std::vector<uint8_t> payload(opt.size_kb * 1024, 0x5a);
+
+    std::vector<std::vector<std::string>> uids(threads);
+    for (auto& v : uids) {
+        for (size_t i = 0; i < opt.files_per_thread; ++i) v.push_back(fileengine::Utils::generate_uuid());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (const auto& uid : uids[t]) {
+                std::unique_lock<std::mutex> lock(global_mutex, std::defer_lock);
+                if (global_lock) lock.lock();
+                auto r = storage.store_file(uid, "20260101_000000.000", payload, "bench");
+                if (!r.success) {
+                    std::cerr << "store_file failed: " << r.error << std::endl;
+                    std::exit(1);
+                }
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::filesystem::remove_all(opt.dir);
+    return secs;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt = parse_args(argc, argv);
+    std::cout << "store_file PUT throughput: " << opt.size_kb << " KiB payloads, "
+              << opt.files_per_thread << " files/thread, dir " << opt.dir << std::endl;
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(22) << "global-lock ops/s" << std::setw(16) << "MB/s"
+              << std::setw(22) << "storage ops/s" << std::setw(16) << "MB/s"
+              << "speedup" << std::endl;
+
+    for (size_t threads = 1; threads <= opt.max_threads; threads *= 2) {
+        double total_ops = static_cast<double>(threads * opt.files_per_thread);
+        double total_mb = total_ops * opt.size_kb / 1024.0;
+        double locked = run_once(opt, threads, true);
+        double unlocked = run_once(opt, threads, false);
+        std::cout << std::left << std::fixed << std::setprecision(1)
+                  << std::setw(10) << threads
+                  << std::setw(22) << total_ops / locked << std::setw(16) << total_mb / locked
+                  << std::setw(22) << total_ops / unlocked << std::setw(16) << total_mb / unlocked
+                  << std::setprecision(2) << locked / unlocked << "x" << std::endl;
+    }
+    return 0;
+}